@@ -956,6 +956,12 @@ void CaptureContext::ExportCapture(const CaptureFileFormat &fmt, const rdcstr &e
   {
     file = Replay().GetCaptureFile();
     sdfile = m_StructuredFile;
+
+    // chunk contents may be loaded lazily, so make sure every chunk is loaded before exporting
+    m_Renderer.BlockInvoke([sdfile](IReplayController *r) {
+      for(uint32_t i = 0; i < sdfile->chunks.size(); i++)
+        r->GetStructuredChunk(i);
+    });
   }
 
   if(!file)
@@ -1382,6 +1382,10 @@ called.
 
   DOCUMENT(R"(Retrieve the :class:`~renderdoc.SDFile` for the currently open capture.
 
+If the ``Replay_LazyStructuredData`` config setting is enabled, the contents of chunks in the frame
+may not be loaded yet. Use :meth:`~renderdoc.ReplayController.GetStructuredChunk` on the replay
+thread to load a chunk before reading its contents.
+
 :return: The structured file.
 :rtype: ~renderdoc.SDFile
 )");
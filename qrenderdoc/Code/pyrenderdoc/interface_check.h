@@ -56,6 +56,9 @@ inline bool checkname(const char *baseType, std::string name, NameType nameType)
     return false;
   if((baseType && strstr(baseType, "rdcstr")) || name.find("rdcstr") != std::string::npos)
     return false;
+  if((baseType && strstr(baseType, "rdcinflexiblestr")) ||
+     name.find("rdcinflexiblestr") != std::string::npos)
+    return false;
   if((baseType && strstr(baseType, "StructuredBufferList")) ||
      name.find("StructuredBufferList") != std::string::npos)
     return false;
@@ -582,6 +582,53 @@ struct TypeConversion<rdcstr, false>
   }
 };
 
+// specialisation for inflexible strings, which are converted the same way as rdcstr
+template <>
+struct TypeConversion<rdcinflexiblestr, false>
+{
+  static swig_type_info *GetTypeInfo()
+  {
+    static swig_type_info *cached_type_info = NULL;
+
+    if(cached_type_info)
+      return cached_type_info;
+
+    cached_type_info = SWIG_TypeQuery("rdcinflexiblestr *");
+
+    return cached_type_info;
+  }
+
+  static int ConvertFromPy(PyObject *in, rdcinflexiblestr &out)
+  {
+    if(PyUnicode_Check(in))
+    {
+      rdcstr str;
+      int ret = TypeConversion<rdcstr>::ConvertFromPy(in, str);
+
+      if(SWIG_IsOK(ret))
+        out = str;
+
+      return ret;
+    }
+
+    swig_type_info *type_info = GetTypeInfo();
+    if(!type_info)
+      return SWIG_ERROR;
+
+    rdcinflexiblestr *ptr = NULL;
+    int res = SWIG_ConvertPtr(in, (void **)&ptr, type_info, 0);
+    if(SWIG_IsOK(res))
+      out = *ptr;
+
+    return res;
+  }
+
+  static PyObject *ConvertToPy(const rdcinflexiblestr &in)
+  {
+    return PyUnicode_FromStringAndSize(in.c_str(), in.size());
+  }
+};
+
 #include "structured_conversion.h"
 
 // free functions forward to struct
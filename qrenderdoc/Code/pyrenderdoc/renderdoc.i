@@ -129,6 +129,8 @@
 %ignore rdcarray::operator[];
 %ignore rdcstr::operator=;
 %ignore rdcstr::operator std::string;
+%ignore rdcinflexiblestr::operator=;
+%ignore rdcinflexiblestr::operator std::string;
 
 // simple typemap to delete old byte arrays in a buffer list before assigning the new one
 %typemap(memberin) StructuredBufferList {
@@ -141,6 +143,7 @@
 }
 
 SIMPLE_TYPEMAPS(rdcstr)
+SIMPLE_TYPEMAPS(rdcinflexiblestr)
 SIMPLE_TYPEMAPS(rdcdatetime)
 SIMPLE_TYPEMAPS(bytebuf)
 
@@ -212,6 +215,7 @@ EXTEND_ARRAY_CLASS_METHODS(StructuredBufferList)
 // list of array types. These are the concrete types used in rdcarray that will be bound
 // If you get an error with add_your_use_of_rdcarray_to_swig_interface missing, add your type here
 // or in qrenderdoc.i, depending on which one is appropriate
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, bool)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, int)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, float)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, uint32_t)
@@ -236,12 +240,15 @@ TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ResourceId)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderCompileFlag)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderConstant)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderDebugState)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderDebugStep)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderResource)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderSampler)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderSourceFile)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderVariable)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderVariableChange)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, SigParameter)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, TextureDescription)
+TEMPLATE_ARRAY_INSTANTIATE(rdcarray, TextureSave)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, ShaderEntryPoint)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, Viewport)
 TEMPLATE_ARRAY_INSTANTIATE(rdcarray, Scissor)
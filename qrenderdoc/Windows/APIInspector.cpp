@@ -127,12 +127,35 @@ void APIInspector::on_apiEvents_itemSelectionChanged()
 }
 
 void APIInspector::fillAPIView()
+{
+  const DrawcallDescription *draw = m_Ctx.CurSelectedDrawcall();
+
+  if(draw == NULL || draw->events.isEmpty())
+  {
+    addAPIEvents(draw);
+    return;
+  }
+
+  // chunk contents may be loaded lazily, so make sure they're available on the replay thread before
+  // displaying them
+  m_Ctx.Replay().AsyncInvoke(lit("fillAPIView"), [this, draw](IReplayController *r) {
+    for(const APIEvent &ev : draw->events)
+      r->GetStructuredChunk(ev.chunkIndex);
+
+    GUIInvoke::call(this, [this, draw]() {
+      // the selection may have moved on while we were loading
+      if(m_Ctx.CurSelectedDrawcall() == draw)
+        addAPIEvents(draw);
+    });
+  });
+}
+
+void APIInspector::addAPIEvents(const DrawcallDescription *draw)
 {
   ui->apiEvents->setUpdatesEnabled(false);
   ui->apiEvents->clear();
 
   const SDFile &file = m_Ctx.GetStructuredFile();
-  const DrawcallDescription *draw = m_Ctx.CurSelectedDrawcall();
 
   if(draw != NULL && !draw->events.isEmpty())
   {
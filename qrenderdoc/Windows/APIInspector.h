@@ -59,4 +59,5 @@ private:
 
   void addCallstack(rdcarray<rdcstr> calls);
   void fillAPIView();
+  void addAPIEvents(const DrawcallDescription *draw);
 };
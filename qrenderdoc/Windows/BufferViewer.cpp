@@ -3314,7 +3314,7 @@ void BufferViewer::debugVertex()
         r->DebugVertex(vertid, m_Config.curInstance, index, m_Ctx.CurDrawcall()->instanceOffset,
                        m_Ctx.CurDrawcall()->vertexOffset);
 
-    if(trace->states.isEmpty())
+    if(trace->GetNumStates() == 0)
     {
       r->FreeTrace(trace);
 
@@ -3131,7 +3131,7 @@ void D3D11PipelineStateViewer::on_debugThread_clicked()
   m_Ctx.Replay().AsyncInvoke([this, thread](IReplayController *r) {
     ShaderDebugTrace *trace = r->DebugThread(thread.g, thread.t);
 
-    if(trace->states.isEmpty())
+    if(trace->GetNumStates() == 0)
     {
       r->FreeTrace(trace);
 
@@ -688,7 +688,7 @@ void PixelHistoryView::startDebug(EventTag tag)
                           tag.primitive);
   });
 
-  if(trace->states.isEmpty())
+  if(trace->GetNumStates() == 0)
   {
     RDDialog::critical(this, tr("Debug Error"), tr("Error debugging pixel."));
     m_Ctx.Replay().AsyncInvoke([trace](IReplayController *r) { r->FreeTrace(trace); });
@@ -214,19 +214,30 @@ void ResourceInspector::Inspect(ResourceId id)
   else
     ui->resetName->hide();
 
-  ui->initChunks->setUpdatesEnabled(false);
   ui->initChunks->clear();
   ui->resourceUsage->clear();
 
-  const SDFile &file = m_Ctx.GetStructuredFile();
   const ResourceDescription *desc = m_Ctx.GetResource(id);
 
-  m_Ctx.Replay().AsyncInvoke([this, id](IReplayController *r) {
+  rdcarray<uint32_t> initChunks;
+  if(desc)
+    initChunks = desc->initialisationChunks;
+
+  m_Ctx.Replay().AsyncInvoke([this, id, initChunks](IReplayController *r) {
     rdcarray<EventUsage> usage = r->GetUsage(id);
 
     rdcarray<ShaderEntryPoint> entries = r->GetShaderEntryPoints(id);
 
-    GUIInvoke::call(this, [this, entries, usage] {
+    // chunk contents may be loaded lazily, make sure they're available before displaying them
+    for(uint32_t chunk : initChunks)
+      r->GetStructuredChunk(chunk);
+
+    GUIInvoke::call(this, [this, id, entries, usage, initChunks] {
+      // another resource may have been selected while we were fetching
+      if(m_Resource != id)
+        return;
+
+      AddInitChunks(initChunks);
 
       if(!entries.isEmpty())
       {
@@ -287,33 +298,41 @@ void ResourceInspector::Inspect(ResourceId id)
       ui->relatedResources->addTopLevelItem(item);
     }
     ui->relatedResources->endUpdate();
+  }
+  else
+  {
+    m_Resource = ResourceId();
+    ui->resourceName->setText(tr("No Resource Selected"));
+  }
+}
 
-    for(uint32_t chunk : desc->initialisationChunks)
-    {
-      RDTreeWidgetItem *root = new RDTreeWidgetItem({QString(), QString()});
+void ResourceInspector::AddInitChunks(const rdcarray<uint32_t> &initChunks)
+{
+  ui->initChunks->setUpdatesEnabled(false);
+  ui->initChunks->clear();
 
-      if(chunk < file.chunks.size())
-      {
-        SDChunk *chunkObj = file.chunks[chunk];
+  const SDFile &file = m_Ctx.GetStructuredFile();
 
-        root->setText(0, chunkObj->name);
+  for(uint32_t chunk : initChunks)
+  {
+    RDTreeWidgetItem *root = new RDTreeWidgetItem({QString(), QString()});
 
-        addStructuredObjects(root, chunkObj->data.children, false);
-      }
-      else
-      {
-        root->setText(1, tr("Invalid chunk index %1").arg(chunk));
-      }
+    if(chunk < file.chunks.size())
+    {
+      SDChunk *chunkObj = file.chunks[chunk];
 
-      ui->initChunks->addTopLevelItem(root);
+      root->setText(0, chunkObj->name);
 
-      ui->initChunks->setSelectedItem(root);
+      addStructuredObjects(root, chunkObj->data.children, false);
     }
-  }
-  else
-  {
-    m_Resource = ResourceId();
-    ui->resourceName->setText(tr("No Resource Selected"));
+    else
+    {
+      root->setText(1, tr("Invalid chunk index %1").arg(chunk));
+    }
+
+    ui->initChunks->addTopLevelItem(root);
+
+    ui->initChunks->setSelectedItem(root);
   }
 
   ui->initChunks->setUpdatesEnabled(true);
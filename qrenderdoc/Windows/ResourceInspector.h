@@ -76,6 +76,7 @@ protected:
 
 private:
   void HighlightUsage();
+  void AddInitChunks(const rdcarray<uint32_t> &initChunks);
 
   Ui::ResourceInspector *ui;
   ICaptureContext &m_Ctx;
@@ -990,7 +990,7 @@ bool ShaderViewer::stepNext()
   if(!m_Trace)
     return false;
 
-  if(CurrentStep() + 1 >= m_Trace->states.count())
+  if(CurrentStep() + 1 >= m_Trace->GetNumStates())
     return false;
 
   SetCurrentStep(CurrentStep() + 1);
@@ -1067,20 +1067,20 @@ void ShaderViewer::runTo(int runToInstruction, bool forward, ShaderEvents condit
 
   bool firstStep = true;
 
-  while(step < m_Trace->states.count())
+  while(step < m_Trace->GetNumStates())
   {
-    if(runToInstruction >= 0 && m_Trace->states[step].nextInstruction == (uint32_t)runToInstruction)
+    if(runToInstruction >= 0 && m_Trace->GetNextInstruction(step) == (uint32_t)runToInstruction)
       break;
 
-    if(!firstStep && (m_Trace->states[step + inc].flags & condition))
+    if(!firstStep && (m_Trace->GetFlags(step + inc) & condition))
       break;
 
-    if(!firstStep && m_Breakpoints.contains((int)m_Trace->states[step].nextInstruction))
+    if(!firstStep && m_Breakpoints.contains((int)m_Trace->GetNextInstruction(step)))
       break;
 
     firstStep = false;
 
-    if(step + inc < 0 || step + inc >= m_Trace->states.count())
+    if(step + inc < 0 || step + inc >= m_Trace->GetNumStates())
       break;
 
     step += inc;
@@ -1189,15 +1189,15 @@ void ShaderViewer::addFileList()
 
 void ShaderViewer::updateDebugging()
 {
-  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->states.count())
+  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->GetNumStates())
     return;
 
-  const ShaderDebugState &state = m_Trace->states[m_CurrentStep];
+  const ShaderDebugState &state = m_CurrentState;
 
   uint32_t nextInst = state.nextInstruction;
   bool done = false;
 
-  if(m_CurrentStep == m_Trace->states.count() - 1)
+  if(m_CurrentStep == m_Trace->GetNumStates() - 1)
   {
     nextInst--;
     done = true;
@@ -1566,10 +1566,16 @@ int ShaderViewer::CurrentStep()
 
 void ShaderViewer::SetCurrentStep(int step)
 {
-  if(m_Trace && !m_Trace->states.empty())
-    m_CurrentStep = qBound(0, step, m_Trace->states.count() - 1);
+  if(m_Trace && m_Trace->GetNumStates() > 0)
+  {
+    m_CurrentStep = qBound(0, step, m_Trace->GetNumStates() - 1);
+    m_CurrentState = m_Trace->GetState(m_CurrentStep);
+  }
   else
+  {
     m_CurrentStep = 0;
+    m_CurrentState = ShaderDebugState();
+  }
 
   updateDebugging();
 }
@@ -1970,7 +1976,7 @@ bool ShaderViewer::eventFilter(QObject *watched, QEvent *event)
 void ShaderViewer::disasm_tooltipShow(int x, int y)
 {
   // do nothing if there's no trace
-  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->states.count())
+  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->GetNumStates())
     return;
 
   // ignore any messages if we're already outside the viewport
@@ -2024,10 +2030,10 @@ const rdcarray<ShaderVariable> *ShaderViewer::GetVariableList(VariableCategory v
 {
   const rdcarray<ShaderVariable> *vars = NULL;
 
-  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->states.count())
+  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->GetNumStates())
     return vars;
 
-  const ShaderDebugState &state = m_Trace->states[m_CurrentStep];
+  const ShaderDebugState &state = m_CurrentState;
 
   arrayIdx = qMax(0, arrayIdx);
 
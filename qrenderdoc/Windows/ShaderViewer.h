@@ -205,6 +205,8 @@ private:
 
   ShaderDebugTrace *m_Trace = NULL;
   int m_CurrentStep;
+  // the trace's state reconstructed at m_CurrentStep
+  ShaderDebugState m_CurrentState;
   QList<int> m_Breakpoints;
 
   static const int CURRENT_MARKER = 0;
@@ -718,12 +718,15 @@ public:
 #endif
 };
 
+struct rdcinflexiblestr;
+
 DOCUMENT("");
 struct rdcstr : public rdcarray<char>
 {
   // extra string constructors
   rdcstr() : rdcarray<char>() {}
   rdcstr(const rdcstr &in) : rdcarray<char>() { assign(in); }
+  inline rdcstr(const rdcinflexiblestr &in);
   rdcstr(const std::string &in) : rdcarray<char>() { assign(in.c_str(), in.size()); }
   rdcstr(const char *const in) : rdcarray<char>() { assign(in, strlen(in)); }
   // extra string assignment
@@ -737,6 +740,7 @@ struct rdcstr : public rdcarray<char>
     assign(in, strlen(in));
     return *this;
   }
+  inline rdcstr &operator=(const rdcinflexiblestr &in);
 
   // cast operators
   operator std::string() const { return std::string(elems, elems + usedCount); }
@@ -770,6 +774,159 @@ struct rdcstr : public rdcarray<char>
   bool operator>(const rdcstr &o) const { return strcmp(elems, o.elems) > 0; }
 };
 
+// An immutable string that either owns a copy of its contents, or refers to a string that is known
+// to outlive it such as a literal or an interned string. Referring costs no allocation and copying
+// such a string only copies the pointer, which makes this suitable for names that are repeated
+// many times over - like the names and type names in structured data.
+DOCUMENT("");
+struct rdcinflexiblestr
+{
+  rdcinflexiblestr() : str(""), owned(false) {}
+  rdcinflexiblestr(const char *const in) { copy(in, strlen(in)); }
+  rdcinflexiblestr(const std::string &in) { copy(in.c_str(), in.size()); }
+  rdcinflexiblestr(const rdcstr &in) { copy(in.c_str(), in.size()); }
+  rdcinflexiblestr(const rdcinflexiblestr &in)
+  {
+    if(in.owned)
+    {
+      copy(in.str, strlen(in.str));
+    }
+    else
+    {
+      str = in.str;
+      owned = false;
+    }
+  }
+  rdcinflexiblestr(rdcinflexiblestr &&in) : str(in.str), owned(in.owned)
+  {
+    in.str = "";
+    in.owned = false;
+  }
+  ~rdcinflexiblestr() { release(); }
+  DOCUMENT("");
+  static rdcinflexiblestr Literal(const char *const in)
+  {
+    rdcinflexiblestr ret;
+    ret.str = in;
+    return ret;
+  }
+
+  rdcinflexiblestr &operator=(const rdcinflexiblestr &in)
+  {
+    if(this != &in)
+    {
+      rdcinflexiblestr tmp(in);
+      swap(tmp);
+    }
+    return *this;
+  }
+  rdcinflexiblestr &operator=(rdcinflexiblestr &&in)
+  {
+    swap(in);
+    return *this;
+  }
+  rdcinflexiblestr &operator=(const char *const in)
+  {
+    rdcinflexiblestr tmp(in);
+    swap(tmp);
+    return *this;
+  }
+  rdcinflexiblestr &operator=(const std::string &in)
+  {
+    rdcinflexiblestr tmp(in);
+    swap(tmp);
+    return *this;
+  }
+  rdcinflexiblestr &operator=(const rdcstr &in)
+  {
+    rdcinflexiblestr tmp(in);
+    swap(tmp);
+    return *this;
+  }
+
+  void swap(rdcinflexiblestr &o)
+  {
+    std::swap(str, o.str);
+    std::swap(owned, o.owned);
+  }
+
+  // cast operators
+  operator std::string() const { return std::string(str); }
+#if defined(RENDERDOC_QT_COMPAT)
+  rdcinflexiblestr(const QString &in)
+  {
+    QByteArray arr = in.toUtf8();
+    copy(arr.data(), arr.size());
+  }
+  operator QString() const { return QString::fromUtf8(str); }
+  operator QVariant() const { return QVariant(QString::fromUtf8(str)); }
+#endif
+
+  // conventional data accessors
+  DOCUMENT("");
+  const char *c_str() const { return str; }
+  size_t size() const { return strlen(str); }
+  bool empty() const { return str[0] == 0; }
+  bool isEmpty() const { return str[0] == 0; }
+  char operator[](size_t i) const { return str[i]; }
+  // returns true if this string refers to storage it doesn't own
+  bool isLiteral() const { return !owned; }
+  // equality checks
+  bool operator==(const char *const o) const { return o && !strcmp(str, o); }
+  bool operator==(const std::string &o) const { return o == str; }
+  bool operator==(const rdcstr &o) const { return !strcmp(str, o.c_str()); }
+  bool operator==(const rdcinflexiblestr &o) const { return str == o.str || !strcmp(str, o.str); }
+  bool operator!=(const char *const o) const { return !(*this == o); }
+  bool operator!=(const std::string &o) const { return !(*this == o); }
+  bool operator!=(const rdcstr &o) const { return !(*this == o); }
+  bool operator!=(const rdcinflexiblestr &o) const { return !(*this == o); }
+  // define ordering operators
+  bool operator<(const rdcinflexiblestr &o) const { return strcmp(str, o.str) < 0; }
+  bool operator>(const rdcinflexiblestr &o) const { return strcmp(str, o.str) > 0; }
+
+private:
+  const char *str;
+  bool owned;
+
+  void copy(const char *in, size_t len)
+  {
+#ifdef RENDERDOC_EXPORTS
+    char *mem = (char *)malloc(len + 1);
+#else
+    char *mem = (char *)RENDERDOC_AllocArrayMem(len + 1);
+#endif
+    memcpy(mem, in, len);
+    mem[len] = 0;
+    str = mem;
+    owned = true;
+  }
+
+  void release()
+  {
+    if(owned)
+    {
+#ifdef RENDERDOC_EXPORTS
+      free((void *)str);
+#else
+      RENDERDOC_FreeArrayMem((const void *)str);
+#endif
+    }
+    str = "";
+    owned = false;
+  }
+};
+
+inline rdcstr::rdcstr(const rdcinflexiblestr &in) : rdcarray<char>()
+{
+  assign(in.c_str(), in.size());
+}
+
+inline rdcstr &rdcstr::operator=(const rdcinflexiblestr &in)
+{
+  assign(in.c_str(), in.size());
+  return *this;
+}
+
 DOCUMENT("");
 struct bytebuf : public rdcarray<byte>
 {
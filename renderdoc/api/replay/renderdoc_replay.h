@@ -914,11 +914,27 @@ See :meth:`BuildTargetShader`.
 
   DOCUMENT(R"(Fetch the structured data representation of the capture loaded.
 
+If the ``Replay_LazyStructuredData`` config setting is enabled, the contents of chunks in the frame
+may not be loaded yet. Use :meth:`GetStructuredChunk` to load a chunk before reading its contents.
+
 :return: The structured file.
 :rtype: SDFile
 )");
   virtual const SDFile &GetStructuredFile() = 0;
 
+  DOCUMENT(R"(Fetch a single chunk from the structured data representation of the capture, making sure
+its contents are loaded.
+
+If the ``Replay_LazyStructuredData`` config setting is ``1`` when the capture is opened, chunks in the
+frame are only loaded with their name and metadata, and their contents are filled in here the first
+time they are requested.
+
+:param int chunkIndex: The index of the chunk in the structured file.
+:return: The chunk, or ``None`` if the index is out of range.
+:rtype: SDChunk
+)");
+  virtual const SDChunk *GetStructuredChunk(uint32_t chunkIndex) = 0;
+
   DOCUMENT(R"(Retrieve the list of root-level drawcalls in the capture.
 
 :return: The list of root-level drawcalls in the capture.
@@ -1102,6 +1118,21 @@ texture to something compatible with the target file format.
 )");
   virtual bool SaveTexture(const TextureSave &saveData, const char *path) = 0;
 
+  DOCUMENT(R"(Save several textures to files on disk, as with :meth:`SaveTexture`.
+
+Textures are read back in order, and encoded and written to disk in parallel while later textures
+are being read back, so this is faster than saving each one in turn.
+
+:param list saveData: A list of :class:`TextureSave` configurations, one for each texture.
+:param list paths: A list of paths to save to on disk, the same length as ``saveData``.
+:return: A list with one entry for each texture, ``True`` if it was saved successfully and
+  ``False`` otherwise. If the lists are different lengths, no textures are saved and the list is
+  empty.
+:rtype: ``list`` of ``bool``
+)");
+  virtual rdcarray<bool> SaveTextures(const rdcarray<TextureSave> &saveData,
+                                      const rdcarray<rdcstr> &paths) = 0;
+
   DOCUMENT(R"(Retrieve the generated data from one of the geometry processing shader stages.
 
 :param int instance: The index of the instance to retrieve data for.
@@ -3231,6 +3231,12 @@ DOCUMENT(R"(A set of flags describing the properties of a section in a renderdoc
 .. data:: ZstdCompressed
 
   This section is compressed with Zstd on disk.
+
+.. data:: BlockIndexed
+
+  This section is compressed as independent blocks with an index of their locations, which allows
+  seeking within the section and decompressing blocks in parallel. This is set together with either
+  :data:`LZ4Compressed` or :data:`ZstdCompressed` which indicates the compression used for the blocks.
 )");
 enum class SectionFlags : uint32_t
 {
@@ -3238,6 +3244,7 @@ enum class SectionFlags : uint32_t
   ASCIIStored = 0x1,
   LZ4Compressed = 0x2,
   ZstdCompressed = 0x4,
+  BlockIndexed = 0x8,
 };
 
 BITMASK_OPERATORS(SectionFlags);
@@ -270,9 +270,87 @@ shader execution happened will have ``nextInstruction == 0``.)");
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugState);
 
+DOCUMENT(R"(A single variable's new value, as part of the changes made by one step of a
+:class:`ShaderDebugTrace`.
+)");
+struct ShaderVariableChange
+{
+  DOCUMENT("");
+  bool operator==(const ShaderVariableChange &o) const
+  {
+    return index == o.index && !memcmp(&value, &o.value, sizeof(value));
+  }
+  bool operator<(const ShaderVariableChange &o) const
+  {
+    if(!(index == o.index))
+      return index < o.index;
+    if(memcmp(&value, &o.value, sizeof(value)) < 0)
+      return true;
+    return false;
+  }
+
+  DOCUMENT(R"(The index of the variable that changed. Variables are numbered depth-first, including
+members, through :data:`ShaderDebugState.registers` then :data:`ShaderDebugState.outputs` then
+:data:`ShaderDebugState.indexableTemps`.
+)");
+  uint32_t index;
+
+  DOCUMENT("The new :class:`contents <ShaderValue>` of the variable.");
+  ShaderValue value;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderVariableChange);
+
+DOCUMENT(R"(The record of one step in a :class:`ShaderDebugTrace`. A step either refers to a full
+keyframe state, or to a list of variable changes made since the previous step.
+)");
+struct ShaderDebugStep
+{
+  DOCUMENT("");
+  bool operator==(const ShaderDebugStep &o) const
+  {
+    return nextInstruction == o.nextInstruction && flags == o.flags && keyframe == o.keyframe &&
+           firstChange == o.firstChange;
+  }
+  bool operator<(const ShaderDebugStep &o) const
+  {
+    if(!(nextInstruction == o.nextInstruction))
+      return nextInstruction < o.nextInstruction;
+    if(!(flags == o.flags))
+      return flags < o.flags;
+    if(!(keyframe == o.keyframe))
+      return keyframe < o.keyframe;
+    if(!(firstChange == o.firstChange))
+      return firstChange < o.firstChange;
+    return false;
+  }
+
+  DOCUMENT("The :data:`ShaderDebugState.nextInstruction` after this step.");
+  uint32_t nextInstruction;
+
+  DOCUMENT("The :data:`ShaderDebugState.flags` for this step.");
+  ShaderEvents flags;
+
+  DOCUMENT(R"(The index in :data:`ShaderDebugTrace.keyframes` of the full state after this step, or
+``-1`` if this step is stored as changes from the previous step.
+)");
+  int32_t keyframe;
+
+  DOCUMENT(R"(The index in :data:`ShaderDebugTrace.changes` of the first change made by this step.
+The step's changes run up to the next step's ``firstChange``, or the end of the list for the last
+step.
+)");
+  uint32_t firstChange;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderDebugStep);
+
 DOCUMENT(R"(This stores the whole state of a shader's execution from start to finish, with each
 individual debugging step along the way, as well as the immutable global constant values that do not
 change with shader execution.
+
+Steps are stored compactly as periodic full keyframes with only the changed variables in between.
+Use :meth:`GetState` to retrieve the full state at any step.
 )");
 struct ShaderDebugTrace
 {
@@ -285,10 +363,106 @@ Each entry in this list corresponds to a constant block with the same index in t
 )");
   rdcarray<ShaderVariable> constantBlocks;
 
-  DOCUMENT(R"(A list of :class:`ShaderDebugState` states representing the state after each
-instruction was executed
+  DOCUMENT(R"(A list of :class:`ShaderDebugStep` records, one for the state after each instruction
+was executed.
+)");
+  rdcarray<ShaderDebugStep> steps;
+
+  DOCUMENT(R"(A list of :class:`ShaderDebugState` full states, referenced by
+:data:`ShaderDebugStep.keyframe`.
+)");
+  rdcarray<ShaderDebugState> keyframes;
+
+  DOCUMENT(R"(A list of :class:`ShaderVariableChange` records, referenced by
+:data:`ShaderDebugStep.firstChange`.
 )");
-  rdcarray<ShaderDebugState> states;
+  rdcarray<ShaderVariableChange> changes;
+
+  DOCUMENT(R"(Retrieves the number of steps in the trace.
+
+:return: The number of steps.
+:rtype: ``int``
+)");
+  int GetNumStates() const { return steps.count(); }
+  DOCUMENT(R"(Retrieves the next instruction at a given step, without reconstructing its state.
+
+:param int step: The step to query.
+:return: The :data:`ShaderDebugState.nextInstruction` at that step.
+:rtype: ``int``
+)");
+  uint32_t GetNextInstruction(int step) const { return steps[step].nextInstruction; }
+  DOCUMENT(R"(Retrieves the event flags at a given step, without reconstructing its state.
+
+:param int step: The step to query.
+:return: The :data:`ShaderDebugState.flags` at that step.
+:rtype: ShaderEvents
+)");
+  ShaderEvents GetFlags(int step) const { return steps[step].flags; }
+  DOCUMENT(R"(Reconstructs the full state after a given step, by starting from the nearest keyframe
+at or before it and applying each change since.
+
+:param int step: The step to reconstruct.
+:return: The state at that step.
+:rtype: ShaderDebugState
+)");
+  ShaderDebugState GetState(int step) const
+  {
+    ShaderDebugState ret;
+
+    if(step < 0 || step >= steps.count())
+      return ret;
+
+    int base = step;
+    while(base > 0 && steps[base].keyframe < 0)
+      base--;
+
+    if(steps[base].keyframe >= 0)
+      ret = keyframes[steps[base].keyframe];
+
+    if(base < step)
+    {
+      rdcarray<ShaderVariable *> vars;
+      FlattenVariables(ret, vars);
+
+      uint32_t first = steps[base + 1].firstChange;
+      uint32_t last =
+          step + 1 < steps.count() ? steps[step + 1].firstChange : (uint32_t)changes.count();
+
+      for(uint32_t c = first; c < last; c++)
+      {
+        if(changes[c].index < (uint32_t)vars.count())
+          vars[changes[c].index]->value = changes[c].value;
+      }
+    }
+
+    ret.nextInstruction = steps[step].nextInstruction;
+    ret.flags = steps[step].flags;
+
+    return ret;
+  }
+
+#if !defined(SWIG)
+  // lists every variable in a state in the order used by ShaderVariableChange::index
+  template <typename State, typename Var>
+  static void FlattenVariables(State &state, rdcarray<Var *> &vars)
+  {
+    vars.clear();
+    for(Var &v : state.registers)
+      FlattenVariable(v, vars);
+    for(Var &v : state.outputs)
+      FlattenVariable(v, vars);
+    for(Var &v : state.indexableTemps)
+      FlattenVariable(v, vars);
+  }
+
+  template <typename Var>
+  static void FlattenVariable(Var &var, rdcarray<Var *> &vars)
+  {
+    vars.push_back(&var);
+    for(Var &m : var.members)
+      FlattenVariable(m, vars);
+  }
+#endif
 };
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugTrace);
@@ -165,9 +165,13 @@ struct SDType
       : name(n), basetype(SDBasic::Struct), flags(SDTypeFlags::NoFlags), byteSize(0)
   {
   }
+  SDType(const rdcinflexiblestr &n)
+      : name(n), basetype(SDBasic::Struct), flags(SDTypeFlags::NoFlags), byteSize(0)
+  {
+  }
 
   DOCUMENT("The name of this type.");
-  rdcstr name;
+  rdcinflexiblestr name;
 
   DOCUMENT("The :class:`SDBasic` category that this type belongs to.");
   SDBasic basetype;
@@ -325,9 +329,11 @@ DECLARE_REFLECTION_STRUCT(SDObjectData);
 DOCUMENT("Defines a single structured object.");
 struct SDObject
 {
-  SDObject(const char *n, const char *t) : type(t)
+  SDObject(const char *n, const char *t) : name(n), type(t) { data.basic.u = 0; }
+  // names that are literals or interned don't need to be copied, which matters when there are
+  // millions of objects in a structured export.
+  SDObject(const rdcinflexiblestr &n, const rdcinflexiblestr &t) : name(n), type(t)
   {
-    name = n;
     data.basic.u = 0;
   }
 
@@ -356,7 +362,7 @@ struct SDObject
   }
 
   DOCUMENT("The name of this object.");
-  rdcstr name;
+  rdcinflexiblestr name;
 
   DOCUMENT("The :class:`SDType` of this object.");
   SDType type;
@@ -640,6 +646,10 @@ DOCUMENT("Defines a single structured chunk, which is a :class:`SDObject`.");
 struct SDChunk : public SDObject
 {
   SDChunk(const char *name) : SDObject(name, "Chunk") { type.basetype = SDBasic::Chunk; }
+  SDChunk(const rdcinflexiblestr &name) : SDObject(name, rdcinflexiblestr::Literal("Chunk"))
+  {
+    type.basetype = SDBasic::Chunk;
+  }
   DOCUMENT("The :class:`SDChunkMetaData` with the metadata for this chunk.");
   SDChunkMetaData metadata;
 
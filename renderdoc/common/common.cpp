@@ -31,6 +31,24 @@
 #include "os/os_specific.h"
 #include "strings/string_utils.h"
 
+// SSE2 is always available on x64, and AVX2 is detected at runtime.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RDOC_SSE2 OPTION_ON
+#include <emmintrin.h>
+#else
+#define RDOC_SSE2 OPTION_OFF
+#endif
+
+#if ENABLED(RDOC_SSE2) && (defined(_MSC_VER) || (defined(__GNUC__) && !defined(__ANDROID__)))
+#define RDOC_AVX2 OPTION_ON
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define RDOC_AVX2 OPTION_OFF
+#endif
+
 using std::string;
 
 //	for(int i=0; i < 256; i++)
@@ -223,6 +241,232 @@ bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &
   return diffStart < bufSize;
 }
 
+// FindDiffRanges scans the buffers with the widest vector compare available, producing a bitmask of
+// differing bytes per vector which is then turned into ranges. Buffers are mostly identical in
+// practice, so the inner loops compare several vectors at once and only look at the masks when
+// something differs.
+
+namespace
+{
+struct DiffRangeBuilder
+{
+  DiffRangeBuilder(std::vector<DiffRange> &r, size_t gap) : ranges(r), gapThreshold(gap) {}
+  std::vector<DiffRange> &ranges;
+  size_t gapThreshold;
+
+  bool active = false;
+  DiffRange current = {};
+
+  void AddRange(size_t start, size_t end)
+  {
+    if(active && start - current.end <= gapThreshold)
+    {
+      current.end = end;
+      return;
+    }
+
+    if(active)
+      ranges.push_back(current);
+
+    current.start = start;
+    current.end = end;
+    active = true;
+  }
+
+  // bit i of mask is set if byte offs+i differs
+  void AddMask(uint32_t mask, size_t offs, uint32_t width)
+  {
+    if(mask == 0)
+      return;
+
+    // if the gap threshold is at least the mask width, any gaps inside the mask will be merged
+    // anyway so we only need the first and last differing bytes.
+    if(gapThreshold >= width)
+    {
+      AddRange(offs + Bits::CountTrailingZeroes(mask), offs + 32 - Bits::CountLeadingZeroes(mask));
+      return;
+    }
+
+    while(mask)
+    {
+      uint32_t start = Bits::CountTrailingZeroes(mask);
+      uint32_t end = start + Bits::CountTrailingZeroes(~(mask >> start));
+
+      AddRange(offs + start, offs + end);
+
+      if(end >= 32)
+        break;
+
+      mask &= ~0U << end;
+    }
+  }
+
+  void Finish()
+  {
+    if(active)
+      ranges.push_back(current);
+    active = false;
+  }
+};
+
+// compares up to 32 bytes one at a time
+uint32_t ScalarDiffMask(const byte *a, const byte *b, size_t size)
+{
+  uint32_t mask = 0;
+  for(size_t i = 0; i < size; i++)
+    if(a[i] != b[i])
+      mask |= 1U << i;
+  return mask;
+}
+
+void ScanDiffScalar(const byte *a, const byte *b, size_t size, DiffRangeBuilder &builder)
+{
+  size_t offs = 0;
+
+  for(; offs + 16 <= size; offs += 16)
+  {
+    uint64_t a64[2], b64[2];
+    memcpy(a64, a + offs, 16);
+    memcpy(b64, b + offs, 16);
+
+    if(a64[0] == b64[0] && a64[1] == b64[1])
+      continue;
+
+    builder.AddMask(ScalarDiffMask(a + offs, b + offs, 16), offs, 16);
+  }
+
+  builder.AddMask(ScalarDiffMask(a + offs, b + offs, size - offs), offs, 16);
+}
+
+#if ENABLED(RDOC_SSE2)
+
+void ScanDiffSSE2(const byte *a, const byte *b, size_t size, DiffRangeBuilder &builder)
+{
+  size_t offs = 0;
+
+  for(; offs + 64 <= size; offs += 64)
+  {
+    __m128i eq[4];
+    for(int i = 0; i < 4; i++)
+      eq[i] = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offs + i * 16)),
+                             _mm_loadu_si128((const __m128i *)(b + offs + i * 16)));
+
+    __m128i all = _mm_and_si128(_mm_and_si128(eq[0], eq[1]), _mm_and_si128(eq[2], eq[3]));
+
+    if(_mm_movemask_epi8(all) == 0xffff)
+      continue;
+
+    for(int i = 0; i < 4; i++)
+      builder.AddMask(uint32_t(_mm_movemask_epi8(eq[i])) ^ 0xffff, offs + i * 16, 16);
+  }
+
+  for(; offs + 16 <= size; offs += 16)
+  {
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + offs)),
+                                _mm_loadu_si128((const __m128i *)(b + offs)));
+    builder.AddMask(uint32_t(_mm_movemask_epi8(eq)) ^ 0xffff, offs, 16);
+  }
+
+  builder.AddMask(ScalarDiffMask(a + offs, b + offs, size - offs), offs, 16);
+}
+
+#endif    // ENABLED(RDOC_SSE2)
+
+#if ENABLED(RDOC_AVX2)
+
+#if defined(_MSC_VER)
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+AVX2_FUNCTION void ScanDiffAVX2(const byte *a, const byte *b, size_t size,
+                                DiffRangeBuilder &builder)
+{
+  size_t offs = 0;
+
+  for(; offs + 128 <= size; offs += 128)
+  {
+    __m256i eq[4];
+    for(int i = 0; i < 4; i++)
+      eq[i] = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offs + i * 32)),
+                                _mm256_loadu_si256((const __m256i *)(b + offs + i * 32)));
+
+    __m256i all = _mm256_and_si256(_mm256_and_si256(eq[0], eq[1]), _mm256_and_si256(eq[2], eq[3]));
+
+    if(uint32_t(_mm256_movemask_epi8(all)) == 0xffffffffU)
+      continue;
+
+    for(int i = 0; i < 4; i++)
+      builder.AddMask(~uint32_t(_mm256_movemask_epi8(eq[i])), offs + i * 32, 32);
+  }
+
+  for(; offs + 32 <= size; offs += 32)
+  {
+    __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + offs)),
+                                   _mm256_loadu_si256((const __m256i *)(b + offs)));
+    builder.AddMask(~uint32_t(_mm256_movemask_epi8(eq)), offs, 32);
+  }
+
+  builder.AddMask(ScalarDiffMask(a + offs, b + offs, size - offs), offs, 32);
+}
+
+bool CPUSupportsAVX2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if(info[0] < 7)
+    return false;
+
+  // the OS must also save the YMM registers on context switches
+  __cpuid(info, 1);
+  const int osxsave = 1 << 27, avx = 1 << 28;
+  if((info[2] & (osxsave | avx)) != (osxsave | avx) || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif    // ENABLED(RDOC_AVX2)
+
+typedef void (*DiffScanFunction)(const byte *a, const byte *b, size_t size,
+                                 DiffRangeBuilder &builder);
+
+DiffScanFunction GetDiffScanFunction()
+{
+#if ENABLED(RDOC_AVX2)
+  if(CPUSupportsAVX2())
+    return &ScanDiffAVX2;
+#endif
+
+#if ENABLED(RDOC_SSE2)
+  return &ScanDiffSSE2;
+#else
+  return &ScanDiffScalar;
+#endif
+}
+};
+
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize, size_t gapThreshold,
+                    std::vector<DiffRange> &ranges)
+{
+  static DiffScanFunction scan = GetDiffScanFunction();
+
+  ranges.clear();
+
+  DiffRangeBuilder builder(ranges, gapThreshold);
+  scan((const byte *)a, (const byte *)b, bufSize, builder);
+  builder.Finish();
+
+  return !ranges.empty();
+}
+
 uint32_t CalcNumMips(int w, int h, int d)
 {
   int mipLevels = 1;
@@ -524,3 +768,221 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
 
   SAFE_DELETE_ARRAY(oversizedBuffer);
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+static std::vector<DiffRange> ReferenceDiffRanges(const byte *a, const byte *b, size_t size,
+                                                  size_t gapThreshold)
+{
+  std::vector<DiffRange> ret;
+
+  for(size_t i = 0; i < size; i++)
+  {
+    if(a[i] == b[i])
+      continue;
+
+    if(!ret.empty() && i - ret.back().end <= gapThreshold)
+      ret.back().end = i + 1;
+    else
+      ret.push_back({i, i + 1});
+  }
+
+  return ret;
+}
+
+static std::vector<DiffScanFunction> AvailableDiffScanFunctions()
+{
+  std::vector<DiffScanFunction> ret = {&ScanDiffScalar};
+#if ENABLED(RDOC_SSE2)
+  ret.push_back(&ScanDiffSSE2);
+#endif
+#if ENABLED(RDOC_AVX2)
+  if(CPUSupportsAVX2())
+    ret.push_back(&ScanDiffAVX2);
+#endif
+  return ret;
+}
+
+TEST_CASE("Check diff range finding", "[diffrange]")
+{
+  const size_t size = 4096 + 37;
+
+  std::vector<byte> a(size + 1), b(size + 1);
+
+  // use the misaligned +1 offset so vector loads are unaligned
+  byte *pa = a.data() + 1;
+  byte *pb = b.data() + 1;
+
+  std::vector<DiffRange> ranges;
+
+  SECTION("Identical buffers")
+  {
+    CHECK_FALSE(FindDiffRanges(pa, pb, size, 0, ranges));
+    CHECK(ranges.empty());
+  };
+
+  SECTION("Single bytes")
+  {
+    pb[0] = 1;
+    pb[100] = 1;
+    pb[size - 1] = 1;
+
+    CHECK(FindDiffRanges(pa, pb, size, 0, ranges));
+    REQUIRE(ranges.size() == 3);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 1);
+    CHECK(ranges[1].start == 100);
+    CHECK(ranges[1].end == 101);
+    CHECK(ranges[2].start == size - 1);
+    CHECK(ranges[2].end == size);
+
+    // merging with a large enough gap
+    CHECK(FindDiffRanges(pa, pb, size, 99, ranges));
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == 101);
+
+    CHECK(FindDiffRanges(pa, pb, size, size, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 0);
+    CHECK(ranges[0].end == size);
+  };
+
+  SECTION("Adjacent bytes across vector boundaries")
+  {
+    for(size_t i = 60; i < 70; i++)
+      pb[i] = 1;
+
+    CHECK(FindDiffRanges(pa, pb, size, 0, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == 60);
+    CHECK(ranges[0].end == 70);
+  };
+
+  SECTION("Random patterns match the reference")
+  {
+    uint32_t seed = 0x1234567;
+    auto rand = [&seed]() {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 8) & 0xffffff;
+    };
+
+    for(int iter = 0; iter < 50; iter++)
+    {
+      memset(pb, 0, size);
+
+      // a mix of single bytes and short runs
+      int numWrites = 1 + rand() % 40;
+      for(int w = 0; w < numWrites; w++)
+      {
+        size_t start = rand() % size;
+        size_t len = RDCMIN(size_t(1 + rand() % 80), size - start);
+        for(size_t i = start; i < start + len; i++)
+          pb[i] = byte(1 + rand() % 255);
+      }
+
+      const size_t gaps[] = {0, 1, 7, 16, 31, 32, 100, 1000};
+      for(size_t gap : gaps)
+      {
+        std::vector<DiffRange> ref = ReferenceDiffRanges(pa, pb, size, gap);
+
+        for(DiffScanFunction scan : AvailableDiffScanFunctions())
+        {
+          // also check sizes that leave an unaligned tail
+          for(size_t len : {size, size - 5, size_t(100)})
+          {
+            std::vector<DiffRange> expected = ReferenceDiffRanges(pa, pb, len, gap);
+
+            ranges.clear();
+            DiffRangeBuilder builder(ranges, gap);
+            scan(pa, pb, len, builder);
+            builder.Finish();
+
+            INFO("iteration " << iter << " gap " << gap << " length " << len);
+            REQUIRE(ranges.size() == expected.size());
+            for(size_t r = 0; r < ranges.size(); r++)
+            {
+              CHECK(ranges[r].start == expected[r].start);
+              CHECK(ranges[r].end == expected[r].end);
+            }
+          }
+        }
+
+        CHECK(FindDiffRanges(pa, pb, size, gap, ranges) == !ref.empty());
+        CHECK(ranges.size() == ref.size());
+      }
+    }
+  };
+};
+
+TEST_CASE("Benchmark diff range finding", "[diffrange][!benchmark]")
+{
+  // a typical large persistently mapped buffer
+  const size_t size = 64 * 1024 * 1024;
+
+  byte *a = AllocAlignedBuffer(size);
+  byte *b = AllocAlignedBuffer(size);
+
+  memset(a, 0, size);
+
+  struct Pattern
+  {
+    const char *name;
+    std::function<void(byte *)> write;
+  };
+
+  Pattern patterns[] = {
+      {"unchanged", [](byte *) {}},
+      {"writes at both ends",
+       [size](byte *buf) {
+         memset(buf, 1, 256);
+         memset(buf + size - 256, 1, 256);
+       }},
+      {"strided 64 bytes per 4KB",
+       [size](byte *buf) {
+         for(size_t offs = 0; offs < size; offs += 4096)
+           memset(buf + offs, 1, 64);
+       }},
+      {"ring buffer 1MB wrapping",
+       [size](byte *buf) {
+         memset(buf + size - 512 * 1024, 1, 512 * 1024);
+         memset(buf, 1, 512 * 1024);
+       }},
+      {"fully rewritten", [size](byte *buf) { memset(buf, 1, size); }},
+  };
+
+  std::vector<DiffRange> ranges;
+
+  for(const Pattern &p : patterns)
+  {
+    memset(b, 0, size);
+    p.write(b);
+
+    BENCHMARK(StringFormat::Fmt("FindDiffRange: %s", p.name))
+    {
+      size_t s = 0, e = 0;
+      FindDiffRange(a, b, size, s, e);
+    }
+
+    std::vector<DiffScanFunction> scans = AvailableDiffScanFunctions();
+    const char *scanNames[] = {"scalar", "SSE2", "AVX2"};
+
+    for(size_t i = 0; i < scans.size(); i++)
+    {
+      BENCHMARK(StringFormat::Fmt("FindDiffRanges %s: %s", scanNames[i], p.name))
+      {
+        ranges.clear();
+        DiffRangeBuilder builder(ranges, 128);
+        scans[i](a, b, size, builder);
+        builder.Finish();
+      }
+    }
+  }
+
+  FreeAlignedBuffer(a);
+  FreeAlignedBuffer(b);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
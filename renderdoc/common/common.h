@@ -28,6 +28,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <vector>
 #include "api/replay/renderdoc_replay.h"
 #include "globalconfig.h"
 
@@ -156,6 +157,19 @@ inline T AlignUpPtr(T x, A a)
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+
+// a byte range [start, end) that differs between two buffers
+struct DiffRange
+{
+  size_t start;
+  size_t end;
+};
+
+// finds every range of bytes that differ between a and b, in order. Ranges separated by no more
+// than gapThreshold identical bytes are merged into one, so callers can trade extra bytes for fewer
+// ranges. Neither buffer needs any particular alignment. Returns true if anything differs.
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize, size_t gapThreshold,
+                    std::vector<DiffRange> &ranges);
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 byte *AllocAlignedBuffer(uint64_t size, uint64_t alignment = 64);
@@ -24,162 +24,419 @@
 
 #pragma once
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include "3rdparty/zstd/xxhash.h"
+#include "common/common.h"
 #include "os/os_specific.h"
 
+// A cache of shader blobs on disk, keyed by a 32-bit hash.
+//
+// The file starts with a header and an index of hashes sorted for binary searching, followed by
+// the blobs it refers to. Entries added after the index was written are appended to the end of the
+// file, each with a small header of its own. At startup the file is mapped and only the header and
+// any appended entries are read, blobs are created with the callbacks the first time they're looked
+// up. New entries are appended when the cache is destroyed, and once too many have been appended
+// the whole file is rewritten with them in the index.
+//
+// Several programs can share the cache at once, so appends always go to the real end of the file
+// under a file lock, and each appended entry is checksummed so a torn write is detected on load.
+// A relative filename is in the application's data folder.
+//
+// The callbacks must provide:
+//   bool Create(uint32_t size, byte *data, ResultType *ret) const;
+//   void Destroy(ResultType result) const;
+//   uint32_t GetSize(ResultType result) const;
+//   const byte *GetData(ResultType result) const;
 template <typename ResultType, typename ShaderCallbacks>
-bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uint32_t versionNumber,
-                     std::map<uint32_t, ResultType> &resultCache, const ShaderCallbacks &callbacks)
+class PersistentShaderCache
 {
-  string shadercache = FileIO::GetAppFolderFilename(filename);
+public:
+  PersistentShaderCache(const char *filename, uint32_t magicNumber, uint32_t versionNumber,
+                        const ShaderCallbacks &callbacks)
+      : m_Callbacks(callbacks), m_MagicNumber(magicNumber), m_VersionNumber(versionNumber)
+  {
+    if(FileIO::IsRelativePath(filename))
+      m_Filename = FileIO::GetAppFolderFilename(filename);
+    else
+      m_Filename = filename;
 
-  FILE *f = FileIO::fopen(shadercache.c_str(), "rb");
+    Load();
+  }
 
-  if(!f)
-    return false;
+  ~PersistentShaderCache()
+  {
+    Save();
 
-  FileIO::fseek64(f, 0, SEEK_END);
-  uint64_t cachelen = FileIO::ftell64(f);
-  FileIO::fseek64(f, 0, SEEK_SET);
+    for(auto it = m_Results.begin(); it != m_Results.end(); ++it)
+      m_Callbacks.Destroy(it->second);
 
-  bool ret = true;
+    FileIO::UnmapFile(m_Data, m_Size);
+  }
 
-  // header: magic number, file version, number of entries
-  if(cachelen < sizeof(uint32_t) * 3)
+  // looks up a blob, creating it from the file if this is the first lookup. The cache keeps
+  // ownership of the result.
+  bool Find(uint32_t hash, ResultType &result)
   {
-    RDCERR("Invalid shader cache");
-    ret = false;
+    auto it = m_Results.find(hash);
+    if(it != m_Results.end())
+    {
+      result = it->second;
+      return true;
+    }
+
+    const IndexEntry *entry = FindEntry(hash);
+
+    if(entry == NULL)
+      return false;
+
+    if(!m_Callbacks.Create(entry->length, (byte *)m_Data + entry->offset, &result))
+    {
+      RDCERR("Couldn't create blob of size %u from shader cache", entry->length);
+      return false;
+    }
+
+    m_Results[hash] = result;
+
+    return true;
   }
-  else
+
+  // adds a blob, which will be written out when the cache is destroyed. The cache takes ownership
+  // of the result, and destroys any previous result for the same hash.
+  void Insert(uint32_t hash, ResultType result)
   {
-    byte *cache = new byte[(size_t)cachelen];
-    FileIO::fread(cache, 1, (size_t)cachelen, f);
+    auto it = m_Results.find(hash);
+    if(it != m_Results.end() && it->second != result)
+      m_Callbacks.Destroy(it->second);
 
-    uint32_t *header = (uint32_t *)cache;
+    m_Results[hash] = result;
+    m_Added.insert(hash);
+  }
+
+private:
+  // once this many entries have been appended since the index was written, rewrite the file
+  static const size_t MaxAppendedEntries = 256;
+
+  // changed whenever the layout of the file changes
+  static const uint32_t FileMagic = MAKE_FOURCC('R', 'D', 'S', '2');
+
+  struct FileHeader
+  {
+    uint32_t fileMagic;
+    uint32_t magicNumber;
+    uint32_t versionNumber;
+    uint32_t numIndexed;
+    // where the entries appended after the index was written start
+    uint64_t appendOffset;
+  };
+
+  struct IndexEntry
+  {
+    bool operator<(uint32_t h) const { return hash < h; }
+    uint32_t hash;
+    uint32_t length;
+    uint64_t offset;
+  };
+
+  struct AppendedEntry
+  {
+    uint32_t hash;
+    uint32_t length;
+    // XXH32 of the data
+    uint32_t checksum;
+  };
+
+  void Load()
+  {
+    m_Data = FileIO::MapFile(m_Filename.c_str(), m_Size);
+
+    // if there's no cache, or it's invalid, write a whole new one out
+    m_Rewrite = true;
 
-    uint32_t fileMagic = header[0];
-    uint32_t fileVer = header[1];
+    if(m_Data == NULL)
+      return;
 
-    if(fileMagic != magicNumber || fileVer != versionNumber)
+    FileHeader header = {};
+
+    if(m_Size >= sizeof(header))
+      memcpy(&header, m_Data, sizeof(header));
+
+    if(header.fileMagic != FileMagic || header.magicNumber != m_MagicNumber ||
+       header.versionNumber != m_VersionNumber)
     {
-      RDCDEBUG("Out of date or invalid shader cache magic: %d version: %d", fileMagic, fileVer);
-      ret = false;
+      RDCDEBUG("Out of date or invalid shader cache magic: %x version: %u", header.magicNumber,
+               header.versionNumber);
+      return;
     }
-    else
+
+    uint64_t indexEnd = sizeof(header) + uint64_t(header.numIndexed) * sizeof(IndexEntry);
+
+    if(indexEnd > header.appendOffset || header.appendOffset > m_Size)
+    {
+      RDCERR("Invalid shader cache - %u entries don't fit in a %llu byte cache", header.numIndexed,
+             m_Size);
+      return;
+    }
+
+    // the indexed entries aren't checked here, since that would read the whole index. Each one is
+    // checked when it's looked up instead.
+    m_Index = (const IndexEntry *)(m_Data + sizeof(header));
+    m_NumIndexed = header.numIndexed;
+    m_IndexedDataEnd = header.appendOffset;
+
+    m_Rewrite = false;
+
+    uint64_t offs = header.appendOffset;
+
+    while(offs < m_Size)
     {
-      uint32_t numentries = header[2];
+      AppendedEntry appended;
 
-      // assume at least 16 bytes for any cache entry. 8 bytes for hash and length, and 8 bytes
-      // data.
-      if(numentries > cachelen / 16LLU)
+      if(m_Size - offs < sizeof(appended))
       {
-        RDCERR("Invalid shader cache - more entries %u than are feasible in a %llu byte cache",
-               numentries, cachelen);
-        ret = false;
+        RDCWARN("Shader cache truncated, not enough data for entry header");
+        m_Rewrite = true;
+        break;
       }
-      else
+
+      memcpy(&appended, m_Data + offs, sizeof(appended));
+      offs += sizeof(appended);
+
+      if(m_Size - offs < appended.length)
       {
-        byte *ptr = cache + sizeof(uint32_t) * 3;
-
-        int64_t bufsize = (int64_t)cachelen - sizeof(uint32_t) * 3;
-
-        for(uint32_t i = 0; i < numentries; i++)
-        {
-          if((size_t)bufsize < sizeof(uint32_t))
-          {
-            RDCERR("Invalid shader cache - truncated, not enough data for shader hash");
-            ret = false;
-            break;
-          }
-
-          uint32_t hash = *(uint32_t *)ptr;
-          ptr += sizeof(uint32_t);
-          bufsize -= sizeof(uint32_t);
-
-          if((size_t)bufsize < sizeof(uint32_t))
-          {
-            RDCERR("Invalid shader cache - truncated, not enough data for shader length");
-            ret = false;
-            break;
-          }
-
-          uint32_t len = *(uint32_t *)ptr;
-          ptr += sizeof(uint32_t);
-          bufsize -= sizeof(uint32_t);
-
-          if(bufsize < len)
-          {
-            RDCERR("Invalid shader cache - truncated, not enough data for shader buffer");
-            ret = false;
-            break;
-          }
-
-          byte *data = ptr;
-          ptr += len;
-          bufsize -= len;
-
-          ResultType result;
-          bool created = callbacks.Create(len, data, &result);
-
-          if(!created)
-          {
-            RDCERR("Couldn't create blob of size %u from shadercache", len);
-            ret = false;
-            break;
-          }
-
-          resultCache[hash] = result;
-        }
-
-        if(ret == true && bufsize != 0)
-        {
-          RDCERR("Invalid shader cache - trailing data");
-          ret = false;
-        }
-
-        RDCDEBUG("Successfully loaded %d shaders from shader cache", resultCache.size());
+        RDCWARN("Shader cache truncated, not enough data for %u byte entry", appended.length);
+        m_Rewrite = true;
+        break;
       }
+
+      if(XXH32(m_Data + offs, appended.length, 0) != appended.checksum)
+      {
+        RDCWARN("Shader cache entry %08x is corrupt", appended.hash);
+        m_Rewrite = true;
+        break;
+      }
+
+      // later entries replace earlier ones with the same hash
+      IndexEntry &entry = m_Appended[appended.hash];
+      entry.hash = appended.hash;
+      entry.length = appended.length;
+      entry.offset = offs;
+
+      offs += AlignUp4(appended.length);
     }
 
-    delete[] cache;
+    RDCDEBUG("Mapped shader cache with %u indexed and %zu appended entries", m_NumIndexed,
+             m_Appended.size());
   }
 
-  FileIO::fclose(f);
+  const IndexEntry *FindEntry(uint32_t hash)
+  {
+    auto it = m_Appended.find(hash);
+    if(it != m_Appended.end())
+      return &it->second;
 
-  return ret;
-}
+    const IndexEntry *end = m_Index + m_NumIndexed;
+    const IndexEntry *entry = std::lower_bound(m_Index, end, hash);
 
-template <typename ResultType, typename ShaderCallbacks>
-void SaveShaderCache(const char *filename, uint32_t magicNumber, uint32_t versionNumber,
-                     const std::map<uint32_t, ResultType> &cache, const ShaderCallbacks &callbacks)
-{
-  string shadercache = FileIO::GetAppFolderFilename(filename);
+    if(entry == end || entry->hash != hash)
+      return NULL;
+
+    if(!IsIndexEntryValid(*entry))
+    {
+      RDCERR("Invalid shader cache - entry %08x is out of bounds", hash);
+      // drop the bad entry the next time the file is written
+      m_Rewrite = true;
+      return NULL;
+    }
+
+    return entry;
+  }
+
+  bool IsIndexEntryValid(const IndexEntry &entry) const
+  {
+    return entry.offset <= m_IndexedDataEnd && entry.length <= m_IndexedDataEnd - entry.offset;
+  }
+
+  void Save()
+  {
+    if(!m_Rewrite && m_Added.empty())
+      return;
 
-  FILE *f = FileIO::fopen(shadercache.c_str(), "wb");
+    if(m_Rewrite || m_Appended.size() + m_Added.size() > MaxAppendedEntries)
+      Rewrite();
+    else
+      Append();
+  }
 
-  if(!f)
+  void WriteBlob(FILE *f, const byte *data, uint32_t length)
   {
-    RDCERR("Error opening shader cache for write");
-    return;
+    static const byte padding[4] = {};
+
+    FileIO::fwrite(data, 1, length, f);
+    FileIO::fwrite(padding, 1, AlignUp4(length) - length, f);
   }
 
-  FileIO::fwrite(&magicNumber, 1, sizeof(magicNumber), f);
-  FileIO::fwrite(&versionNumber, 1, sizeof(versionNumber), f);
-  uint32_t numentries = (uint32_t)cache.size();
-  FileIO::fwrite(&numentries, 1, sizeof(numentries), f);
+  void Append()
+  {
+    // the file can't be modified while it's mapped
+    FileIO::UnmapFile(m_Data, m_Size);
+    m_Data = NULL;
+    m_Index = NULL;
+
+    // other programs may have appended to the file since we mapped it, so open it for appending
+    // which always writes at the real end of the file, and lock it so entries can't interleave.
+    FILE *f = FileIO::fopen(m_Filename.c_str(), "a+b");
+
+    if(!f)
+    {
+      RDCERR("Error opening shader cache for write");
+      return;
+    }
+
+    if(!FileIO::lockfile(f))
+    {
+      RDCERR("Couldn't lock shader cache for write");
+      FileIO::fclose(f);
+      return;
+    }
+
+    // the file could also have been rewritten for a different version in the meantime
+    FileHeader header = {};
+    FileIO::fseek64(f, 0, SEEK_SET);
+    FileIO::fread(&header, 1, sizeof(header), f);
+
+    if(header.fileMagic != FileMagic || header.magicNumber != m_MagicNumber ||
+       header.versionNumber != m_VersionNumber)
+    {
+      RDCDEBUG("Shader cache was replaced, not appending to it");
+      FileIO::fclose(f);
+      return;
+    }
 
-  for(auto it = cache.begin(); it != cache.end(); ++it)
+    // appended entries always end aligned, so the new ones will be too. Write them all at once so
+    // that a program exiting part-way through leaves at most one truncated entry at the end.
+    std::vector<byte> entries;
+
+    for(uint32_t hash : m_Added)
+    {
+      ResultType result = m_Results[hash];
+
+      const byte *data = m_Callbacks.GetData(result);
+      AppendedEntry appended = {hash, m_Callbacks.GetSize(result), 0};
+      appended.checksum = XXH32(data, appended.length, 0);
+
+      entries.insert(entries.end(), (const byte *)&appended, (const byte *)(&appended + 1));
+      entries.insert(entries.end(), data, data + appended.length);
+      entries.resize(AlignUp4(entries.size()));
+    }
+
+    // switching from reading to writing needs a seek, even though appends ignore the position
+    FileIO::fseek64(f, 0, SEEK_END);
+    FileIO::fwrite(entries.data(), 1, entries.size(), f);
+
+    FileIO::fclose(f);
+
+    RDCDEBUG("Appended %zu shaders to shader cache", m_Added.size());
+  }
+
+  void Rewrite()
   {
-    uint32_t hash = it->first;
-    uint32_t len = callbacks.GetSize(it->second);
-    const byte *data = callbacks.GetData(it->second);
-    FileIO::fwrite(&hash, 1, sizeof(hash), f);
-    FileIO::fwrite(&len, 1, sizeof(len), f);
-    FileIO::fwrite(data, 1, len, f);
-
-    callbacks.Destroy(it->second);
+    struct Blob
+    {
+      uint32_t length;
+      const byte *data;
+    };
+
+    // gather every entry, in hash order. Later entries replace earlier ones.
+    std::map<uint32_t, Blob> blobs;
+
+    for(uint32_t i = 0; i < m_NumIndexed; i++)
+    {
+      if(IsIndexEntryValid(m_Index[i]))
+        blobs[m_Index[i].hash] = {m_Index[i].length, m_Data + m_Index[i].offset};
+    }
+
+    for(auto it = m_Appended.begin(); it != m_Appended.end(); ++it)
+      blobs[it->first] = {it->second.length, m_Data + it->second.offset};
+
+    for(uint32_t hash : m_Added)
+    {
+      ResultType result = m_Results[hash];
+      blobs[hash] = {m_Callbacks.GetSize(result), m_Callbacks.GetData(result)};
+    }
+
+    // write to a new file, since we're reading from the old one. Other programs could be rewriting
+    // at the same time, so the name is unique to this one.
+    std::string tmpFilename = m_Filename + StringFormat::Fmt(".%u.tmp", Process::GetCurrentPID());
+
+    FILE *f = FileIO::fopen(tmpFilename.c_str(), "wb");
+
+    if(!f)
+    {
+      RDCERR("Error opening shader cache for write");
+      return;
+    }
+
+    FileHeader header = {};
+    header.fileMagic = FileMagic;
+    header.magicNumber = m_MagicNumber;
+    header.versionNumber = m_VersionNumber;
+    header.numIndexed = (uint32_t)blobs.size();
+
+    uint64_t offs = sizeof(header) + blobs.size() * sizeof(IndexEntry);
+
+    std::vector<IndexEntry> index;
+    index.reserve(blobs.size());
+
+    for(auto it = blobs.begin(); it != blobs.end(); ++it)
+    {
+      index.push_back({it->first, it->second.length, offs});
+      offs += AlignUp4(it->second.length);
+    }
+
+    header.appendOffset = offs;
+
+    FileIO::fwrite(&header, 1, sizeof(header), f);
+    FileIO::fwrite(index.data(), sizeof(IndexEntry), index.size(), f);
+
+    for(auto it = blobs.begin(); it != blobs.end(); ++it)
+      WriteBlob(f, it->second.data, it->second.length);
+
+    FileIO::fclose(f);
+
+    FileIO::UnmapFile(m_Data, m_Size);
+    m_Data = NULL;
+    m_Index = NULL;
+
+    if(!FileIO::Move(tmpFilename.c_str(), m_Filename.c_str(), true))
+    {
+      RDCERR("Couldn't replace shader cache");
+      FileIO::Delete(tmpFilename.c_str());
+      return;
+    }
+
+    RDCDEBUG("Successfully wrote %u shaders to shader cache", header.numIndexed);
   }
 
-  FileIO::fclose(f);
+  const ShaderCallbacks &m_Callbacks;
+  uint32_t m_MagicNumber, m_VersionNumber;
+  std::string m_Filename;
+
+  const byte *m_Data = NULL;
+  uint64_t m_Size = 0;
+
+  const IndexEntry *m_Index = NULL;
+  uint32_t m_NumIndexed = 0;
+  // indexed entries must lie before this offset
+  uint64_t m_IndexedDataEnd = 0;
+  std::map<uint32_t, IndexEntry> m_Appended;
+
+  bool m_Rewrite = false;
 
-  RDCDEBUG("Successfully wrote %u shaders to shader cache", numentries);
-}
+  // every blob that's been looked up or added
+  std::map<uint32_t, ResultType> m_Results;
+  // hashes added since the cache was loaded
+  std::set<uint32_t> m_Added;
+};
@@ -0,0 +1,229 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "shader_cache.h"
+
+typedef std::vector<uint32_t> *TestBlob;
+
+struct TestBlobCallbacks
+{
+  bool Create(uint32_t size, byte *data, TestBlob *ret) const
+  {
+    *ret = new std::vector<uint32_t>(size / sizeof(uint32_t));
+    memcpy((*ret)->data(), data, size);
+    return true;
+  }
+
+  void Destroy(TestBlob blob) const { delete blob; }
+  uint32_t GetSize(TestBlob blob) const { return (uint32_t)(blob->size() * sizeof(uint32_t)); }
+  const byte *GetData(TestBlob blob) const { return (const byte *)blob->data(); }
+} TestCallbacks;
+
+typedef PersistentShaderCache<TestBlob, TestBlobCallbacks> TestShaderCache;
+
+static TestBlob MakeBlob(uint32_t hash, uint32_t value)
+{
+  // vary the sizes so entries aren't all at regular offsets
+  return new std::vector<uint32_t>(1 + hash % 13, value);
+}
+
+static bool CheckBlob(TestShaderCache &cache, uint32_t hash, uint32_t value)
+{
+  TestBlob blob = NULL;
+  if(!cache.Find(hash, blob))
+    return false;
+
+  return *blob == std::vector<uint32_t>(1 + hash % 13, value);
+}
+
+TEST_CASE("Check persistent shader cache", "[shadercache]")
+{
+  std::string filename = FileIO::GetTempFolderFilename() + "renderdoc_shader_cache_test.cache";
+  const char *testCacheName = filename.c_str();
+  FileIO::Delete(testCacheName);
+
+  // written out fresh, with everything in the index
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(0, blob));
+
+    for(uint32_t i = 0; i < 100; i++)
+      cache.Insert(i * 7, MakeBlob(i * 7, i));
+
+    CHECK(CheckBlob(cache, 7, 1));
+  }
+
+  uint64_t size = 0;
+
+  {
+    FILE *f = FileIO::fopen(filename.c_str(), "rb");
+    REQUIRE(f);
+    FileIO::fseek64(f, 0, SEEK_END);
+    size = FileIO::ftell64(f);
+    FileIO::fclose(f);
+  }
+
+  // new and replaced entries are appended
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    for(uint32_t i = 0; i < 100; i++)
+      CHECK(CheckBlob(cache, i * 7, i));
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(1, blob));
+
+    cache.Insert(1, MakeBlob(1, 1000));
+    cache.Insert(14, MakeBlob(14, 1001));
+  }
+
+  {
+    FILE *f = FileIO::fopen(filename.c_str(), "rb");
+    REQUIRE(f);
+    FileIO::fseek64(f, 0, SEEK_END);
+    uint64_t newSize = FileIO::ftell64(f);
+    FileIO::fclose(f);
+
+    // only the two entries were added, each with a hash, length and checksum before its two words
+    // of data
+    CHECK(newSize == size + 2 * (sizeof(uint32_t) * 3 + sizeof(uint32_t) * 2));
+  }
+
+  // caches open at the same time both append to the end, rather than over each other
+  {
+    TestShaderCache *a = new TestShaderCache(testCacheName, 0x1234, 1, TestCallbacks);
+    TestShaderCache *b = new TestShaderCache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    a->Insert(2, MakeBlob(2, 1002));
+    b->Insert(9, MakeBlob(9, 1003));
+
+    delete a;
+    delete b;
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    CHECK(CheckBlob(cache, 1, 1000));
+    CHECK(CheckBlob(cache, 2, 1002));
+    CHECK(CheckBlob(cache, 9, 1003));
+  }
+
+  // corrupting the last appended entry drops it, but keeps everything before it
+  {
+    FILE *f = FileIO::fopen(testCacheName, "r+b");
+    REQUIRE(f);
+    FileIO::fseek64(f, 0, SEEK_END);
+    uint64_t end = FileIO::ftell64(f);
+    FileIO::fseek64(f, end - sizeof(uint32_t), SEEK_SET);
+    uint32_t garbage = 0xdeadbeef;
+    FileIO::fwrite(&garbage, 1, sizeof(garbage), f);
+    FileIO::fclose(f);
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    CHECK(CheckBlob(cache, 2, 1002));
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(9, blob));
+
+    cache.Insert(9, MakeBlob(9, 1003));
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    CHECK(CheckBlob(cache, 1, 1000));
+    CHECK(CheckBlob(cache, 14, 1001));
+    CHECK(CheckBlob(cache, 21, 3));
+    CHECK(CheckBlob(cache, 9, 1003));
+
+    // enough new entries that the file is rewritten
+    for(uint32_t i = 0; i < 300; i++)
+      cache.Insert(i * 7 + 3, MakeBlob(i * 7 + 3, i + 2000));
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    CHECK(CheckBlob(cache, 1, 1000));
+    CHECK(CheckBlob(cache, 14, 1001));
+
+    for(uint32_t i = 0; i < 100; i++)
+      CHECK(CheckBlob(cache, i * 7, i == 2 ? 1001 : i));
+
+    for(uint32_t i = 0; i < 300; i++)
+      CHECK(CheckBlob(cache, i * 7 + 3, i + 2000));
+  }
+
+  // an indexed entry pointing outside the file is rejected when it's looked up, and dropped when
+  // the file is next written. Hash 0 sorts first, so it's the first index entry after the header.
+  {
+    FILE *f = FileIO::fopen(testCacheName, "r+b");
+    REQUIRE(f);
+    FileIO::fseek64(f, sizeof(uint32_t) * 4 + sizeof(uint64_t) + sizeof(uint32_t) * 2, SEEK_SET);
+    uint64_t offset = ~0ULL;
+    FileIO::fwrite(&offset, 1, sizeof(offset), f);
+    FileIO::fclose(f);
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(0, blob));
+    CHECK(CheckBlob(cache, 7, 1));
+  }
+
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 1, TestCallbacks);
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(0, blob));
+    CHECK(CheckBlob(cache, 7, 1));
+    CHECK(CheckBlob(cache, 1, 1000));
+  }
+
+  // a different version ignores the cache entirely
+  {
+    TestShaderCache cache(testCacheName, 0x1234, 2, TestCallbacks);
+
+    TestBlob blob = NULL;
+    CHECK_FALSE(cache.Find(7, blob));
+  }
+
+  FileIO::Delete(testCacheName);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,304 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+#include "common.h"
+
+// Unordered set and map for small plain keys such as ResourceIds, handles and pointers, used on
+// hot paths that would otherwise allocate a tree node per insert.
+//
+// Entries are stored in an open-addressed table with linear probing. The first InlineCount slots
+// live inside the object itself, so small tables never touch the heap, and a table that has grown
+// keeps its allocation when cleared so it can be reused without allocating again.
+//
+// The default-constructed key (ResourceId(), NULL, VK_NULL_HANDLE) marks an empty slot, so it is
+// never stored - inserting it is ignored. Iteration order is unspecified, and any insert may
+// invalidate iterators and references.
+template <typename Key, typename Entry, size_t InlineCount>
+class SmallHashTable
+{
+  static_assert(InlineCount >= 4 && (InlineCount & (InlineCount - 1)) == 0,
+                "Inline count must be a power of two");
+  static_assert(sizeof(Key) <= sizeof(uint64_t), "Keys must fit in 64 bits to be hashed");
+
+public:
+  template <typename EntryType, typename TableType>
+  class iterator_base
+  {
+  public:
+    iterator_base(TableType *t, size_t i) : table(t), idx(i) { skip(); }
+    EntryType &operator*() const { return table->m_Entries[idx]; }
+    EntryType *operator->() const { return &table->m_Entries[idx]; }
+    iterator_base &operator++()
+    {
+      idx++;
+      skip();
+      return *this;
+    }
+    bool operator==(const iterator_base &o) const { return idx == o.idx; }
+    bool operator!=(const iterator_base &o) const { return idx != o.idx; }
+  private:
+    friend class SmallHashTable;
+
+    void skip()
+    {
+      while(idx < table->m_Capacity && IsEmpty(table->m_Entries[idx]))
+        idx++;
+    }
+
+    TableType *table;
+    size_t idx;
+  };
+
+  typedef iterator_base<Entry, SmallHashTable> iterator;
+  typedef iterator_base<const Entry, const SmallHashTable> const_iterator;
+
+  SmallHashTable() : m_Entries(m_Inline), m_Capacity(InlineCount), m_Count(0) {}
+  SmallHashTable(const SmallHashTable &o) : SmallHashTable() { *this = o; }
+  ~SmallHashTable()
+  {
+    if(m_Entries != m_Inline)
+      delete[] m_Entries;
+  }
+
+  SmallHashTable &operator=(const SmallHashTable &o)
+  {
+    if(this == &o)
+      return *this;
+
+    clear();
+    Reserve(o.m_Count);
+    for(size_t i = 0; i < o.m_Capacity; i++)
+      if(!IsEmpty(o.m_Entries[i]))
+        Insert(o.m_Entries[i]);
+
+    return *this;
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, m_Capacity); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, m_Capacity); }
+  size_t size() const { return m_Count; }
+  bool empty() const { return m_Count == 0; }
+  size_t count(const Key &key) const { return Find(key) == m_Capacity ? 0 : 1; }
+  iterator find(const Key &key) { return iterator(this, Find(key)); }
+  const_iterator find(const Key &key) const { return const_iterator(this, Find(key)); }
+  // clears all entries, but keeps any heap storage for re-use.
+  void clear()
+  {
+    if(m_Count == 0)
+      return;
+
+    for(size_t i = 0; i < m_Capacity; i++)
+      m_Entries[i] = Entry();
+    m_Count = 0;
+  }
+
+  void erase(iterator it)
+  {
+    size_t hole = it.idx;
+
+    if(hole >= m_Capacity)
+      return;
+
+    // shift back any following entries in the same probe run that would no longer be found once
+    // there's a gap in front of them.
+    const size_t mask = m_Capacity - 1;
+    for(size_t next = (hole + 1) & mask; !IsEmpty(m_Entries[next]); next = (next + 1) & mask)
+    {
+      size_t home = Hash(GetKey(m_Entries[next])) & mask;
+
+      // leave the entry alone if its home slot is cyclically after the hole
+      bool afterHole = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+      if(afterHole)
+        continue;
+
+      m_Entries[hole] = m_Entries[next];
+      hole = next;
+    }
+
+    m_Entries[hole] = Entry();
+    m_Count--;
+  }
+
+  void swap(SmallHashTable &o)
+  {
+    bool inlineA = m_Entries == m_Inline;
+    bool inlineB = o.m_Entries == o.m_Inline;
+
+    std::swap(m_Inline, o.m_Inline);
+    std::swap(m_Entries, o.m_Entries);
+    std::swap(m_Capacity, o.m_Capacity);
+    std::swap(m_Count, o.m_Count);
+
+    if(inlineA)
+      o.m_Entries = o.m_Inline;
+    if(inlineB)
+      m_Entries = m_Inline;
+  }
+
+protected:
+  static const Key &GetKey(const Key &k) { return k; }
+  template <typename Value>
+  static const Key &GetKey(const std::pair<Key, Value> &e)
+  {
+    return e.first;
+  }
+
+  static bool IsEmpty(const Entry &e) { return GetKey(e) == Key(); }
+  static size_t Hash(const Key &key)
+  {
+    uint64_t v = 0;
+    memcpy(&v, &key, sizeof(Key));
+
+    // IDs are sequential and pointers are aligned, so mix the bits before masking off the low ones
+    v *= 0x9E3779B97F4A7C15ULL;
+    return size_t(v ^ (v >> 32));
+  }
+
+  size_t Find(const Key &key) const
+  {
+    if(key == Key())
+      return m_Capacity;
+
+    const size_t mask = m_Capacity - 1;
+    for(size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+    {
+      const Key &k = GetKey(m_Entries[i]);
+      if(k == key)
+        return i;
+      if(k == Key())
+        return m_Capacity;
+    }
+  }
+
+  // returns the index of the entry and whether it was newly inserted. The entry must not be empty.
+  std::pair<size_t, bool> Insert(const Entry &entry)
+  {
+    const Key &key = GetKey(entry);
+
+    size_t mask = m_Capacity - 1;
+    size_t i = Hash(key) & mask;
+    for(; !IsEmpty(m_Entries[i]); i = (i + 1) & mask)
+    {
+      if(GetKey(m_Entries[i]) == key)
+        return std::make_pair(i, false);
+    }
+
+    // keep the load factor under 3/4 so probe runs stay short
+    if((m_Count + 1) * 4 > m_Capacity * 3)
+    {
+      Rehash(m_Capacity * 2);
+
+      mask = m_Capacity - 1;
+      for(i = Hash(key) & mask; !IsEmpty(m_Entries[i]); i = (i + 1) & mask)
+        ;
+    }
+
+    m_Entries[i] = entry;
+    m_Count++;
+    return std::make_pair(i, true);
+  }
+
+  void Reserve(size_t count)
+  {
+    size_t capacity = m_Capacity;
+    while(count * 4 > capacity * 3)
+      capacity *= 2;
+
+    if(capacity != m_Capacity)
+      Rehash(capacity);
+  }
+
+  void Rehash(size_t capacity)
+  {
+    Entry *oldEntries = m_Entries;
+    size_t oldCapacity = m_Capacity;
+
+    m_Entries = new Entry[capacity]();
+    m_Capacity = capacity;
+    m_Count = 0;
+
+    for(size_t i = 0; i < oldCapacity; i++)
+      if(!IsEmpty(oldEntries[i]))
+        Insert(oldEntries[i]);
+
+    if(oldEntries != m_Inline)
+      delete[] oldEntries;
+  }
+
+  Entry m_Inline[InlineCount] = {};
+  Entry *m_Entries;
+  size_t m_Capacity;
+  size_t m_Count;
+};
+
+template <typename Key, size_t InlineCount = 16>
+class SmallHashSet : public SmallHashTable<Key, Key, InlineCount>
+{
+  typedef SmallHashTable<Key, Key, InlineCount> Base;
+
+public:
+  // only const iteration is allowed, modifying a key in place would corrupt the table
+  typedef typename Base::const_iterator iterator;
+
+  iterator begin() const { return Base::begin(); }
+  iterator end() const { return Base::end(); }
+  iterator find(const Key &key) const { return Base::find(key); }
+  bool insert(const Key &key)
+  {
+    if(key == Key())
+      return false;
+
+    return Base::Insert(key).second;
+  }
+
+  template <typename It>
+  void insert(It first, It last)
+  {
+    for(; first != last; ++first)
+      insert(*first);
+  }
+};
+
+template <typename Key, typename Value, size_t InlineCount = 8>
+class SmallHashMap : public SmallHashTable<Key, std::pair<Key, Value>, InlineCount>
+{
+  typedef SmallHashTable<Key, std::pair<Key, Value>, InlineCount> Base;
+
+public:
+  // inserts a default-constructed value if the key isn't present. The key must not be the empty
+  // key.
+  Value &operator[](const Key &key)
+  {
+    RDCASSERT(key != Key());
+    size_t idx = Base::Insert(std::make_pair(key, Value())).first;
+    return Base::m_Entries[idx].second;
+  }
+};
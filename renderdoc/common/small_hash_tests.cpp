@@ -0,0 +1,224 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include <map>
+#include <set>
+#include "3rdparty/catch/catch.hpp"
+#include "api/replay/renderdoc_replay.h"
+#include "small_hash.h"
+
+template <typename SetType>
+static bool SameContents(const SetType &a, const std::set<ResourceId> &b)
+{
+  if(a.size() != b.size())
+    return false;
+
+  for(ResourceId id : a)
+    if(b.find(id) == b.end())
+      return false;
+
+  return true;
+}
+
+TEST_CASE("Check small hash set and map", "[smallhash]")
+{
+  std::vector<ResourceId> ids;
+  for(int i = 0; i < 1000; i++)
+    ids.push_back(ResourceIDGen::GetNewUniqueID());
+
+  SECTION("Set insert, find, clear")
+  {
+    SmallHashSet<ResourceId> set;
+    std::set<ResourceId> reference;
+
+    CHECK(set.empty());
+    CHECK_FALSE(set.insert(ResourceId()));
+    CHECK(set.empty());
+
+    // stay within the inline storage, then grow onto the heap
+    for(size_t i = 0; i < ids.size(); i += 3)
+    {
+      CHECK(set.insert(ids[i]));
+      CHECK_FALSE(set.insert(ids[i]));
+      reference.insert(ids[i]);
+
+      if(i == 9 || i == 999)
+        CHECK(SameContents(set, reference));
+    }
+
+    for(size_t i = 0; i < ids.size(); i++)
+      CHECK((set.find(ids[i]) != set.end()) == (i % 3 == 0));
+
+    set.clear();
+    CHECK(set.empty());
+    CHECK((set.begin() == set.end()));
+    CHECK((set.find(ids[0]) == set.end()));
+
+    set.insert(ids.begin(), ids.begin() + 100);
+    reference.clear();
+    reference.insert(ids.begin(), ids.begin() + 100);
+    CHECK(SameContents(set, reference));
+  }
+
+  SECTION("Set swap between inline and heap storage")
+  {
+    SmallHashSet<ResourceId> small, large;
+    std::set<ResourceId> smallRef, largeRef;
+
+    small.insert(ids.begin(), ids.begin() + 5);
+    smallRef.insert(ids.begin(), ids.begin() + 5);
+    large.insert(ids.begin() + 100, ids.begin() + 400);
+    largeRef.insert(ids.begin() + 100, ids.begin() + 400);
+
+    small.swap(large);
+    CHECK(SameContents(small, largeRef));
+    CHECK(SameContents(large, smallRef));
+
+    // swap back, and check both still work after further inserts
+    small.swap(large);
+    small.insert(ids[900]);
+    smallRef.insert(ids[900]);
+    large.insert(ids[901]);
+    largeRef.insert(ids[901]);
+    CHECK(SameContents(small, smallRef));
+    CHECK(SameContents(large, largeRef));
+
+    SmallHashSet<ResourceId> copy = large;
+    CHECK(SameContents(copy, largeRef));
+  }
+
+  SECTION("Map refcounting with erase")
+  {
+    SmallHashMap<ResourceId, uint32_t> map;
+    std::map<ResourceId, uint32_t> reference;
+
+    // add and remove references in an interleaved pattern so that erases happen in the middle of
+    // probe runs
+    for(int pass = 0; pass < 4; pass++)
+    {
+      for(size_t i = 0; i < ids.size(); i++)
+      {
+        if((i + pass) % 2 == 0)
+        {
+          map[ids[i]]++;
+          reference[ids[i]]++;
+        }
+        else
+        {
+          auto it = map.find(ids[i]);
+          auto refit = reference.find(ids[i]);
+
+          REQUIRE((it == map.end()) == (refit == reference.end()));
+
+          if(it == map.end())
+            continue;
+
+          it->second--;
+          refit->second--;
+
+          if(it->second == 0)
+          {
+            map.erase(it);
+            reference.erase(refit);
+          }
+        }
+      }
+
+      REQUIRE(map.size() == reference.size());
+
+      for(auto it = reference.begin(); it != reference.end(); ++it)
+      {
+        auto found = map.find(it->first);
+        REQUIRE((found != map.end()));
+        CHECK(found->second == it->second);
+      }
+    }
+  }
+};
+
+// roughly what a command buffer records per draw: a couple of descriptor set binds, some dirtied
+// resources and the occasional sparse resource, all out of a working set that's re-used heavily.
+template <typename IDSetType, typename HandleSetType>
+static void RecordDraws(uint32_t numDraws, const std::vector<ResourceId> &ids,
+                        const std::vector<void *> &handles, IDSetType &dirtied,
+                        HandleSetType &boundDescSets, HandleSetType &sparse)
+{
+  for(uint32_t draw = 0; draw < numDraws; draw++)
+  {
+    boundDescSets.insert(handles[(draw * 7) % handles.size()]);
+    boundDescSets.insert(handles[(draw * 13 + 1) % handles.size()]);
+    dirtied.insert(ids[(draw * 3) % ids.size()]);
+    dirtied.insert(ids[(draw * 11 + 5) % ids.size()]);
+    if(draw % 64 == 0)
+      sparse.insert(handles[draw % 16]);
+  }
+}
+
+TEST_CASE("Benchmark command buffer reference tracking", "[smallhash][!benchmark]")
+{
+  const uint32_t numDraws = 100000;
+
+  std::vector<ResourceId> ids;
+  for(int i = 0; i < 2048; i++)
+    ids.push_back(ResourceIDGen::GetNewUniqueID());
+
+  std::vector<void *> handles;
+  for(uintptr_t i = 1; i <= 512; i++)
+    handles.push_back((void *)(i * 64));
+
+  BENCHMARK("Record 100k draws: std::set")
+  {
+    std::set<ResourceId> dirtied;
+    std::set<void *> boundDescSets, sparse;
+    RecordDraws(numDraws, ids, handles, dirtied, boundDescSets, sparse);
+  }
+
+  BENCHMARK("Record 100k draws: SmallHashSet")
+  {
+    SmallHashSet<ResourceId> dirtied;
+    SmallHashSet<void *> boundDescSets, sparse;
+    RecordDraws(numDraws, ids, handles, dirtied, boundDescSets, sparse);
+  }
+
+  // command buffers are re-recorded every frame, and the sets are cleared and re-used
+  SmallHashSet<ResourceId> dirtied;
+  SmallHashSet<void *> boundDescSets, sparse;
+  RecordDraws(numDraws, ids, handles, dirtied, boundDescSets, sparse);
+
+  BENCHMARK("Re-record 100k draws: SmallHashSet")
+  {
+    dirtied.clear();
+    boundDescSets.clear();
+    sparse.clear();
+    RecordDraws(numDraws, ids, handles, dirtied, boundDescSets, sparse);
+  }
+
+  CHECK(dirtied.size() == ids.size());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,280 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "threading.h"
+#include "common/common.h"
+
+namespace Threading
+{
+struct JobPool::Job
+{
+  enum State
+  {
+    Queued,
+    Running,
+    Done,
+  };
+
+  std::function<void()> func;
+  State state = Queued;
+
+  // woken by the worker once the job is done, if it ran it. Each waiter wakes it again for the next.
+  Semaphore done;
+};
+
+JobPool::JobPool(uint32_t numThreads, size_t maxQueued) : m_MaxQueued(RDCMAX((size_t)1, maxQueued))
+{
+  for(uint32_t i = 0; i < numThreads; i++)
+    m_Threads.push_back(Threading::CreateThread([this]() { WorkerThread(); }));
+}
+
+JobPool::~JobPool()
+{
+  {
+    SCOPED_LOCK(m_Lock);
+    m_Shutdown = true;
+  }
+
+  m_WorkAvailable.Wake((uint32_t)m_Threads.size());
+
+  for(ThreadHandle t : m_Threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+}
+
+JobPool &JobPool::Shared()
+{
+  static JobPool *pool = new JobPool(RDCMAX(1U, Threading::GetNumCores() - 1), 256);
+  return *pool;
+}
+
+bool JobPool::Claim(Job *job)
+{
+  SCOPED_LOCK(m_Lock);
+
+  if(job->state != Job::Queued)
+    return false;
+
+  job->state = Job::Running;
+  return true;
+}
+
+void JobPool::Complete(Job *job)
+{
+  // release anything the function captured now, rather than whenever the last handle goes
+  job->func = std::function<void()>();
+
+  SCOPED_LOCK(m_Lock);
+  job->state = Job::Done;
+}
+
+void JobPool::WorkerThread()
+{
+  for(;;)
+  {
+    m_WorkAvailable.Wait();
+
+    JobHandle job;
+
+    {
+      SCOPED_LOCK(m_Lock);
+
+      if(m_Queue.empty())
+      {
+        if(m_Shutdown)
+          return;
+        continue;
+      }
+
+      job = m_Queue.front();
+      m_Queue.pop_front();
+
+      // skip jobs that a waiting thread has already taken to run itself
+      if(job->state != Job::Queued)
+        continue;
+
+      job->state = Job::Running;
+    }
+
+    job->func();
+
+    Complete(job.get());
+    job->done.Wake();
+  }
+}
+
+JobPool::JobHandle JobPool::Submit(std::function<void()> func)
+{
+  JobHandle job = std::make_shared<Job>();
+  job->func = std::move(func);
+
+  bool queued = false;
+
+  {
+    SCOPED_LOCK(m_Lock);
+    if(!m_Threads.empty() && m_Queue.size() < m_MaxQueued)
+    {
+      m_Queue.push_back(job);
+      queued = true;
+    }
+  }
+
+  if(queued)
+  {
+    m_WorkAvailable.Wake();
+  }
+  else
+  {
+    job->state = Job::Running;
+    job->func();
+    Complete(job.get());
+  }
+
+  return job;
+}
+
+void JobPool::Wait(const JobHandle &job)
+{
+  if(!job)
+    return;
+
+  if(Claim(job.get()))
+  {
+    job->func();
+    Complete(job.get());
+    job->done.Wake();
+    return;
+  }
+
+  bool done = false;
+  {
+    SCOPED_LOCK(m_Lock);
+    done = (job->state == Job::Done);
+  }
+
+  if(!done)
+  {
+    job->done.Wait();
+    job->done.Wake();
+  }
+}
+
+void JobPool::ParallelFor(size_t count, uint32_t numJobs, const std::function<void(size_t)> &func)
+{
+  if(count == 0)
+    return;
+
+  // jobs pull indices from a shared counter until they run out, so uneven work balances itself
+  volatile int64_t next = 0;
+
+  auto work = [&next, count, &func]() {
+    for(;;)
+    {
+      int64_t i = Atomic::Inc64(&next) - 1;
+      if(i >= (int64_t)count)
+        return;
+      func((size_t)i);
+    }
+  };
+
+  numJobs = (uint32_t)RDCMIN((size_t)RDCMIN(numJobs, GetNumThreads()), count - 1);
+
+  std::vector<JobHandle> jobs;
+  for(uint32_t j = 0; j < numJobs; j++)
+    jobs.push_back(Submit(work));
+
+  work();
+
+  for(JobHandle &job : jobs)
+    Wait(job);
+}
+};
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check job pool", "[threading]")
+{
+  SECTION("Jobs run on workers and when waited on")
+  {
+    Threading::JobPool pool(2, 4);
+
+    volatile int32_t ran[64] = {};
+    std::vector<Threading::JobPool::JobHandle> jobs;
+
+    // more jobs than the queue holds, so some run inline during Submit
+    for(int i = 0; i < 64; i++)
+      jobs.push_back(pool.Submit([&ran, i]() { Atomic::Inc32(&ran[i]); }));
+
+    for(Threading::JobPool::JobHandle &job : jobs)
+      pool.Wait(job);
+
+    // waiting again on a completed job returns immediately
+    for(Threading::JobPool::JobHandle &job : jobs)
+      pool.Wait(job);
+
+    for(int i = 0; i < 64; i++)
+      CHECK(ran[i] == 1);
+  };
+
+  SECTION("Waiting from inside a job doesn't deadlock")
+  {
+    Threading::JobPool pool(1, 16);
+
+    volatile int32_t inner = 0;
+
+    // the only worker is busy running the outer job, so the inner one must run when waited on
+    Threading::JobPool::JobHandle outer = pool.Submit([&pool, &inner]() {
+      Threading::JobPool::JobHandle job = pool.Submit([&inner]() { Atomic::Inc32(&inner); });
+      pool.Wait(job);
+    });
+
+    pool.Wait(outer);
+
+    CHECK(inner == 1);
+  };
+
+  SECTION("ParallelFor visits every index once")
+  {
+    std::vector<int32_t> visited(1000);
+
+    Threading::JobPool::Shared().ParallelFor(
+        visited.size(), 8, [&visited](size_t i) { Atomic::Inc32((volatile int32_t *)&visited[i]); });
+
+    for(size_t i = 0; i < visited.size(); i++)
+      CHECK(visited[i] == 1);
+
+    // with a pool that has no workers, everything runs inline
+    Threading::JobPool empty(0, 4);
+    empty.ParallelFor(visited.size(), 8, [&visited](size_t i) { visited[i]++; });
+
+    for(size_t i = 0; i < visited.size(); i++)
+      CHECK(visited[i] == 2);
+  };
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -25,6 +25,10 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
 #include "os/os_specific.h"
 
 namespace Threading
@@ -53,6 +57,76 @@ private:
   CriticalSection *m_CS;
   bool m_Owned;
 };
+
+class ScopedReadLock
+{
+public:
+  ScopedReadLock(RWLock &rw) : m_RW(&rw) { m_RW->ReadLock(); }
+  ~ScopedReadLock() { m_RW->ReadUnlock(); }
+private:
+  RWLock *m_RW;
+};
+
+class ScopedWriteLock
+{
+public:
+  ScopedWriteLock(RWLock &rw) : m_RW(&rw) { m_RW->WriteLock(); }
+  ~ScopedWriteLock() { m_RW->WriteUnlock(); }
+private:
+  RWLock *m_RW;
+};
+
+// A fixed set of worker threads that run short independent jobs, so work that's split across
+// threads doesn't create and destroy a thread for every piece.
+//
+// The queue is bounded - once it's full, Submit() runs the job immediately on the calling thread
+// instead of queueing it, so a producer that runs ahead of the workers does some of the work
+// itself rather than queueing up unbounded amounts of memory.
+class JobPool
+{
+public:
+  struct Job;
+  typedef std::shared_ptr<Job> JobHandle;
+
+  JobPool(uint32_t numThreads, size_t maxQueued);
+  ~JobPool();
+
+  // the pool shared across renderdoc, with a worker for each core but one. It's never destroyed,
+  // since its threads can't be safely joined while the module is unloading - they just sleep.
+  static JobPool &Shared();
+
+  uint32_t GetNumThreads() const { return (uint32_t)m_Threads.size(); }
+  JobHandle Submit(std::function<void()> func);
+
+  // waits for a job to complete. If no worker has started it yet, it's run on this thread instead
+  // so that waiting from within a job can't deadlock.
+  void Wait(const JobHandle &job);
+
+  // calls func for each index in [0, count) on up to numJobs jobs, with this thread helping.
+  // Returns once all have completed.
+  void ParallelFor(size_t count, uint32_t numJobs, const std::function<void(size_t)> &func);
+
+private:
+  // no copying
+  JobPool &operator=(const JobPool &other);
+  JobPool(const JobPool &other);
+
+  void WorkerThread();
+  bool Claim(Job *job);
+  void Complete(Job *job);
+
+  std::vector<ThreadHandle> m_Threads;
+  size_t m_MaxQueued;
+
+  CriticalSection m_Lock;
+  std::deque<JobHandle> m_Queue;
+  bool m_Shutdown = false;
+
+  // woken once for each job queued, and once for each thread on shutdown
+  Semaphore m_WorkAvailable;
+};
 };
 
 #define SCOPED_LOCK(cs) Threading::ScopedLock CONCAT(scopedlock, __LINE__)(cs);
+#define SCOPED_READLOCK(rw) Threading::ScopedReadLock CONCAT(scopedlock, __LINE__)(rw);
+#define SCOPED_WRITELOCK(rw) Threading::ScopedWriteLock CONCAT(scopedlock, __LINE__)(rw);
@@ -49,27 +49,43 @@ public:
 };
 
 // allocate each class in its own pool so we can identify the type by the pointer
+//
+// Allocation, deallocation and IsAlloc are all lock-free. Each pool tracks its slots in a bitmap
+// which is claimed and released with atomic compare-exchanges, and additional pools are kept in
+// a list that is only ever appended to. Only creating a new additional pool takes a lock.
 template <typename WrapType, int PoolCount = 8192, int MaxPoolByteSize = 1024 * 1024, bool DebugClear = true>
 class WrappingPool
 {
 public:
   void *Allocate()
   {
-    SCOPED_LOCK(m_Lock);
-
     // try and allocate from immediate pool
     void *ret = m_ImmediatePool.Allocate();
     if(ret != NULL)
       return ret;
 
     // fall back to additional pools, if there are any
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+    for(ItemPool *pool = m_ImmediatePool.next; pool; pool = pool->next)
     {
-      ret = m_AdditionalPools[i]->Allocate();
+      ret = pool->Allocate();
       if(ret != NULL)
         return ret;
     }
 
+    SCOPED_LOCK(m_Lock);
+
+    // another thread may have added a pool while we were looking, so check again now that no more
+    // can be added
+    ItemPool *last = &m_ImmediatePool;
+    for(ItemPool *pool = m_ImmediatePool.next; pool; pool = pool->next)
+    {
+      ret = pool->Allocate();
+      if(ret != NULL)
+        return ret;
+
+      last = pool;
+    }
+
 // warn when we need to allocate an additional pool
 #if ENABLED(INCLUDE_TYPE_NAMES)
     RDCWARN("Ran out of free slots in %s pool!", GetTypeName<WrapType>::Name());
@@ -77,34 +93,29 @@ public:
     RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
 #endif
 
-    // allocate a new additional pool and use that to allocate from
-    m_AdditionalPools.push_back(new ItemPool());
+    // allocate a new additional pool and use that to allocate from. Allocate before publishing it
+    // so that other threads don't fill it up before we get a slot.
+    ItemPool *pool = new ItemPool();
+    ret = pool->Allocate();
+
+    m_NumAdditionalPools++;
 
 #if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", (uint32_t)m_AdditionalPools.size() - 1,
-             GetTypeName<WrapType>::Name(), &m_AdditionalPools.back()->items[0],
-             &m_AdditionalPools.back()->items[AllocCount - 1]);
+    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", m_NumAdditionalPools - 1,
+             GetTypeName<WrapType>::Name(), &pool->items[0], &pool->items[AllocCount - 1]);
 #endif
 
-    return m_AdditionalPools.back()->Allocate();
+    // the exchange acts as a barrier, so the pool is fully constructed before anyone can see it
+    Atomic::CmpExchPtr((void *volatile *)&last->next, NULL, pool);
+
+    return ret;
   }
 
   bool IsAlloc(const void *p)
   {
-    // we can check the immediate pool without locking
-    if(m_ImmediatePool.IsAlloc(p))
-      return true;
-
-    // if we have additional pools, lock and check them.
-    // TODO: Check for additional pools in a lock-free manner,
-    // to prevent the cost of locking if there are no more pools.
-    {
-      SCOPED_LOCK(m_Lock);
-
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-        if(m_AdditionalPools[i]->IsAlloc(p))
-          return true;
-    }
+    for(ItemPool *pool = &m_ImmediatePool; pool; pool = pool->next)
+      if(pool->IsAlloc(p))
+        return true;
 
     return false;
   }
@@ -114,24 +125,12 @@ public:
     if(p == NULL)
       return;
 
-    SCOPED_LOCK(m_Lock);
-
-    // try immediate pool
-    if(m_ImmediatePool.IsAlloc(p))
+    for(ItemPool *pool = &m_ImmediatePool; pool; pool = pool->next)
     {
-      m_ImmediatePool.Deallocate(p);
-      return;
-    }
-    else if(!m_AdditionalPools.empty())
-    {
-      // fall back and try additional pools
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+      if(pool->IsAlloc(p))
       {
-        if(m_AdditionalPools[i]->IsAlloc(p))
-        {
-          m_AdditionalPools[i]->Deallocate(p);
-          return;
-        }
+        pool->Deallocate(p);
+        return;
       }
     }
 
@@ -162,53 +161,86 @@ private:
   }
   ~WrappingPool()
   {
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      delete m_AdditionalPools[i];
+    ItemPool *pool = m_ImmediatePool.next;
+    while(pool)
+    {
+      ItemPool *next = pool->next;
+      delete pool;
+      pool = next;
+    }
 
-    m_AdditionalPools.clear();
+    m_ImmediatePool.next = NULL;
   }
 
+  // only held while adding a new additional pool
   Threading::CriticalSection m_Lock;
+  int m_NumAdditionalPools = 0;
 
   struct ItemPool
   {
     ItemPool()
     {
-      lastAllocIdx = 0;
-      RDCEraseEl(allocated);
+      lastAllocWord = 0;
+      numAllocated = 0;
+      next = NULL;
+
+      for(int32_t i = 0; i < NumWords; i++)
+        allocated[i] = 0;
+
+      // mark the bits past the end of the pool as permanently allocated
+      if(PoolCount % 32)
+        allocated[NumWords - 1] = int32_t(~((1U << (PoolCount % 32)) - 1));
 
       items = (WrapType *)(new uint8_t[AllocCount * AllocByteSize]);
     }
     ~ItemPool() { delete[](uint8_t *) items; }
     void *Allocate()
     {
-      int lastAlloc = lastAllocIdx;
+      // quick out when the pool is full, so that falling through full pools is cheap. This is only
+      // a hint, if it's stale we'll either find nothing below or skip to another pool.
+      if(numAllocated >= PoolCount)
+        return NULL;
 
-      if(allocated[lastAlloc])
+      // start at the word we last allocated from. Good performance when the pool is empty or
+      // contiguously allocated, and it handles repeated new/free well by reallocating the same
+      // element.
+      int32_t word = lastAllocWord;
+
+      for(int32_t i = 0; i < NumWords; i++)
       {
-        int end = lastAlloc;
+        volatile int32_t *bits = &allocated[word];
 
-        do
-        {
-          lastAlloc = (lastAlloc + 1) % PoolCount;
-        } while(allocated[lastAlloc] && lastAlloc != end);
+        int32_t val = *bits;
 
-        if(allocated[lastAlloc])
+        // claim the lowest free bit in this word, retrying if another thread changed it first
+        while(val != -1)
         {
-          return NULL;
-        }
-      }
+          uint32_t bit = Bits::CountTrailingZeroes(~uint32_t(val));
+          int32_t newVal = int32_t(uint32_t(val) | (1U << bit));
+
+          int32_t prev = Atomic::CmpExch32(bits, val, newVal);
 
-      void *ret = (void *)&items[lastAlloc];
-      allocated[lastAlloc] = true;
+          if(prev == val)
+          {
+            lastAllocWord = word;
+            Atomic::Inc32(&numAllocated);
+
+            void *ret = (void *)&items[word * 32 + bit];
 
 #if ENABLED(RDOC_DEVEL)
-      memset(ret, 0xb0, AllocByteSize);
+            memset(ret, 0xb0, AllocByteSize);
 #endif
 
-      lastAllocIdx = lastAlloc;
+            return ret;
+          }
 
-      return ret;
+          val = prev;
+        }
+
+        word = (word + 1) % NumWords;
+      }
+
+      return NULL;
     }
 
     void Deallocate(void *p)
@@ -225,31 +257,49 @@ private:
 
       size_t idx = (WrapType *)p - &items[0];
 
-      allocated[idx] = false;
-
 #if ENABLED(RDOC_DEVEL)
       if(DebugClear)
         memset(p, 0xfe, AllocByteSize);
 #endif
+
+      // clear the memory before releasing the slot, after this it could be reallocated at any time
+      volatile int32_t *bits = &allocated[idx / 32];
+      uint32_t mask = 1U << (idx % 32);
+
+      int32_t val = *bits;
+
+      for(;;)
+      {
+        int32_t prev = Atomic::CmpExch32(bits, val, int32_t(uint32_t(val) & ~mask));
+
+        if(prev == val)
+          break;
+
+        val = prev;
+      }
+
+      Atomic::Dec32(&numAllocated);
     }
 
     bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[PoolCount]; }
     WrapType *items;
 
-    // could possibly make this uint32s and check via bitmasks, but
-    // we'll see if it shows up in profiling
-    bool allocated[PoolCount];
+    static const int32_t NumWords = (PoolCount + 31) / 32;
+
+    // one bit per item, set when the item is allocated
+    volatile int32_t allocated[NumWords];
+
+    // the word we last allocated from, where we start searching next time
+    volatile int32_t lastAllocWord;
+
+    // how many items are allocated
+    volatile int32_t numAllocated;
 
-    // store the last allocations index. Good place to start from and we
-    // go through the pool in a ring. Good performance when the pool is empty
-    // or contiguously allocated, poorer performance when the pool gets filled up.
-    // It also has the bonus of handling repeated new/free well by reallocating the
-    // same element.
-    int lastAllocIdx;
+    // the next additional pool, written once when it's added
+    ItemPool *volatile next;
   };
 
   ItemPool m_ImmediatePool;
-  std::vector<ItemPool *> m_AdditionalPools;
 
   friend typename FriendMaker<WrapType>::Type;
 };
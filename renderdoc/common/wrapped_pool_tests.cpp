@@ -0,0 +1,173 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include <algorithm>
+#include "3rdparty/catch/catch.hpp"
+#include "strings/string_utils.h"
+#include "wrapped_pool.h"
+
+// deliberately small and not a multiple of 32, so that additional pools and the end of the
+// allocation bitmap get exercised.
+struct SmallPooledObject
+{
+  uint64_t owner;
+  uint64_t value;
+
+  ALLOCATE_WITH_WRAPPED_POOL(SmallPooledObject, 100);
+};
+
+struct PooledObject
+{
+  uint64_t owner;
+  uint64_t value;
+
+  ALLOCATE_WITH_WRAPPED_POOL(PooledObject);
+};
+
+WRAPPED_POOL_INST(SmallPooledObject);
+WRAPPED_POOL_INST(PooledObject);
+
+template <typename T>
+static void AllocateFromThreads(uint32_t numThreads, uint32_t iterations, uint32_t batchSize,
+                                volatile int32_t *errors)
+{
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    threads.push_back(Threading::CreateThread([t, iterations, batchSize, errors]() {
+      std::vector<T *> objs;
+      objs.reserve(batchSize);
+
+      for(uint32_t i = 0; i < iterations; i++)
+      {
+        for(uint32_t b = 0; b < batchSize; b++)
+        {
+          T *obj = new T;
+          obj->owner = t;
+          obj->value = i * batchSize + b;
+          objs.push_back(obj);
+        }
+
+        // if any slot was handed out twice, another thread will have overwritten our values
+        for(uint32_t b = 0; b < batchSize; b++)
+        {
+          if(objs[b]->owner != t || objs[b]->value != i * batchSize + b || !T::IsAlloc(objs[b]))
+            Atomic::Inc32(errors);
+
+          delete objs[b];
+        }
+
+        objs.clear();
+      }
+    }));
+  }
+
+  for(Threading::ThreadHandle t : threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+}
+
+TEST_CASE("Check wrapped pool allocation", "[wrappedpool]")
+{
+  SECTION("Allocations overflow into additional pools")
+  {
+    // fill exactly three pools, so that the same set of slots must come back when reallocating
+    const int count = 300;
+
+    std::vector<SmallPooledObject *> objs;
+
+    for(int i = 0; i < count; i++)
+    {
+      objs.push_back(new SmallPooledObject);
+      objs.back()->value = i;
+    }
+
+    std::vector<SmallPooledObject *> sorted = objs;
+    std::sort(sorted.begin(), sorted.end());
+    bool unique = std::unique(sorted.begin(), sorted.end()) == sorted.end();
+    CHECK(unique);
+
+    for(int i = 0; i < count; i++)
+    {
+      CHECK(SmallPooledObject::IsAlloc(objs[i]));
+      CHECK(objs[i]->value == (uint64_t)i);
+    }
+
+    uint64_t notPooled = 0;
+    CHECK_FALSE(SmallPooledObject::IsAlloc(&notPooled));
+    CHECK_FALSE(PooledObject::IsAlloc(objs[0]));
+
+    for(SmallPooledObject *o : objs)
+      delete o;
+
+    // freed slots are reused, rather than adding more pools
+    objs.clear();
+    for(int i = 0; i < count; i++)
+      objs.push_back(new SmallPooledObject);
+
+    std::vector<SmallPooledObject *> resorted = objs;
+    std::sort(resorted.begin(), resorted.end());
+    CHECK(resorted == sorted);
+
+    for(SmallPooledObject *o : objs)
+      delete o;
+  };
+
+  SECTION("Concurrent allocation never hands out a slot twice")
+  {
+    volatile int32_t errors = 0;
+
+    // more live objects than fit in the first pool, so threads race to add and use new pools
+    AllocateFromThreads<SmallPooledObject>(8, 2000, 40, &errors);
+    AllocateFromThreads<PooledObject>(8, 2000, 40, &errors);
+
+    CHECK(errors == 0);
+  };
+};
+
+TEST_CASE("Benchmark wrapped pool allocation", "[wrappedpool][!benchmark]")
+{
+  volatile int32_t errors = 0;
+
+  // each thread does the same amount of work, so ideally the time stays constant as threads are
+  // added.
+  for(uint32_t numThreads : {1U, 2U, 4U, 8U, 16U})
+  {
+    BENCHMARK(StringFormat::Fmt("Allocate/Deallocate, %u threads", numThreads))
+    {
+      AllocateFromThreads<PooledObject>(numThreads, 2000, 64, &errors);
+    }
+  }
+
+  CHECK(errors == 0);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
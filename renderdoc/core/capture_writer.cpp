@@ -0,0 +1,345 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "capture_writer.h"
+#include <deque>
+#include "common/threading.h"
+#include "jpeg-compressor/jpge.h"
+#include "serialise/rdcfile.h"
+
+// data is handed from the capturing thread to the writing thread in pages of this size
+static const uint64_t capturePageSize = 4 * 1024 * 1024;
+
+// how many pages can be queued before the capturing thread has to wait for the writing thread to
+// catch up, so that a capture being written to a slow disk doesn't pile up in memory.
+static const uint32_t maxQueuedPages = 64;
+
+namespace
+{
+struct CapturePage
+{
+  byte *data;
+  uint64_t size;
+};
+
+struct PendingCapture
+{
+  PendingCapture() { freePages.Wake(maxQueuedPages); }
+
+  RDCDriver driver;
+  uint32_t frameNumber;
+  SectionProperties props;
+  CaptureThumbnail thumb;
+
+  // protects pages and the capture-finished flag
+  Threading::CriticalSection lock;
+  std::deque<CapturePage> pages;
+  uint64_t totalSize = 0;
+  bool captureFinished = false;
+
+  // woken for each page queued and once the capture is finished
+  Threading::Semaphore dataAvailable;
+  // counts how many more pages can be queued
+  Threading::Semaphore freePages;
+
+  Threading::ThreadHandle thread = 0;
+  volatile int32_t writeFinished = 0;
+  Threading::Semaphore writeDone;
+};
+
+// the pending captures that haven't been reaped yet
+Threading::CriticalSection pendingLock;
+std::vector<PendingCapture *> pendingCaptures;
+
+// only one capture is written to disk at once, so that capture filenames are still allocated in
+// order and we don't thrash the disk.
+Threading::CriticalSection fileWriteLock;
+
+// This 'compressor' is the sink for the StreamWriter handed to the driver. It doesn't compress,
+// it just copies the serialised data into pages which are passed to the writing thread.
+class CaptureQueueWriter : public Compressor
+{
+public:
+  CaptureQueueWriter(PendingCapture *capture) : Compressor(NULL, Ownership::Nothing)
+  {
+    m_Capture = capture;
+    m_Page = AllocAlignedBuffer(capturePageSize);
+    m_PageOffset = 0;
+  }
+
+  ~CaptureQueueWriter()
+  {
+    // if we weren't finished (e.g. the writer was destroyed without finishing), make sure the
+    // capture thread doesn't wait forever
+    if(m_Page)
+      Finish();
+  }
+
+  bool Write(const void *data, uint64_t numBytes)
+  {
+    if(!m_Page)
+      return false;
+
+    const byte *src = (const byte *)data;
+
+    while(numBytes > 0)
+    {
+      uint64_t partialBytes = RDCMIN(capturePageSize - m_PageOffset, numBytes);
+      memcpy(m_Page + m_PageOffset, src, (size_t)partialBytes);
+
+      m_PageOffset += partialBytes;
+      numBytes -= partialBytes;
+      src += partialBytes;
+
+      if(m_PageOffset == capturePageSize)
+        PushPage();
+    }
+
+    return true;
+  }
+
+  bool Finish()
+  {
+    // Calling Write() after Finish() is illegal
+    if(!m_Page)
+      return true;
+
+    PushPage();
+
+    FreeAlignedBuffer(m_Page);
+    m_Page = NULL;
+
+    {
+      SCOPED_LOCK(m_Capture->lock);
+      m_Capture->captureFinished = true;
+    }
+
+    m_Capture->dataAvailable.Wake();
+
+    return true;
+  }
+
+private:
+  void PushPage()
+  {
+    if(m_PageOffset > 0)
+    {
+      // blocks if the queue is full, until the writing thread has written a page out
+      m_Capture->freePages.Wait();
+
+      {
+        SCOPED_LOCK(m_Capture->lock);
+        m_Capture->pages.push_back({m_Page, m_PageOffset});
+        m_Capture->totalSize += m_PageOffset;
+      }
+
+      m_Capture->dataAvailable.Wake();
+
+      m_Page = AllocAlignedBuffer(capturePageSize);
+    }
+
+    m_PageOffset = 0;
+  }
+
+  PendingCapture *m_Capture;
+
+  byte *m_Page;
+  uint64_t m_PageOffset;
+};
+
+void WriteCapture(PendingCapture *capture)
+{
+  SCOPED_LOCK(fileWriteLock);
+
+  CaptureThumbnail &thumb = capture->thumb;
+
+  byte *jpgbuf = NULL;
+  int len = 0;
+
+  if(thumb.pixels && thumb.jpeg)
+  {
+    jpgbuf = thumb.pixels;
+    len = (int)thumb.len;
+    thumb.pixels = NULL;
+  }
+  else if(thumb.pixels && thumb.width > 0 && thumb.height > 0)
+  {
+    // jpge::compress_image_to_jpeg_file_in_memory requires at least 1024 bytes
+    len = RDCMAX(thumb.width * thumb.height, 1024);
+
+    jpgbuf = new byte[len];
+
+    jpge::params p;
+    p.m_quality = 80;
+
+    bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thumb.width,
+                                                               thumb.height, 3, thumb.pixels, p);
+
+    if(!success)
+    {
+      RDCERR("Failed to compress to jpg");
+      SAFE_DELETE_ARRAY(jpgbuf);
+      len = 0;
+    }
+  }
+
+  SAFE_DELETE_ARRAY(thumb.pixels);
+
+  RDCFile *rdc = RenderDoc::Inst().CreateRDC(capture->driver, capture->frameNumber, jpgbuf, len,
+                                             jpgbuf ? thumb.width : 0, jpgbuf ? thumb.height : 0);
+
+  SAFE_DELETE_ARRAY(jpgbuf);
+
+  StreamWriter *sectionWriter = NULL;
+
+  if(rdc)
+    sectionWriter = rdc->WriteSection(capture->props);
+  else
+    sectionWriter = new StreamWriter(StreamWriter::InvalidStream);
+
+  uint64_t writtenSize = 0;
+
+  RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
+
+  for(;;)
+  {
+    CapturePage page = {};
+    bool finished = false;
+    uint64_t totalSize = 0;
+
+    {
+      SCOPED_LOCK(capture->lock);
+      if(!capture->pages.empty())
+      {
+        page = capture->pages.front();
+        capture->pages.pop_front();
+      }
+      finished = capture->captureFinished;
+      totalSize = capture->totalSize;
+    }
+
+    if(page.data)
+    {
+      sectionWriter->Write(page.data, page.size);
+      FreeAlignedBuffer(page.data);
+
+      capture->freePages.Wake();
+
+      writtenSize += page.size;
+
+      // we only know how much there is to write once the capturing thread has finished
+      if(finished)
+        RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting,
+                                      float(writtenSize) / float(totalSize));
+    }
+    else if(finished)
+    {
+      break;
+    }
+    else
+    {
+      // wait for the capturing thread to produce more data
+      capture->dataAvailable.Wait();
+    }
+  }
+
+  if(sectionWriter->IsErrored())
+    RDCERR("Error writing frame capture %u", capture->frameNumber);
+
+  sectionWriter->Finish();
+  delete sectionWriter;
+
+  RenderDoc::Inst().FinishCaptureWriting(rdc, capture->frameNumber);
+}
+
+// if join is false the threads are closed without joining, for use when we can't safely join
+// (e.g. during module unloading on windows).
+void ReapFinishedCaptures(bool wait, bool join)
+{
+  SCOPED_LOCK(pendingLock);
+
+  for(size_t i = 0; i < pendingCaptures.size();)
+  {
+    PendingCapture *capture = pendingCaptures[i];
+
+    if(wait && Atomic::CmpExch32(&capture->writeFinished, 1, 1) == 0)
+      capture->writeDone.Wait();
+
+    if(Atomic::CmpExch32(&capture->writeFinished, 1, 1) == 1)
+    {
+      // without joining, the thread could still be waking writeDone so the capture is leaked.
+      // This only happens while shutting down.
+      Threading::ThreadHandle thread = capture->thread;
+      if(join)
+      {
+        Threading::JoinThread(thread);
+        delete capture;
+      }
+      Threading::CloseThread(thread);
+      pendingCaptures.erase(pendingCaptures.begin() + i);
+      continue;
+    }
+
+    i++;
+  }
+}
+};
+
+StreamWriter *CaptureWriter::BeginWrite(RDCDriver driver, uint32_t frameNumber,
+                                        const SectionProperties &props,
+                                        const CaptureThumbnail &thumb)
+{
+  // tidy up any previous captures that have completed
+  ReapFinishedCaptures(false, true);
+
+  PendingCapture *capture = new PendingCapture;
+  capture->driver = driver;
+  capture->frameNumber = frameNumber;
+  capture->props = props;
+  capture->thumb = thumb;
+
+  capture->thread = Threading::CreateThread([capture]() {
+    WriteCapture(capture);
+
+    Atomic::Inc32(&capture->writeFinished);
+    capture->writeDone.Wake();
+  });
+
+  {
+    SCOPED_LOCK(pendingLock);
+    pendingCaptures.push_back(capture);
+  }
+
+  return new StreamWriter(new CaptureQueueWriter(capture), Ownership::Stream);
+}
+
+void CaptureWriter::WaitForPendingWrites()
+{
+  ReapFinishedCaptures(true, true);
+}
+
+void CaptureWriter::Shutdown()
+{
+  ReapFinishedCaptures(true, false);
+}
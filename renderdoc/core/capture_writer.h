@@ -0,0 +1,61 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "core/core.h"
+
+class StreamWriter;
+
+// the thumbnail for a capture being written. Either raw tightly packed RGB8 pixels which will be
+// encoded to JPEG on the background thread, or an already encoded JPEG.
+struct CaptureThumbnail
+{
+  byte *pixels = NULL;
+  uint32_t len = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  bool jpeg = false;
+};
+
+// The capture writer moves the expensive parts of writing a capture off the capturing thread.
+//
+// The driver serialises its frame capture into the returned StreamWriter as normal, which only
+// copies the data into a queue. A background thread encodes the thumbnail, creates the capture
+// file, and then compresses and writes the queued data to disk while the application continues.
+//
+// Once the writer is finished (e.g. by the owning WriteSerialiser being destroyed) the capture is
+// completed in the background and added to the list of captures when it's fully on disk.
+namespace CaptureWriter
+{
+// takes ownership of the thumbnail pixels. The returned writer must be deleted by the caller.
+StreamWriter *BeginWrite(RDCDriver driver, uint32_t frameNumber, const SectionProperties &props,
+                         const CaptureThumbnail &thumb);
+
+// blocks until all captures that have been handed off are completely written.
+void WaitForPendingWrites();
+
+// as WaitForPendingWrites, but safe to call during module unloading.
+void Shutdown();
+};
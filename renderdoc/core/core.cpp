@@ -28,6 +28,7 @@
 #include <algorithm>
 #include "api/replay/version.h"
 #include "common/common.h"
+#include "core/capture_writer.h"
 #include "hooks/hooks.h"
 #include "replay/replay_driver.h"
 #include "serialise/rdcfile.h"
@@ -339,6 +340,9 @@ RenderDoc::~RenderDoc()
   for(auto it = m_ShutdownFunctions.begin(); it != m_ShutdownFunctions.end(); ++it)
     (*it)();
 
+  // make sure any captures still being written in the background make it to disk
+  CaptureWriter::Shutdown();
+
   for(size_t i = 0; i < m_Captures.size(); i++)
   {
     if(m_Captures[i].retrieved)
@@ -375,6 +379,8 @@ RenderDoc::~RenderDoc()
 
 void RenderDoc::Shutdown()
 {
+  CaptureWriter::WaitForPendingWrites();
+
   if(m_ExHandler)
   {
     UnloadCrashHandler();
@@ -702,20 +708,28 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, void *thpixel
 {
   RDCFile *ret = new RDCFile;
 
-  m_CurrentLogFile = StringFormat::Fmt("%s_frame%u.rdc", m_CaptureFileTemplate.c_str(), frameNum);
+  std::string path;
 
-  // make sure we don't stomp another capture if we make multiple captures in the same frame.
+  // captures can be written from background threads as well as the application's, so the path is
+  // picked under the lock and reserved until FinishCaptureWriting.
   {
     SCOPED_LOCK(m_CaptureLock);
+
+    path = StringFormat::Fmt("%s_frame%u.rdc", m_CaptureFileTemplate.c_str(), frameNum);
+
+    // make sure we don't stomp another capture if we make multiple captures in the same frame.
     int altnum = 2;
-    while(std::find_if(m_Captures.begin(), m_Captures.end(), [this](const CaptureData &o) {
-            return o.path == m_CurrentLogFile;
+    while(m_WritingCaptures.find(path) != m_WritingCaptures.end() ||
+          std::find_if(m_Captures.begin(), m_Captures.end(), [&path](const CaptureData &o) {
+            return o.path == path;
           }) != m_Captures.end())
     {
-      m_CurrentLogFile =
+      path =
           StringFormat::Fmt("%s_frame%u_%d.rdc", m_CaptureFileTemplate.c_str(), frameNum, altnum);
       altnum++;
     }
+
+    m_WritingCaptures.insert(path);
   }
 
   RDCThumb th;
@@ -732,14 +746,17 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, void *thpixel
 
   ret->SetData(driver, ToStr(driver).c_str(), OSUtility::GetMachineIdent(), thumb);
 
-  FileIO::CreateParentDirectory(m_CurrentLogFile);
+  FileIO::CreateParentDirectory(path);
 
-  ret->Create(m_CurrentLogFile.c_str());
+  ret->Create(path.c_str());
 
   if(ret->ErrorCode() != ContainerError::NoError)
   {
-    RDCERR("Error creating RDC at '%s'", m_CurrentLogFile.c_str());
+    RDCERR("Error creating RDC at '%s'", path.c_str());
     SAFE_DELETE(ret);
+
+    SCOPED_LOCK(m_CaptureLock);
+    m_WritingCaptures.erase(path);
   }
 
   return ret;
@@ -1049,6 +1066,8 @@ void RenderDoc::SetCaptureFileTemplate(const char *pathtemplate)
   if(pathtemplate == NULL || pathtemplate[0] == '\0')
     return;
 
+  SCOPED_LOCK(m_CaptureLock);
+
   m_CaptureFileTemplate = pathtemplate;
 
   if(m_CaptureFileTemplate.length() > 4 &&
@@ -1060,8 +1079,6 @@ void RenderDoc::SetCaptureFileTemplate(const char *pathtemplate)
 
 void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
 {
-  RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
-
   if(rdc)
   {
     // add the resolve database if we were capturing callstacks.
@@ -1085,17 +1102,24 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       delete w;
     }
 
+    std::string path = rdc->GetFilename();
+
     delete rdc;
 
-    RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+    RDCLOG("Written to disk: %s", path.c_str());
 
-    CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), frameNumber);
+    CaptureData cap(path, Timing::GetUnixTimestamp(), frameNumber);
     {
       SCOPED_LOCK(m_CaptureLock);
+      m_WritingCaptures.erase(path);
       m_Captures.push_back(cap);
     }
   }
 
+  // the frame's chunks are freed at the end of the capture, so stop threads allocating from their
+  // old pages and let any left behind by threads that have since exited be freed.
+  ChunkAllocator::ReleaseArenaPages();
+
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 1.0f);
 }
 
@@ -559,7 +559,6 @@ private:
 
   string m_Target;
   string m_CaptureFileTemplate;
-  string m_CurrentLogFile;
   CaptureOptions m_Options;
   uint32_t m_Overlay;
 
@@ -574,8 +573,11 @@ private:
 
   std::map<std::string, RENDERDOC_ProgressCallback> m_ProgressCallbacks;
 
+  // protects the capture list, the paths of captures still being written and the capture file
+  // template, since captures are written from background threads.
   Threading::CriticalSection m_CaptureLock;
   vector<CaptureData> m_Captures;
+  std::set<std::string> m_WritingCaptures;
 
   Threading::CriticalSection m_ChildLock;
   vector<pair<uint32_t, uint32_t> > m_Children;
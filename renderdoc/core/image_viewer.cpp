@@ -158,6 +158,7 @@ public:
     return ReplayStatus::Succeeded;
   }
   const SDFile &GetStructuredFile() { return m_File; }
+  void LoadStructuredChunk(uint32_t chunkIndex) {}
   void RenderMesh(uint32_t eventId, const vector<MeshFormat> &secondaryDraws, const MeshDisplay &cfg)
   {
   }
@@ -23,19 +23,22 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <algorithm>
 #include <sstream>
 #include <utility>
+#include "3rdparty/zstd/xxhash.h"
 #include "android/android.h"
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
 #include "os/os_specific.h"
 #include "replay/replay_controller.h"
+#include "serialise/blockio.h"
 #include "serialise/rdcfile.h"
 #include "serialise/serialiser.h"
 #include "strings/string_utils.h"
 #include "replay_proxy.h"
 
-static const uint32_t RemoteServerProtocolVersion = 3;
+static const uint32_t RemoteServerProtocolVersion = 5;
 
 enum RemoteServerPacket
 {
@@ -67,6 +70,7 @@ enum RemoteServerPacket
   eRemoteServer_GetSectionProperties,
   eRemoteServer_GetSectionContents,
   eRemoteServer_WriteSection,
+  eRemoteServer_TransferBlock,
   eRemoteServer_RemoteServerCount,
 };
 
@@ -76,6 +80,354 @@ RDCCOMPILE_ASSERT((int)eRemoteServer_RemoteServerCount < (int)eReplayProxy_First
 #define WRITE_DATA_SCOPE() WriteSerialiser &ser = writer;
 #define READ_DATA_SCOPE() ReadSerialiser &ser = reader;
 
+// Captures are copied in fixed-size blocks. The sender lists a hash of every block, and the
+// receiver replies with the blocks that don't match what it already has from an interrupted
+// transfer or an earlier copy of the same file. Only those blocks are sent, each compressed on its
+// own and written into the receiver's file as it arrives, so an interrupted copy resumes where it
+// left off and re-sending a capture with a few changed sections only sends those.
+struct FileBlockList
+{
+  uint64_t fileSize = 0;
+  uint64_t blockSize = BlockCompression::BlockSize;
+  std::vector<uint64_t> hashes;
+};
+
+template <typename SerialiserType>
+static void SerialiseFileBlockList(SerialiserType &ser, FileBlockList &list)
+{
+  ser.Serialise("fileSize", list.fileSize);
+  ser.Serialise("blockSize", list.blockSize);
+  ser.Serialise("hashes", list.hashes);
+}
+
+static BlockCodec GetTransferCodec()
+{
+  // LZ4 is the default since it's fastest, but zstd is much smaller over slow connections.
+  return RenderDoc::Inst().GetConfigSetting("RemoteServer_TransferCompression") == "zstd"
+             ? BlockCodec::Zstd
+             : BlockCodec::LZ4;
+}
+
+// hashes the blocks of a file that are within fileSize. Stops at the first block that can't be
+// completely read, so a truncated file lists fewer blocks.
+static void HashFileBlocks(FILE *f, uint64_t fileSize, uint64_t blockSize,
+                           std::vector<uint64_t> &hashes)
+{
+  hashes.clear();
+
+  if(f == NULL || blockSize == 0)
+    return;
+
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  bytebuf block;
+  block.resize((size_t)blockSize);
+
+  for(uint64_t offs = 0; offs < fileSize; offs += blockSize)
+  {
+    size_t size = (size_t)RDCMIN(blockSize, fileSize - offs);
+
+    if(FileIO::fread(block.data(), 1, size, f) != size)
+      break;
+
+    hashes.push_back(XXH64(block.data(), size, 0));
+  }
+}
+
+static void ListFileBlocks(FILE *f, FileBlockList &list)
+{
+  list.fileSize = 0;
+
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    list.fileSize = FileIO::ftell64(f);
+  }
+
+  HashFileBlocks(f, list.fileSize, list.blockSize, list.hashes);
+}
+
+// where the remote server receives copies of a given client file, kept between transfers so they
+// can be resumed or de-duplicated.
+static std::string GetTransferStagingPath(const std::string &source)
+{
+  std::string path, dummy, dummy2;
+  FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
+
+  return StringFormat::Fmt("%s/remotecopy_%016llx.partial", dirname(path).c_str(),
+                           XXH64(source.c_str(), source.size(), 0));
+}
+
+// staging files are only left behind by interrupted transfers. Keep them for a day in case the
+// transfer is retried, then delete them.
+static void DeleteStaleTransfers()
+{
+  std::string path, dummy, dummy2;
+  FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
+
+  std::string dir = dirname(path);
+  uint64_t now = Timing::GetUnixTimestamp();
+
+  std::vector<PathEntry> files = FileIO::GetFilesInDirectory(dir.c_str());
+
+  for(const PathEntry &file : files)
+  {
+    std::string name = file.filename;
+
+    if(name.find("remotecopy_") != 0 || name.size() < 8 ||
+       name.substr(name.size() - 8) != ".partial" || file.lastmod + 24 * 60 * 60 > now)
+      continue;
+
+    RDCLOG("Deleting stale partial transfer '%s'", name.c_str());
+    FileIO::Delete((dir + "/" + name).c_str());
+  }
+}
+
+// called after the receiver has been sent the block list. Reads the list of blocks it needs, in a
+// chunk of the given packet type, then sends them.
+static bool SendFileBlocks(ReadSerialiser &reader, WriteSerialiser &writer,
+                           RemoteServerPacket packet, FILE *f, const FileBlockList &list,
+                           RENDERDOC_ProgressCallback progress, uint32_t *numSent = NULL)
+{
+  std::vector<uint32_t> needed;
+
+  {
+    READ_DATA_SCOPE();
+    RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+    if(type == packet)
+    {
+      SERIALISE_ELEMENT(needed);
+    }
+    else
+    {
+      RDCERR("Unexpected response to block list");
+    }
+
+    ser.EndChunk();
+
+    if(type != packet || ser.IsErrored())
+      return false;
+  }
+
+  if(progress)
+    progress(0.0001f);
+
+  BlockCodec codec = GetTransferCodec();
+
+  bytebuf block, payload;
+  block.resize((size_t)list.blockSize);
+
+  bool success = true;
+
+  for(size_t n = 0; n < needed.size(); n++)
+  {
+    uint32_t index = needed[n];
+    uint32_t blockCodec = 0;
+
+    uint64_t offs = uint64_t(index) * list.blockSize;
+    size_t size = offs < list.fileSize ? (size_t)RDCMIN(list.blockSize, list.fileSize - offs) : 0;
+
+    payload.clear();
+
+    // if the block can't be read, an empty block is still sent to keep both sides in step. It will
+    // fail to verify on the receiving side.
+    if(f && size > 0)
+    {
+      FileIO::fseek64(f, offs, SEEK_SET);
+      if(FileIO::fread(block.data(), 1, size, f) == size)
+      {
+        payload.resize((size_t)BlockCompression::CompressBound(codec, size));
+        uint64_t compSize = BlockCompression::Compress(codec, block.data(), size, payload.data(),
+                                                       payload.size());
+
+        // send incompressible blocks as-is
+        if(compSize > 0 && compSize < size)
+        {
+          payload.resize((size_t)compSize);
+          blockCodec = (uint32_t)codec;
+        }
+        else
+        {
+          payload.assign(block.data(), size);
+        }
+      }
+      else
+      {
+        RDCERR("Couldn't read block %u of file being sent", index);
+        success = false;
+      }
+    }
+
+    {
+      WRITE_DATA_SCOPE();
+      SCOPED_SERIALISE_CHUNK(eRemoteServer_TransferBlock);
+      SERIALISE_ELEMENT(index);
+      SERIALISE_ELEMENT(blockCodec);
+      SERIALISE_ELEMENT(payload);
+    }
+
+    if(writer.IsErrored())
+      return false;
+
+    if(progress)
+      progress(float(n + 1) / float(needed.size()));
+  }
+
+  if(progress)
+    progress(1.0f);
+
+  if(numSent)
+    *numSent = (uint32_t)needed.size();
+
+  return success;
+}
+
+// receives the blocks of a file given its block list, replying with the blocks needed in a chunk of
+// the given packet type. The file is written to staging, re-using any blocks that already match
+// there. If there's no staging file, it starts from a copy of basis if that exists.
+static bool ReceiveFileBlocks(ReadSerialiser &reader, WriteSerialiser &writer,
+                              RemoteServerPacket packet, const std::string &staging,
+                              const std::string &basis, const FileBlockList &list,
+                              RENDERDOC_ProgressCallback progress)
+{
+  // the list comes from the other end of the connection, so check it describes the file before
+  // sizing anything by it. If not, ask for no blocks so both sides stay in step.
+  uint64_t numBlocks =
+      (list.fileSize + BlockCompression::BlockSize - 1) / BlockCompression::BlockSize;
+
+  if(list.blockSize != BlockCompression::BlockSize || list.hashes.size() != numBlocks)
+  {
+    RDCERR("Invalid block list: %zu blocks of %llu bytes for a %llu byte file", list.hashes.size(),
+           list.blockSize, list.fileSize);
+
+    std::vector<uint32_t> needed;
+
+    {
+      WRITE_DATA_SCOPE();
+      SCOPED_SERIALISE_CHUNK(packet);
+      SERIALISE_ELEMENT(needed);
+    }
+
+    return false;
+  }
+
+  FileIO::CreateParentDirectory(staging);
+
+  if(!FileIO::exists(staging.c_str()) && !basis.empty() && FileIO::exists(basis.c_str()))
+    FileIO::Copy(basis.c_str(), staging.c_str(), true);
+
+  FILE *f = FileIO::fopen(staging.c_str(), "r+b");
+  if(f == NULL)
+    f = FileIO::fopen(staging.c_str(), "w+b");
+
+  if(f == NULL)
+    RDCERR("Couldn't open '%s' to receive file", staging.c_str());
+
+  std::vector<uint64_t> existing;
+  HashFileBlocks(f, list.fileSize, list.blockSize, existing);
+
+  std::vector<uint32_t> needed;
+  for(uint32_t i = 0; i < (uint32_t)list.hashes.size(); i++)
+    if(i >= existing.size() || existing[i] != list.hashes[i])
+      needed.push_back(i);
+
+  RDCLOG("Receiving %zu of %zu blocks", needed.size(), list.hashes.size());
+
+  {
+    WRITE_DATA_SCOPE();
+    SCOPED_SERIALISE_CHUNK(packet);
+    SERIALISE_ELEMENT(needed);
+  }
+
+  if(progress)
+    progress(0.0001f);
+
+  bytebuf block;
+  block.resize((size_t)list.blockSize);
+
+  bool success = (f != NULL);
+
+  for(size_t n = 0; n < needed.size(); n++)
+  {
+    uint32_t index = 0;
+    uint32_t blockCodec = 0;
+    bytebuf payload;
+
+    {
+      READ_DATA_SCOPE();
+      RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+      if(type == eRemoteServer_TransferBlock)
+      {
+        SERIALISE_ELEMENT(index);
+        SERIALISE_ELEMENT(blockCodec);
+        SERIALISE_ELEMENT(payload);
+      }
+
+      ser.EndChunk();
+
+      // we can't continue if the connection is lost, but everything received so far is in the
+      // staging file to resume from.
+      if(type != eRemoteServer_TransferBlock || index != needed[n] || ser.IsErrored())
+      {
+        RDCERR("Block transfer interrupted after %zu of %zu blocks", n, needed.size());
+        if(f)
+          FileIO::fclose(f);
+        return false;
+      }
+    }
+
+    uint64_t offs = uint64_t(index) * list.blockSize;
+    size_t size = (size_t)RDCMIN(list.blockSize, list.fileSize - offs);
+
+    const byte *data = payload.data();
+
+    bool valid = false;
+    if(blockCodec == 0)
+    {
+      valid = (payload.size() == size);
+    }
+    else
+    {
+      valid = BlockCompression::Decompress((BlockCodec)blockCodec, payload.data(), payload.size(),
+                                           block.data(), size);
+      data = block.data();
+    }
+
+    if(!valid || XXH64(data, size, 0) != list.hashes[index])
+    {
+      RDCERR("Block %u is corrupt", index);
+      success = false;
+      continue;
+    }
+
+    if(f)
+    {
+      FileIO::fseek64(f, offs, SEEK_SET);
+      if(FileIO::fwrite(data, 1, size, f) != size)
+      {
+        RDCERR("Couldn't write block %u to '%s'", index, staging.c_str());
+        success = false;
+      }
+    }
+
+    if(progress)
+      progress(float(n + 1) / float(needed.size()));
+  }
+
+  if(f)
+  {
+    FileIO::ftruncateat(f, list.fileSize);
+    FileIO::fclose(f);
+  }
+
+  if(progress)
+    progress(1.0f);
+
+  return success;
+}
+
 struct ClientThread
 {
   ClientThread()
@@ -197,12 +549,25 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     }
   }
 
+  DeleteStaleTransfers();
+
   std::vector<std::string> tempFiles;
+  // the received copy of each client file, to start from if it's sent again
+  std::map<std::string, std::string> receivedCopies;
   IRemoteDriver *remoteDriver = NULL;
   IReplayDriver *replayDriver = NULL;
   ReplayProxy *proxy = NULL;
   RDCFile *rdc = NULL;
   Callstack::StackResolver *resolver = NULL;
+  std::string resolveCachePath;
+
+  // saves anything the resolver has looked up before deleting it, so re-opening the capture in this
+  // session doesn't need to resolve it again. The cache is a temp file, deleted at the end.
+  auto deleteResolver = [&resolver, &resolveCachePath]() {
+    if(resolver)
+      resolver->SaveCache(resolveCachePath.c_str());
+    SAFE_DELETE(resolver);
+  };
 
   WriteSerialiser writer(new StreamWriter(client, Ownership::Nothing), Ownership::Stream);
   ReadSerialiser reader(new StreamReader(client, Ownership::Nothing), Ownership::Stream);
@@ -299,45 +664,70 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       reader.EndChunk();
 
+      FILE *f = FileIO::fopen(path.c_str(), "rb");
+
+      FileBlockList list;
+      ListFileBlocks(f, list);
+
       {
         WRITE_DATA_SCOPE();
         SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureFromRemote);
-
-        StreamReader fileStream(FileIO::fopen(path.c_str(), "rb"));
-        ser.SerialiseStream(path, fileStream);
+        SerialiseFileBlockList(ser, list);
       }
+
+      SendFileBlocks(reader, writer, eRemoteServer_CopyCaptureFromRemote, f, list, NULL);
+
+      if(f)
+        FileIO::fclose(f);
+
+      if(reader.IsErrored() || writer.IsErrored())
+        break;
     }
     else if(type == eRemoteServer_CopyCaptureToRemote)
     {
-      std::string path;
-      std::string dummy, dummy2;
-      FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
-
-      RDCLOG("Copying file to local path '%s'.", path.c_str());
-
-      FileIO::CreateParentDirectory(path);
+      std::string source;
+      FileBlockList list;
 
       {
         READ_DATA_SCOPE();
-
-        StreamWriter streamWriter(FileIO::fopen(path.c_str(), "wb"), Ownership::Stream);
-
-        ser.SerialiseStream(path.c_str(), streamWriter, NULL);
+        SERIALISE_ELEMENT(source);
+        SerialiseFileBlockList(ser, list);
       }
 
       reader.EndChunk();
 
-      if(reader.IsErrored())
-      {
-        FileIO::Delete(path.c_str());
+      // receive into a staging file for this source, which is kept if the transfer is interrupted
+      // so the next copy of the same file can resume. Once complete it's moved into place, and a
+      // later copy of the same file in this session starts from that.
+      std::string staging = GetTransferStagingPath(source);
 
-        RDCERR("Network error receiving file");
+      bool success = ReceiveFileBlocks(reader, writer, eRemoteServer_CopyCaptureToRemote, staging,
+                                       receivedCopies[source], list, NULL);
+
+      if(reader.IsErrored() || writer.IsErrored())
+      {
+        RDCERR("Network error receiving file, partial copy kept in '%s'", staging.c_str());
         break;
       }
 
-      RDCLOG("File received.");
+      std::string path;
+      std::string dummy, dummy2;
+      FileIO::GetDefaultFiles("remotecopy", path, dummy, dummy2);
+
+      if(success)
+        success = FileIO::Move(staging.c_str(), path.c_str(), true);
 
-      tempFiles.push_back(path);
+      if(success)
+      {
+        RDCLOG("File received to local path '%s'.", path.c_str());
+        tempFiles.push_back(path);
+        receivedCopies[source] = path;
+      }
+      else
+      {
+        RDCERR("Failed to receive file");
+        path = "";
+      }
 
       {
         WRITE_DATA_SCOPE();
@@ -501,7 +891,7 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       int sectionIndex = rdc ? rdc->SectionIndex(SectionType::ResolveDatabase) : -1;
 
-      SAFE_DELETE(resolver);
+      deleteResolver();
       if(sectionIndex >= 0)
       {
         StreamReader *sectionReader = rdc->ReadSection(sectionIndex);
@@ -531,6 +921,15 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
           resolver = Callstack::MakeResolver(buf.data(), buf.size(),
                                              [&progress](float p) { progress = p; });
 
+          if(resolver)
+          {
+            resolveCachePath = Callstack::GetResolveCacheFilename(buf.data(), buf.size());
+            resolver->LoadCache(resolveCachePath.c_str());
+
+            if(std::find(tempFiles.begin(), tempFiles.end(), resolveCachePath) == tempFiles.end())
+              tempFiles.push_back(resolveCachePath);
+          }
+
           Threading::JoinThread(ticker);
           Threading::CloseThread(ticker);
         }
@@ -561,12 +960,12 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       if(resolver)
       {
+        std::vector<Callstack::AddressDetails> details(StackAddresses.size());
+        resolver->GetAddrs(StackAddresses.data(), StackAddresses.size(), details.data());
+
         StackFrames.reserve(StackAddresses.size());
-        for(uint64_t frame : StackAddresses)
-        {
-          Callstack::AddressDetails info = resolver->GetAddr(frame);
+        for(Callstack::AddressDetails &info : details)
           StackFrames.push_back(info.formattedString());
-        }
       }
       else
       {
@@ -727,8 +1126,8 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
       remoteDriver = NULL;
       replayDriver = NULL;
 
+      deleteResolver();
       SAFE_DELETE(rdc);
-      SAFE_DELETE(resolver);
     }
     else if(type == eRemoteServer_ExecuteAndInject)
     {
@@ -782,8 +1181,8 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
     remoteDriver->Shutdown();
   remoteDriver = NULL;
   replayDriver = NULL;
+  deleteResolver();
   SAFE_DELETE(rdc);
-  SAFE_DELETE(resolver);
 
   for(size_t i = 0; i < tempFiles.size(); i++)
   {
@@ -1010,6 +1409,14 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port,
   SAFE_DELETE(sock);
 }
 
+// the open capture's proxy shares the connection, and may have responses to prefetch requests in
+// flight. Those must be received before any other packet is sent, or they'd be read as its
+// response.
+#undef WRITE_DATA_SCOPE
+#define WRITE_DATA_SCOPE() \
+  ReceiveProxyResponses(); \
+  WriteSerialiser &ser = writer;
+
 struct RemoteServer : public IRemoteServer
 {
 public:
@@ -1302,41 +1709,57 @@ public:
       SERIALISE_ELEMENT(path);
     }
 
+    FileBlockList list;
+
     {
       READ_DATA_SCOPE();
       RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
 
       if(type == eRemoteServer_CopyCaptureFromRemote)
-      {
-        StreamWriter streamWriter(FileIO::fopen(localpath, "wb"), Ownership::Stream);
-
-        ser.SerialiseStream(localpath, streamWriter, progress);
-
-        if(ser.IsErrored())
-        {
-          RDCERR("Network error receiving file");
-          return;
-        }
-      }
+        SerialiseFileBlockList(ser, list);
       else
-      {
         RDCERR("Unexpected response to capture copy request");
-      }
 
       ser.EndChunk();
+
+      if(type != eRemoteServer_CopyCaptureFromRemote || ser.IsErrored())
+        return;
     }
+
+    // a partial copy is kept next to the destination until it's complete, so the copy can be
+    // resumed. An existing file at the destination is re-used as a starting point.
+    std::string staging = std::string(localpath) + ".partial";
+
+    if(ReceiveFileBlocks(reader, writer, eRemoteServer_CopyCaptureFromRemote, staging, localpath,
+                         list, progress))
+      FileIO::Move(staging.c_str(), localpath, true);
+    else
+      RDCERR("Failed to receive file");
   }
 
   rdcstr CopyCaptureToRemote(const char *filename, RENDERDOC_ProgressCallback progress)
   {
+    FILE *f = FileIO::fopen(filename, "rb");
+
+    FileBlockList list;
+    ListFileBlocks(f, list);
+
+    // the source filename identifies the file to the server, so it can resume or re-use an earlier
+    // copy.
+    std::string source = filename;
+
     {
       WRITE_DATA_SCOPE();
       SCOPED_SERIALISE_CHUNK(eRemoteServer_CopyCaptureToRemote);
-
-      StreamReader fileStream(FileIO::fopen(filename, "rb"));
-      ser.SerialiseStream(filename, fileStream, progress);
+      SERIALISE_ELEMENT(source);
+      SerialiseFileBlockList(ser, list);
     }
 
+    SendFileBlocks(reader, writer, eRemoteServer_CopyCaptureToRemote, f, list, progress);
+
+    if(f)
+      FileIO::fclose(f);
+
     std::string path;
 
     {
@@ -1463,6 +1886,8 @@ public:
       return ret;
     }
 
+    m_OpenProxy = proxy;
+
     // ReplayController takes ownership of the ProxySerialiser (as IReplayDriver)
     // and it cleans itself up in Shutdown.
 
@@ -1489,6 +1914,8 @@ public:
       SCOPED_SERIALISE_CHUNK(eRemoteServer_CloseLog);
     }
 
+    m_OpenProxy = NULL;
+
     rend->Shutdown();
   }
 
@@ -1794,11 +2221,20 @@ public:
   }
 
 private:
+  void ReceiveProxyResponses()
+  {
+    if(m_OpenProxy)
+      m_OpenProxy->ReceivePendingResponses();
+  }
+
   Network::Socket *m_Socket;
   WriteSerialiser writer;
   ReadSerialiser reader;
   std::string m_hostname;
 
+  // the proxy for the capture opened with OpenCapture, until it's closed with CloseCapture
+  ReplayProxy *m_OpenProxy = NULL;
+
   std::vector<std::pair<RDCDriver, std::string> > m_Proxies;
 };
 
@@ -1880,3 +2316,167 @@ RENDERDOC_CreateRemoteServerConnection(const char *host, uint32_t port, IRemoteS
 
   return ReplayStatus::Succeeded;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+static void WriteTestFile(const std::string &filename, const bytebuf &data)
+{
+  FILE *f = FileIO::fopen(filename.c_str(), "wb");
+  REQUIRE(f);
+  FileIO::fwrite(data.data(), 1, data.size(), f);
+  FileIO::fclose(f);
+}
+
+TEST_CASE("Check block transfer of captures over loopback", "[remoteserver]")
+{
+  Network::Socket *server = NULL;
+  uint16_t port = 0;
+  for(port = 39970; port < 40000 && server == NULL; port++)
+    server = Network::CreateServerSocket("127.0.0.1", port, 1);
+  port--;
+
+  REQUIRE(server);
+
+  Network::Socket *senderSock = Network::CreateClientSocket("127.0.0.1", port, 1000);
+  REQUIRE(senderSock);
+  Network::Socket *receiverSock = server->AcceptClient(true);
+  REQUIRE(receiverSock);
+
+  WriteSerialiser senderWriter(new StreamWriter(senderSock, Ownership::Nothing), Ownership::Stream);
+  ReadSerialiser senderReader(new StreamReader(senderSock, Ownership::Nothing), Ownership::Stream);
+  WriteSerialiser receiverWriter(new StreamWriter(receiverSock, Ownership::Nothing),
+                                 Ownership::Stream);
+  ReadSerialiser receiverReader(new StreamReader(receiverSock, Ownership::Nothing),
+                                Ownership::Stream);
+
+  senderWriter.SetStreamingMode(true);
+  senderReader.SetStreamingMode(true);
+  receiverWriter.SetStreamingMode(true);
+  receiverReader.SetStreamingMode(true);
+
+  std::string source = FileIO::GetTempFolderFilename() + "renderdoc_blocktransfer_src.rdc";
+  std::string staging = FileIO::GetTempFolderFilename() + "renderdoc_blocktransfer_dst.partial";
+  FileIO::Delete(staging.c_str());
+
+  // a capture-sized file that isn't a whole number of blocks, half of it compressible
+  const size_t blockSize = (size_t)BlockCompression::BlockSize;
+  bytebuf data;
+  data.resize(blockSize * 5 + blockSize / 2);
+  uint32_t seed = 0x1234567;
+  for(size_t i = 0; i < data.size(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    data[i] = (i / blockSize) % 2 ? byte(i / 64) : byte(seed >> 16);
+  }
+
+  // sends source to staging, returning how many blocks had to be sent
+  auto transfer = [&]() -> uint32_t {
+    WriteTestFile(source, data);
+
+    FILE *f = FileIO::fopen(source.c_str(), "rb");
+    FileBlockList list;
+    ListFileBlocks(f, list);
+
+    bool received = false;
+    Threading::ThreadHandle receiver = Threading::CreateThread([&]() {
+      received = ReceiveFileBlocks(receiverReader, receiverWriter, eRemoteServer_CopyCaptureToRemote,
+                                   staging, "", list, NULL);
+    });
+
+    uint32_t numSent = ~0U;
+    bool sent = SendFileBlocks(senderReader, senderWriter, eRemoteServer_CopyCaptureToRemote, f,
+                               list, NULL, &numSent);
+
+    Threading::JoinThread(receiver);
+    Threading::CloseThread(receiver);
+
+    FileIO::fclose(f);
+
+    CHECK(sent);
+    CHECK(received);
+
+    std::vector<unsigned char> result;
+    CHECK(FileIO::slurp(staging.c_str(), result));
+    CHECK(result.size() == data.size());
+    CHECK((result.size() == data.size() && memcmp(result.data(), data.data(), data.size()) == 0));
+
+    return numSent;
+  };
+
+  SECTION("Full, incremental and resumed transfers")
+  {
+    CHECK(transfer() == 6);
+
+    // nothing changed, nothing to send
+    CHECK(transfer() == 0);
+
+    // change one block and append past the end of the last partial block
+    data[blockSize * 4 + 100] ^= 0xff;
+    data.resize(data.size() + blockSize / 4);
+    CHECK(transfer() == 2);
+
+    // simulate an interrupted transfer that only got partway into the third block
+    FILE *f = FileIO::fopen(staging.c_str(), "r+b");
+    REQUIRE(f);
+    FileIO::ftruncateat(f, blockSize * 2 + 1000);
+    FileIO::fclose(f);
+
+    CHECK(transfer() == 4);
+
+    // shrinking the file truncates the copy
+    data.resize(blockSize * 3);
+    CHECK(transfer() == 0);
+  }
+
+  SECTION("Invalid block lists are rejected")
+  {
+    WriteTestFile(source, data);
+
+    FILE *f = FileIO::fopen(source.c_str(), "rb");
+    FileBlockList list;
+    ListFileBlocks(f, list);
+    FileIO::fclose(f);
+
+    FileBlockList wrongBlockSize = list;
+    wrongBlockSize.blockSize *= 2;
+
+    FileBlockList tooManyBlocks = list;
+    tooManyBlocks.hashes.push_back(0);
+
+    FileBlockList tooFewBlocks = list;
+    tooFewBlocks.fileSize *= 4;
+
+    for(const FileBlockList &invalid : {wrongBlockSize, tooManyBlocks, tooFewBlocks})
+    {
+      bool received = true;
+      Threading::ThreadHandle receiver = Threading::CreateThread([&]() {
+        received = ReceiveFileBlocks(receiverReader, receiverWriter,
+                                     eRemoteServer_CopyCaptureToRemote, staging, "", invalid, NULL);
+      });
+
+      // the receiver asks for nothing, so the connection is still usable afterwards
+      uint32_t numSent = ~0U;
+      CHECK(SendFileBlocks(senderReader, senderWriter, eRemoteServer_CopyCaptureToRemote, NULL,
+                           invalid, NULL, &numSent));
+
+      Threading::JoinThread(receiver);
+      Threading::CloseThread(receiver);
+
+      CHECK_FALSE(received);
+      CHECK(numSent == 0);
+    }
+
+    CHECK(transfer() == 6);
+  }
+
+  FileIO::Delete(source.c_str());
+  FileIO::Delete(staging.c_str());
+
+  SAFE_DELETE(senderSock);
+  SAFE_DELETE(receiverSock);
+  SAFE_DELETE(server);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
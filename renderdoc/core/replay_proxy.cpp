@@ -24,17 +24,24 @@
  ******************************************************************************/
 
 #include "replay_proxy.h"
+#include <algorithm>
 #include "3rdparty/lz4/lz4.h"
+#include "serialise/blockio.h"
 #include "serialise/lz4io.h"
+#include "serialise/zstdio.h"
 
 // utility macros for implementing proxied functions
 
 // begins a chunk with the given packet type, and if reading verifies that the
-// read type was what was expected - otherwise sets an error flag
+// read type was what was expected - otherwise sets an error flag. Responses to any requests that
+// were sent ahead are received first, since they come back in the order the requests were sent.
 #define PACKET_HEADER(packet)                                         \
+  if(ser.IsReading())                                                 \
+    ReceivePrefetches();                                              \
   ReplayProxyPacket p = (ReplayProxyPacket)ser.BeginChunk(packet, 0); \
   if(ser.IsReading() && p != packet)                                  \
-    m_IsErrored = true;
+    m_IsErrored = true;                                               \
+  SerialiseResponseID(ser);
 
 // begins the set of parameters. Note that we only begin a chunk when writing (sending a request to
 // the remote server), since on reading the chunk has already been begun to read the type to
@@ -42,7 +49,8 @@
 #define BEGIN_PARAMS()             \
   ParamSerialiser &ser = paramser; \
   if(ser.IsWriting())              \
-    ser.BeginChunk(packet, 0);
+    ser.BeginChunk(packet, 0);     \
+  SerialiseRequestID(ser);
 
 // end the set of parameters, and that chunk.
 #define END_PARAMS() ser.EndChunk();
@@ -68,6 +76,10 @@
 
 ReplayProxy::~ReplayProxy()
 {
+  // don't leave prefetched data on the connection for whatever reads from it next
+  if(!m_RemoteServer)
+    ReceivePrefetches();
+
   ShutdownPreviewWindow();
 
   if(m_Proxy)
@@ -78,6 +90,36 @@ ReplayProxy::~ReplayProxy()
     delete it->second;
 }
 
+template <typename SerialiserType>
+void ReplayProxy::SerialiseRequestID(SerialiserType &ser)
+{
+  uint32_t requestID = 0;
+
+  // the host numbers requests as it sends them, the remote server remembers the number of the one
+  // it's handling to send back in the response.
+  if(ser.IsWriting())
+    requestID = m_ExpectedResponseID = ++m_NextRequestID;
+
+  SERIALISE_ELEMENT(requestID);
+
+  if(ser.IsReading())
+    m_CurrentRequestID = requestID;
+}
+
+template <typename SerialiserType>
+void ReplayProxy::SerialiseResponseID(SerialiserType &ser)
+{
+  uint32_t requestID = m_CurrentRequestID;
+
+  SERIALISE_ELEMENT(requestID);
+
+  if(ser.IsReading() && requestID != m_ExpectedResponseID)
+  {
+    RDCERR("Received response to request %u, expected %u", requestID, m_ExpectedResponseID);
+    m_IsErrored = true;
+  }
+}
+
 #pragma region Proxied Functions
 
 template <typename ParamSerialiser, typename ReturnSerialiser>
@@ -381,6 +423,10 @@ FrameRecord ReplayProxy::Proxied_GetFrameRecord(ParamSerialiser &paramser, Retur
 
   SERIALISE_RETURN(ret);
 
+  // keep a copy on the host so we can look up the outputs of each draw for prefetching
+  if(retser.IsReading())
+    m_FrameRecord = ret;
+
   return ret;
 }
 
@@ -1303,6 +1349,9 @@ void ReplayProxy::Proxied_ReplayLog(ParamSerialiser &paramser, ReturnSerialiser
 
   if(retser.IsReading())
   {
+    // any prefetched data is for the previous event, so it must be received before it's thrown away
+    ReceivePrefetches();
+
     m_TextureProxyCache.clear();
     m_BufferProxyCache.clear();
   }
@@ -1312,7 +1361,18 @@ void ReplayProxy::Proxied_ReplayLog(ParamSerialiser &paramser, ReturnSerialiser
 
 void ReplayProxy::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
 {
-  PROXY_FUNCTION(ReplayLog, endEventID, replayType);
+  if(m_RemoteServer)
+  {
+    Proxied_ReplayLog(m_Reader, m_Writer, endEventID, replayType);
+    return;
+  }
+
+  Proxied_ReplayLog(m_Writer, m_Reader, endEventID, replayType);
+
+  // selecting an event replays up to it without the draw, then only the draw. Either way once the
+  // draw has been replayed the outputs are in the state that will be displayed.
+  if(replayType == eReplay_Full || replayType == eReplay_OnlyDraw)
+    PrefetchEventOutputs(endEventID);
 }
 
 template <typename ParamSerialiser, typename ReturnSerialiser>
@@ -1373,31 +1433,197 @@ void ReplayProxy::FetchStructuredFile()
   PROXY_FUNCTION(FetchStructuredFile);
 }
 
-struct DeltaSection
+template <typename ParamSerialiser, typename ReturnSerialiser>
+void ReplayProxy::Proxied_LoadStructuredChunk(ParamSerialiser &paramser, ReturnSerialiser &retser,
+                                              uint32_t chunkIndex)
 {
-  uint64_t offs = 0;
-  bytebuf contents;
+  const ReplayProxyPacket packet = eReplayProxy_LoadStructuredChunk;
+
+  // once a chunk has been fetched its contents are complete, so don't fetch it again
+  if(retser.IsReading() &&
+     m_LoadedStructuredChunks.find(chunkIndex) != m_LoadedStructuredChunks.end())
+    return;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(chunkIndex);
+    END_PARAMS();
+  }
+
+  SDFile *file = &m_StructuredFile;
+
+  if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+  {
+    m_Remote->LoadStructuredChunk(chunkIndex);
+    file = (SDFile *)&m_Remote->GetStructuredFile();
+  }
+
+  {
+    ReturnSerialiser &ser = retser;
+    PACKET_HEADER(packet);
+
+    bool valid = chunkIndex < file->chunks.size();
+    SERIALISE_ELEMENT(valid);
+
+    if(valid)
+    {
+      // read into a temporary chunk so that the existing one stays where it is
+      SDChunk loaded("");
+      SDChunk *chunk = retser.IsReading() ? &loaded : file->chunks[chunkIndex];
+
+      ser.Serialise("chunk", *chunk);
+
+      if(retser.IsReading() && !ser.IsErrored() && chunkIndex < file->chunks.size())
+      {
+        SDChunk *dst = file->chunks[chunkIndex];
+
+        dst->type.flags = loaded.type.flags;
+        dst->data.basic = loaded.data.basic;
+        dst->data.children.swap(loaded.data.children);
+
+        m_LoadedStructuredChunks.insert(chunkIndex);
+      }
+    }
+
+    ser.EndChunk();
+  }
+}
+
+void ReplayProxy::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  PROXY_FUNCTION(LoadStructuredChunk, chunkIndex);
+}
+
+// Deltas are sent as a header and a table of the changed ranges, followed by the contents of every
+// range back to back. The contents are streamed straight from the new data into the compressor and
+// decompressed straight into the reference data on the other side, so they're never copied into
+// intermediate buffers.
+struct DeltaHeader
+{
+  // the total size of the data, so that the reference data can be created or resized to match
+  uint64_t dataSize;
+  uint64_t numRanges;
 };
 
-DECLARE_REFLECTION_STRUCT(DeltaSection);
+struct DeltaRange
+{
+  uint64_t offs;
+  uint64_t length;
+};
 
-template <typename SerialiserType>
-void DoSerialise(SerialiserType &ser, DeltaSection &el)
+static BlockCodec GetDeltaCodec()
 {
-  SERIALISE_MEMBER(offs);
-  SERIALISE_MEMBER(contents);
+  // LZ4 is the default since it's fastest, but zstd is much smaller over slow connections.
+  return RenderDoc::Inst().GetConfigSetting("Replay_ProxyCompression") == "zstd" ? BlockCodec::Zstd
+                                                                                : BlockCodec::LZ4;
 }
 
-template <typename SerialiserType>
-void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &referenceData, bytebuf &newData)
+static Compressor *CreateDeltaCompressor(BlockCodec codec, StreamWriter *writer)
 {
-  char empty[128] = {};
+  if(codec == BlockCodec::Zstd)
+    return new ZSTDCompressor(writer, Ownership::Nothing);
 
-  // we use a list so that we don't have to reserve and pushing new sections will never cause
-  // previous ones to be reallocated and move around lots of data.
-  std::list<DeltaSection> deltas;
+  return new LZ4Compressor(writer, Ownership::Nothing);
+}
 
-  // lz4 compress
+static Decompressor *CreateDeltaDecompressor(BlockCodec codec, StreamReader *reader)
+{
+  if(codec == BlockCodec::Zstd)
+    return new ZSTDDecompressor(reader, Ownership::Nothing);
+  if(codec == BlockCodec::LZ4)
+    return new LZ4Decompressor(reader, Ownership::Nothing);
+
+  return NULL;
+}
+
+static uint64_t GetDeltaSize(const std::vector<DiffRange> &ranges)
+{
+  uint64_t ret = sizeof(DeltaHeader) + ranges.size() * sizeof(DeltaRange);
+
+  for(const DiffRange &range : ranges)
+    ret += range.end - range.start;
+
+  return ret;
+}
+
+static bool WriteDeltas(Compressor &comp, const bytebuf &data, const std::vector<DiffRange> &ranges)
+{
+  bool success = true;
+
+  DeltaHeader header = {data.size(), ranges.size()};
+  success &= comp.Write(&header, sizeof(header));
+
+  std::vector<DeltaRange> table(ranges.size());
+  for(size_t i = 0; i < ranges.size(); i++)
+  {
+    table[i].offs = ranges[i].start;
+    table[i].length = ranges[i].end - ranges[i].start;
+  }
+
+  success &= comp.Write(table.data(), table.size() * sizeof(DeltaRange));
+
+  for(size_t i = 0; success && i < ranges.size(); i++)
+    success &= comp.Write(data.data() + ranges[i].start, ranges[i].end - ranges[i].start);
+
+  success &= comp.Finish();
+
+  return success;
+}
+
+static bool ReadDeltas(Decompressor &decomp, bytebuf &referenceData)
+{
+  DeltaHeader header = {};
+
+  // every range must contain at least one byte, except for a full transfer of empty data
+  if(!decomp.Read(&header, sizeof(header)) ||
+     header.numRanges > RDCMAX(header.dataSize, (uint64_t)1))
+  {
+    RDCERR("Invalid delta header, %llu ranges for %llu bytes", header.numRanges, header.dataSize);
+    return false;
+  }
+
+  std::vector<DeltaRange> table((size_t)header.numRanges);
+  if(!decomp.Read(table.data(), table.size() * sizeof(DeltaRange)))
+    return false;
+
+  if(referenceData.size() != header.dataSize)
+  {
+    if(!referenceData.empty())
+      RDCERR("Reference data existed at %llu bytes, but deltas are for %llu bytes - resizing.",
+             (uint64_t)referenceData.size(), header.dataSize);
+
+    referenceData.resize((size_t)header.dataSize);
+  }
+
+  uint64_t deltaBytes = 0;
+
+  for(const DeltaRange &range : table)
+  {
+    if(range.offs > header.dataSize || range.length > header.dataSize - range.offs)
+    {
+      // the ranges come from a diff of data this size, so this is corrupt and we can't trust
+      // anything else either.
+      RDCERR("{%llu, %llu} larger than reference data (%llu bytes)", range.offs, range.length,
+             header.dataSize);
+      return false;
+    }
+
+    // decompress straight into place
+    if(!decomp.Read(referenceData.data() + (ptrdiff_t)range.offs, range.length))
+      return false;
+
+    deltaBytes += range.length;
+  }
+
+  RDCDEBUG("Applied %llu deltas, %llu total delta bytes to %llu resource size", header.numRanges,
+           deltaBytes, header.dataSize);
+
+  return true;
+}
+
+template <typename SerialiserType>
+void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &referenceData, bytebuf &newData)
+{
   if(xferser.IsReading())
   {
     uint64_t uncompSize = 0;
@@ -1409,208 +1635,77 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
       RDCDEBUG("Unchanged");
       return;
     }
-    else
-    {
-      {
-        ReadSerialiser ser(
-            new StreamReader(new LZ4Decompressor(xferser.GetReader(), Ownership::Nothing),
-                             uncompSize, Ownership::Stream),
-            Ownership::Stream);
-
-        SERIALISE_ELEMENT(deltas);
-
-        // add any necessary padding.
-        uint64_t offs = ser.GetReader()->GetOffset();
-        RDCASSERT(offs <= uncompSize, offs, uncompSize);
-        RDCASSERT(uncompSize - offs < sizeof(empty), offs, uncompSize);
 
-        ser.GetReader()->Read(empty, uncompSize - offs);
-      }
-
-      if(deltas.empty())
-      {
-        RDCERR("Unexpected empty delta list");
-      }
-      else if(referenceData.empty())
-      {
-        // if we don't have reference data we blat the whole contents.
-        // in this case we only expect one delta with the whole range
-        if(deltas.size() != 1)
-          RDCERR("Got more than one delta with no reference data - taking first delta.");
-
-        referenceData = deltas.front().contents;
-        RDCDEBUG("Creating new reference data, %llu bytes", (uint64_t)referenceData.size());
-      }
-      else
-      {
-        uint64_t deltaBytes = 0;
-
-        // apply deltas to refData
-        for(const DeltaSection &delta : deltas)
-        {
-          if(delta.offs + delta.contents.size() > referenceData.size())
-          {
-            RDCERR("{%llu, %llu} larger than reference data (%llu bytes) - expanding to fit.",
-                   delta.offs, (uint64_t)delta.contents.size(), (uint64_t)referenceData.size());
-
-            referenceData.resize(size_t(delta.offs + delta.contents.size()));
-          }
-
-          byte *dst = referenceData.data() + (ptrdiff_t)delta.offs;
-          const byte *src = delta.contents.data();
+    uint32_t codec = 0;
+    xferser.Serialise("codec", codec);
 
-          memcpy(dst, src, delta.contents.size());
+    Decompressor *decomp = CreateDeltaDecompressor((BlockCodec)codec, xferser.GetReader());
 
-          deltaBytes += (uint64_t)delta.contents.size();
-        }
+    if(!decomp)
+    {
+      // we can't skip data we can't decompress, so the stream is unusable from here on
+      RDCERR("Unknown delta compression codec %u", codec);
+      m_IsErrored = true;
+      return;
+    }
 
-        RDCDEBUG("Applied %u deltas data, %llu total delta bytes to %llu resource size",
-                 (uint32_t)deltas.size(), deltaBytes, (uint64_t)referenceData.size());
-      }
+    if(!ReadDeltas(*decomp, referenceData))
+    {
+      RDCERR("Failed to apply deltas");
+      m_IsErrored = true;
     }
+
+    delete decomp;
   }
   else
   {
-    uint64_t uncompSize = 0;
+    std::vector<DiffRange> ranges;
 
     if(referenceData.empty())
     {
       // no previous reference data, need to transfer the whole object.
-      deltas.resize(1);
-      deltas.back().contents = newData;
+      ranges.push_back({0, newData.size()});
     }
-    else
+    else if(referenceData.size() != newData.size())
     {
-      if(referenceData.size() != newData.size())
-      {
-        RDCERR("Reference data existed at %llu bytes, but new data is now %llu bytes",
-               referenceData.size(), newData.size());
-
-        // re-transfer the whole block, something went seriously wrong if the resource changed size.
-        deltas.resize(1);
-        deltas.back().contents = newData;
-      }
-      else
-      {
-        // do actual diff.
-        const byte *srcBegin = newData.data();
-        const byte *src = srcBegin;
-        const byte *dst = referenceData.data();
-        size_t bytesRemain = newData.size();
-
-        // we only care about large-ish chunks at a time. This prevents us generating lots of tiny
-        // deltas where we could batch changes together. This is tuned to not be too large (and
-        // thus causing us to miss too many sections we could skip) and not too small (causing us
-        // to devolve into lots of byte-wise deltas). The current value as of this comment of 128
-        // is definitely on the small end of the range, but consider e.g. an android image of
-        // 1440x2560 and a pixel-wide line that goes vertically from top to bottom. Reading
-        // horizontally that will mean 2560 different diffs, and only actually one pixel changed.
-        // The larger this value gets, the more redundant data we'll send along with.
-        const size_t chunkSize = 128;
-
-        // we use a simple state machine. Start in state 1
-        //
-        // State 1: No active delta. Look at the current chunk, if there's no difference move to the
-        //          next chunk and stay in this state. If there is a difference, push a delta onto
-        //          the list at the current offset. Copy the current chunk into the contents of the
-        //          delta. Move to state 2.
-        // State 2. Active delta. Look at the current chunk, if there is a difference then append
-        //          the current chunk to the last delta's contents, move to the next chunk, and stay
-        //          in this state. If there isn't a difference, move back to state 1 (the delta is
-        //          already 'finished' so we have no need to do anything more on it).
-        //
-        // At any point we can end the loop, both states are 'complete' at all points.
-
-        enum DeltaState
-        {
-          None,
-          Active
-        };
-        DeltaState state = DeltaState::None;
+      RDCERR("Reference data existed at %llu bytes, but new data is now %llu bytes",
+             referenceData.size(), newData.size());
 
-        // loop over whole chunks
-        while(bytesRemain > chunkSize)
-        {
-          // check if there's a difference in this chunk.
-          bool chunkDiff = memcmp(src, dst, chunkSize) != 0;
-
-          // if we're in state 1
-          if(state == DeltaState::None)
-          {
-            // if there's a difference, append a new delta with the current offset and chunk
-            // contents and move to state 2
-            if(chunkDiff)
-            {
-              deltas.push_back(DeltaSection());
-              deltas.back().offs = src - srcBegin;
-              deltas.back().contents.append(src, chunkSize);
-
-              state = DeltaState::Active;
-            }
-          }
-          // if we're in state 2
-          else if(state == DeltaState::Active)
-          {
-            // continue to append to the delta if there's another difference in this chunk.
-            if(chunkDiff)
-            {
-              deltas.back().contents.append(src, chunkSize);
-            }
-            else
-            {
-              state = DeltaState::None;
-            }
-          }
-
-          // move to the next chunk
-          bytesRemain -= chunkSize;
-          src += chunkSize;
-          dst += chunkSize;
-        }
-
-        // if there are still some bytes remaining at the end of the image, smaller than the chunk
-        // size, just diff directly and send if needed. We could combine this with the last delta if
-        // we ended in the active state.
-        if(bytesRemain > 0 && memcmp(src, dst, bytesRemain))
-        {
-          deltas.push_back(DeltaSection());
-          deltas.back().offs = src - srcBegin;
-          deltas.back().contents.append(src, bytesRemain);
-        }
-      }
-    }
-
-    // fast path - no changes.
-    if(deltas.empty())
-    {
-      uncompSize = 0;
+      // re-transfer the whole block, something went seriously wrong if the resource changed size.
+      ranges.push_back({0, newData.size()});
     }
     else
     {
-      // serialise to an invalid writer, to get the size of the data that will be written.
-      WriteSerialiser ser(new StreamWriter(StreamWriter::InvalidStream), Ownership::Stream);
-
-      SERIALISE_ELEMENT(deltas);
-
-      uncompSize = ser.GetWriter()->GetOffset() + ser.GetChunkAlignment();
+      // we only care about large-ish gaps between changes. This prevents us generating lots of
+      // tiny deltas where we could batch changes together. This is tuned to not be too large (and
+      // thus causing us to send too many unchanged bytes) and not too small (causing us to
+      // devolve into lots of byte-wise deltas, each with its own overhead). Consider e.g. an
+      // android image of 1440x2560 and a pixel-wide line that goes vertically from top to bottom.
+      // Reading horizontally that will mean 2560 different diffs, and only actually one pixel
+      // changed.
+      const size_t gapThreshold = 128;
+
+      FindDiffRanges(newData.data(), referenceData.data(), newData.size(), gapThreshold, ranges);
     }
 
+    // fast path - no changes.
+    uint64_t uncompSize = ranges.empty() ? 0 : GetDeltaSize(ranges);
+
     xferser.Serialise("uncompSize", uncompSize);
 
     if(uncompSize > 0)
     {
-      WriteSerialiser ser(new StreamWriter(new LZ4Compressor(xferser.GetWriter(), Ownership::Nothing),
-                                           Ownership::Stream),
-                          Ownership::Stream);
+      BlockCodec codec = GetDeltaCodec();
+
+      uint32_t codecValue = (uint32_t)codec;
+      xferser.Serialise("codec", codecValue);
 
-      SERIALISE_ELEMENT(deltas);
+      Compressor *comp = CreateDeltaCompressor(codec, xferser.GetWriter());
 
-      // add any necessary padding.
-      uint64_t offs = ser.GetWriter()->GetOffset();
-      RDCASSERT(offs <= uncompSize, offs, uncompSize);
-      RDCASSERT(uncompSize - offs < sizeof(empty), offs, uncompSize);
+      if(!WriteDeltas(*comp, newData, ranges))
+        RDCERR("Failed to write deltas");
 
-      ser.GetWriter()->Write(empty, uncompSize - offs);
+      delete comp;
     }
 
     // This is the proxy side, so we have the complete newest contents in data. Swap the new data
@@ -1767,11 +1862,137 @@ void ReplayProxy::RemapProxyTextureIfNeeded(TextureDescription &tex, GetTextureD
   }
 }
 
+void ReplayProxy::PrefetchEventOutputs(uint32_t eventId)
+{
+  if(RenderDoc::Inst().GetConfigSetting("Replay_ProxyPrefetch") != "1")
+    return;
+
+  if(m_Reader.IsErrored() || m_Writer.IsErrored() || m_IsErrored)
+    return;
+
+  const DrawcallDescription *draw = FindDraw(m_FrameRecord.drawcallList, eventId);
+
+  if(draw == NULL)
+    return;
+
+  // stepping through events often moves between passes, so also fetch the targets of the draws on
+  // either side. The current draw's come first as they're the most likely to be displayed.
+  std::vector<ResourceId> targets;
+
+  auto addTargets = [&targets](const DrawcallDescription *d) {
+    if(d == NULL)
+      return;
+
+    for(ResourceId id : d->outputs)
+      if(id != ResourceId() && std::find(targets.begin(), targets.end(), id) == targets.end())
+        targets.push_back(id);
+
+    if(d->depthOut != ResourceId() &&
+       std::find(targets.begin(), targets.end(), d->depthOut) == targets.end())
+      targets.push_back(d->depthOut);
+  };
+
+  addTargets(draw);
+
+  if(draw->previous)
+    addTargets(FindDraw(m_FrameRecord.drawcallList, (uint32_t)draw->previous));
+  if(draw->next)
+    addTargets(FindDraw(m_FrameRecord.drawcallList, (uint32_t)draw->next));
+
+  for(ResourceId id : targets)
+  {
+
+    // textures are cached by live ID. Only use IDs we've already looked up, a lookup would cost the
+    // round trip we're trying to save.
+    auto liveit = m_LiveIDs.find(id);
+    if(liveit != m_LiveIDs.end())
+      id = liveit->second;
+
+    // only prefetch textures that have been displayed before, which already have a proxy texture
+    // and the params used to fetch it. This also skips local textures.
+    auto proxyit = m_ProxyTextures.find(id);
+    if(proxyit == m_ProxyTextures.end())
+      continue;
+
+    TextureCacheEntry entry = {id, 0, 0};
+
+    bool pending = false;
+    for(const PendingTexturePrefetch &prefetch : m_PendingPrefetches)
+      pending |= !(prefetch.entry < entry) && !(entry < prefetch.entry);
+
+    if(pending || m_TextureProxyCache.find(entry) != m_TextureProxyCache.end())
+      continue;
+
+    // send the same request as CacheTextureData, but don't wait for the response. The remote server
+    // handles it like any other.
+    {
+      const ReplayProxyPacket packet = eReplayProxy_CacheTextureData;
+      WriteSerialiser &ser = m_Writer;
+
+      ser.BeginChunk(packet, 0);
+      SerialiseRequestID(ser);
+      SERIALISE_ELEMENT_LOCAL(tex, entry.replayid);
+      SERIALISE_ELEMENT_LOCAL(arrayIdx, entry.arrayIdx);
+      SERIALISE_ELEMENT_LOCAL(mip, entry.mip);
+      SERIALISE_ELEMENT_LOCAL(params, proxyit->second.params);
+      ser.EndChunk();
+    }
+
+    PendingTexturePrefetch prefetch = {m_NextRequestID, entry};
+    m_PendingPrefetches.push_back(prefetch);
+  }
+}
+
+void ReplayProxy::ReceivePrefetches()
+{
+  if(m_PendingPrefetches.empty())
+    return;
+
+  // take the list so that receiving below doesn't recurse back in
+  std::vector<PendingTexturePrefetch> pending;
+  pending.swap(m_PendingPrefetches);
+
+  // we may be in the middle of receiving the response to another request
+  uint32_t expectedID = m_ExpectedResponseID;
+
+  for(const PendingTexturePrefetch &prefetch : pending)
+  {
+    if(m_Reader.IsErrored() || m_IsErrored)
+      break;
+
+    m_ExpectedResponseID = prefetch.requestID;
+
+    // the response half of Proxied_CacheTextureData
+    {
+      const ReplayProxyPacket packet = eReplayProxy_CacheTextureData;
+      ReadSerialiser &ser = m_Reader;
+      PACKET_HEADER(packet);
+    }
+
+    bytebuf unused;
+    bytebuf &data = m_ProxyTextureData[prefetch.entry];
+    DeltaTransferBytes(m_Reader, data, unused);
+
+    m_Reader.EndChunk();
+
+    m_Proxy->SetProxyTextureData(m_ProxyTextures[prefetch.entry.replayid].id,
+                                 prefetch.entry.arrayIdx, prefetch.entry.mip, data.data(),
+                                 data.size());
+
+    m_TextureProxyCache.insert(prefetch.entry);
+  }
+
+  m_ExpectedResponseID = expectedID;
+}
+
 void ReplayProxy::EnsureTexCached(ResourceId texid, uint32_t arrayIdx, uint32_t mip)
 {
   if(m_Reader.IsErrored() || m_Writer.IsErrored())
     return;
 
+  // if this texture was prefetched, its data could already be on its way
+  ReceivePrefetches();
+
   TextureCacheEntry entry = {texid, arrayIdx, mip};
 
   if(m_LocalTextures.find(texid) != m_LocalTextures.end())
@@ -2074,6 +2295,7 @@ bool ReplayProxy::Tick(int type)
       break;
     case eReplayProxy_DisassembleShader: DisassembleShader(ResourceId(), NULL, ""); break;
     case eReplayProxy_GetDisassemblyTargets: GetDisassemblyTargets(); break;
+    case eReplayProxy_LoadStructuredChunk: LoadStructuredChunk(0); break;
     default: RDCERR("Unexpected command %u", type); return false;
   }
 
@@ -2084,3 +2306,176 @@ bool ReplayProxy::Tick(int type)
 
   return true;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+// a 4K RGBA8 render target, with the kinds of changes typically seen between two fetches
+struct DeltaPattern
+{
+  const char *name;
+  std::function<void(bytebuf &)> edit;
+};
+
+static const uint32_t deltaWidth = 3840, deltaHeight = 2160;
+
+static std::vector<DeltaPattern> GetDeltaPatterns()
+{
+  const uint32_t w = deltaWidth, h = deltaHeight;
+
+  return {
+      {"unchanged", [](bytebuf &) {}},
+      {"small rect",
+       [w](bytebuf &data) {
+         for(uint32_t y = 1000; y < 1064; y++)
+           memset(data.data() + (y * w + 1800) * 4, 0x40, 64 * 4);
+       }},
+      {"vertical line",
+       [w, h](bytebuf &data) {
+         for(uint32_t y = 0; y < h; y++)
+           memset(data.data() + (y * w + 2000) * 4, 0xff, 4);
+       }},
+      {"bottom half redrawn",
+       [w, h](bytebuf &data) {
+         for(size_t i = (w * h / 2) * 4; i < data.size(); i++)
+           data[i] = byte((i * 3) >> 8);
+       }},
+      {"cleared", [](bytebuf &data) { memset(data.data(), 0x20, data.size()); }},
+  };
+}
+
+static bytebuf MakeDeltaTexture()
+{
+  bytebuf ret;
+  ret.resize(deltaWidth * deltaHeight * 4);
+
+  // a smooth gradient, roughly as compressible as a real render
+  for(uint32_t y = 0; y < deltaHeight; y++)
+  {
+    for(uint32_t x = 0; x < deltaWidth; x++)
+    {
+      byte *px = ret.data() + (y * deltaWidth + x) * 4;
+      px[0] = byte(x >> 4);
+      px[1] = byte(y >> 3);
+      px[2] = byte((x + y) >> 5);
+      px[3] = 0xff;
+    }
+  }
+
+  return ret;
+}
+
+TEST_CASE("Check delta transfer round-trips", "[replayproxy]")
+{
+  bytebuf original = MakeDeltaTexture();
+
+  for(BlockCodec codec : {BlockCodec::LZ4, BlockCodec::Zstd})
+  {
+    for(const DeltaPattern &p : GetDeltaPatterns())
+    {
+      bytebuf reference = original;
+      bytebuf edited = original;
+      p.edit(edited);
+
+      std::vector<DiffRange> ranges;
+      FindDiffRanges(edited.data(), reference.data(), edited.size(), 128, ranges);
+
+      StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+      {
+        Compressor *comp = CreateDeltaCompressor(codec, &buf);
+        CHECK(WriteDeltas(*comp, edited, ranges));
+        delete comp;
+      }
+
+      {
+        StreamReader reader(buf.GetData(), buf.GetOffset());
+        Decompressor *decomp = CreateDeltaDecompressor(codec, &reader);
+        CHECK(ReadDeltas(*decomp, reference));
+        delete decomp;
+      }
+
+      INFO(p.name);
+      CHECK(reference.size() == edited.size());
+      CHECK(memcmp(reference.data(), edited.data(), edited.size()) == 0);
+    }
+  }
+
+  // a full transfer with no reference data, as for the first fetch
+  {
+    std::vector<DiffRange> ranges = {{0, original.size()}};
+
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      Compressor *comp = CreateDeltaCompressor(BlockCodec::LZ4, &buf);
+      CHECK(WriteDeltas(*comp, original, ranges));
+      delete comp;
+    }
+
+    bytebuf reference;
+
+    {
+      StreamReader reader(buf.GetData(), buf.GetOffset());
+      Decompressor *decomp = CreateDeltaDecompressor(BlockCodec::LZ4, &reader);
+      CHECK(ReadDeltas(*decomp, reference));
+      delete decomp;
+    }
+
+    CHECK(reference.size() == original.size());
+    CHECK(memcmp(reference.data(), original.data(), original.size()) == 0);
+  }
+};
+
+TEST_CASE("Benchmark delta transfer", "[replayproxy][!benchmark]")
+{
+  bytebuf original = MakeDeltaTexture();
+
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  for(const DeltaPattern &p : GetDeltaPatterns())
+  {
+    bytebuf edited = original;
+    p.edit(edited);
+
+    std::vector<DiffRange> ranges;
+
+    BENCHMARK(StringFormat::Fmt("Diff: %s", p.name))
+    {
+      FindDiffRanges(edited.data(), original.data(), edited.size(), 128, ranges);
+    }
+
+    if(ranges.empty())
+      continue;
+
+    const char *codecNames[] = {"", "LZ4", "Zstd"};
+
+    for(BlockCodec codec : {BlockCodec::LZ4, BlockCodec::Zstd})
+    {
+      BENCHMARK(StringFormat::Fmt("Compress %s: %s", codecNames[(uint32_t)codec], p.name))
+      {
+        buf.Rewind();
+        Compressor *comp = CreateDeltaCompressor(codec, &buf);
+        WriteDeltas(*comp, edited, ranges);
+        delete comp;
+      }
+
+      WARN(p.name << " with " << codecNames[(uint32_t)codec] << ": " << ranges.size()
+                  << " ranges, " << GetDeltaSize(ranges) << " bytes sent as " << buf.GetOffset()
+                  << " compressed");
+
+      bytebuf reference = original;
+
+      BENCHMARK(StringFormat::Fmt("Decompress %s: %s", codecNames[(uint32_t)codec], p.name))
+      {
+        StreamReader reader(buf.GetData(), buf.GetOffset());
+        Decompressor *decomp = CreateDeltaDecompressor(codec, &reader);
+        ReadDeltas(*decomp, reference);
+        delete decomp;
+      }
+    }
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -93,6 +93,8 @@ enum ReplayProxyPacket
 
   eReplayProxy_DisassembleShader,
   eReplayProxy_GetDisassemblyTargets,
+
+  eReplayProxy_LoadStructuredChunk,
 };
 
 #define IMPLEMENT_FUNCTION_PROXIED(rettype, name, ...)                                  \
@@ -145,6 +147,10 @@ public:
 
   bool IsRemoteProxy() { return !m_RemoteServer; }
   void Shutdown() { delete this; }
+
+  // receives any responses still in flight from requests sent without waiting, so that something
+  // else can use the connection.
+  void ReceivePendingResponses() { ReceivePrefetches(); }
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers)
   {
     return ReplayStatus::Succeeded;
@@ -424,6 +430,7 @@ public:
   const VKPipe::State &GetVulkanPipelineState() { return m_VulkanPipelineState; }
   const SDFile &GetStructuredFile() { return m_StructuredFile; }
   IMPLEMENT_FUNCTION_PROXIED(void, FetchStructuredFile);
+  IMPLEMENT_FUNCTION_PROXIED(void, LoadStructuredChunk, uint32_t chunkIndex);
 
   IMPLEMENT_FUNCTION_PROXIED(const std::vector<ResourceDescription> &, GetResources);
 
@@ -546,6 +553,21 @@ private:
   const DrawcallDescription *FindDraw(const rdcarray<DrawcallDescription> &drawcallList,
                                       uint32_t eventId);
 
+  // every request carries an ID which the remote server sends back in its response, so that
+  // requests can be sent without waiting for previous responses and each response is checked
+  // against the request it answers.
+  template <typename SerialiserType>
+  void SerialiseRequestID(SerialiserType &ser);
+  template <typename SerialiserType>
+  void SerialiseResponseID(SerialiserType &ser);
+
+  // after replaying to an event, request the current contents of its outputs and those of the
+  // draws either side of it, without waiting for them. They're almost always displayed next, so
+  // this saves a round trip per output. Enabled with the Replay_ProxyPrefetch config setting.
+  void PrefetchEventOutputs(uint32_t eventId);
+  // receive the responses to any prefetch requests and update the proxy textures with them.
+  void ReceivePrefetches();
+
   struct TextureCacheEntry
   {
     ResourceId replayid;
@@ -587,6 +609,21 @@ private:
   // on the remote side to determine which deltas are necessary, and then each time on the client
   // side the data is uploaded into the proxy textures above.
   std::map<TextureCacheEntry, bytebuf> m_ProxyTextureData;
+
+  // prefetch requests that have been sent but whose responses haven't been received yet. The
+  // responses come back in order, before the response to any later request.
+  struct PendingTexturePrefetch
+  {
+    uint32_t requestID;
+    TextureCacheEntry entry;
+  };
+  std::vector<PendingTexturePrefetch> m_PendingPrefetches;
+
+  // on the host, the last ID assigned and the ID the next response should have. On the remote
+  // server, the ID of the request currently being handled.
+  uint32_t m_NextRequestID = 0;
+  uint32_t m_ExpectedResponseID = 0;
+  uint32_t m_CurrentRequestID = 0;
   std::map<ResourceId, bytebuf> m_ProxyBufferData;
 
   // this lists any textures which are only created locally (e.g. custom visualisation shaders) and
@@ -650,6 +687,7 @@ private:
   APIProperties m_APIProps;
 
   SDFile m_StructuredFile;
+  std::set<uint32_t> m_LoadedStructuredChunks;
 
   std::vector<ResourceDescription> m_Resources;
 
@@ -51,47 +51,6 @@ void SetReplayResourceIDs()
 
 INSTANTIATE_SERIALISE_TYPE(ResourceManagerInternal::WrittenRecord);
 
-bool MarkReferenced(std::map<ResourceId, FrameRefType> &refs, ResourceId id, FrameRefType refType)
-{
-  if(refs.find(id) == refs.end())
-  {
-    if(refType == eFrameRef_Read)
-      refs[id] = eFrameRef_ReadOnly;
-    else if(refType == eFrameRef_Write)
-      refs[id] = eFrameRef_ReadAndWrite;
-    else    // unknown or existing state
-      refs[id] = refType;
-
-    return true;
-  }
-  else
-  {
-    if(refType == eFrameRef_Unknown)
-    {
-      // nothing
-    }
-    else if(refType == eFrameRef_ReadBeforeWrite)
-    {
-      // special case, explicitly set to ReadBeforeWrite for when
-      // we know that this use will likely be a partial-write
-      refs[id] = eFrameRef_ReadBeforeWrite;
-    }
-    else if(refs[id] == eFrameRef_Unknown)
-    {
-      if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
-        refs[id] = eFrameRef_ReadOnly;
-      else
-        refs[id] = eFrameRef_ReadAndWrite;
-    }
-    else if(refs[id] == eFrameRef_ReadOnly && refType == eFrameRef_Write)
-    {
-      refs[id] = eFrameRef_ReadBeforeWrite;
-    }
-  }
-
-  return false;
-}
-
 bool ResourceRecord::MarkResourceFrameReferenced(ResourceId id, FrameRefType refType)
 {
   if(id == ResourceId())
@@ -141,3 +100,153 @@ void ResourceRecord::Delete(ResourceRecordHandler *mgr)
     mgr->DestroyResourceRecord(this);
   }
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "strings/string_utils.h"
+
+namespace
+{
+struct TestRecord : public ResourceRecord
+{
+  static const uint64_t NullResource = 0;
+
+  TestRecord(ResourceId id) : ResourceRecord(id, true) {}
+};
+
+struct TestInitialContents
+{
+  template <typename Configuration>
+  void Free(ResourceManager<Configuration> *rm)
+  {
+  }
+};
+
+struct TestResourceManagerConfiguration
+{
+  typedef uint64_t WrappedResourceType;
+  typedef uint64_t RealResourceType;
+  typedef TestRecord RecordType;
+  typedef TestInitialContents InitialContentData;
+};
+
+class TestResourceManager : public ResourceManager<TestResourceManagerConfiguration>
+{
+public:
+  ~TestResourceManager() { Shutdown(); }
+  using ResourceManager::HasFrameReference;
+
+private:
+  bool SerialisableResource(ResourceId id, TestRecord *record) { return true; }
+  ResourceId GetID(uint64_t res) { return ResourceId(); }
+  bool ResourceTypeRelease(uint64_t res) { return true; }
+  bool Force_InitialState(uint64_t res, bool prepare) { return false; }
+  bool Need_InitialStateChunk(uint64_t res) { return false; }
+  bool Prepare_InitialState(uint64_t res) { return true; }
+  uint32_t GetSize_InitialState(ResourceId id, uint64_t res) { return 0; }
+  bool Serialise_InitialState(WriteSerialiser &ser, ResourceId id, uint64_t res) { return true; }
+  void Create_InitialState(ResourceId id, uint64_t live, bool hasData) {}
+  void Apply_InitialState(uint64_t live, TestInitialContents initial) {}
+};
+
+// marks references to a shared set of resources from several threads at once, the way threads
+// recording command buffers in parallel would.
+void MarkFromThreads(TestResourceManager &manager, const std::vector<ResourceId> &ids,
+                     uint32_t numThreads, uint32_t marksPerThread)
+{
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    threads.push_back(Threading::CreateThread([&manager, &ids, t, marksPerThread]() {
+      for(uint32_t i = 0; i < marksPerThread; i++)
+      {
+        // each use reads then writes, so whichever thread marks a resource first marks a read
+        ResourceId id = ids[(t * 7 + i) % ids.size()];
+        manager.MarkResourceFrameReferenced(id, eFrameRef_Read);
+        manager.MarkResourceFrameReferenced(id, eFrameRef_Write);
+      }
+    }));
+  }
+
+  for(Threading::ThreadHandle t : threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+}
+};
+
+TEST_CASE("Check frame references marked from multiple threads", "[resourcemanager]")
+{
+  TestResourceManager manager;
+
+  std::vector<ResourceId> ids;
+  std::vector<TestRecord *> records;
+
+  for(int i = 0; i < 1000; i++)
+  {
+    ids.push_back(ResourceIDGen::GetNewUniqueID());
+    records.push_back(manager.AddResourceRecord(ids.back()));
+  }
+
+  ResourceId unreferenced = ResourceIDGen::GetNewUniqueID();
+
+  MarkFromThreads(manager, ids, 8, 10000);
+
+  for(ResourceId id : ids)
+  {
+    CHECK(manager.HasFrameReference(id));
+    // every resource was read then written, whichever thread got there first
+    CHECK(manager.ReadBeforeWrite(id));
+  }
+
+  CHECK_FALSE(manager.HasFrameReference(unreferenced));
+
+  // each record gained exactly one reference for being in the frame, which clearing releases.
+  manager.ClearReferencedResources();
+
+  for(ResourceId id : ids)
+  {
+    CHECK_FALSE(manager.HasFrameReference(id));
+    CHECK(manager.HasResourceRecord(id));
+  }
+
+  for(TestRecord *record : records)
+    record->Delete(&manager);
+
+  for(ResourceId id : ids)
+    CHECK_FALSE(manager.HasResourceRecord(id));
+};
+
+TEST_CASE("Benchmark marking frame references", "[resourcemanager][!benchmark]")
+{
+  TestResourceManager manager;
+
+  std::vector<ResourceId> ids;
+  std::vector<TestRecord *> records;
+
+  for(int i = 0; i < 4096; i++)
+  {
+    ids.push_back(ResourceIDGen::GetNewUniqueID());
+    records.push_back(manager.AddResourceRecord(ids.back()));
+  }
+
+  // each thread does the same amount of work, so ideally the time stays constant as threads are
+  // added.
+  for(uint32_t numThreads : {1U, 2U, 4U, 8U, 16U})
+  {
+    BENCHMARK(StringFormat::Fmt("MarkResourceFrameReferenced, %u threads", numThreads))
+    {
+      MarkFromThreads(manager, ids, numThreads, 200000);
+    }
+
+    manager.ClearReferencedResources();
+  }
+
+  for(TestRecord *record : records)
+    record->Delete(&manager);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -25,8 +25,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include "api/replay/renderdoc_replay.h"
 #include "common/threading.h"
 #include "core/core.h"
@@ -54,7 +56,64 @@ enum FrameRefType
 };
 
 // handle marking a resource referenced for read or write and storing RAW access etc.
-bool MarkReferenced(std::map<ResourceId, FrameRefType> &refs, ResourceId id, FrameRefType refType);
+template <typename RefMap>
+bool MarkReferenced(RefMap &refs, ResourceId id, FrameRefType refType)
+{
+  auto it = refs.find(id);
+
+  if(it == refs.end())
+  {
+    if(refType == eFrameRef_Read)
+      refs[id] = eFrameRef_ReadOnly;
+    else if(refType == eFrameRef_Write)
+      refs[id] = eFrameRef_ReadAndWrite;
+    else    // unknown or existing state
+      refs[id] = refType;
+
+    return true;
+  }
+
+  FrameRefType &ref = it->second;
+
+  if(refType == eFrameRef_Unknown)
+  {
+    // nothing
+  }
+  else if(refType == eFrameRef_ReadBeforeWrite)
+  {
+    // special case, explicitly set to ReadBeforeWrite for when
+    // we know that this use will likely be a partial-write
+    ref = eFrameRef_ReadBeforeWrite;
+  }
+  else if(ref == eFrameRef_Unknown)
+  {
+    if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
+      ref = eFrameRef_ReadOnly;
+    else
+      ref = eFrameRef_ReadAndWrite;
+  }
+  else if(ref == eFrameRef_ReadOnly && refType == eFrameRef_Write)
+  {
+    ref = eFrameRef_ReadBeforeWrite;
+  }
+
+  return false;
+}
+
+// hashes a ResourceId for unordered containers. IDs are allocated sequentially so the bits are
+// mixed to spread neighbouring IDs apart.
+struct ResourceIdHash
+{
+  size_t operator()(ResourceId id) const
+  {
+    uint64_t val = 0;
+    memcpy(&val, &id, sizeof(val));
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+    return size_t(val);
+  }
+};
 
 // verbose prints with IDs of each dirty resource and whether it was prepared,
 // and whether it was serialised.
@@ -97,7 +156,8 @@ struct ResourceRecord
         DataOffset(0),
         Length(0),
         DataWritten(false),
-        SpecialResource(false)
+        SpecialResource(false),
+        TransientChunks(false)
   {
     m_ChunkLock = NULL;
 
@@ -175,6 +235,10 @@ struct ResourceRecord
 
   void AddChunk(Chunk *chunk, int32_t ID = 0)
   {
+    // long-lived chunks mustn't keep the rest of a shared allocator page alive
+    if(!TransientChunks)
+      chunk->Unpack();
+
     LockChunks();
     if(ID == 0)
       ID = GetID();
@@ -261,6 +325,10 @@ struct ResourceRecord
   bool SpecialResource;    // like the swap chain back buffers
   bool DataWritten;
 
+  // set for records whose chunks are regularly freed, like frame or command buffer recordings, so
+  // that their chunks can stay packed in the recording thread's allocator pages.
+  bool TransientChunks;
+
 protected:
   volatile int32_t RefCount;
 
@@ -429,25 +497,49 @@ protected:
   virtual void Create_InitialState(ResourceId id, WrappedResourceType live, bool hasData) = 0;
   virtual void Apply_InitialState(WrappedResourceType live, InitialContentData initial) = 0;
 
-  // very coarse lock, protects EVERYTHING. This could certainly be improved and it may be a
-  // bottleneck
-  // for performance. Given that the main use cases are write-rarely read-often the lock should be
-  // optimised
-  // for that as we only want to make sure we're not modifying the objects together, by far the most
-  // common
-  // operation is looking up data.
+  // returns true if the resource has been referenced in the current frame
+  bool HasFrameReference(ResourceId id);
+
+  // fetches a copy of all resources referenced in the current frame, sorted by ID
+  void GetFrameReferences(std::vector<std::pair<ResourceId, FrameRefType> > &refs);
+
+  // fetches a copy of all current resources, sorted by ID. Used to iterate over them without
+  // holding m_ResourceLock, so callbacks are free to look up resources.
+  void GetCurrentResources(std::vector<std::pair<ResourceId, WrappedResourceType> > &resources);
+
+  // follows any replacement for an ID. m_ResourceLock must be held.
+  ResourceId ResolveReplacement(ResourceId id);
+
+  // protects the dirty resource sets and initial contents, and serialises the bulk operations at
+  // the start and end of a capture.
   Threading::CriticalSection m_Lock;
 
-  // easy optimisation win - don't use maps everywhere. It's convenient but not optimal, and
-  // profiling will
-  // likely prove that some or all of these could be a problem
+  // protects the resource lookup maps below. These are looked up on nearly every API call from any
+  // number of threads, but only modified when resources are created or destroyed, so they're read
+  // locked for lookups. This lock is not recursive and nothing that could call back into the
+  // manager may be called while holding it.
+  Threading::RWLock m_ResourceLock;
 
   // used during capture - map from real resource to its wrapper (other way can be done just with an
   // Unwrap)
   map<RealResourceType, WrappedResourceType> m_WrapperMap;
 
-  // used during capture - holds resources referenced in current frame (and how they're referenced)
-  map<ResourceId, FrameRefType> m_FrameReferencedResources;
+  // used during capture - holds resources referenced in current frame (and how they're referenced).
+  // These are marked from every thread that records commands, so they are split by ID into
+  // independently locked shards so that threads rarely wait on each other.
+  struct FrameRefShard
+  {
+    Threading::CriticalSection lock;
+    std::unordered_map<ResourceId, FrameRefType, ResourceIdHash> refs;
+  };
+
+  static const uint32_t NumFrameRefShards = 16;
+  FrameRefShard m_FrameReferencedResources[NumFrameRefShards];
+
+  FrameRefShard &GetFrameRefShard(ResourceId id)
+  {
+    return m_FrameReferencedResources[ResourceIdHash()(id) % NumFrameRefShards];
+  }
 
   // used during capture - holds resources marked as dirty, needing initial contents
   set<ResourceId> m_DirtyResources;
@@ -461,19 +553,19 @@ protected:
 
   // used during capture or replay - map of resources currently alive with their real IDs, used in
   // capture and replay.
-  map<ResourceId, WrappedResourceType> m_CurrentResourceMap;
+  std::unordered_map<ResourceId, WrappedResourceType, ResourceIdHash> m_CurrentResourceMap;
 
   // used during replay - maps back and forth from original id to live id and vice-versa
-  map<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
+  std::unordered_map<ResourceId, ResourceId, ResourceIdHash> m_OriginalIDs, m_LiveIDs;
 
   // used during replay - holds resources allocated and the original id that they represent
-  map<ResourceId, WrappedResourceType> m_LiveResourceMap;
+  std::unordered_map<ResourceId, WrappedResourceType, ResourceIdHash> m_LiveResourceMap;
 
   // used during capture - holds resource records by id.
-  map<ResourceId, RecordType *> m_ResourceRecords;
+  std::unordered_map<ResourceId, RecordType *, ResourceIdHash> m_ResourceRecords;
 
   // used during replay - holds current resource replacements
-  map<ResourceId, ResourceId> m_Replacements;
+  std::unordered_map<ResourceId, ResourceId, ResourceIdHash> m_Replacements;
 };
 
 template <typename Configuration>
@@ -516,12 +608,14 @@ ResourceManager<Configuration>::~ResourceManager()
 template <typename Configuration>
 void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id, FrameRefType refType)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(id == ResourceId())
     return;
 
-  bool newRef = MarkReferenced(m_FrameReferencedResources, id, refType);
+  FrameRefShard &shard = GetFrameRefShard(id);
+
+  SCOPED_LOCK(shard.lock);
+
+  bool newRef = MarkReferenced(shard.refs, id, refType);
 
   if(newRef)
   {
@@ -535,13 +629,71 @@ void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id,
 template <typename Configuration>
 bool ResourceManager<Configuration>::ReadBeforeWrite(ResourceId id)
 {
-  if(m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end())
-    return m_FrameReferencedResources[id] == eFrameRef_ReadBeforeWrite ||
-           m_FrameReferencedResources[id] == eFrameRef_ReadOnly;
+  FrameRefShard &shard = GetFrameRefShard(id);
+
+  SCOPED_LOCK(shard.lock);
+
+  auto it = shard.refs.find(id);
+
+  if(it != shard.refs.end())
+    return it->second == eFrameRef_ReadBeforeWrite || it->second == eFrameRef_ReadOnly;
 
   return false;
 }
 
+template <typename Configuration>
+bool ResourceManager<Configuration>::HasFrameReference(ResourceId id)
+{
+  FrameRefShard &shard = GetFrameRefShard(id);
+
+  SCOPED_LOCK(shard.lock);
+
+  return shard.refs.find(id) != shard.refs.end();
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::GetFrameReferences(
+    std::vector<std::pair<ResourceId, FrameRefType> > &refs)
+{
+  refs.clear();
+
+  for(FrameRefShard &shard : m_FrameReferencedResources)
+  {
+    SCOPED_LOCK(shard.lock);
+    refs.insert(refs.end(), shard.refs.begin(), shard.refs.end());
+  }
+
+  std::sort(refs.begin(), refs.end());
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::GetCurrentResources(
+    std::vector<std::pair<ResourceId, WrappedResourceType> > &resources)
+{
+  {
+    SCOPED_READLOCK(m_ResourceLock);
+    resources.assign(m_CurrentResourceMap.begin(), m_CurrentResourceMap.end());
+  }
+
+  std::sort(resources.begin(), resources.end(),
+            [](const std::pair<ResourceId, WrappedResourceType> &a,
+               const std::pair<ResourceId, WrappedResourceType> &b) { return a.first < b.first; });
+}
+
+template <typename Configuration>
+ResourceId ResourceManager<Configuration>::ResolveReplacement(ResourceId id)
+{
+  auto it = m_Replacements.find(id);
+
+  while(it != m_Replacements.end())
+  {
+    id = it->second;
+    it = m_Replacements.find(id);
+  }
+
+  return id;
+}
+
 template <typename Configuration>
 void ResourceManager<Configuration>::MarkDirtyResource(ResourceId res)
 {
@@ -681,10 +833,13 @@ void ResourceManager<Configuration>::Serialise_InitialContentsNeeded(WriteSerial
 
   std::vector<WrittenRecord> WrittenRecords;
 
+  std::vector<std::pair<ResourceId, FrameRefType> > frameRefs;
+  GetFrameReferences(frameRefs);
+
   // reasonable estimate, and these records are small
-  WrittenRecords.reserve(m_FrameReferencedResources.size());
+  WrittenRecords.reserve(frameRefs.size());
 
-  for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+  for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
   {
     RecordType *record = GetResourceRecord(it->first);
 
@@ -699,8 +854,9 @@ void ResourceManager<Configuration>::Serialise_InitialContentsNeeded(WriteSerial
   for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
   {
     ResourceId id = *it;
-    auto ref = m_FrameReferencedResources.find(id);
-    if(ref == m_FrameReferencedResources.end() || ref->second == eFrameRef_ReadOnly)
+    auto ref = std::lower_bound(frameRefs.begin(), frameRefs.end(),
+                                std::make_pair(id, eFrameRef_Unknown));
+    if(ref == frameRefs.end() || ref->first != id || ref->second == eFrameRef_ReadOnly)
     {
       WrittenRecord wr = {id, true};
 
@@ -787,7 +943,7 @@ void ResourceManager<Configuration>::ApplyInitialContents()
 template <typename Configuration>
 void ResourceManager<Configuration>::MarkUnwrittenResources()
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
   for(auto it = m_ResourceRecords.begin(); it != m_ResourceRecords.end(); ++it)
   {
@@ -802,14 +958,24 @@ void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser
 
   SCOPED_LOCK(m_Lock);
 
-  RDCDEBUG("%u frame resource records", (uint32_t)m_FrameReferencedResources.size());
+  std::vector<std::pair<ResourceId, FrameRefType> > frameRefs;
+  GetFrameReferences(frameRefs);
+
+  RDCDEBUG("%u frame resource records", (uint32_t)frameRefs.size());
 
   if(RenderDoc::Inst().GetCaptureOptions().refAllResources)
   {
-    float num = float(m_ResourceRecords.size());
+    std::vector<std::pair<ResourceId, RecordType *> > records;
+
+    {
+      SCOPED_READLOCK(m_ResourceLock);
+      records.assign(m_ResourceRecords.begin(), m_ResourceRecords.end());
+    }
+
+    float num = float(records.size());
     float idx = 0.0f;
 
-    for(auto it = m_ResourceRecords.begin(); it != m_ResourceRecords.end(); ++it)
+    for(auto it = records.begin(); it != records.end(); ++it)
     {
       RenderDoc::Inst().SetProgress(CaptureProgress::AddReferencedResources, idx / num);
       idx += 1.0f;
@@ -822,10 +988,10 @@ void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser
   }
   else
   {
-    float num = float(m_FrameReferencedResources.size());
+    float num = float(frameRefs.size());
     float idx = 0.0f;
 
-    for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+    for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
     {
       RenderDoc::Inst().SetProgress(CaptureProgress::AddReferencedResources, idx / num);
       idx += 1.0f;
@@ -884,7 +1050,10 @@ void ResourceManager<Configuration>::PrepareInitialContents()
 
   prepared = 0;
 
-  for(auto it = m_CurrentResourceMap.begin(); it != m_CurrentResourceMap.end(); ++it)
+  std::vector<std::pair<ResourceId, WrappedResourceType> > currentResources;
+  GetCurrentResources(currentResources);
+
+  for(auto it = currentResources.begin(); it != currentResources.end(); ++it)
   {
     if(it->second == (WrappedResourceType)RecordType::NullResource)
       continue;
@@ -919,8 +1088,7 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
     RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseInitialStates, idx / num);
     idx += 1.0f;
 
-    if(m_FrameReferencedResources.find(id) == m_FrameReferencedResources.end() &&
-       !RenderDoc::Inst().GetCaptureOptions().refAllResources)
+    if(!HasFrameReference(id) && !RenderDoc::Inst().GetCaptureOptions().refAllResources)
     {
 #if ENABLED(VERBOSE_DIRTY_RESOURCES)
       RDCDEBUG("Dirty tesource %llu is GPU dirty but not referenced - skipping", id);
@@ -994,7 +1162,10 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
 
   dirty = 0;
 
-  for(auto it = m_CurrentResourceMap.begin(); it != m_CurrentResourceMap.end(); ++it)
+  std::vector<std::pair<ResourceId, WrappedResourceType> > currentResources;
+  GetCurrentResources(currentResources);
+
+  for(auto it = currentResources.begin(); it != currentResources.end(); ++it)
   {
     if(it->second == (WrappedResourceType)RecordType::NullResource)
       continue;
@@ -1039,8 +1210,7 @@ void ResourceManager<Configuration>::ApplyInitialContentsNonChunks(WriteSerialis
   {
     ResourceId id = *it;
 
-    if(m_FrameReferencedResources.find(id) == m_FrameReferencedResources.end() &&
-       !RenderDoc::Inst().GetCaptureOptions().refAllResources)
+    if(!HasFrameReference(id) && !RenderDoc::Inst().GetCaptureOptions().refAllResources)
     {
       continue;
     }
@@ -1069,30 +1239,40 @@ void ResourceManager<Configuration>::ClearReferencedResources()
 {
   SCOPED_LOCK(m_Lock);
 
-  for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+  // take the references out of each shard before releasing the records, so that any resource
+  // referenced meanwhile keeps its entry along with the record reference it added.
+  std::vector<std::pair<ResourceId, FrameRefType> > frameRefs;
+
+  for(FrameRefShard &shard : m_FrameReferencedResources)
+  {
+    SCOPED_LOCK(shard.lock);
+    frameRefs.insert(frameRefs.end(), shard.refs.begin(), shard.refs.end());
+    shard.refs.clear();
+  }
+
+  for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
   {
     RecordType *record = GetResourceRecord(it->first);
 
     if(record)
       record->Delete(this);
   }
-
-  m_FrameReferencedResources.clear();
 }
 
 template <typename Configuration>
 void ResourceManager<Configuration>::ReplaceResource(ResourceId from, ResourceId to)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
-  if(HasLiveResource(to))
+  if(m_LiveResourceMap.find(to) != m_LiveResourceMap.end() ||
+     m_Replacements.find(to) != m_Replacements.end())
     m_Replacements[from] = to;
 }
 
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasReplacement(ResourceId from)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
   return m_Replacements.find(from) != m_Replacements.end();
 }
@@ -1100,7 +1280,7 @@ bool ResourceManager<Configuration>::HasReplacement(ResourceId from)
 template <typename Configuration>
 void ResourceManager<Configuration>::RemoveReplacement(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   auto it = m_Replacements.find(id);
 
@@ -1113,7 +1293,7 @@ void ResourceManager<Configuration>::RemoveReplacement(ResourceId id)
 template <typename Configuration>
 typename Configuration::RecordType *ResourceManager<Configuration>::GetResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
   auto it = m_ResourceRecords.find(id);
 
@@ -1126,7 +1306,7 @@ typename Configuration::RecordType *ResourceManager<Configuration>::GetResourceR
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
   auto it = m_ResourceRecords.find(id);
 
@@ -1139,7 +1319,7 @@ bool ResourceManager<Configuration>::HasResourceRecord(ResourceId id)
 template <typename Configuration>
 typename Configuration::RecordType *ResourceManager<Configuration>::AddResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   RDCASSERT(m_ResourceRecords.find(id) == m_ResourceRecords.end(), id);
 
@@ -1149,7 +1329,7 @@ typename Configuration::RecordType *ResourceManager<Configuration>::AddResourceR
 template <typename Configuration>
 void ResourceManager<Configuration>::RemoveResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   RDCASSERT(m_ResourceRecords.find(id) != m_ResourceRecords.end(), id);
 
@@ -1165,7 +1345,7 @@ void ResourceManager<Configuration>::DestroyResourceRecord(ResourceRecord *recor
 template <typename Configuration>
 bool ResourceManager<Configuration>::AddWrapper(WrappedResourceType wrap, RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   bool ret = true;
 
@@ -1190,26 +1370,28 @@ bool ResourceManager<Configuration>::AddWrapper(WrappedResourceType wrap, RealRe
 template <typename Configuration>
 void ResourceManager<Configuration>::RemoveWrapper(RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
-  if(real == (RealResourceType)RecordType::NullResource || !HasWrapper(real))
+  auto it = m_WrapperMap.find(real);
+
+  if(real == (RealResourceType)RecordType::NullResource || it == m_WrapperMap.end())
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource is NULL or doesn't have wrapper");
     return;
   }
 
-  m_WrapperMap.erase(m_WrapperMap.find(real));
+  m_WrapperMap.erase(it);
 }
 
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasWrapper(RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(real == (RealResourceType)RecordType::NullResource)
     return false;
 
+  SCOPED_READLOCK(m_ResourceLock);
+
   return (m_WrapperMap.find(real) != m_WrapperMap.end());
 }
 
@@ -1217,52 +1399,70 @@ template <typename Configuration>
 typename Configuration::WrappedResourceType ResourceManager<Configuration>::GetWrapper(
     RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(real == (RealResourceType)RecordType::NullResource)
     return (WrappedResourceType)RecordType::NullResource;
 
-  if(real != (RealResourceType)RecordType::NullResource && !HasWrapper(real))
+  SCOPED_READLOCK(m_ResourceLock);
+
+  auto it = m_WrapperMap.find(real);
+
+  if(it == m_WrapperMap.end())
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource isn't NULL and doesn't have "
         "wrapper");
+    return (WrappedResourceType)RecordType::NullResource;
   }
 
-  return m_WrapperMap[real];
+  return it->second;
 }
 
 template <typename Configuration>
 void ResourceManager<Configuration>::AddLiveResource(ResourceId origid, WrappedResourceType livePtr)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(origid == ResourceId() || livePtr == (WrappedResourceType)RecordType::NullResource)
   {
     RDCERR("Invalid state adding resource mapping - id is invalid or live pointer is NULL");
   }
 
-  m_OriginalIDs[GetID(livePtr)] = origid;
-  m_LiveIDs[origid] = GetID(livePtr);
+  ResourceId liveid = GetID(livePtr);
+
+  WrappedResourceType duplicate = (WrappedResourceType)RecordType::NullResource;
 
-  if(m_LiveResourceMap.find(origid) != m_LiveResourceMap.end())
   {
-    RDCERR("Releasing live resource for duplicate creation: %llu", origid);
-    ResourceTypeRelease(m_LiveResourceMap[origid]);
-    m_LiveResourceMap.erase(origid);
+    SCOPED_WRITELOCK(m_ResourceLock);
+
+    m_OriginalIDs[liveid] = origid;
+    m_LiveIDs[origid] = liveid;
+
+    auto it = m_LiveResourceMap.find(origid);
+    if(it != m_LiveResourceMap.end())
+    {
+      duplicate = it->second;
+      it->second = livePtr;
+    }
+    else
+    {
+      m_LiveResourceMap[origid] = livePtr;
+    }
   }
 
-  m_LiveResourceMap[origid] = livePtr;
+  // release outside the lock, as releasing may look up or remove other resources
+  if(duplicate != (WrappedResourceType)RecordType::NullResource)
+  {
+    RDCERR("Releasing live resource for duplicate creation: %llu", origid);
+    ResourceTypeRelease(duplicate);
+  }
 }
 
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasLiveResource(ResourceId origid)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(origid == ResourceId())
     return false;
 
+  SCOPED_READLOCK(m_ResourceLock);
+
   return (m_Replacements.find(origid) != m_Replacements.end() ||
           m_LiveResourceMap.find(origid) != m_LiveResourceMap.end());
 }
@@ -1271,18 +1471,17 @@ template <typename Configuration>
 typename Configuration::WrappedResourceType ResourceManager<Configuration>::GetLiveResource(
     ResourceId origid)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(origid == ResourceId())
     return (WrappedResourceType)RecordType::NullResource;
 
-  RDCASSERT(HasLiveResource(origid), origid);
+  SCOPED_READLOCK(m_ResourceLock);
+
+  auto it = m_LiveResourceMap.find(ResolveReplacement(origid));
 
-  if(m_Replacements.find(origid) != m_Replacements.end())
-    return GetLiveResource(m_Replacements[origid]);
+  RDCASSERT(it != m_LiveResourceMap.end(), origid);
 
-  if(m_LiveResourceMap.find(origid) != m_LiveResourceMap.end())
-    return m_LiveResourceMap[origid];
+  if(it != m_LiveResourceMap.end())
+    return it->second;
 
   return (WrappedResourceType)RecordType::NullResource;
 }
@@ -1290,9 +1489,11 @@ typename Configuration::WrappedResourceType ResourceManager<Configuration>::GetL
 template <typename Configuration>
 void ResourceManager<Configuration>::EraseLiveResource(ResourceId origid)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
-  RDCASSERT(HasLiveResource(origid), origid);
+  RDCASSERT(m_Replacements.find(origid) != m_Replacements.end() ||
+                m_LiveResourceMap.find(origid) != m_LiveResourceMap.end(),
+            origid);
 
   m_LiveResourceMap.erase(origid);
 }
@@ -1300,7 +1501,7 @@ void ResourceManager<Configuration>::EraseLiveResource(ResourceId origid)
 template <typename Configuration>
 void ResourceManager<Configuration>::AddCurrentResource(ResourceId id, WrappedResourceType res)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   RDCASSERT(m_CurrentResourceMap.find(id) == m_CurrentResourceMap.end(), id);
   m_CurrentResourceMap[id] = res;
@@ -1309,7 +1510,7 @@ void ResourceManager<Configuration>::AddCurrentResource(ResourceId id, WrappedRe
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
   return m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end();
 }
@@ -1318,19 +1519,22 @@ template <typename Configuration>
 typename Configuration::WrappedResourceType ResourceManager<Configuration>::GetCurrentResource(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_ResourceLock);
 
-  if(m_Replacements.find(id) != m_Replacements.end())
-    return GetCurrentResource(m_Replacements[id]);
+  auto it = m_CurrentResourceMap.find(ResolveReplacement(id));
 
-  RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
-  return m_CurrentResourceMap[id];
+  RDCASSERT(it != m_CurrentResourceMap.end(), id);
+
+  if(it != m_CurrentResourceMap.end())
+    return it->second;
+
+  return (WrappedResourceType)RecordType::NullResource;
 }
 
 template <typename Configuration>
 void ResourceManager<Configuration>::ReleaseCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_ResourceLock);
 
   RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
   m_CurrentResourceMap.erase(id);
@@ -1342,8 +1546,16 @@ ResourceId ResourceManager<Configuration>::GetOriginalID(ResourceId id)
   if(id == ResourceId())
     return id;
 
-  RDCASSERT(m_OriginalIDs.find(id) != m_OriginalIDs.end(), id);
-  return m_OriginalIDs[id];
+  SCOPED_READLOCK(m_ResourceLock);
+
+  auto it = m_OriginalIDs.find(id);
+
+  RDCASSERT(it != m_OriginalIDs.end(), id);
+
+  if(it != m_OriginalIDs.end())
+    return it->second;
+
+  return ResourceId();
 }
 
 template <typename Configuration>
@@ -1352,6 +1564,14 @@ ResourceId ResourceManager<Configuration>::GetLiveID(ResourceId id)
   if(id == ResourceId())
     return id;
 
-  RDCASSERT(m_LiveIDs.find(id) != m_LiveIDs.end(), id);
-  return m_LiveIDs[id];
+  SCOPED_READLOCK(m_ResourceLock);
+
+  auto it = m_LiveIDs.find(id);
+
+  RDCASSERT(it != m_LiveIDs.end(), id);
+
+  if(it != m_LiveIDs.end())
+    return it->second;
+
+  return ResourceId();
 }
@@ -1677,7 +1677,7 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       SectionProperties props;
 
       // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
       props.version = m_SectionVersion;
       props.type = SectionType::FrameCapture;
 
@@ -1759,6 +1759,8 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       UnlockForChunkFlushing();
     }
 
+    RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
+
     RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
 
     m_State = CaptureState::BackgroundCapturing;
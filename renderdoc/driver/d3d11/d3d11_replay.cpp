@@ -1449,6 +1449,11 @@ const SDFile &D3D11Replay::GetStructuredFile()
   return m_pDevice->GetStructuredFile();
 }
 
+void D3D11Replay::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  // structured data is always loaded in full
+}
+
 vector<uint32_t> D3D11Replay::GetPassEvents(uint32_t eventId)
 {
   vector<uint32_t> passEvents;
@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "d3d11_shader_cache.h"
-#include "common/shader_cache.h"
 #include "driver/dx/official/d3dcompiler.h"
 #include "driver/shaders/dxbc/dxbc_inspect.h"
 #include "strings/string_utils.h"
@@ -72,28 +71,14 @@ struct D3DBlobShaderCallbacks
 } D3D11ShaderCacheCallbacks;
 
 D3D11ShaderCache::D3D11ShaderCache(WrappedID3D11Device *wrapper)
+    : m_ShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
+                    D3D11ShaderCacheCallbacks)
 {
   m_pDevice = wrapper;
-
-  bool success = LoadShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, D3D11ShaderCacheCallbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
 }
 
 D3D11ShaderCache::~D3D11ShaderCache()
 {
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    D3D11ShaderCacheCallbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      D3D11ShaderCacheCallbacks.Destroy(it->second);
-  }
 }
 
 std::string D3D11ShaderCache::GetShaderBlob(const char *source, const char *entry,
@@ -105,9 +90,8 @@ std::string D3D11ShaderCache::GetShaderBlob(const char *source, const char *entr
   hash = strhash(profile, hash);
   hash ^= compileFlags;
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
+  if(m_ShaderCache.Find(hash, *srcblob))
   {
-    *srcblob = m_ShaderCache[hash];
     (*srcblob)->AddRef();
     return "";
   }
@@ -159,9 +143,8 @@ std::string D3D11ShaderCache::GetShaderBlob(const char *source, const char *entr
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = byteBlob;
+    m_ShaderCache.Insert(hash, byteBlob);
     byteBlob->AddRef();
-    m_ShaderCacheDirty = true;
   }
 
   SAFE_RELEASE(errBlob);
@@ -28,9 +28,11 @@
 #include <string>
 #include <vector>
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "driver/dx/official/d3d11_4.h"
 
 class WrappedID3D11Device;
+struct D3DBlobShaderCallbacks;
 
 class D3D11ShaderCache
 {
@@ -54,6 +56,6 @@ private:
 
   ID3D11Device *m_pDevice = NULL;
 
-  bool m_ShaderCacheDirty = false, m_CacheShaders = false;
-  std::map<uint32_t, ID3DBlob *> m_ShaderCache;
+  bool m_CacheShaders = false;
+  PersistentShaderCache<ID3DBlob *, D3DBlobShaderCallbacks> m_ShaderCache;
 };
\ No newline at end of file
@@ -938,9 +938,9 @@ ShaderDebugTrace D3D11Replay::DebugVertex(uint32_t eventId, uint32_t vertid, uin
 
   State last;
 
-  vector<ShaderDebugState> states;
+  ShaderDebugTraceBuilder states(ret);
 
-  states.push_back((State)initialState);
+  states.AddState(initialState);
 
   D3D11MarkerRegion simloop("Simulation Loop");
 
@@ -951,7 +951,7 @@ ShaderDebugTrace D3D11Replay::DebugVertex(uint32_t eventId, uint32_t vertid, uin
 
     initialState = initialState.GetNext(global, NULL);
 
-    states.push_back((State)initialState);
+    states.AddState(initialState);
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
@@ -960,8 +960,6 @@ ShaderDebugTrace D3D11Replay::DebugVertex(uint32_t eventId, uint32_t vertid, uin
     }
   }
 
-  ret.states = states;
-
   return ret;
 }
 
@@ -1808,9 +1806,9 @@ ShaderDebugTrace D3D11Replay::DebugPixel(uint32_t eventId, uint32_t x, uint32_t
 
   SAFE_DELETE_ARRAY(initialData);
 
-  vector<ShaderDebugState> states;
+  ShaderDebugTraceBuilder states(traces[destIdx]);
 
-  states.push_back((State)quad[destIdx]);
+  states.AddState(quad[destIdx]);
 
   // ping pong between so that we can have 'current' quad to update into new one
   State quad2[4];
@@ -1843,7 +1841,7 @@ ShaderDebugTrace D3D11Replay::DebugPixel(uint32_t eventId, uint32_t x, uint32_t
 
     // if our destination quad is paused don't record multiple identical states.
     if(activeMask[destIdx])
-      states.push_back((State)curquad[destIdx]);
+      states.AddState(curquad[destIdx]);
 
     // we need to make sure that control flow which converges stays in lockstep so that
     // derivatives are still valid. While diverged, we don't have to keep threads in lockstep
@@ -1933,8 +1931,6 @@ ShaderDebugTrace D3D11Replay::DebugPixel(uint32_t eventId, uint32_t x, uint32_t
     }
   } while(!finished);
 
-  traces[destIdx].states = states;
-
   return traces[destIdx];
 }
 
@@ -1990,9 +1986,9 @@ ShaderDebugTrace D3D11Replay::DebugThread(uint32_t eventId, const uint32_t group
     initialState.semantics.ThreadID[i] = threadid[i];
   }
 
-  vector<ShaderDebugState> states;
+  ShaderDebugTraceBuilder states(ret);
 
-  states.push_back((State)initialState);
+  states.AddState(initialState);
 
   for(int cycleCounter = 0;; cycleCounter++)
   {
@@ -2001,7 +1997,7 @@ ShaderDebugTrace D3D11Replay::DebugThread(uint32_t eventId, const uint32_t group
 
     initialState = initialState.GetNext(global, NULL);
 
-    states.push_back((State)initialState);
+    states.AddState(initialState);
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
@@ -2010,7 +2006,5 @@ ShaderDebugTrace D3D11Replay::DebugThread(uint32_t eventId, const uint32_t group
     }
   }
 
-  ret.states = states;
-
   return ret;
 }
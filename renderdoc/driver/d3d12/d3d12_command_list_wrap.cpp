@@ -381,6 +381,7 @@ HRESULT WrappedID3D12GraphicsCommandList::Reset(ID3D12CommandAllocator *pAllocat
         GetResourceManager()->AddResourceRecord(ResourceIDGen::GetNewUniqueID());
     m_ListRecord->bakedCommands->type = Resource_GraphicsCommandList;
     m_ListRecord->bakedCommands->SpecialResource = true;
+    m_ListRecord->bakedCommands->TransientChunks = true;
     m_ListRecord->bakedCommands->cmdInfo = new CmdListRecordingInfo();
 
     {
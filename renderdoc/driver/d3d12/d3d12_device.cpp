@@ -224,6 +224,7 @@ WrappedID3D12Device::WrappedID3D12Device(ID3D12Device *realDevice, D3D12InitPara
     m_FrameCaptureRecord = GetResourceManager()->AddResourceRecord(ResourceIDGen::GetNewUniqueID());
     m_FrameCaptureRecord->DataInSerialiser = false;
     m_FrameCaptureRecord->SpecialResource = true;
+    m_FrameCaptureRecord->TransientChunks = true;
     m_FrameCaptureRecord->Length = 0;
 
     RenderDoc::Inst().AddDeviceFrameCapturer((ID3D12Device *)this, this);
@@ -1610,7 +1611,7 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
     SectionProperties props;
 
     // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
@@ -1700,6 +1701,8 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Done");
   }
 
+  RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
+
   RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
 
   SAFE_DELETE(m_HeaderChunk);
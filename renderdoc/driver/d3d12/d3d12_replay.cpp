@@ -205,6 +205,11 @@ const SDFile &D3D12Replay::GetStructuredFile()
   return m_pDevice->GetStructuredFile();
 }
 
+void D3D12Replay::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  // structured data is always loaded in full
+}
+
 ResourceDescription &D3D12Replay::GetResourceDesc(ResourceId id)
 {
   auto it = m_ResourceIdx.find(id);
@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "d3d12_shader_cache.h"
-#include "common/shader_cache.h"
 #include "driver/dx/official/d3dcompiler.h"
 #include "driver/shaders/dxbc/dxbc_inspect.h"
 #include "strings/string_utils.h"
@@ -71,26 +70,13 @@ struct D3D12BlobShaderCallbacks
 } D3D12ShaderCacheCallbacks;
 
 D3D12ShaderCache::D3D12ShaderCache()
+    : m_ShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
+                    D3D12ShaderCacheCallbacks)
 {
-  bool success = LoadShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, D3D12ShaderCacheCallbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
 }
 
 D3D12ShaderCache::~D3D12ShaderCache()
 {
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    D3D12ShaderCacheCallbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      D3D12ShaderCacheCallbacks.Destroy(it->second);
-  }
 }
 
 std::string D3D12ShaderCache::GetShaderBlob(const char *source, const char *entry,
@@ -102,9 +88,8 @@ std::string D3D12ShaderCache::GetShaderBlob(const char *source, const char *entr
   hash = strhash(profile, hash);
   hash ^= compileFlags;
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
+  if(m_ShaderCache.Find(hash, *srcblob))
   {
-    *srcblob = m_ShaderCache[hash];
     (*srcblob)->AddRef();
     return "";
   }
@@ -156,9 +141,8 @@ std::string D3D12ShaderCache::GetShaderBlob(const char *source, const char *entr
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = byteBlob;
+    m_ShaderCache.Insert(hash, byteBlob);
     byteBlob->AddRef();
-    m_ShaderCacheDirty = true;
   }
 
   SAFE_RELEASE(errBlob);
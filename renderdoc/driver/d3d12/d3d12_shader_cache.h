@@ -28,9 +28,11 @@
 #include <string>
 #include <vector>
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "driver/dx/official/d3d11_4.h"
 
 class WrappedID3D11Device;
+struct D3D12BlobShaderCallbacks;
 
 class D3D12ShaderCache
 {
@@ -54,6 +56,6 @@ private:
   static const uint32_t m_ShaderCacheMagic = 0xf000baba;
   static const uint32_t m_ShaderCacheVersion = 3;
 
-  bool m_ShaderCacheDirty = false, m_CacheShaders = false;
-  std::map<uint32_t, ID3DBlob *> m_ShaderCache;
+  bool m_CacheShaders = false;
+  PersistentShaderCache<ID3DBlob *, D3D12BlobShaderCallbacks> m_ShaderCache;
 };
\ No newline at end of file
@@ -1778,4 +1778,34 @@ extern GLChunk gl_CurChunk;
 
 #define PUSH_CURRENT_CHUNK GLChunkPreserver _chunk_restore(gl_CurChunk)
 
+// Lets hooked calls that only touch the current context's state run without taking the global GL
+// lock, while still letting the lock holder stop them and wait for any in progress - e.g. when a
+// frame capture starts. Each thread counts its own calls in progress, so calls on different
+// threads never write to the same memory.
+class GLFastPathGate
+{
+public:
+  struct ThreadCalls
+  {
+    volatile int32_t active = 0;
+  };
+
+  GLFastPathGate();
+  ~GLFastPathGate();
+
+  // returns NULL if the gate is closed and the call must take the slow path. Otherwise the call
+  // can go ahead, and must pass the returned pointer to Leave() once it's done.
+  ThreadCalls *Enter();
+  static void Leave(ThreadCalls *calls) { Atomic::Dec32(&calls->active); }
+  // stops any new calls from entering, and waits for any in progress to leave.
+  void Close();
+  void Open();
+
+private:
+  uint64_t m_TLSSlot;
+  Threading::CriticalSection m_Lock;
+  std::vector<ThreadCalls *> m_Threads;
+  volatile int32_t m_Closed = 0;
+};
+
 DECLARE_REFLECTION_ENUM(GLChunk);
@@ -26,10 +26,11 @@
 #include "gl_driver.h"
 #include <algorithm>
 #include "common/common.h"
+#include "core/capture_writer.h"
 #include "driver/shaders/spirv/spirv_common.h"
-#include "jpeg-compressor/jpge.h"
 #include "serialise/rdcfile.h"
 #include "strings/string_utils.h"
+#include "gl_shader_cache.h"
 
 std::map<uint64_t, GLWindowingData> WrappedOpenGL::m_ActiveContexts;
 
@@ -567,6 +568,7 @@ WrappedOpenGL::WrappedOpenGL(const GLHookSet &funcs, GLPlatform &platform)
     m_ContextRecord->DataInSerialiser = false;
     m_ContextRecord->Length = 0;
     m_ContextRecord->SpecialResource = true;
+    m_ContextRecord->TransientChunks = true;
 
     // we register an ID for the backbuffer, this will be tied to the fake-created backbuffer on
     // replay, and every context's FBO 0 will be pointed to it with ReplaceResource
@@ -748,6 +750,8 @@ WrappedOpenGL::~WrappedOpenGL()
 
   SAFE_DELETE(m_FrameReader);
 
+  SAFE_DELETE(m_ShaderCache);
+
   GetResourceManager()->ClearReferencedResources();
 
   GetResourceManager()->ReleaseCurrentResource(m_DeviceResourceID);
@@ -773,6 +777,18 @@ WrappedOpenGL::~WrappedOpenGL()
     RenderDoc::Inst().GetCrashHandler()->UnregisterMemoryRegion(this);
 }
 
+GLShaderCache *WrappedOpenGL::GetShaderCache()
+{
+  // don't write any files from inside a program being captured
+  if(IsCaptureMode(m_State))
+    return NULL;
+
+  if(m_ShaderCache == NULL)
+    m_ShaderCache = new GLShaderCache(m_Real);
+
+  return m_ShaderCache;
+}
+
 ContextPair &WrappedOpenGL::GetCtx()
 {
   ContextPair *ret = (ContextPair *)Threading::GetTLSValue(m_CurCtxPairTLS);
@@ -1695,6 +1711,10 @@ void WrappedOpenGL::StartFrameCapture(void *dev, void *wnd)
 
   SCOPED_LOCK(GetGLLock());
 
+  // calls that skip the lock aren't recorded, so they must all finish and then go through the lock
+  // until the capture is over.
+  m_FastPath.Close();
+
   m_State = CaptureState::ActiveCapturing;
 
   m_AppControlledCapture = true;
@@ -1779,33 +1799,29 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(bbim == NULL)
       bbim = SaveBackbufferImage();
 
-    RDCFile *rdc =
-        RenderDoc::Inst().CreateRDC(GetDriverType(), m_CapturedFrames.back().frameNumber,
-                                    bbim->jpgbuf, bbim->len, bbim->thwidth, bbim->thheight);
+    // the thumbnail is encoded on the capture writing thread, which takes ownership of the pixels
+    CaptureThumbnail thumb;
+    thumb.pixels = bbim->thpixels;
+    thumb.len = (uint32_t)bbim->len;
+    thumb.width = bbim->thwidth;
+    thumb.height = bbim->thheight;
 
+    bbim->thpixels = NULL;
     SAFE_DELETE(bbim);
 
     for(auto it = m_BackbufferImages.begin(); it != m_BackbufferImages.end(); ++it)
       delete it->second;
     m_BackbufferImages.clear();
 
-    StreamWriter *captureWriter = NULL;
+    SectionProperties props;
 
-    if(rdc)
-    {
-      SectionProperties props;
+    // Compress with LZ4 so that it's fast
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
+    props.version = m_SectionVersion;
+    props.type = SectionType::FrameCapture;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
-      props.version = m_SectionVersion;
-      props.type = SectionType::FrameCapture;
-
-      captureWriter = rdc->WriteSection(props);
-    }
-    else
-    {
-      captureWriter = new StreamWriter(StreamWriter::InvalidStream);
-    }
+    StreamWriter *captureWriter = CaptureWriter::BeginWrite(
+        GetDriverType(), m_CapturedFrames.back().frameNumber, props, thumb);
 
     {
       WriteSerialiser ser(captureWriter, Ownership::Stream);
@@ -1873,10 +1889,10 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
       }
     }
 
-    RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
-
     m_State = CaptureState::BackgroundCapturing;
 
+    m_FastPath.Open();
+
     GetResourceManager()->MarkUnwrittenResources();
 
     GetResourceManager()->ClearReferencedResources();
@@ -1940,6 +1956,8 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
       m_State = CaptureState::BackgroundCapturing;
 
+      m_FastPath.Open();
+
       GetResourceManager()->MarkUnwrittenResources();
     }
     else
@@ -2096,36 +2114,9 @@ WrappedOpenGL::BackbufferImage *WrappedOpenGL::SaveBackbufferImage()
     }
   }
 
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(len > 0)
-  {
-    // jpge::compress_image_to_jpeg_file_in_memory requires at least 1024 bytes
-    len = len >= 1024 ? len : 1024;
-
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
-
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
-
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
-    }
-  }
-
-  SAFE_DELETE_ARRAY(thpixels);
-
   BackbufferImage *bbim = new BackbufferImage();
-  bbim->jpgbuf = jpgbuf;
-  bbim->len = len;
+  bbim->thpixels = thpixels;
+  bbim->len = 3U * thwidth * thheight;
   bbim->thwidth = thwidth;
   bbim->thheight = thheight;
 
@@ -4148,6 +4139,18 @@ ReplayStatus WrappedOpenGL::ContextReplayLog(CaptureState readType, uint32_t sta
     m_StructuredFile = &ser.GetStructuredFile();
   }
 
+  // the frame stays in memory, so if requested we only export each chunk's name and metadata while
+  // loading and fill in the contents on demand in LoadStructuredChunk.
+  const bool lazy = IsLoading(m_State) &&
+                    RenderDoc::Inst().GetConfigSetting("Replay_LazyStructuredData") == "1";
+
+  if(lazy)
+  {
+    ser.SetLazyStructuredExport(true);
+    m_LazyChunkOffsets.clear();
+    m_LazyChunkOffsets[(uint32_t)m_StructuredFile->chunks.size()] = 0;
+  }
+
   SystemChunk header = ser.ReadChunk<SystemChunk>();
   RDCASSERTEQUAL(header, SystemChunk::CaptureBegin);
 
@@ -4229,6 +4232,9 @@ ReplayStatus WrappedOpenGL::ContextReplayLog(CaptureState readType, uint32_t sta
     if(ser.GetReader()->IsErrored())
       return ReplayStatus::APIDataCorrupted;
 
+    if(lazy)
+      m_LazyChunkOffsets[(uint32_t)m_StructuredFile->chunks.size() - 1] = m_CurChunkOffset;
+
     m_ChunkMetadata = ser.ChunkMetadata();
 
     bool success = ContextProcessChunk(ser, chunktype);
@@ -4281,6 +4287,68 @@ ReplayStatus WrappedOpenGL::ContextReplayLog(CaptureState readType, uint32_t sta
   return ReplayStatus::Succeeded;
 }
 
+void WrappedOpenGL::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  auto it = m_LazyChunkOffsets.find(chunkIndex);
+
+  // already loaded, or never lazy in the first place
+  if(it == m_LazyChunkOffsets.end())
+    return;
+
+  uint64_t offset = it->second;
+  m_LazyChunkOffsets.erase(it);
+
+  SDChunk *dst = m_StructuredFile->chunks[chunkIndex];
+
+  m_FrameReader->SetOffset(offset);
+
+  ReadSerialiser ser(m_FrameReader, Ownership::Nothing);
+
+  ser.SetStringDatabase(&m_StringDB);
+  ser.SetUserData(GetResourceManager());
+  ser.SetVersion(m_SectionVersion);
+
+  ser.ConfigureStructuredExport(&GetChunkName, false);
+
+  // re-read the chunk as if we were exporting it, so that nothing is replayed
+  CaptureState prevState = m_State;
+  SDFile *prevFile = m_StructuredFile;
+  uint64_t prevOffset = m_CurChunkOffset;
+  SDChunkMetaData prevMetadata = m_ChunkMetadata;
+
+  m_State = CaptureState::StructuredExport;
+  m_StructuredFile = &ser.GetStructuredFile();
+  m_CurChunkOffset = offset;
+
+  GLChunk chunktype = ser.ReadChunk<GLChunk>();
+
+  m_ChunkMetadata = ser.ChunkMetadata();
+
+  if((SystemChunk)chunktype == SystemChunk::CaptureBegin)
+    Serialise_BeginCaptureFrame(ser);
+  else
+    ProcessChunk(ser, chunktype);
+
+  ser.EndChunk();
+
+  m_State = prevState;
+  m_StructuredFile = prevFile;
+  m_CurChunkOffset = prevOffset;
+  m_ChunkMetadata = prevMetadata;
+
+  if(ser.IsErrored() || ser.GetStructuredFile().chunks.empty())
+  {
+    RDCERR("Couldn't load structured data for chunk %u", chunkIndex);
+    return;
+  }
+
+  SDChunk *src = ser.GetStructuredFile().chunks[0];
+
+  dst->type.flags = src->type.flags;
+  dst->data.basic = src->data.basic;
+  dst->data.children.swap(src->data.children);
+}
+
 bool WrappedOpenGL::ContextProcessChunk(ReadSerialiser &ser, GLChunk chunk)
 {
   m_AddedDrawcall = false;
@@ -38,6 +38,8 @@
 #include "gl_replay.h"
 #include "gl_resources.h"
 
+class GLShaderCache;
+
 using std::list;
 
 struct GLInitParams
@@ -127,6 +129,8 @@ private:
   std::set<std::string> m_StringDB;
 
   StreamReader *m_FrameReader = NULL;
+  // offsets in m_FrameReader of any frame chunks whose structured data was loaded lazily
+  std::map<uint32_t, uint64_t> m_LazyChunkOffsets;
 
   static std::map<uint64_t, GLWindowingData> m_ActiveContexts;
 
@@ -134,6 +138,9 @@ private:
   uint64_t m_CurCtxPairTLS;
   std::vector<ContextPair *> m_CtxPairs;
 
+  // closed while a frame is being captured, so that every call goes through the lock
+  GLFastPathGate m_FastPath;
+
   uintptr_t m_ShareGroupID;
 
   std::vector<GLWindowingData> m_LastContexts;
@@ -304,7 +311,14 @@ private:
     GLuint prog;
     int version;
 
+    // key for this shader in the shader cache, if there is one
+    uint32_t cacheKey = 0;
+
+    // SPIR-V is only needed for disassembly, so it's compiled the first time it's needed
+    bool spirvCompiled = false;
+
     void Compile(WrappedOpenGL &gl, ResourceId id, GLuint realShader);
+    void PrepareSPIRV(WrappedOpenGL &gl);
   };
 
   struct ProgramData
@@ -349,6 +363,9 @@ private:
   map<ResourceId, PipelineData> m_Pipelines;
   vector<pair<ResourceId, Replacement> > m_DependentReplacements;
 
+  // only created on replay, when shaders are first processed
+  GLShaderCache *m_ShaderCache = NULL;
+
   GLuint m_FakeBB_FBO;
   GLuint m_FakeBB_Color;
   GLuint m_FakeBB_DepthStencil;
@@ -525,11 +542,12 @@ private:
   void RenderOverlayText(float x, float y, const char *fmt, ...);
   void RenderOverlayStr(float x, float y, const char *str);
 
+  // raw RGB8 thumbnail pixels, encoded when the capture is written
   struct BackbufferImage
   {
-    BackbufferImage() : jpgbuf(NULL), len(0), thwidth(0), thheight(0) {}
-    ~BackbufferImage() { SAFE_DELETE_ARRAY(jpgbuf); }
-    byte *jpgbuf;
+    BackbufferImage() : thpixels(NULL), len(0), thwidth(0), thheight(0) {}
+    ~BackbufferImage() { SAFE_DELETE_ARRAY(thpixels); }
+    byte *thpixels;
     size_t len;
     uint16_t thwidth;
     uint16_t thheight;
@@ -578,8 +596,10 @@ public:
     m_State = CaptureState::StructuredExport;
   }
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
+  void LoadStructuredChunk(uint32_t chunkIndex);
   void SetFetchCounters(bool in) { m_FetchCounters = in; };
   const GLHookSet &GetHookset() { return m_Real; }
+  GLShaderCache *GetShaderCache();
   void SetDebugMsgContext(const char *context) { m_DebugMsgContext = context; }
   void AddDebugMessage(DebugMessage msg)
   {
@@ -621,6 +641,11 @@ public:
   void StartFrameCapture(void *dev, void *wnd);
   bool EndFrameCapture(void *dev, void *wnd);
 
+  // hooked functions that only change the current context's state, and do nothing else unless a
+  // frame is being captured, can skip the lock and call the real function directly while this is
+  // open.
+  GLFastPathGate &GetFastPath() { return m_FastPath; }
+
   IMPLEMENT_FUNCTION_SERIALISED(void, glBindTexture, GLenum target, GLuint texture);
   IMPLEMENT_FUNCTION_SERIALISED(void, glBindTextures, GLuint first, GLsizei count,
                                 const GLuint *textures);
@@ -110,6 +110,11 @@ Threading::CriticalSection &GetGLLock()
         echo ") \\";
 
         echo -e "  { \\";
+        if [ $ALIAS -eq 0 ]; then
+          echo -n "    GL_FAST_PATH(function, (";
+            for I in `seq 1 $N`; do echo -n "p$I"; if [ $I -ne $N ]; then echo -n ", "; fi; done;
+          echo -e ")); \\";
+        fi
         echo -e "    SCOPED_GLCALL(glLock, function); \\";
         echo -e "    gl_CurChunk = GLChunk::function; \\";
         if [ $ALIAS -eq 1 ]; then
@@ -127,6 +132,11 @@ Threading::CriticalSection &GetGLLock()
         echo ") \\";
 
         echo -e "  { \\";
+        if [ $ALIAS -eq 0 ]; then
+          echo -n "    GL_FAST_PATH(function, (";
+            for I in `seq 1 $N`; do echo -n "p$I"; if [ $I -ne $N ]; then echo -n ", "; fi; done;
+          echo -e ")); \\";
+        fi
         echo -e "    SCOPED_GLCALL(glLock, function); \\";
         echo -e "    gl_CurChunk = GLChunk::function; \\";
         if [ $ALIAS -eq 1 ]; then
@@ -188,6 +198,132 @@ int ScopedPrinter::depth = 0;
 
 #endif
 
+// Functions listed here only change the current context's state, and their wrappers do nothing
+// more than call the real function unless a frame is being captured. Outside of a frame capture
+// they call straight through to the real function without taking the GL lock, so that
+// applications using several contexts on different threads don't serialise on them. See
+// GLFastPathGate.
+//
+// Wrappers that track anything while background capturing (bound texture records, chunks added to
+// resource records) must not be listed. util/check_gl_fast_path.py verifies this on CI.
+template <GLChunk chunk>
+struct GLFastPath
+{
+  static const bool enabled = false;
+
+  // never called, but the fast path must still compile for every function
+  template <typename FuncType>
+  static FuncType Real()
+  {
+    return NULL;
+  }
+};
+
+#define GLFastPathFunction(function)   \
+  template <>                          \
+  struct GLFastPath<GLChunk::function> \
+  {                                    \
+    static const bool enabled = true;  \
+                                       \
+    template <typename FuncType>       \
+    static FuncType Real()             \
+    {                                  \
+      return (FuncType)GL.function;    \
+    }                                  \
+  }
+
+GLFastPathFunction(glBindImageTexture);
+GLFastPathFunction(glBindImageTextures);
+GLFastPathFunction(glBindSampler);
+GLFastPathFunction(glBindSamplers);
+GLFastPathFunction(glBlendColor);
+GLFastPathFunction(glBlendEquation);
+GLFastPathFunction(glBlendEquationSeparate);
+GLFastPathFunction(glBlendEquationSeparatei);
+GLFastPathFunction(glBlendEquationi);
+GLFastPathFunction(glBlendFunc);
+GLFastPathFunction(glBlendFuncSeparate);
+GLFastPathFunction(glBlendFunci);
+GLFastPathFunction(glClearColor);
+GLFastPathFunction(glClearDepth);
+GLFastPathFunction(glClearDepthf);
+GLFastPathFunction(glClearStencil);
+GLFastPathFunction(glClipControl);
+GLFastPathFunction(glColorMask);
+GLFastPathFunction(glColorMaski);
+GLFastPathFunction(glCullFace);
+GLFastPathFunction(glDepthBoundsEXT);
+GLFastPathFunction(glDepthFunc);
+GLFastPathFunction(glDepthMask);
+GLFastPathFunction(glDepthRange);
+GLFastPathFunction(glDepthRangeArrayfvOES);
+GLFastPathFunction(glDepthRangeArrayv);
+GLFastPathFunction(glDepthRangeIndexed);
+GLFastPathFunction(glDepthRangeIndexedfOES);
+GLFastPathFunction(glDepthRangef);
+GLFastPathFunction(glDisable);
+GLFastPathFunction(glDisablei);
+GLFastPathFunction(glEnable);
+GLFastPathFunction(glEnablei);
+GLFastPathFunction(glFrontFace);
+GLFastPathFunction(glHint);
+GLFastPathFunction(glLineWidth);
+GLFastPathFunction(glLogicOp);
+GLFastPathFunction(glMinSampleShading);
+GLFastPathFunction(glPatchParameterfv);
+GLFastPathFunction(glPatchParameteri);
+GLFastPathFunction(glPauseTransformFeedback);
+GLFastPathFunction(glPointParameterf);
+GLFastPathFunction(glPointParameterfv);
+GLFastPathFunction(glPointParameteri);
+GLFastPathFunction(glPointParameteriv);
+GLFastPathFunction(glPointSize);
+GLFastPathFunction(glPolygonMode);
+GLFastPathFunction(glPolygonOffset);
+GLFastPathFunction(glPolygonOffsetClampEXT);
+GLFastPathFunction(glPopDebugGroup);
+GLFastPathFunction(glPrimitiveBoundingBox);
+GLFastPathFunction(glPrimitiveRestartIndex);
+GLFastPathFunction(glProvokingVertex);
+GLFastPathFunction(glPushDebugGroup);
+GLFastPathFunction(glQueryCounter);
+GLFastPathFunction(glRasterSamplesEXT);
+GLFastPathFunction(glResumeTransformFeedback);
+GLFastPathFunction(glSampleCoverage);
+GLFastPathFunction(glSampleMaski);
+GLFastPathFunction(glScissor);
+GLFastPathFunction(glScissorArrayv);
+GLFastPathFunction(glStencilFunc);
+GLFastPathFunction(glStencilFuncSeparate);
+GLFastPathFunction(glStencilMask);
+GLFastPathFunction(glStencilMaskSeparate);
+GLFastPathFunction(glStencilOp);
+GLFastPathFunction(glStencilOpSeparate);
+GLFastPathFunction(glUniformSubroutinesuiv);
+GLFastPathFunction(glViewport);
+GLFastPathFunction(glViewportArrayv);
+GLFastPathFunction(glWaitSync);
+
+struct GLFastPathCall
+{
+  GLFastPathCall() : calls(m_GLDriver->GetFastPath().Enter()) {}
+  ~GLFastPathCall()
+  {
+    if(calls)
+      GLFastPathGate::Leave(calls);
+  }
+  GLFastPathGate::ThreadCalls *calls;
+};
+
+// the condition is constant, so this compiles away entirely for any function not listed above.
+#define GL_FAST_PATH(function, args)                                                  \
+  if(GLFastPath<GLChunk::function>::enabled)                                          \
+  {                                                                                   \
+    GLFastPathCall fastcall;                                                          \
+    if(fastcall.calls)                                                                \
+      return GLFastPath<GLChunk::function>::Real<CONCAT(function, _hooktype)>() args; \
+  }
+
 // the _renderdoc_hooked variants are to make sure we always have a function symbol
 // exported that we can return from glXGetProcAddress. If another library (or the app)
 // creates a symbol called 'glEnable' we'll return the address of that, and break
@@ -198,12 +334,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))();                    \
   extern "C" __attribute__((visibility("default"))) ret function() \
   {                                                                \
+    GL_FAST_PATH(function, ());                                    \
     SCOPED_GLCALL(glLock, function);                               \
     gl_CurChunk = GLChunk::function;                               \
     return m_GLDriver->function();                                 \
   }                                                                \
   ret CONCAT(function, _renderdoc_hooked)()                        \
   {                                                                \
+    GL_FAST_PATH(function, ());                                    \
     SCOPED_GLCALL(glLock, function);                               \
     gl_CurChunk = GLChunk::function;                               \
     return m_GLDriver->function();                                 \
@@ -213,12 +351,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))(t1);                       \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1) \
   {                                                                     \
+    GL_FAST_PATH(function, (p1));                                       \
     SCOPED_GLCALL(glLock, function);                                    \
     gl_CurChunk = GLChunk::function;                                    \
     return m_GLDriver->function(p1);                                    \
   }                                                                     \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1)                        \
   {                                                                     \
+    GL_FAST_PATH(function, (p1));                                       \
     SCOPED_GLCALL(glLock, function);                                    \
     gl_CurChunk = GLChunk::function;                                    \
     return m_GLDriver->function(p1);                                    \
@@ -228,12 +368,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))(t1, t2);                          \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2) \
   {                                                                            \
+    GL_FAST_PATH(function, (p1, p2));                                          \
     SCOPED_GLCALL(glLock, function);                                           \
     gl_CurChunk = GLChunk::function;                                           \
     return m_GLDriver->function(p1, p2);                                       \
   }                                                                            \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2)                        \
   {                                                                            \
+    GL_FAST_PATH(function, (p1, p2));                                          \
     SCOPED_GLCALL(glLock, function);                                           \
     gl_CurChunk = GLChunk::function;                                           \
     return m_GLDriver->function(p1, p2);                                       \
@@ -243,12 +385,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3);                             \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3) \
   {                                                                                   \
+    GL_FAST_PATH(function, (p1, p2, p3));                                             \
     SCOPED_GLCALL(glLock, function);                                                  \
     gl_CurChunk = GLChunk::function;                                                  \
     return m_GLDriver->function(p1, p2, p3);                                          \
   }                                                                                   \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3)                        \
   {                                                                                   \
+    GL_FAST_PATH(function, (p1, p2, p3));                                             \
     SCOPED_GLCALL(glLock, function);                                                  \
     gl_CurChunk = GLChunk::function;                                                  \
     return m_GLDriver->function(p1, p2, p3);                                          \
@@ -258,12 +402,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3, t4);                                \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4) \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4));                                                \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4);                                             \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4)                        \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4));                                                \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4);                                             \
@@ -273,12 +419,14 @@ int ScopedPrinter::depth = 0;
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3, t4, t5);                                   \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5) \
   {                                                                                                 \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5));                                                   \
     SCOPED_GLCALL(glLock, function);                                                                \
     gl_CurChunk = GLChunk::function;                                                                \
     return m_GLDriver->function(p1, p2, p3, p4, p5);                                                \
   }                                                                                                 \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5)                        \
   {                                                                                                 \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5));                                                   \
     SCOPED_GLCALL(glLock, function);                                                                \
     gl_CurChunk = GLChunk::function;                                                                \
     return m_GLDriver->function(p1, p2, p3, p4, p5);                                                \
@@ -289,12 +437,14 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, \
                                                                  t5 p5, t6 p6)               \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6));                                        \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6);                                     \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6)          \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6));                                        \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6);                                     \
@@ -305,12 +455,14 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, \
                                                                  t5 p5, t6 p6, t7 p7)        \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7));                                    \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7);                                 \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7)   \
   {                                                                                          \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7));                                    \
     SCOPED_GLCALL(glLock, function);                                                         \
     gl_CurChunk = GLChunk::function;                                                         \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7);                                 \
@@ -321,12 +473,14 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4,        \
                                                                  t5 p5, t6 p6, t7 p7, t8 p8)        \
   {                                                                                                 \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8));                                       \
     SCOPED_GLCALL(glLock, function);                                                                \
     gl_CurChunk = GLChunk::function;                                                                \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8);                                    \
   }                                                                                                 \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8)   \
   {                                                                                                 \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8));                                       \
     SCOPED_GLCALL(glLock, function);                                                                \
     gl_CurChunk = GLChunk::function;                                                                \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8);                                    \
@@ -338,6 +492,7 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9)                              \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9));                                 \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9);                              \
@@ -345,6 +500,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9)                                                  \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9));                                 \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9);                              \
@@ -356,6 +512,7 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10)                     \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10));                            \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);                         \
@@ -363,6 +520,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10)                                         \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10));                            \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);                         \
@@ -374,6 +532,7 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11)            \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11));                       \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);                    \
@@ -381,6 +540,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11)                                \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11));                       \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);                    \
@@ -392,6 +552,7 @@ int ScopedPrinter::depth = 0;
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12)   \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12));                  \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);               \
@@ -399,6 +560,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12)                       \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12));                  \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);               \
@@ -412,6 +574,7 @@ int ScopedPrinter::depth = 0;
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,   \
       t13 p13)                                                                                    \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13));             \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);          \
@@ -419,6 +582,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13)              \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13));             \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);          \
@@ -432,6 +596,7 @@ int ScopedPrinter::depth = 0;
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,   \
       t13 p13, t14 p14)                                                                           \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14));        \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);     \
@@ -439,6 +604,7 @@ int ScopedPrinter::depth = 0;
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14)     \
   {                                                                                               \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14));        \
     SCOPED_GLCALL(glLock, function);                                                              \
     gl_CurChunk = GLChunk::function;                                                              \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);     \
@@ -452,6 +618,7 @@ int ScopedPrinter::depth = 0;
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,    \
       t13 p13, t14 p14, t15 p15)                                                                   \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15));    \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15); \
@@ -460,6 +627,7 @@ int ScopedPrinter::depth = 0;
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14,      \
                                           t15 p15)                                                 \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15));    \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15); \
@@ -474,6 +642,8 @@ int ScopedPrinter::depth = 0;
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,    \
       t13 p13, t14 p14, t15 p15, t16 p16)                                                          \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,      \
+                            p16));                                                                 \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,  \
@@ -483,6 +653,8 @@ int ScopedPrinter::depth = 0;
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14,      \
                                           t15 p15, t16 p16)                                        \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,      \
+                            p16));                                                                 \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,  \
@@ -498,6 +670,8 @@ int ScopedPrinter::depth = 0;
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,    \
       t13 p13, t14 p14, t15 p15, t16 p16, t17 p17)                                                 \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, \
+                            p17));                                                                 \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,  \
@@ -507,6 +681,8 @@ int ScopedPrinter::depth = 0;
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14,      \
                                           t15 p15, t16 p16, t17 p17)                               \
   {                                                                                                \
+    GL_FAST_PATH(function, (p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, \
+                            p17));                                                                 \
     SCOPED_GLCALL(glLock, function);                                                               \
     gl_CurChunk = GLChunk::function;                                                               \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15,  \
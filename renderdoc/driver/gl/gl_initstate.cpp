@@ -876,14 +876,14 @@ bool GLResourceManager::Force_InitialState(GLResource res, bool prepare)
       return true;
 
     // if this data resource was referenced already, just skip
-    if(m_FrameReferencedResources.find(record->GetResourceID()) != m_FrameReferencedResources.end())
+    if(HasFrameReference(record->GetResourceID()))
       return false;
 
     // see if any of our viewers were referenced
     for(auto it = record->viewTextures.begin(); it != record->viewTextures.end(); ++it)
     {
       // if so, return true to force our inclusion, for the benefit of the view
-      if(m_FrameReferencedResources.find(*it) != m_FrameReferencedResources.end())
+      if(HasFrameReference(*it))
       {
         RDCDEBUG("Forcing inclusion of %llu for %llu", record->GetResourceID(), *it);
         return true;
@@ -91,6 +91,11 @@ const SDFile &GLReplay::GetStructuredFile()
   return m_pDriver->GetStructuredFile();
 }
 
+void GLReplay::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  m_pDriver->LoadStructuredChunk(chunkIndex);
+}
+
 vector<uint32_t> GLReplay::GetPassEvents(uint32_t eventId)
 {
   vector<uint32_t> passEvents;
@@ -641,7 +646,13 @@ string GLReplay::DisassembleShader(ResourceId pipeline, const ShaderReflection *
     std::string &disasm = shaderDetails.disassembly;
 
     if(disasm.empty())
-      disasm = shaderDetails.spirv.Disassemble(refl->entryPoint.c_str());
+    {
+      shaderDetails.PrepareSPIRV(*m_pDriver);
+
+      // if compiling failed, the disassembly is now the compile errors
+      if(disasm.empty())
+        disasm = shaderDetails.spirv.Disassemble(refl->entryPoint.c_str());
+    }
 
     return disasm;
   }
@@ -213,6 +213,7 @@ struct GLResourceRecord : public ResourceRecord
     RDCEraseEl(ShadowPtr);
     RDCEraseEl(Map);
     ShadowSize = 0;
+    ShadowWatched = false;
   }
 
   ~GLResourceRecord() { FreeShadowStorage(); }
@@ -285,8 +286,15 @@ struct GLResourceRecord : public ResourceRecord
   {
     if(ShadowPtr[0] == NULL)
     {
-      ShadowPtr[0] = AllocAlignedBuffer(size + sizeof(markerValue));
-      ShadowPtr[1] = AllocAlignedBuffer(size + sizeof(markerValue));
+      // if we might watch writes to the shadow storage, it must have pages to itself
+      size_t alignment = 64;
+      if(WriteWatch::IsEnabled())
+        alignment = WriteWatch::GetPageSize();
+
+      size_t allocSize = AlignUp(size + sizeof(markerValue), alignment);
+
+      ShadowPtr[0] = AllocAlignedBuffer(allocSize, alignment);
+      ShadowPtr[1] = AllocAlignedBuffer(allocSize, alignment);
 
       memcpy(ShadowPtr[0] + size, markerValue, sizeof(markerValue));
       memcpy(ShadowPtr[1] + size, markerValue, sizeof(markerValue));
@@ -306,8 +314,22 @@ struct GLResourceRecord : public ResourceRecord
     return true;
   }
 
+  // begin watching for writes to the shadow storage that the application writes into, so that
+  // only written pages need to be compared. Returns false if writes can't be watched.
+  bool WatchShadowWrites()
+  {
+    if(!ShadowWatched && ShadowPtr[0])
+      ShadowWatched = WriteWatch::Register(ShadowPtr[0], ShadowSize);
+
+    return ShadowWatched;
+  }
+
   void FreeShadowStorage()
   {
+    if(ShadowWatched)
+      WriteWatch::Unregister(ShadowPtr[0]);
+    ShadowWatched = false;
+
     if(ShadowPtr[0] != NULL)
     {
       FreeAlignedBuffer(ShadowPtr[0]);
@@ -320,4 +342,5 @@ struct GLResourceRecord : public ResourceRecord
 private:
   byte *ShadowPtr[2];
   size_t ShadowSize;
+  bool ShadowWatched;
 };
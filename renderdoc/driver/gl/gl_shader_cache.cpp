@@ -0,0 +1,181 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014-2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "gl_shader_cache.h"
+#include "api/replay/version.h"
+#include "serialise/serialiser.h"
+#include "strings/string_utils.h"
+
+typedef std::vector<byte> GLShaderCacheEntry;
+
+struct GLBlobShaderCallbacks
+{
+  bool Create(uint32_t size, byte *data, GLShaderCacheEntry **ret) const
+  {
+    RDCASSERT(ret);
+
+    // must at least have the reflection size
+    if(size < sizeof(uint32_t))
+      return false;
+
+    *ret = new GLShaderCacheEntry(data, data + size);
+
+    return true;
+  }
+
+  void Destroy(GLShaderCacheEntry *entry) const { delete entry; }
+  uint32_t GetSize(GLShaderCacheEntry *entry) const { return (uint32_t)entry->size(); }
+  const byte *GetData(GLShaderCacheEntry *entry) const { return entry->data(); }
+} GLShaderCacheCallbacks;
+
+static uint32_t GetReflectionSize(const GLShaderCacheEntry &entry)
+{
+  return *(const uint32_t *)entry.data();
+}
+
+// offset of the SPIR-V in an entry, after the reflection size and the reflection itself
+static size_t GetSPIRVOffset(const GLShaderCacheEntry &entry)
+{
+  return AlignUp4(sizeof(uint32_t) + GetReflectionSize(entry));
+}
+
+GLShaderCache::GLShaderCache(const GLHookSet &gl)
+    : m_ShaderCache("glshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
+                    GLShaderCacheCallbacks)
+{
+  // reflection depends on the driver's compiler, and the serialised format on our own version.
+  const char *driverStrings[] = {
+      (const char *)gl.glGetString(eGL_VENDOR), (const char *)gl.glGetString(eGL_RENDERER),
+      (const char *)gl.glGetString(eGL_VERSION), GitVersionHash,
+  };
+
+  m_DriverHash = strhash(MAJOR_MINOR_VERSION_STRING);
+  for(const char *str : driverStrings)
+    m_DriverHash = strhash(str ? str : "", m_DriverHash);
+}
+
+GLShaderCache::~GLShaderCache()
+{
+}
+
+uint32_t GLShaderCache::MakeKey(GLenum type, const std::vector<std::string> &sources) const
+{
+  uint32_t hash = strhash(ToStr((uint32_t)type).c_str(), m_DriverHash);
+  for(const std::string &s : sources)
+    hash = strhash(s.c_str(), hash);
+
+  return hash;
+}
+
+bool GLShaderCache::GetReflection(uint32_t key, ShaderReflection &refl)
+{
+  GLShaderCacheEntry *entry = NULL;
+
+  if(!m_ShaderCache.Find(key, entry))
+    return false;
+
+  uint32_t size = GetReflectionSize(*entry);
+
+  if(size == 0 || sizeof(uint32_t) + size > entry->size())
+    return false;
+
+  ReadSerialiser ser(new StreamReader(entry->data() + sizeof(uint32_t), size), Ownership::Stream);
+
+  ser.ReadChunk<uint32_t>();
+  ser.Serialise("reflection", refl);
+  ser.EndChunk();
+
+  if(ser.IsErrored())
+  {
+    RDCERR("Corrupt reflection in shader cache");
+    refl = ShaderReflection();
+    return false;
+  }
+
+  return true;
+}
+
+void GLShaderCache::SetReflection(uint32_t key, const ShaderReflection &refl)
+{
+  WriteSerialiser ser(new StreamWriter(4 * 1024), Ownership::Stream);
+
+  {
+    SCOPED_SERIALISE_CHUNK(1);
+    ser.Serialise("reflection", (ShaderReflection &)refl);
+  }
+
+  StreamWriter *writer = ser.GetWriter();
+  uint32_t size = (uint32_t)writer->GetOffset();
+
+  // keep any SPIR-V that was already cached
+  std::vector<uint32_t> spirv;
+  GetSPIRV(key, spirv);
+
+  GLShaderCacheEntry *entry = new GLShaderCacheEntry;
+
+  entry->resize(AlignUp4(sizeof(uint32_t) + size) + spirv.size() * sizeof(uint32_t));
+  memcpy(entry->data(), &size, sizeof(uint32_t));
+  memcpy(entry->data() + sizeof(uint32_t), writer->GetData(), size);
+
+  if(!spirv.empty())
+    memcpy(entry->data() + GetSPIRVOffset(*entry), spirv.data(), spirv.size() * sizeof(uint32_t));
+
+  m_ShaderCache.Insert(key, entry);
+}
+
+bool GLShaderCache::GetSPIRV(uint32_t key, std::vector<uint32_t> &spirv)
+{
+  GLShaderCacheEntry *entry = NULL;
+
+  if(!m_ShaderCache.Find(key, entry))
+    return false;
+
+  size_t offs = GetSPIRVOffset(*entry);
+
+  if(offs >= entry->size())
+    return false;
+
+  const uint32_t *words = (const uint32_t *)(entry->data() + offs);
+  spirv.assign(words, words + (entry->size() - offs) / sizeof(uint32_t));
+
+  return true;
+}
+
+void GLShaderCache::SetSPIRV(uint32_t key, const std::vector<uint32_t> &spirv)
+{
+  GLShaderCacheEntry *entry = NULL;
+
+  // with no reflection cached, the entry is just an empty reflection followed by the SPIR-V
+  if(!m_ShaderCache.Find(key, entry))
+    entry = new GLShaderCacheEntry(sizeof(uint32_t), 0);
+
+  size_t offs = GetSPIRVOffset(*entry);
+
+  entry->resize(offs + spirv.size() * sizeof(uint32_t));
+  memcpy(entry->data() + offs, spirv.data(), spirv.size() * sizeof(uint32_t));
+
+  // the entry is modified in place if it was already cached, this marks it to be written out
+  m_ShaderCache.Insert(key, entry);
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014-2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
+#include "gl_hookset.h"
+
+struct GLBlobShaderCallbacks;
+
+// Caches the expensive parts of processing a shader on replay across runs - the reflection built
+// by querying a separable program, and the SPIR-V compiled for disassembly. Entries are keyed on
+// the shader's stage and source as well as the driver, since what's reflected depends on what the
+// driver's compiler decided was active.
+class GLShaderCache
+{
+public:
+  GLShaderCache(const GLHookSet &gl);
+  ~GLShaderCache();
+
+  uint32_t MakeKey(GLenum type, const std::vector<std::string> &sources) const;
+
+  bool GetReflection(uint32_t key, ShaderReflection &refl);
+  void SetReflection(uint32_t key, const ShaderReflection &refl);
+
+  bool GetSPIRV(uint32_t key, std::vector<uint32_t> &spirv);
+  void SetSPIRV(uint32_t key, const std::vector<uint32_t> &spirv);
+
+private:
+  static const uint32_t m_ShaderCacheMagic = 0xf00d00d6;
+  static const uint32_t m_ShaderCacheVersion = 1;
+
+  uint32_t m_DriverHash = 0;
+
+  // each entry is the serialised reflection, padded to a uint32_t boundary, followed by the SPIR-V
+  // words if they've been compiled.
+  PersistentShaderCache<std::vector<byte> *, GLBlobShaderCallbacks> m_ShaderCache;
+};
@@ -2584,27 +2584,51 @@ void WrappedOpenGL::PersistentMapMemoryBarrier(const set<GLResourceRecord *> &ma
   // this function iterates over all the maps, checking for any changes between
   // the shadow pointers, and propogates that to 'real' GL
 
+  // every flush is a separate chunk and a separate call to GL, so close together changes are
+  // flushed together rather than individually.
+  const size_t flushGapThreshold = 1024;
+
+  std::vector<WriteWatch::Range> ranges;
+  std::vector<DiffRange> diffs;
+
   for(set<GLResourceRecord *>::const_iterator it = maps.begin(); it != maps.end(); ++it)
   {
     GLResourceRecord *record = *it;
 
     RDCASSERT(record && record->Map.persistentPtr);
 
-    size_t diffStart = 0, diffEnd = 0;
-    bool found = FindDiffRange(record->GetShadowPtr(0), record->GetShadowPtr(1),
-                               (size_t)record->Length, diffStart, diffEnd);
-    if(found)
+    // if we can, only compare the pages that have been written since last time. Otherwise
+    // compare the whole buffer.
+    ranges.clear();
+
+    if(!record->WatchShadowWrites() ||
+       !WriteWatch::GetDirtyRanges(record->GetShadowPtr(0), ranges))
     {
-      // update the modified region in the 'comparison' shadow buffer for next check
-      memcpy(record->GetShadowPtr(1) + diffStart, record->GetShadowPtr(0) + diffStart,
-             diffEnd - diffStart);
+      WriteWatch::Range all = {0, (size_t)record->Length};
+      ranges.push_back(all);
+    }
 
-      // we use our own flush function so it will serialise chunks when necessary, and it
-      // also handles copying into the persistent mapped pointer and flushing the real GL
-      // buffer
-      gl_CurChunk = GLChunk::glFlushMappedNamedBufferRangeEXT;
-      glFlushMappedNamedBufferRangeEXT(record->Resource.name, GLintptr(diffStart),
-                                       GLsizeiptr(diffEnd - diffStart));
+    for(const WriteWatch::Range &range : ranges)
+    {
+      FindDiffRanges(record->GetShadowPtr(0) + range.start, record->GetShadowPtr(1) + range.start,
+                     range.end - range.start, flushGapThreshold, diffs);
+
+      for(const DiffRange &diff : diffs)
+      {
+        size_t diffStart = range.start + diff.start;
+        size_t diffEnd = range.start + diff.end;
+
+        // update the modified region in the 'comparison' shadow buffer for next check
+        memcpy(record->GetShadowPtr(1) + diffStart, record->GetShadowPtr(0) + diffStart,
+               diffEnd - diffStart);
+
+        // we use our own flush function so it will serialise chunks when necessary, and it
+        // also handles copying into the persistent mapped pointer and flushing the real GL
+        // buffer
+        gl_CurChunk = GLChunk::glFlushMappedNamedBufferRangeEXT;
+        glFlushMappedNamedBufferRangeEXT(record->Resource.name, GLintptr(diffStart),
+                                         GLsizeiptr(diffEnd - diffStart));
+      }
     }
   }
 }
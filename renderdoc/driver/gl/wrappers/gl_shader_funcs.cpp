@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "../gl_driver.h"
+#include "../gl_shader_cache.h"
 #include "../gl_shader_refl.h"
 #include "common/common.h"
 #include "driver/shaders/spirv/spirv_common.h"
@@ -158,8 +159,15 @@ void WrappedOpenGL::ShaderData::Compile(WrappedOpenGL &gl, ResourceId id, GLuint
   if(version == 0)
     version = 100;
 
-  reflection.encoding = ShaderEncoding::GLSL;
-  reflection.rawBytes.assign((byte *)concatenated.c_str(), concatenated.size());
+  GLShaderCache *cache = gl.GetShaderCache();
+
+  reflection = ShaderReflection();
+  spirv = SPVModule();
+  spirvCompiled = false;
+  disassembly.clear();
+
+  if(cache)
+    cacheKey = cache->MakeKey(type, sources);
 
   GLuint sepProg = prog;
 
@@ -184,18 +192,16 @@ void WrappedOpenGL::ShaderData::Compile(WrappedOpenGL &gl, ResourceId id, GLuint
   else
   {
     prog = sepProg;
-    MakeShaderReflection(gl.GetHookset(), type, sepProg, reflection, pointSizeUsed, clipDistanceUsed);
-
-    vector<uint32_t> spirvwords;
 
-    SPIRVCompilationSettings settings(SPIRVSourceLanguage::OpenGLGLSL,
-                                      SPIRVShaderStage(ShaderIdx(type)));
+    // the separable program is still needed for replay, but its reflection can come from the cache
+    if(!cache || !cache->GetReflection(cacheKey, reflection))
+    {
+      MakeShaderReflection(gl.GetHookset(), type, sepProg, reflection, pointSizeUsed,
+                           clipDistanceUsed);
 
-    string s = CompileSPIRV(settings, sources, spirvwords);
-    if(!spirvwords.empty())
-      ParseSPIRV(&spirvwords.front(), spirvwords.size(), spirv);
-    else
-      disassembly = s;
+      if(cache)
+        cache->SetReflection(cacheKey, reflection);
+    }
 
     reflection.resourceId = id;
     reflection.entryPoint = "main";
@@ -206,6 +212,41 @@ void WrappedOpenGL::ShaderData::Compile(WrappedOpenGL &gl, ResourceId id, GLuint
     reflection.debugInfo.files[0].filename = "main.glsl";
     reflection.debugInfo.files[0].contents = concatenated;
   }
+
+  reflection.encoding = ShaderEncoding::GLSL;
+  reflection.rawBytes.assign((byte *)concatenated.c_str(), concatenated.size());
+}
+
+void WrappedOpenGL::ShaderData::PrepareSPIRV(WrappedOpenGL &gl)
+{
+  // only compile once, even if it failed. The shader must have compiled successfully on the real
+  // driver for there to be anything to disassemble.
+  if(spirvCompiled || prog == 0)
+    return;
+
+  spirvCompiled = true;
+
+  GLShaderCache *cache = gl.GetShaderCache();
+
+  vector<uint32_t> spirvwords;
+
+  if(!cache || !cache->GetSPIRV(cacheKey, spirvwords))
+  {
+    SPIRVCompilationSettings settings(SPIRVSourceLanguage::OpenGLGLSL,
+                                      SPIRVShaderStage(ShaderIdx(type)));
+
+    string s = CompileSPIRV(settings, sources, spirvwords);
+    if(spirvwords.empty())
+    {
+      disassembly = s;
+      return;
+    }
+
+    if(cache)
+      cache->SetSPIRV(cacheKey, spirvwords);
+  }
+
+  ParseSPIRV(&spirvwords.front(), spirvwords.size(), spirv);
 }
 
 #pragma region Shaders
@@ -322,6 +363,8 @@ bool WrappedOpenGL::Serialise_glShaderSource(SerialiserType &ser, GLuint shaderH
       m_Real.glDeleteProgram(m_Shaders[liveId].prog);
       m_Shaders[liveId].prog = 0;
       m_Shaders[liveId].spirv = SPVModule();
+      m_Shaders[liveId].spirvCompiled = false;
+      m_Shaders[liveId].disassembly.clear();
       m_Shaders[liveId].reflection = ShaderReflection();
     }
 
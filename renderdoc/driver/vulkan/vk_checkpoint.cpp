@@ -0,0 +1,747 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "vk_core.h"
+
+// Replay checkpoints let a replay start part-way through the frame instead of at the beginning.
+//
+// While loading we note which images, memory objects and descriptor sets are written at each
+// event. Buffers are tracked as the memory they're bound to. Then during a replay, after a queue
+// submit that was replayed in full, we snapshot everything written since the previous checkpoint.
+// Checkpoints are at least Replay_CheckpointInterval events apart and stop being taken once they
+// use Replay_CheckpointBudgetMB of memory.
+//
+// A later replay restores the last checkpoint before its end. Only resources written between
+// that checkpoint and the event we last replayed to need to be restored, each from its latest
+// snapshot at or before the checkpoint, or its initial contents if it has none. We then read the
+// frame from the start but skip everything except command buffer recording until we pass the
+// checkpoint's submit.
+
+void WrappedVulkan::InitReplayCheckpoints()
+{
+  FreeReplayCheckpoints();
+
+  m_CheckpointWrites.clear();
+  m_ReplayCheckpointsSupported = true;
+
+  std::string budget = RenderDoc::Inst().GetConfigSetting("Replay_CheckpointBudgetMB");
+  std::string interval = RenderDoc::Inst().GetConfigSetting("Replay_CheckpointInterval");
+
+  m_ReplayCheckpointBudget = budget.empty() ? 512 : (VkDeviceSize)RDCMAX(0, atoi(budget.c_str()));
+  m_ReplayCheckpointBudget *= 1024 * 1024;
+
+  m_ReplayCheckpointInterval = interval.empty() ? 256 : (uint32_t)RDCMAX(1, atoi(interval.c_str()));
+}
+
+bool WrappedVulkan::IsCheckpointSkippableChunk(VulkanChunk chunk)
+{
+  // these are the only chunks outside of command buffers that we can skip before the checkpoint
+  // we resume from. Either what they change is part of the checkpoint, or they don't change any
+  // state that later replaying depends on.
+  switch(chunk)
+  {
+    case VulkanChunk::vkQueueSubmit:
+    case VulkanChunk::vkUpdateDescriptorSets:
+    case VulkanChunk::vkUpdateDescriptorSetWithTemplate:
+    case VulkanChunk::vkUnmapMemory:
+    case VulkanChunk::vkFlushMappedMemoryRanges:
+    case VulkanChunk::vkQueueWaitIdle:
+    case VulkanChunk::vkDeviceWaitIdle:
+    case VulkanChunk::vkGetFenceStatus:
+    case VulkanChunk::vkResetFences:
+    case VulkanChunk::vkWaitForFences:
+    case VulkanChunk::vkQueueBeginDebugUtilsLabelEXT:
+    case VulkanChunk::vkQueueEndDebugUtilsLabelEXT:
+    case VulkanChunk::vkQueueInsertDebugUtilsLabelEXT:
+    case VulkanChunk::vkSetDebugUtilsObjectNameEXT:
+    case VulkanChunk::vkDebugMarkerSetObjectNameEXT: return true;
+    default: break;
+  }
+
+  return false;
+}
+
+void WrappedVulkan::DisableReplayCheckpoints(const char *reason)
+{
+  if(m_ReplayCheckpointsSupported)
+    RDCLOG("Replay checkpoints disabled: %s", reason);
+
+  m_ReplayCheckpointsSupported = false;
+  m_CheckpointWrites.clear();
+
+  FreeReplayCheckpoints();
+}
+
+void WrappedVulkan::AddCheckpointWrite(uint32_t eventId, ResourceId id)
+{
+  if(!m_ReplayCheckpointsSupported || id == ResourceId())
+    return;
+
+  if(m_CreationInfo.m_Buffer.find(id) != m_CreationInfo.m_Buffer.end())
+  {
+    ResourceId origId = GetResourceManager()->GetOriginalID(id);
+
+    bool bound = false;
+
+    for(ResourceId parent : GetReplay()->GetResourceDesc(origId).parentResources)
+    {
+      if(!GetResourceManager()->HasLiveResource(parent))
+        continue;
+
+      ResourceId mem = GetResourceManager()->GetLiveID(parent);
+
+      if(m_CreationInfo.m_Memory.find(mem) != m_CreationInfo.m_Memory.end())
+      {
+        m_CheckpointWrites[eventId].insert(mem);
+        bound = true;
+      }
+    }
+
+    // sparse buffers don't have a single memory object to snapshot
+    if(!bound)
+      DisableReplayCheckpoints(
+          StringFormat::Fmt("buffer %llu has no bound memory", origId).c_str());
+
+    return;
+  }
+
+  if(m_CreationInfo.m_Image.find(id) != m_CreationInfo.m_Image.end() ||
+     m_CreationInfo.m_Memory.find(id) != m_CreationInfo.m_Memory.end() ||
+     m_DescriptorSetState.find(id) != m_DescriptorSetState.end())
+    m_CheckpointWrites[eventId].insert(id);
+}
+
+void WrappedVulkan::AddCheckpointUsage(ResourceId id, const EventUsage &usage)
+{
+  switch(usage.usage)
+  {
+    // read-only usages
+    case ResourceUsage::Unused:
+    case ResourceUsage::VertexBuffer:
+    case ResourceUsage::IndexBuffer:
+    case ResourceUsage::VS_Constants:
+    case ResourceUsage::HS_Constants:
+    case ResourceUsage::DS_Constants:
+    case ResourceUsage::GS_Constants:
+    case ResourceUsage::PS_Constants:
+    case ResourceUsage::CS_Constants:
+    case ResourceUsage::All_Constants:
+    case ResourceUsage::VS_Resource:
+    case ResourceUsage::HS_Resource:
+    case ResourceUsage::DS_Resource:
+    case ResourceUsage::GS_Resource:
+    case ResourceUsage::PS_Resource:
+    case ResourceUsage::CS_Resource:
+    case ResourceUsage::All_Resource:
+    case ResourceUsage::InputTarget:
+    case ResourceUsage::Indirect:
+    case ResourceUsage::ResolveSrc:
+    case ResourceUsage::CopySrc: return;
+    // anything else may write, including barriers since they can discard contents
+    default: break;
+  }
+
+  AddCheckpointWrite(usage.eventId, id);
+}
+
+void WrappedVulkan::AddCheckpointRootChunk(VulkanChunk chunk)
+{
+  if(!IsCheckpointSkippableChunk(chunk))
+    DisableReplayCheckpoints(
+        StringFormat::Fmt("%s in frame", GetChunkName((uint32_t)chunk).c_str()).c_str());
+}
+
+std::set<ResourceId> WrappedVulkan::GetCheckpointWrites(uint32_t firstEventID, uint32_t lastEventID)
+{
+  std::set<ResourceId> ret;
+
+  // writes after firstEventID, up to and including lastEventID
+  for(auto it = m_CheckpointWrites.upper_bound(firstEventID);
+      it != m_CheckpointWrites.end() && it->first <= lastEventID; ++it)
+    ret.insert(it->second.begin(), it->second.end());
+
+  return ret;
+}
+
+bool WrappedVulkan::HasTruncatedRerecord(uint32_t eventId)
+{
+  // a command buffer that contains the event we're replaying to is only re-recorded up to that
+  // event. If it's also submitted at or before eventId, then that submit didn't run in full.
+  for(int p = 0; p < ePartialNum; p++)
+  {
+    for(auto it = m_Partial[p].cmdBufferSubmits.begin();
+        it != m_Partial[p].cmdBufferSubmits.end(); ++it)
+    {
+      const uint32_t length = m_BakedCmdBufferInfo[it->first].eventCount;
+
+      bool partial = false, earlier = false;
+
+      for(const Submission &submit : it->second)
+      {
+        if(submit.baseEvent <= m_LastEventID && m_LastEventID < submit.baseEvent + length)
+          partial = true;
+        else if(submit.baseEvent <= eventId)
+          earlier = true;
+      }
+
+      if(partial && earlier)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+void WrappedVulkan::CopyCheckpointImage(VkCommandBuffer cmd, ResourceId id, VkImage snapshot,
+                                        bool restore)
+{
+  const VulkanCreationInfo::Image &c = m_CreationInfo.m_Image[id];
+  ImageLayouts &layouts = m_ImageLayouts[id];
+
+  VkImage live = GetResourceManager()->GetCurrentHandle<VkImage>(id);
+
+  VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+  if(IsDepthOnlyFormat(c.format))
+    aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
+  else if(IsStencilOnlyFormat(c.format))
+    aspectFlags = VK_IMAGE_ASPECT_STENCIL_BIT;
+  else if(IsDepthOrStencilFormat(c.format))
+    aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  // the snapshot is permanently in transfer source layout once it's been filled
+  VkImageLayout liveLayout =
+      restore ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  VkAccessFlags copyAccess = restore ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_TRANSFER_READ_BIT;
+
+  VkImageMemoryBarrier barrier = {
+      VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      NULL,
+      0,
+      copyAccess,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      liveLayout,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      Unwrap(live),
+      {aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+  };
+
+  for(size_t si = 0; si < layouts.subresourceStates.size(); si++)
+  {
+    barrier.subresourceRange = layouts.subresourceStates[si].subresourceRange;
+    barrier.oldLayout = layouts.subresourceStates[si].newLayout;
+    barrier.srcAccessMask = VK_ACCESS_ALL_WRITE_BITS | MakeAccessMask(barrier.oldLayout);
+    DoPipelineBarrier(cmd, 1, &barrier);
+  }
+
+  VkImageMemoryBarrier snapshotBarrier = {
+      VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      NULL,
+      0,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      Unwrap(snapshot),
+      {aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+  };
+
+  if(!restore)
+    DoPipelineBarrier(cmd, 1, &snapshotBarrier);
+
+  std::vector<VkImageCopy> regions;
+
+  VkExtent3D extent = c.extent;
+
+  for(int m = 0; m < c.mipLevels; m++)
+  {
+    VkImageSubresourceLayers sub = {aspectFlags, (uint32_t)m, 0, (uint32_t)c.arrayLayers};
+
+    VkImageCopy region = {sub, {0, 0, 0}, sub, {0, 0, 0}, extent};
+    regions.push_back(region);
+
+    extent.width = RDCMAX(extent.width >> 1, 1U);
+    extent.height = RDCMAX(extent.height >> 1, 1U);
+    extent.depth = RDCMAX(extent.depth >> 1, 1U);
+  }
+
+  if(restore)
+    ObjDisp(cmd)->CmdCopyImage(Unwrap(cmd), Unwrap(snapshot), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               Unwrap(live), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32_t)regions.size(), regions.data());
+  else
+    ObjDisp(cmd)->CmdCopyImage(Unwrap(cmd), Unwrap(live), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               Unwrap(snapshot), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32_t)regions.size(), regions.data());
+
+  if(!restore)
+  {
+    snapshotBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    snapshotBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    snapshotBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    snapshotBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    DoPipelineBarrier(cmd, 1, &snapshotBarrier);
+  }
+
+  // put the live image back how it was. We can't transition back to undefined, so any subresources
+  // that were undefined are now tracked in the copy's layout.
+  barrier.oldLayout = liveLayout;
+  barrier.srcAccessMask = copyAccess;
+
+  for(size_t si = 0; si < layouts.subresourceStates.size(); si++)
+  {
+    ImageRegionState &state = layouts.subresourceStates[si];
+
+    if(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+       state.newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+    {
+      state.newLayout = liveLayout;
+      continue;
+    }
+
+    barrier.subresourceRange = state.subresourceRange;
+    barrier.newLayout = state.newLayout;
+    barrier.dstAccessMask = VK_ACCESS_ALL_READ_BITS | MakeAccessMask(barrier.newLayout);
+    DoPipelineBarrier(cmd, 1, &barrier);
+  }
+}
+
+void WrappedVulkan::TakeReplayCheckpoint(uint32_t eventId, uint64_t resumeOffset)
+{
+  if(!m_ReplayCheckpointsSupported || m_ReplayCheckpointBudget == 0)
+    return;
+
+  uint32_t prevEventID = m_ReplayCheckpoints.empty() ? 0 : m_ReplayCheckpoints.back().eventId;
+
+  if(eventId < prevEventID + m_ReplayCheckpointInterval || HasTruncatedRerecord(eventId))
+    return;
+
+  std::set<ResourceId> written = GetCheckpointWrites(prevEventID, eventId);
+
+  VkDeviceSize size = 0;
+
+  for(ResourceId id : written)
+  {
+    ResourceId origId = GetResourceManager()->GetOriginalID(id);
+
+    auto img = m_CreationInfo.m_Image.find(id);
+    auto mem = m_CreationInfo.m_Memory.find(id);
+
+    if(img != m_CreationInfo.m_Image.end())
+    {
+      const VulkanCreationInfo::Image &c = img->second;
+
+      if(IsYUVFormat(c.format))
+      {
+        DisableReplayCheckpoints(StringFormat::Fmt("YUV image %llu is written", origId).c_str());
+        return;
+      }
+
+      if(GetResourceManager()->GetInitialContents(origId).tag == VkInitialContents::Sparse)
+      {
+        DisableReplayCheckpoints(StringFormat::Fmt("sparse image %llu is written", origId).c_str());
+        return;
+      }
+
+      VkDeviceSize imageSize = 0;
+      for(int m = 0; m < c.mipLevels; m++)
+        imageSize += GetByteSize(c.extent.width, c.extent.height, c.extent.depth, c.format, m);
+
+      size += imageSize * c.arrayLayers * (VkDeviceSize)c.samples;
+    }
+    else if(mem != m_CreationInfo.m_Memory.end())
+    {
+      if(mem->second.wholeMemBuf == VK_NULL_HANDLE)
+      {
+        DisableReplayCheckpoints(StringFormat::Fmt("memory %llu can't be copied", origId).c_str());
+        return;
+      }
+
+      size += mem->second.size;
+    }
+  }
+
+  if(m_ReplayCheckpointBytes + size > m_ReplayCheckpointBudget)
+  {
+    RDCDEBUG("Skipping replay checkpoint at %u, %llu bytes would exceed the budget", eventId, size);
+    return;
+  }
+
+  VkDevice dev = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  // the replayed submits may be on other queues
+  ObjDisp(dev)->DeviceWaitIdle(Unwrap(dev));
+
+  ReplayCheckpoint checkpoint;
+  checkpoint.eventId = eventId;
+  checkpoint.resumeOffset = resumeOffset;
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_ALL_READ_BITS,
+  };
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  for(ResourceId id : written)
+  {
+    auto img = m_CreationInfo.m_Image.find(id);
+    auto mem = m_CreationInfo.m_Memory.find(id);
+
+    if(img != m_CreationInfo.m_Image.end())
+    {
+      const VulkanCreationInfo::Image &c = img->second;
+
+      VkImageCreateInfo imInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          NULL,
+          0,
+          c.type,
+          c.format,
+          c.extent,
+          (uint32_t)c.mipLevels,
+          (uint32_t)c.arrayLayers,
+          c.samples,
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+          VK_SHARING_MODE_EXCLUSIVE,
+          0,
+          NULL,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+
+      // multisampled images need an attachment usage to be created
+      if(c.samples != VK_SAMPLE_COUNT_1_BIT)
+      {
+        if(IsDepthOrStencilFormat(c.format))
+          imInfo.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        else
+          imInfo.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+      }
+
+      VkImage snapshot = VK_NULL_HANDLE;
+
+      vkr = ObjDisp(dev)->CreateImage(Unwrap(dev), &imInfo, NULL, &snapshot);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      GetResourceManager()->WrapResource(Unwrap(dev), snapshot);
+
+      MemoryAllocation alloc =
+          AllocateMemoryForResource(snapshot, MemoryScope::ReplayCheckpoints, MemoryType::GPULocal);
+
+      vkr = ObjDisp(dev)->BindImageMemory(Unwrap(dev), Unwrap(snapshot), Unwrap(alloc.mem),
+                                          alloc.offs);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      CopyCheckpointImage(cmd, id, snapshot, false);
+
+      VkInitialContents contents(eResImage, alloc);
+      contents.img = snapshot;
+
+      checkpoint.contents[id] = contents;
+      m_ReplayCheckpointBytes += alloc.size;
+    }
+    else if(mem != m_CreationInfo.m_Memory.end())
+    {
+      VkBufferCreateInfo bufInfo = {
+          VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+          NULL,
+          0,
+          mem->second.size,
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      };
+
+      VkBuffer snapshot = VK_NULL_HANDLE;
+
+      vkr = ObjDisp(dev)->CreateBuffer(Unwrap(dev), &bufInfo, NULL, &snapshot);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      GetResourceManager()->WrapResource(Unwrap(dev), snapshot);
+
+      MemoryAllocation alloc =
+          AllocateMemoryForResource(snapshot, MemoryScope::ReplayCheckpoints, MemoryType::GPULocal);
+
+      vkr = ObjDisp(dev)->BindBufferMemory(Unwrap(dev), Unwrap(snapshot), Unwrap(alloc.mem),
+                                           alloc.offs);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      VkBufferCopy region = {0, 0, mem->second.size};
+
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(mem->second.wholeMemBuf), Unwrap(snapshot), 1,
+                                  &region);
+
+      m_ReplayCheckpointBytes += alloc.size;
+
+      // applying a memory snapshot copies mem.size bytes, so it must be exactly the memory's size
+      VkInitialContents contents(eResDeviceMemory, alloc);
+      contents.buf = snapshot;
+      contents.mem.size = mem->second.size;
+
+      checkpoint.contents[id] = contents;
+    }
+    else
+    {
+      DescriptorSetInfo &setInfo = m_DescriptorSetState[id];
+      const DescSetLayout &layout = m_CreationInfo.m_DescSetLayout[setInfo.layout];
+
+      // push descriptors are only written by commands, which are replayed anyway
+      if(layout.flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+        continue;
+
+      std::vector<DescriptorSetSlot> slots;
+
+      for(size_t b = 0; b < layout.bindings.size(); b++)
+      {
+        for(uint32_t a = 0; a < layout.bindings[b].descriptorCount; a++)
+        {
+          DescriptorSetSlot slot;
+          RDCEraseEl(slot);
+
+          if(b < setInfo.currentBindings.size())
+            slot = setInfo.currentBindings[b][a];
+
+          slots.push_back(slot);
+        }
+      }
+
+      VkInitialContents contents(eResDescriptorSet, VkInitialContents::DescriptorSet);
+
+      CreateDescriptorWrites(contents, GetResourceManager()->GetCurrentResource(id), layout,
+                             slots.data(), (uint32_t)slots.size());
+
+      checkpoint.contents[id] = contents;
+    }
+  }
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+
+  // our own images aren't part of the capture, so their layouts are left alone when restoring
+  for(auto it = m_ImageLayouts.begin(); it != m_ImageLayouts.end(); ++it)
+    if(GetResourceManager()->GetOriginalID(it->first) != it->first)
+      checkpoint.imageLayouts[it->first] = it->second;
+
+  RDCDEBUG("Took replay checkpoint at %u with %zu resources, %llu bytes in total", eventId,
+           checkpoint.contents.size(), m_ReplayCheckpointBytes);
+
+  m_ReplayCheckpoints.push_back(checkpoint);
+}
+
+void WrappedVulkan::RestoreReplayCheckpoint(size_t idx, uint32_t replayedEventID)
+{
+  const ReplayCheckpoint &checkpoint = m_ReplayCheckpoints[idx];
+
+  std::set<ResourceId> restore;
+
+  if(replayedEventID == 0)
+  {
+    // we don't know what has changed, so go back to the initial contents and restore everything
+    // written up to the checkpoint.
+    ApplyInitialContents();
+
+    restore = GetCheckpointWrites(0, checkpoint.eventId);
+  }
+  else
+  {
+    // anything not written between the checkpoint and where we replayed to is already the same.
+    restore = GetCheckpointWrites(RDCMIN(replayedEventID, checkpoint.eventId),
+                                  RDCMAX(replayedEventID, checkpoint.eventId));
+  }
+
+  VkResult vkr = VK_SUCCESS;
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_ALL_READ_BITS,
+  };
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // as in ApplyInitialContents, sync all GPU work so we can update descriptor sets
+  SubmitCmds();
+  FlushQ();
+
+  cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  for(ResourceId id : restore)
+  {
+    // find the latest snapshot of this resource at or before the checkpoint
+    const VkInitialContents *snapshot = NULL;
+
+    for(size_t i = idx + 1; i > 0 && snapshot == NULL; i--)
+    {
+      auto it = m_ReplayCheckpoints[i - 1].contents.find(id);
+      if(it != m_ReplayCheckpoints[i - 1].contents.end())
+        snapshot = &it->second;
+    }
+
+    if(snapshot && snapshot->type == eResImage)
+    {
+      CopyCheckpointImage(cmd, id, snapshot->img, true);
+    }
+    else if(snapshot)
+    {
+      Apply_InitialState(GetResourceManager()->GetCurrentResource(id), *snapshot);
+    }
+    else
+    {
+      // not written before the checkpoint, so it goes back to its initial contents
+      ResourceId origId = GetResourceManager()->GetOriginalID(id);
+      VkInitialContents initial = GetResourceManager()->GetInitialContents(origId);
+
+      if(initial.type != eResUnknown)
+        Apply_InitialState(GetResourceManager()->GetLiveResource(origId), initial);
+    }
+  }
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // now put all images into the layouts they had at the checkpoint, as Serialise_BeginCaptureFrame
+  // does for the start of the frame.
+  std::vector<VkImageMemoryBarrier> imgBarriers;
+  std::vector<std::pair<ResourceId, ImageRegionState> > states;
+
+  for(auto it = checkpoint.imageLayouts.begin(); it != checkpoint.imageLayouts.end(); ++it)
+  {
+    // skip any images destroyed since
+    if(m_ImageLayouts.find(it->first) == m_ImageLayouts.end())
+      continue;
+
+    for(const ImageRegionState &state : it->second.subresourceStates)
+    {
+      if(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+         state.newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+        continue;
+
+      VkImageMemoryBarrier t = {
+          VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          NULL,
+          0,
+          0,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+          state.newLayout,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(it->first)),
+          state.subresourceRange,
+      };
+
+      imgBarriers.push_back(t);
+      states.push_back(std::make_pair(it->first, state));
+    }
+  }
+
+  GetResourceManager()->ApplyBarriers(states, m_ImageLayouts);
+
+  for(size_t i = 0; i < states.size(); i++)
+    imgBarriers[i].oldLayout = states[i].second.oldLayout;
+
+  // erase any do-nothing barriers
+  for(auto it = imgBarriers.begin(); it != imgBarriers.end();)
+  {
+    if(it->oldLayout == UNKNOWN_PREV_IMG_LAYOUT)
+      it->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if(it->oldLayout == it->newLayout)
+    {
+      it = imgBarriers.erase(it);
+    }
+    else
+    {
+      it->srcAccessMask = VK_ACCESS_ALL_WRITE_BITS | MakeAccessMask(it->oldLayout);
+      it->dstAccessMask = VK_ACCESS_ALL_READ_BITS | MakeAccessMask(it->newLayout);
+      ++it;
+    }
+  }
+
+  cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  if(!imgBarriers.empty())
+    DoPipelineBarrier(cmd, (uint32_t)imgBarriers.size(), imgBarriers.data());
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  RDCDEBUG("Restored replay checkpoint at %u, %zu resources from %u", checkpoint.eventId,
+           restore.size(), replayedEventID);
+}
+
+void WrappedVulkan::FreeReplayCheckpoints()
+{
+  if(m_ReplayCheckpoints.empty())
+    return;
+
+  VkDevice dev = GetDev();
+  ObjDisp(dev)->DeviceWaitIdle(Unwrap(dev));
+
+  for(ReplayCheckpoint &checkpoint : m_ReplayCheckpoints)
+    for(auto it = checkpoint.contents.begin(); it != checkpoint.contents.end(); ++it)
+      it->second.Free(GetResourceManager());
+
+  m_ReplayCheckpoints.clear();
+  m_ReplayCheckpointBytes = 0;
+
+  FreeAllMemory(MemoryScope::ReplayCheckpoints);
+}
+
+void WrappedVulkan::InvalidateReplayCheckpoints()
+{
+  m_ContinueEventID = 0;
+  m_ReplayedEventID = 0;
+
+  FreeReplayCheckpoints();
+}
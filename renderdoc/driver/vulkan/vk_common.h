@@ -278,6 +278,7 @@ enum class MemoryScope : uint8_t
 {
   InitialContents,
   First = InitialContents,
+  ReplayCheckpoints,
   Count,
 };
 
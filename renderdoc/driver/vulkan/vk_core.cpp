@@ -23,8 +23,8 @@
  ******************************************************************************/
 
 #include "vk_core.h"
+#include "core/capture_writer.h"
 #include "driver/ihv/amd/amd_rgp.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/rdcfile.h"
 #include "strings/string_utils.h"
@@ -152,6 +152,7 @@ WrappedVulkan::WrappedVulkan() : m_RenderState(this, &m_CreationInfo)
     m_FrameCaptureRecord->DataInSerialiser = false;
     m_FrameCaptureRecord->Length = 0;
     m_FrameCaptureRecord->SpecialResource = true;
+    m_FrameCaptureRecord->TransientChunks = true;
   }
   else
   {
@@ -1032,7 +1033,10 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
   // and go into the frame record.
   {
     SCOPED_LOCK(m_CapTransitionLock);
+
+    BeginInitialStateBatch();
     GetResourceManager()->PrepareInitialContents();
+    EndInitialStateBatch();
 
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
@@ -1049,6 +1053,8 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
       m_HeaderChunk = scope.Get();
     }
 
+    m_CaptureGeneration++;
+
     m_State = CaptureState::ActiveCapturing;
   }
 
@@ -1394,52 +1400,31 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     GetResourceManager()->ReleaseWrappedResource(readbackIm);
   }
 
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(wnd)
-  {
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
-
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
-
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
-    }
-  }
-
-  RDCFile *rdc = RenderDoc::Inst().CreateRDC(RDCDriver::Vulkan, m_CapturedFrames.back().frameNumber,
-                                             jpgbuf, len, thwidth, thheight);
-
-  SAFE_DELETE_ARRAY(jpgbuf);
-  SAFE_DELETE_ARRAY(thpixels);
+  // the thumbnail is encoded on the capture writing thread
+  CaptureThumbnail thumb;
 
-  StreamWriter *captureWriter = NULL;
-
-  if(rdc)
+  if(wnd && thpixels)
   {
-    SectionProperties props;
-
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
-    props.version = m_SectionVersion;
-    props.type = SectionType::FrameCapture;
-
-    captureWriter = rdc->WriteSection(props);
+    thumb.pixels = thpixels;
+    thumb.len = 3U * thwidth * thheight;
+    thumb.width = thwidth;
+    thumb.height = thheight;
   }
   else
   {
-    captureWriter = new StreamWriter(StreamWriter::InvalidStream);
+    SAFE_DELETE_ARRAY(thpixels);
   }
 
+  SectionProperties props;
+
+  // Compress with LZ4 so that it's fast
+  props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
+  props.version = m_SectionVersion;
+  props.type = SectionType::FrameCapture;
+
+  StreamWriter *captureWriter = CaptureWriter::BeginWrite(
+      RDCDriver::Vulkan, m_CapturedFrames.back().frameNumber, props, thumb);
+
   {
     WriteSerialiser ser(captureWriter, Ownership::Stream);
 
@@ -1510,8 +1495,6 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     }
   }
 
-  RenderDoc::Inst().FinishCaptureWriting(rdc, m_CapturedFrames.back().frameNumber);
-
   SAFE_DELETE(m_HeaderChunk);
 
   m_State = CaptureState::BackgroundCapturing;
@@ -1731,10 +1714,23 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     m_StructuredFile = &ser.GetStructuredFile();
   }
 
+  // the frame stays in memory, so if requested we only export each chunk's name and metadata while
+  // loading and fill in the contents on demand in LoadStructuredChunk.
+  const bool lazy = IsLoading(m_State) &&
+                    RenderDoc::Inst().GetConfigSetting("Replay_LazyStructuredData") == "1";
+
+  if(lazy)
+  {
+    ser.SetLazyStructuredExport(true);
+    m_LazyChunkOffsets.clear();
+    m_LazyChunkOffsets[(uint32_t)m_StructuredFile->chunks.size()] = 0;
+  }
+
   SystemChunk header = ser.ReadChunk<SystemChunk>();
   RDCASSERTEQUAL(header, SystemChunk::CaptureBegin);
 
-  if(partial)
+  // when resuming from a checkpoint, it restores the image layouts instead
+  if(partial || m_ResumeOffset != 0)
     ser.SkipCurrentChunk();
   else
     Serialise_BeginCaptureFrame(ser);
@@ -1752,6 +1748,8 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
 
     SubmitCmds();
     FlushQ();
+
+    InitReplayCheckpoints();
   }
 
   m_RootEvents.clear();
@@ -1791,6 +1789,10 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
 
   for(;;)
   {
+    // once we reach the chunk after the checkpoint's submit, pick up the event IDs from there
+    if(m_ResumeOffset != 0 && ser.GetReader()->GetOffset() == m_ResumeOffset)
+      m_RootEventID = m_ResumeEventID + 1;
+
     if(IsActiveReplaying(m_State) && m_RootEventID > endEventID)
     {
       // we can just break out if we've done all the events desired.
@@ -1805,8 +1807,21 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     if(ser.GetReader()->IsErrored())
       return ReplayStatus::APIDataCorrupted;
 
+    if(lazy)
+      m_LazyChunkOffsets[(uint32_t)m_StructuredFile->chunks.size() - 1] = m_CurChunkOffset;
+
     m_ChunkMetadata = ser.ChunkMetadata();
 
+    // before the checkpoint we resumed from we only need to record command buffers, everything
+    // else has already been restored.
+    if(m_ResumeOffset != 0 && m_CurChunkOffset < m_ResumeOffset &&
+       IsCheckpointSkippableChunk(chunktype))
+    {
+      ser.SkipCurrentChunk();
+      ser.EndChunk();
+      continue;
+    }
+
     m_LastCmdBufferID = ResourceId();
 
     bool success = ContextProcessChunk(ser, chunktype);
@@ -1828,6 +1843,9 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     if((SystemChunk)chunktype == SystemChunk::CaptureEnd)
       break;
 
+    if(IsLoading(m_State) && m_LastCmdBufferID == ResourceId())
+      AddCheckpointRootChunk(chunktype);
+
     // break out if we were only executing one event
     if(IsActiveReplaying(m_State) && startEventID == endEventID)
       break;
@@ -1851,6 +1869,11 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
          chunktype != VulkanChunk::vkEndCommandBuffer)
         m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID++;
     }
+
+    // a submit we replayed in full is a point where we can take a checkpoint
+    if(IsActiveReplaying(m_State) && !partial && m_DrawcallCallback == NULL &&
+       chunktype == VulkanChunk::vkQueueSubmit && m_RootEventID - 1 <= m_LastEventID)
+      TakeReplayCheckpoint(m_RootEventID - 1, ser.GetReader()->GetOffset());
   }
 
   if(!partial && !IsStructuredExporting(m_State))
@@ -1946,6 +1969,68 @@ void WrappedVulkan::ApplyInitialContents()
 #endif
 }
 
+void WrappedVulkan::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  auto it = m_LazyChunkOffsets.find(chunkIndex);
+
+  // already loaded, or never lazy in the first place
+  if(it == m_LazyChunkOffsets.end())
+    return;
+
+  uint64_t offset = it->second;
+  m_LazyChunkOffsets.erase(it);
+
+  SDChunk *dst = m_StructuredFile->chunks[chunkIndex];
+
+  m_FrameReader->SetOffset(offset);
+
+  ReadSerialiser ser(m_FrameReader, Ownership::Nothing);
+
+  ser.SetStringDatabase(&m_StringDB);
+  ser.SetUserData(GetResourceManager());
+  ser.SetVersion(m_SectionVersion);
+
+  ser.ConfigureStructuredExport(&GetChunkName, false);
+
+  // re-read the chunk as if we were exporting it, so that nothing is replayed
+  CaptureState prevState = m_State;
+  SDFile *prevFile = m_StructuredFile;
+  uint64_t prevOffset = m_CurChunkOffset;
+  SDChunkMetaData prevMetadata = m_ChunkMetadata;
+
+  m_State = CaptureState::StructuredExport;
+  m_StructuredFile = &ser.GetStructuredFile();
+  m_CurChunkOffset = offset;
+
+  VulkanChunk chunktype = ser.ReadChunk<VulkanChunk>();
+
+  m_ChunkMetadata = ser.ChunkMetadata();
+
+  if((SystemChunk)chunktype == SystemChunk::CaptureBegin)
+    Serialise_BeginCaptureFrame(ser);
+  else
+    ProcessChunk(ser, chunktype);
+
+  ser.EndChunk();
+
+  m_State = prevState;
+  m_StructuredFile = prevFile;
+  m_CurChunkOffset = prevOffset;
+  m_ChunkMetadata = prevMetadata;
+
+  if(ser.IsErrored() || ser.GetStructuredFile().chunks.empty())
+  {
+    RDCERR("Couldn't load structured data for chunk %u", chunkIndex);
+    return;
+  }
+
+  SDChunk *src = ser.GetStructuredFile().chunks[0];
+
+  dst->type.flags = src->type.flags;
+  dst->data.basic = src->data.basic;
+  dst->data.children.swap(src->data.children);
+}
+
 bool WrappedVulkan::ContextProcessChunk(ReadSerialiser &ser, VulkanChunk chunk)
 {
   m_AddedDrawcall = false;
@@ -2483,21 +2568,99 @@ void WrappedVulkan::AddFrameTerminator(uint64_t queueMarkerTag)
   SubmitCmds();
 }
 
+bool WrappedVulkan::CanContinueReplay(uint32_t continueEventID, uint32_t endEventID)
+{
+  if(continueEventID == 0 || continueEventID >= endEventID)
+    return false;
+
+  // partial replays restore whether a render pass was active afterwards, and can't cross command
+  // buffers. So we can only continue if there are no pass boundaries (which includes subpasses)
+  // between the two events, and nothing executes secondary command buffers.
+  const DrawcallDescription *draw = GetDrawcall(endEventID);
+
+  if(draw == NULL)
+    return false;
+
+  while(draw && draw->eventId > continueEventID)
+  {
+    if(draw->flags & (DrawFlags::PassBoundary | DrawFlags::CmdList))
+      return false;
+
+    draw = GetDrawcall((uint32_t)draw->previous);
+  }
+
+  return draw != NULL && !(draw->flags & (DrawFlags::EndPass | DrawFlags::CmdList));
+}
+
 void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType)
 {
   bool partial = true;
 
+  // any replay invalidates where we can continue from unless it's one that we know continues.
+  uint32_t continueEventID = m_ContinueEventID;
+  m_ContinueEventID = 0;
+
+  // similarly we only know which event the resources correspond to after some replays
+  uint32_t replayedEventID = m_ReplayedEventID;
+  m_ReplayedEventID = 0;
+
+  bool seek = (startEventID == 0 && replayType == eReplay_WithoutDraw);
+  bool onlyDraw =
+      (replayType == eReplay_OnlyDraw && (startEventID == 0 || startEventID == endEventID));
+
   if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
   {
     startEventID = 1;
     partial = false;
   }
 
+  // if we're seeking forward within the same render pass we already replayed up to, only replay
+  // the events in between.
+  if(seek && CanContinueReplay(continueEventID, endEventID))
+  {
+    // if we're already where we need to be, there's nothing to replay
+    if(continueEventID + 1 == endEventID)
+    {
+      m_ContinueEventID = continueEventID;
+      m_ReplayedEventID = replayedEventID;
+      return;
+    }
+
+    startEventID = continueEventID + 1;
+    partial = true;
+  }
+
+  // the last event this replay will execute
+  uint32_t lastEventID =
+      replayType == eReplay_WithoutDraw ? RDCMAX(1U, endEventID) - 1 : endEventID;
+
   if(!partial)
   {
-    VkMarkerRegion::Begin("!!!!RenderDoc Internal: ApplyInitialContents");
-    ApplyInitialContents();
-    VkMarkerRegion::End();
+    // find the latest checkpoint we can start from, a callback needs to see every event though.
+    size_t resume = m_ReplayCheckpoints.size();
+
+    if(m_DrawcallCallback == NULL)
+    {
+      for(size_t i = 0; i < m_ReplayCheckpoints.size(); i++)
+        if(m_ReplayCheckpoints[i].eventId <= lastEventID)
+          resume = i;
+    }
+
+    if(resume < m_ReplayCheckpoints.size())
+    {
+      VkMarkerRegion::Begin("!!!!RenderDoc Internal: RestoreReplayCheckpoint");
+      RestoreReplayCheckpoint(resume, replayedEventID);
+      VkMarkerRegion::End();
+
+      m_ResumeEventID = m_ReplayCheckpoints[resume].eventId;
+      m_ResumeOffset = m_ReplayCheckpoints[resume].resumeOffset;
+    }
+    else
+    {
+      VkMarkerRegion::Begin("!!!!RenderDoc Internal: ApplyInitialContents");
+      ApplyInitialContents();
+      VkMarkerRegion::End();
+    }
 
     SubmitCmds();
     FlushQ();
@@ -2603,6 +2766,9 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
     else
       RDCFATAL("Unexpected replay type");
 
+    m_ResumeEventID = 0;
+    m_ResumeOffset = 0;
+
     RDCASSERTEQUAL(status, ReplayStatus::Succeeded);
 
     if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
@@ -2631,6 +2797,30 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 #endif
   }
 
+  // update where we can continue from if we're at a point inside a render pass (outside of any
+  // secondary command buffers) that we got to by replaying in order.
+  if(m_Partial[Primary].renderPassActive && m_Partial[Secondary].partialParent == ResourceId())
+  {
+    if(seek)
+      m_ContinueEventID = RDCMAX(1U, endEventID) - 1;
+    else if(!partial && replayType == eReplay_Full)
+      m_ContinueEventID = endEventID;
+    else if(onlyDraw && continueEventID != 0 && continueEventID + 1 == endEventID)
+      m_ContinueEventID = endEventID;
+  }
+
+  // and which event the resources now correspond to, for restoring checkpoints. A callback can
+  // replay events differently so we don't know.
+  if(m_DrawcallCallback == NULL)
+  {
+    if(!partial)
+      m_ReplayedEventID = lastEventID;
+    else if(seek && replayedEventID == continueEventID)
+      m_ReplayedEventID = lastEventID;
+    else if(onlyDraw && replayedEventID != 0 && replayedEventID + 1 == endEventID)
+      m_ReplayedEventID = endEventID;
+  }
+
   VkMarkerRegion::Set("!!!!RenderDoc Internal: Done replay");
 }
 
@@ -245,6 +245,8 @@ private:
   uint64_t m_SectionVersion;
 
   StreamReader *m_FrameReader = NULL;
+  // offsets in m_FrameReader of any frame chunks whose structured data was loaded lazily
+  std::map<uint32_t, uint64_t> m_LazyChunkOffsets;
 
   std::set<std::string> m_StringDB;
 
@@ -267,6 +269,13 @@ private:
 
   Threading::CriticalSection m_CapTransitionLock;
 
+  // incremented whenever a capture starts, so descriptor sets can tell whether their bind frame
+  // refs have been applied in this capture yet. Every descriptor set's bind frame refs and the
+  // tracking of which have changed are protected by m_DescSetRefsLock, since sets can be updated on
+  // one thread while they're bound or submitted on another.
+  uint32_t m_CaptureGeneration = 0;
+  Threading::CriticalSection m_DescSetRefsLock;
+
   VulkanDrawcallCallback *m_DrawcallCallback;
 
   SDFile *m_StructuredFile;
@@ -396,6 +405,27 @@ private:
     // -> FlushQ() ----back to freesems-------^
   } m_InternalCmds;
 
+  // Initial state readbacks during capture are batched. The copies for many resources are recorded
+  // and submitted together, then we wait once and destroy the temporary objects they used. A batch
+  // is flushed early once it's copying enough data that it could take a long time on the GPU.
+  struct InitialStateBatch
+  {
+    bool active = false;
+
+    uint32_t pendingCopies = 0;
+    VkDeviceSize pendingBytes = 0;
+
+    std::vector<VkBuffer> buffers;
+    std::vector<VkImage> images;
+  } m_InitStateBatch;
+
+  void BeginInitialStateBatch();
+  void EndInitialStateBatch();
+  void FlushInitialStateBatch();
+  // called once the copy for a resource has been recorded. Outside of a batch this submits and
+  // waits immediately.
+  void FinishInitialStateCopy(VkDeviceSize size);
+
   // Internal lumped/pooled memory allocations
 
   // Each memory scope gets a separate vector of allocation objects. The vector contains the list of
@@ -452,6 +482,10 @@ private:
 
     std::vector<std::pair<ResourceId, EventUsage> > resourceUsage;
 
+    // resources written by commands that don't add a resource usage, like render pass load/store
+    // ops or buffer fills. Only used for replay checkpoints.
+    std::set<ResourceId> writtenResources;
+
     struct CmdBufferState
     {
       ResourceId pipeline;
@@ -697,6 +731,10 @@ private:
 
   void ApplyInitialContents();
 
+  bool CreateDescriptorWrites(VkInitialContents &initialContents, WrappedVkRes *set,
+                              const DescSetLayout &layout, const DescriptorSetSlot *slots,
+                              uint32_t numSlots);
+
   vector<APIEvent> m_RootEvents, m_Events;
   bool m_AddedDrawcall;
 
@@ -705,6 +743,57 @@ private:
   uint32_t m_RootEventID, m_RootDrawcallID;
   uint32_t m_FirstEventID, m_LastEventID;
 
+  // the event that the current replayed state corresponds to, if it was reached only by replaying
+  // the frame in order and is inside a render pass. A later seek in the same pass can continue from
+  // here with a partial replay instead of replaying the whole frame. 0 if there's no such state.
+  uint32_t m_ContinueEventID = 0;
+
+  bool CanContinueReplay(uint32_t continueEventID, uint32_t endEventID);
+
+  // the event that the current resource contents correspond to, or 0 if they aren't known (e.g.
+  // after a replay with a drawcall callback).
+  uint32_t m_ReplayedEventID = 0;
+
+  // replay checkpoints, in vk_checkpoint.cpp. When a queue submit has been replayed in full, we
+  // snapshot the resources written since the previous checkpoint. A later replay then restores the
+  // nearest checkpoint before its end and only replays the frame from there.
+  struct ReplayCheckpoint
+  {
+    uint32_t eventId = 0;
+    // file offset of the chunk following the submit
+    uint64_t resumeOffset = 0;
+    // snapshots of the resources written since the previous checkpoint, by live ID
+    std::map<ResourceId, VkInitialContents> contents;
+    // the layouts of all images at this point
+    std::map<ResourceId, ImageLayouts> imageLayouts;
+  };
+
+  std::vector<ReplayCheckpoint> m_ReplayCheckpoints;
+  VkDeviceSize m_ReplayCheckpointBytes = 0;
+  VkDeviceSize m_ReplayCheckpointBudget = 0;
+  uint32_t m_ReplayCheckpointInterval = 0;
+  bool m_ReplayCheckpointsSupported = false;
+
+  // live IDs of the images, memory and descriptor sets written at each event, filled in on load
+  std::map<uint32_t, std::set<ResourceId> > m_CheckpointWrites;
+
+  // if non-zero, ContextReplayLog resumes after the checkpoint at this event and file offset
+  uint32_t m_ResumeEventID = 0;
+  uint64_t m_ResumeOffset = 0;
+
+  static bool IsCheckpointSkippableChunk(VulkanChunk chunk);
+  void InitReplayCheckpoints();
+  void AddCheckpointWrite(uint32_t eventId, ResourceId id);
+  void AddCheckpointUsage(ResourceId id, const EventUsage &usage);
+  void AddCheckpointRootChunk(VulkanChunk chunk);
+  std::set<ResourceId> GetCheckpointWrites(uint32_t firstEventID, uint32_t lastEventID);
+  void DisableReplayCheckpoints(const char *reason);
+  bool HasTruncatedRerecord(uint32_t eventId);
+  void CopyCheckpointImage(VkCommandBuffer cmd, ResourceId id, VkImage snapshot, bool restore);
+  void TakeReplayCheckpoint(uint32_t eventId, uint64_t resumeOffset);
+  void RestoreReplayCheckpoint(size_t idx, uint32_t replayedEventID);
+  void FreeReplayCheckpoints();
+
   ReplayStatus m_FailedReplayStatus = ReplayStatus::APIReplayFailed;
 
   VulkanDrawcallTreeNode m_ParentDrawcall;
@@ -792,9 +881,12 @@ public:
   }
   void Shutdown();
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  // must be called if anything changes the replayed state other than ReplayLog
+  void InvalidateReplayCheckpoints();
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
 
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
+  void LoadStructuredChunk(uint32_t chunkIndex);
   FrameRecord &GetFrameRecord() { return m_FrameRecord; }
   const APIEvent &GetEvent(uint32_t eventId);
   uint32_t GetMaxEID() { return m_Events.back().eventId; }
@@ -167,7 +167,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
+    reflData.Init(resourceMan, id, info.m_ShaderModule[id].GetSPIRV(), shad.entryPoint,
                   pCreateInfo->pStages[i].stage);
 
     if(pCreateInfo->pStages[i].pSpecializationInfo)
@@ -418,7 +418,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
 
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
+    reflData.Init(resourceMan, id, info.m_ShaderModule[id].GetSPIRV(), shad.entryPoint,
                   pCreateInfo->stage.stage);
 
     if(pCreateInfo->stage.pSpecializationInfo)
@@ -686,10 +686,35 @@ void VulkanCreationInfo::ImageView::Init(VulkanResourceManager *resourceMan, Vul
   swizzle[3] = Convert(pCreateInfo->components.a, 3);
 }
 
+void SPIRVParseQueue::Enqueue(const std::shared_ptr<Job> &job)
+{
+  // the pool job only holds a weak reference so that a module that's destroyed before it's parsed
+  // isn't kept alive, and to avoid a cycle through job->parse.
+  std::weak_ptr<Job> weak = job;
+
+  job->parse = Threading::JobPool::Shared().Submit([weak]() {
+    std::shared_ptr<Job> j = weak.lock();
+    if(!j)
+      return;
+
+    ParseSPIRV(j->code.data(), j->code.size(), j->module);
+
+    // the module keeps its own copy of the code
+    std::vector<uint32_t>().swap(j->code);
+  });
+}
+
+void SPIRVParseQueue::Wait(Job &job)
+{
+  Threading::JobPool::Shared().Wait(job.parse);
+}
+
 void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
                                             VulkanCreationInfo &info,
                                             const VkShaderModuleCreateInfo *pCreateInfo)
 {
+  parse = std::make_shared<SPIRVParseQueue::Job>();
+
   const uint32_t SPIRVMagic = 0x07230203;
   if(pCreateInfo->codeSize < 4 || memcmp(pCreateInfo->pCode, &SPIRVMagic, sizeof(SPIRVMagic)))
   {
@@ -698,10 +723,23 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   else
   {
     RDCASSERT(pCreateInfo->codeSize % sizeof(uint32_t) == 0);
-    ParseSPIRV((uint32_t *)pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
+    parse->code.assign(pCreateInfo->pCode,
+                       pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t));
+    SPIRVParseQueue::Enqueue(parse);
   }
 }
 
+SPVModule &VulkanCreationInfo::ShaderModule::GetSPIRV()
+{
+  // modules that were never initialised are empty
+  if(!parse)
+    parse = std::make_shared<SPIRVParseQueue::Job>();
+
+  SPIRVParseQueue::Wait(*parse);
+
+  return parse->module;
+}
+
 void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *resourceMan,
                                                         ResourceId id, const SPVModule &spv,
                                                         const std::string &entry,
@@ -24,12 +24,34 @@
 
 #pragma once
 
+#include <memory>
+#include "common/threading.h"
 #include "driver/shaders/spirv/spirv_common.h"
 #include "vk_common.h"
 #include "vk_manager.h"
 
 struct VulkanCreationInfo;
 
+// Parsing SPIR-V is a large part of loading a capture with many shader modules, so modules are
+// parsed on the shared job pool as they're created rather than serially while processing chunks.
+// Anything that needs a module waits for it, or parses it immediately if no worker has got to it.
+namespace SPIRVParseQueue
+{
+struct Job
+{
+  std::vector<uint32_t> code;
+  SPVModule module;
+
+  // the pool job parsing the module, or NULL if there was nothing to parse
+  Threading::JobPool::JobHandle parse;
+};
+
+void Enqueue(const std::shared_ptr<Job> &job);
+
+// returns once the job has been parsed
+void Wait(Job &job);
+};
+
 struct DescSetLayout
 {
   void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -400,7 +422,10 @@ struct VulkanCreationInfo
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
               const VkShaderModuleCreateInfo *pCreateInfo);
 
-    SPVModule spirv;
+    // returns the parsed module, waiting for it to be parsed if necessary.
+    SPVModule &GetSPIRV();
+
+    std::shared_ptr<SPIRVParseQueue::Job> parse;
 
     string unstrippedPath;
 
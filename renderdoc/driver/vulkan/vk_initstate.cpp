@@ -34,12 +34,71 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
-// See INITSTATEBATCH
+// Preparing initial states during capture is batched (see InitialStateBatch) so we don't
+// submit and wait for every resource. Readback memory is suballocated from large blocks in
+// the InitialContents scope.
+// VKTODOLOW on replay we still do a lot of "create buffer, use it, flush/sync then destroy"
+// for each resource. See INITSTATEBATCH
+
+// the most data or resources we'll copy in one batch before submitting it, so that a single
+// submission doesn't run long enough to risk a device timeout and we don't keep too many command
+// buffers and temporary objects alive.
+static const VkDeviceSize InitialStateBatchBytes = 256 * 1024 * 1024;
+static const uint32_t InitialStateBatchCopies = 1024;
+
+void WrappedVulkan::BeginInitialStateBatch()
+{
+  RDCASSERT(!m_InitStateBatch.active);
+
+  m_InitStateBatch.active = true;
+  m_InitStateBatch.pendingCopies = 0;
+  m_InitStateBatch.pendingBytes = 0;
+}
+
+void WrappedVulkan::EndInitialStateBatch()
+{
+  FlushInitialStateBatch();
+
+  m_InitStateBatch.active = false;
+}
+
+void WrappedVulkan::FlushInitialStateBatch()
+{
+  if(m_InitStateBatch.pendingCopies == 0)
+    return;
+
+  SubmitCmds();
+  FlushQ();
+
+  VkDevice d = GetDev();
+
+  for(VkBuffer buf : m_InitStateBatch.buffers)
+  {
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(buf), NULL);
+    GetResourceManager()->ReleaseWrappedResource(buf);
+  }
+
+  for(VkImage im : m_InitStateBatch.images)
+  {
+    ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(im), NULL);
+    GetResourceManager()->ReleaseWrappedResource(im);
+  }
+
+  m_InitStateBatch.buffers.clear();
+  m_InitStateBatch.images.clear();
+  m_InitStateBatch.pendingCopies = 0;
+  m_InitStateBatch.pendingBytes = 0;
+}
+
+void WrappedVulkan::FinishInitialStateCopy(VkDeviceSize size)
+{
+  m_InitStateBatch.pendingCopies++;
+  m_InitStateBatch.pendingBytes += size;
+
+  if(!m_InitStateBatch.active || m_InitStateBatch.pendingCopies >= InitialStateBatchCopies ||
+     m_InitStateBatch.pendingBytes >= InitialStateBatchBytes)
+    FlushInitialStateBatch();
+}
 
 bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 {
@@ -106,7 +165,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     }
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
     VkCommandBuffer cmd = GetNextCmd();
 
     ImageLayouts *layout = NULL;
@@ -360,18 +418,13 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    // the buffer and array image are destroyed once the batch has completed
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
     if(arrayIm != VK_NULL_HANDLE)
-    {
-      ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(arrayIm), NULL);
-      GetResourceManager()->ReleaseWrappedResource(arrayIm);
-    }
+      m_InitStateBatch.images.push_back(arrayIm);
+
+    FinishInitialStateCopy(bufInfo.size);
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
@@ -382,7 +435,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     VkResult vkr = VK_SUCCESS;
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
     VkCommandBuffer cmd = GetNextCmd();
 
     VkResourceRecord *record = GetResourceManager()->GetResourceRecord(id);
@@ -446,14 +498,10 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    m_InitStateBatch.buffers.push_back(srcBuf);
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(srcBuf), NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(srcBuf);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    FinishInitialStateCopy(datasize);
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
@@ -518,7 +566,7 @@ static const char *NameOfType(VkResourceType type)
 
 static bool IsValid(const VkWriteDescriptorSet &write, uint32_t arrayElement)
 {
-  // this makes assumptions that only hold within the context of Serialise_InitialState below,
+  // this makes assumptions that only hold within the context of CreateDescriptorWrites below,
   // specifically that if pTexelBufferView/pBufferInfo is set then we are using them. In the general
   // case they can be garbage and we must ignore them based on the descriptorType
 
@@ -551,6 +599,190 @@ static bool IsValid(const VkWriteDescriptorSet &write, uint32_t arrayElement)
   return false;
 }
 
+// fills out the VkWriteDescriptorSet array in initialContents that re-applies the given descriptor
+// slots, one array of descriptors per binding in the layout.
+bool WrappedVulkan::CreateDescriptorWrites(VkInitialContents &initialContents, WrappedVkRes *set,
+                                           const DescSetLayout &layout,
+                                           const DescriptorSetSlot *slots, uint32_t numSlots)
+{
+  bool ret = true;
+
+  initialContents.numDescriptors = (uint32_t)layout.bindings.size();
+  initialContents.descriptorInfo = new VkDescriptorBufferInfo[numSlots];
+
+  // if we have partially-valid arrays, we need to split up writes. The worst case will never be
+  // == number of bindings since that implies all arrays are valid, but it is an upper bound as
+  // we'll never need more writes than bindings
+  initialContents.descriptorWrites = new VkWriteDescriptorSet[numSlots];
+
+  RDCCOMPILE_ASSERT(sizeof(VkDescriptorBufferInfo) >= sizeof(VkDescriptorImageInfo),
+                    "Descriptor structs sizes are unexpected, ensure largest size is used");
+
+  VkWriteDescriptorSet *writes = initialContents.descriptorWrites;
+  VkDescriptorBufferInfo *dstData = initialContents.descriptorInfo;
+  const DescriptorSetSlot *srcData = slots;
+
+  // validBinds counts up as we make a valid VkWriteDescriptorSet, so can be used to index into
+  // writes[] along the way as the 'latest' write.
+  uint32_t bind = 0;
+
+  for(uint32_t j = 0; j < initialContents.numDescriptors; j++)
+  {
+    writes[bind].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[bind].pNext = NULL;
+
+    // template for this write. We will expand it to include more descriptors as we find valid
+    // descriptors to update.
+    writes[bind].dstSet = (VkDescriptorSet)(uint64_t)set;
+    writes[bind].dstBinding = j;
+    writes[bind].dstArrayElement = 0;
+    // descriptor count starts at 0. We increment it as we find valid descriptors
+    writes[bind].descriptorCount = 0;
+    writes[bind].descriptorType = layout.bindings[j].descriptorType;
+
+    uint32_t descriptorCount = layout.bindings[j].descriptorCount;
+
+    const DescriptorSetSlot *src = srcData;
+    srcData += descriptorCount;
+
+    // will be cast to the appropriate type, we just need to increment
+    // the dstData pointer by worst case size
+    VkDescriptorBufferInfo *dstBuffer = dstData;
+    VkDescriptorImageInfo *dstImage = (VkDescriptorImageInfo *)dstData;
+    VkBufferView *dstTexelBuffer = (VkBufferView *)dstData;
+    dstData += descriptorCount;
+
+    // the correct one will be set below
+    writes[bind].pBufferInfo = NULL;
+    writes[bind].pImageInfo = NULL;
+    writes[bind].pTexelBufferView = NULL;
+
+    // check that the resources we need for this write are present, as some might have been
+    // skipped due to stale descriptor set slots or otherwise unreferenced objects (the
+    // descriptor set initial contents do not cause a frame reference for their resources).
+    //
+    // For the non-array case it's trivial as either the descriptor is valid, in which case it
+    // gets a write, or not, in which case we skip.
+    // For the array case we batch up updates as much as possible, iterating along the array and
+    // skipping any invalid descriptors.
+
+    // quick check for slots that were completely uninitialised and so don't have valid data
+    if(src->texelBufferView == VK_NULL_HANDLE && src->imageInfo.sampler == VK_NULL_HANDLE &&
+       src->imageInfo.imageView == VK_NULL_HANDLE && src->bufferInfo.buffer == VK_NULL_HANDLE)
+    {
+      // do nothing - don't increment bind so that the same write descriptor is used next time.
+      continue;
+    }
+    else
+    {
+      // first we copy the right data over unconditionally
+      switch(writes[bind].descriptorType)
+      {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        {
+          for(uint32_t d = 0; d < descriptorCount; d++)
+            dstImage[d] = src[d].imageInfo;
+
+          writes[bind].pImageInfo = dstImage;
+          // NULL the others
+          dstBuffer = NULL;
+          dstTexelBuffer = NULL;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        {
+          for(uint32_t d = 0; d < descriptorCount; d++)
+            dstTexelBuffer[d] = src[d].texelBufferView;
+
+          writes[bind].pTexelBufferView = dstTexelBuffer;
+          // NULL the others
+          dstBuffer = NULL;
+          dstImage = NULL;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        {
+          for(uint32_t d = 0; d < descriptorCount; d++)
+            dstBuffer[d] = src[d].bufferInfo;
+
+          writes[bind].pBufferInfo = dstBuffer;
+          // NULL the others
+          dstImage = NULL;
+          dstTexelBuffer = NULL;
+          break;
+        }
+        default:
+        {
+          RDCERR("Unexpected descriptor type %d", writes[bind].descriptorType);
+          ret = false;
+        }
+      }
+
+      // iterate over all the descriptors coalescing valid writes. At all times writes[bind] is
+      // the 'current' batched update
+      for(uint32_t d = 0; d < descriptorCount; d++)
+      {
+        // is this array element in the write valid? Note that below when we encounter an
+        // invalid write, the next one starts from a later point in the array, so we need to
+        // check relative to the dstArrayElement
+        if(IsValid(writes[bind], d - writes[bind].dstArrayElement))
+        {
+          // if this descriptor is valid, just increment the number of descriptors. The data
+          // and dstArrayElement is pointing to the start of the valid range
+          writes[bind].descriptorCount++;
+        }
+        else
+        {
+          // if this descriptor is *invalid* we must skip it. First see if we have some
+          // previously valid range and commit it
+          if(writes[bind].descriptorCount)
+          {
+            bind++;
+
+            // copy over the previous data for the sake of the things that won't be reset below
+            writes[bind] = writes[bind - 1];
+          }
+
+          // now offset to the next potentially valid descriptor. Note that at the end of the
+          // iteration there is no next descriptor so these pointer values will be off the end
+          // of the array, but descriptorCount will be 0 so this will be treated as invalid and
+          // skipped
+          writes[bind].dstArrayElement = d + 1;
+
+          // start counting from 0 again
+          writes[bind].descriptorCount = 0;
+
+          // offset the array being used
+          if(dstBuffer)
+            writes[bind].pBufferInfo = dstBuffer + d + 1;
+          else if(dstImage)
+            writes[bind].pImageInfo = dstImage + d + 1;
+          else if(dstTexelBuffer)
+            writes[bind].pTexelBufferView = dstTexelBuffer + d + 1;
+        }
+      }
+
+      // after the loop there may be a valid write which hasn't been accounted for. If the
+      // current write has a descriptor count that means it has some descriptors, so
+      // increment i and validBinds so that it's accounted for.
+      if(writes[bind].descriptorCount)
+        bind++;
+    }
+  }
+
+  initialContents.numDescriptors = bind;
+
+  return ret;
+}
+
 // second parameter isn't used, as we might be serialising init state for a deleted resource
 template <typename SerialiserType>
 bool WrappedVulkan::Serialise_InitialState(SerialiserType &ser, ResourceId id, WrappedVkRes *)
@@ -617,178 +849,8 @@ bool WrappedVulkan::Serialise_InitialState(SerialiserType &ser, ResourceId id, W
 
       VkInitialContents initialContents(type, VkInitialContents::DescriptorSet);
 
-      initialContents.numDescriptors = (uint32_t)layout.bindings.size();
-      initialContents.descriptorInfo = new VkDescriptorBufferInfo[NumBindings];
-
-      // if we have partially-valid arrays, we need to split up writes. The worst case will never be
-      // == number of bindings since that implies all arrays are valid, but it is an upper bound as
-      // we'll never need more writes than bindings
-      initialContents.descriptorWrites = new VkWriteDescriptorSet[NumBindings];
-
-      RDCCOMPILE_ASSERT(sizeof(VkDescriptorBufferInfo) >= sizeof(VkDescriptorImageInfo),
-                        "Descriptor structs sizes are unexpected, ensure largest size is used");
-
-      VkWriteDescriptorSet *writes = initialContents.descriptorWrites;
-      VkDescriptorBufferInfo *dstData = initialContents.descriptorInfo;
-      DescriptorSetSlot *srcData = Bindings;
-
-      // validBinds counts up as we make a valid VkWriteDescriptorSet, so can be used to index into
-      // writes[] along the way as the 'latest' write.
-      uint32_t bind = 0;
-
-      for(uint32_t j = 0; j < initialContents.numDescriptors; j++)
-      {
-        writes[bind].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[bind].pNext = NULL;
-
-        // template for this write. We will expand it to include more descriptors as we find valid
-        // descriptors to update.
-        writes[bind].dstSet = (VkDescriptorSet)(uint64_t)res;
-        writes[bind].dstBinding = j;
-        writes[bind].dstArrayElement = 0;
-        // descriptor count starts at 0. We increment it as we find valid descriptors
-        writes[bind].descriptorCount = 0;
-        writes[bind].descriptorType = layout.bindings[j].descriptorType;
-
-        uint32_t descriptorCount = layout.bindings[j].descriptorCount;
-
-        DescriptorSetSlot *src = srcData;
-        srcData += descriptorCount;
-
-        // will be cast to the appropriate type, we just need to increment
-        // the dstData pointer by worst case size
-        VkDescriptorBufferInfo *dstBuffer = dstData;
-        VkDescriptorImageInfo *dstImage = (VkDescriptorImageInfo *)dstData;
-        VkBufferView *dstTexelBuffer = (VkBufferView *)dstData;
-        dstData += descriptorCount;
-
-        // the correct one will be set below
-        writes[bind].pBufferInfo = NULL;
-        writes[bind].pImageInfo = NULL;
-        writes[bind].pTexelBufferView = NULL;
-
-        // check that the resources we need for this write are present, as some might have been
-        // skipped due to stale descriptor set slots or otherwise unreferenced objects (the
-        // descriptor set initial contents do not cause a frame reference for their resources).
-        //
-        // For the non-array case it's trivial as either the descriptor is valid, in which case it
-        // gets a write, or not, in which case we skip.
-        // For the array case we batch up updates as much as possible, iterating along the array and
-        // skipping any invalid descriptors.
-
-        // quick check for slots that were completely uninitialised and so don't have valid data
-        if(src->texelBufferView == VK_NULL_HANDLE && src->imageInfo.sampler == VK_NULL_HANDLE &&
-           src->imageInfo.imageView == VK_NULL_HANDLE && src->bufferInfo.buffer == VK_NULL_HANDLE)
-        {
-          // do nothing - don't increment bind so that the same write descriptor is used next time.
-          continue;
-        }
-        else
-        {
-          // first we copy the right data over unconditionally
-          switch(writes[bind].descriptorType)
-          {
-            case VK_DESCRIPTOR_TYPE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-            {
-              for(uint32_t d = 0; d < descriptorCount; d++)
-                dstImage[d] = src[d].imageInfo;
-
-              writes[bind].pImageInfo = dstImage;
-              // NULL the others
-              dstBuffer = NULL;
-              dstTexelBuffer = NULL;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-            {
-              for(uint32_t d = 0; d < descriptorCount; d++)
-                dstTexelBuffer[d] = src[d].texelBufferView;
-
-              writes[bind].pTexelBufferView = dstTexelBuffer;
-              // NULL the others
-              dstBuffer = NULL;
-              dstImage = NULL;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-            {
-              for(uint32_t d = 0; d < descriptorCount; d++)
-                dstBuffer[d] = src[d].bufferInfo;
-
-              writes[bind].pBufferInfo = dstBuffer;
-              // NULL the others
-              dstImage = NULL;
-              dstTexelBuffer = NULL;
-              break;
-            }
-            default:
-            {
-              RDCERR("Unexpected descriptor type %d", writes[bind].descriptorType);
-              ret = false;
-            }
-          }
-
-          // iterate over all the descriptors coalescing valid writes. At all times writes[bind] is
-          // the 'current' batched update
-          for(uint32_t d = 0; d < descriptorCount; d++)
-          {
-            // is this array element in the write valid? Note that below when we encounter an
-            // invalid write, the next one starts from a later point in the array, so we need to
-            // check relative to the dstArrayElement
-            if(IsValid(writes[bind], d - writes[bind].dstArrayElement))
-            {
-              // if this descriptor is valid, just increment the number of descriptors. The data
-              // and dstArrayElement is pointing to the start of the valid range
-              writes[bind].descriptorCount++;
-            }
-            else
-            {
-              // if this descriptor is *invalid* we must skip it. First see if we have some
-              // previously valid range and commit it
-              if(writes[bind].descriptorCount)
-              {
-                bind++;
-
-                // copy over the previous data for the sake of the things that won't be reset below
-                writes[bind] = writes[bind - 1];
-              }
-
-              // now offset to the next potentially valid descriptor. Note that at the end of the
-              // iteration there is no next descriptor so these pointer values will be off the end
-              // of the array, but descriptorCount will be 0 so this will be treated as invalid and
-              // skipped
-              writes[bind].dstArrayElement = d + 1;
-
-              // start counting from 0 again
-              writes[bind].descriptorCount = 0;
-
-              // offset the array being used
-              if(dstBuffer)
-                writes[bind].pBufferInfo = dstBuffer + d + 1;
-              else if(dstImage)
-                writes[bind].pImageInfo = dstImage + d + 1;
-              else if(dstTexelBuffer)
-                writes[bind].pTexelBufferView = dstTexelBuffer + d + 1;
-            }
-          }
-
-          // after the loop there may be a valid write which hasn't been accounted for. If the
-          // current write has a descriptor count that means it has some descriptors, so
-          // increment i and validBinds so that it's accounted for.
-          if(writes[bind].descriptorCount)
-            bind++;
-        }
-      }
-
-      initialContents.numDescriptors = bind;
+      if(!CreateDescriptorWrites(initialContents, res, layout, Bindings, NumBindings))
+        ret = false;
 
       GetResourceManager()->SetInitialContents(id, initialContents);
     }
@@ -1169,23 +1231,24 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live, VkInitialContents ini
 
       for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
       {
+        // the write's arrays already start at dstArrayElement
         uint32_t idx = writes[i].dstArrayElement + d;
 
         if(writes[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
            writes[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
         {
-          bind[idx].texelBufferView = writes[i].pTexelBufferView[idx];
+          bind[idx].texelBufferView = writes[i].pTexelBufferView[d];
         }
         else if(writes[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
                 writes[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
                 writes[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
                 writes[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
         {
-          bind[idx].bufferInfo = writes[i].pBufferInfo[idx];
+          bind[idx].bufferInfo = writes[i].pBufferInfo[d];
         }
         else
         {
-          bind[idx].imageInfo = writes[i].pImageInfo[idx];
+          bind[idx].imageInfo = writes[i].pImageInfo[d];
         }
       }
     }
@@ -303,9 +303,17 @@ public:
   {
     ResourceId id = GetResID(obj);
 
-    auto origit = m_OriginalIDs.find(id);
-    if(origit != m_OriginalIDs.end())
-      EraseLiveResource(origit->second);
+    ResourceId origid;
+
+    {
+      SCOPED_READLOCK(m_ResourceLock);
+      auto origit = m_OriginalIDs.find(id);
+      if(origit != m_OriginalIDs.end())
+        origid = origit->second;
+    }
+
+    if(origid != ResourceId())
+      EraseLiveResource(origid);
 
     if(IsReplayMode(m_State))
       ResourceManager::RemoveWrapper(ToTypedHandle(Unwrap(obj)));
@@ -1131,7 +1131,7 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   if(pipeInfo.shaders[0].module == ResourceId())
     return;
 
-  const VulkanCreationInfo::ShaderModule &moduleInfo =
+  VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
 
   ShaderReflection *refl = pipeInfo.shaders[0].refl;
@@ -1356,7 +1356,7 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   }
 
   uint32_t bufStride = 0;
-  vector<uint32_t> modSpirv = moduleInfo.spirv.spirv;
+  vector<uint32_t> modSpirv = moduleInfo.GetSPIRV().spirv;
 
   struct CompactedAttrBuffer
   {
@@ -100,6 +100,11 @@ const SDFile &VulkanReplay::GetStructuredFile()
   return m_pDriver->GetStructuredFile();
 }
 
+void VulkanReplay::LoadStructuredChunk(uint32_t chunkIndex)
+{
+  m_pDriver->LoadStructuredChunk(chunkIndex);
+}
+
 vector<uint32_t> VulkanReplay::GetPassEvents(uint32_t eventId)
 {
   vector<uint32_t> passEvents;
@@ -312,12 +317,12 @@ rdcarray<ShaderEntryPoint> VulkanReplay::GetShaderEntryPoints(ResourceId shader)
   if(shad == m_pDriver->m_CreationInfo.m_ShaderModule.end())
     return {};
 
-  std::vector<std::string> entries = shad->second.spirv.EntryPoints();
+  std::vector<std::string> entries = shad->second.GetSPIRV().EntryPoints();
 
   rdcarray<ShaderEntryPoint> ret;
 
   for(const std::string &e : entries)
-    ret.push_back({e, shad->second.spirv.StageForEntry(e)});
+    ret.push_back({e, shad->second.GetSPIRV().StageForEntry(e)});
 
   return ret;
 }
@@ -332,8 +337,8 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId shader, ShaderEntryPoint en
     return NULL;
   }
 
-  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), shader, shad->second.spirv,
-                                              entry.name,
+  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), shader,
+                                              shad->second.GetSPIRV(), entry.name,
                                               VkShaderStageFlagBits(1 << uint32_t(entry.stage)));
 
   return &shad->second.m_Reflections[entry.name].refl;
@@ -372,7 +377,7 @@ string VulkanReplay::DisassembleShader(ResourceId pipeline, const ShaderReflecti
     std::string &disasm = it->second.m_Reflections[refl->entryPoint.c_str()].disassembly;
 
     if(disasm.empty())
-      disasm = it->second.spirv.Disassemble(refl->entryPoint.c_str());
+      disasm = it->second.GetSPIRV().Disassemble(refl->entryPoint.c_str());
 
     return disasm;
   }
@@ -3305,6 +3310,9 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
   rm->ReplaceResource(liveid, to);
 
   ClearPostVSCache();
+
+  // the replayed state no longer matches what replaying with the new shaders would give
+  m_pDriver->InvalidateReplayCheckpoints();
 }
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
@@ -3351,6 +3359,8 @@ void VulkanReplay::RemoveReplacement(ResourceId id)
   }
 
   ClearPostVSCache();
+
+  m_pDriver->InvalidateReplayCheckpoints();
 }
 
 vector<PixelModification> VulkanReplay::PixelHistory(vector<EventUsage> events, ResourceId target,
@@ -217,6 +217,7 @@ public:
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
   const SDFile &GetStructuredFile();
+  void LoadStructuredChunk(uint32_t chunkIndex);
 
   vector<uint32_t> GetPassEvents(uint32_t eventId);
 
@@ -1087,3 +1087,99 @@ void SparseMapping::Update(uint32_t numBindings, const VkSparseMemoryBind *pBind
       opaquemappings.push_back(curRange);
   }
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#undef None
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Descriptor set frame refs applied while updated on another thread", "[vulkan]")
+{
+  // stands in for WrappedVulkan::m_DescSetRefsLock
+  Threading::CriticalSection lock;
+
+  VkResourceRecord record(ResourceIDGen::GetNewUniqueID());
+  record.descInfo = new DescriptorSetData();
+
+  std::vector<ResourceId> ids(300);
+  for(ResourceId &id : ids)
+    id = ResourceIDGen::GetNewUniqueID();
+
+  volatile int32_t stop = 0;
+
+  // updates the set the way descriptor writes do, binding and unbinding resources. Some become
+  // written as well as read, which changes their existing ref. It yields regularly so that there
+  // are few enough changes between submits for them to be applied incrementally.
+  Threading::ThreadHandle updater = Threading::CreateThread([&]() {
+    for(uint32_t i = 0; stop == 0; i++)
+    {
+      ResourceId id = ids[i % ids.size()];
+
+      if(i % 8 == 0)
+        Threading::Sleep(0);
+
+      SCOPED_LOCK(lock);
+
+      if((i / ids.size()) % 3 == 2)
+      {
+        record.RemoveBindFrameRef(id);
+        if(i % 7 == 0)
+          record.RemoveBindFrameRef(id);
+      }
+      else
+      {
+        record.AddBindFrameRef(id, eFrameRef_Read);
+        if(i % 7 == 0)
+          record.AddBindFrameRef(id, eFrameRef_Write);
+      }
+    }
+  });
+
+  // submits the set, and checks that every ref currently bound has been applied in this capture
+  // with its current type, whether by a full or an incremental apply.
+  std::map<ResourceId, FrameRefType> applied;
+  uint32_t generation = 1;
+  uint32_t missing = 0;
+  uint32_t incremental = 0;
+
+  auto apply = [&applied](DescriptorSetData::BindFrameRefs::iterator it) {
+    applied[it->first] = it->second.second;
+  };
+
+  for(uint32_t submit = 0; submit < 5000; submit++)
+  {
+    // a new capture every so often
+    if(submit % 500 == 0)
+    {
+      generation++;
+      applied.clear();
+    }
+
+    SCOPED_LOCK(lock);
+
+    DescriptorSetData *descInfo = record.descInfo;
+
+    if(descInfo->ApplyBindFrameRefs(generation, apply))
+      incremental++;
+
+    for(auto it = descInfo->bindFrameRefs.begin(); it != descInfo->bindFrameRefs.end(); ++it)
+    {
+      auto a = applied.find(it->first);
+      if(a == applied.end() || a->second != it->second.second)
+        missing++;
+    }
+  }
+
+  stop = 1;
+  Threading::JoinThread(updater);
+  Threading::CloseThread(updater);
+
+  CHECK(missing == 0);
+  // the incremental path must have been exercised for this to test anything
+  CHECK(incremental > 0);
+
+  SAFE_DELETE(record.descInfo);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
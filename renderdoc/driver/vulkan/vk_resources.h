@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "common/small_hash.h"
 #include "common/wrapped_pool.h"
 #include "core/resource_manager.h"
 #include "vk_common.h"
@@ -908,15 +909,15 @@ struct CmdBufferRecordingInfo
 
   // sparse resources referenced by this command buffer (at submit time
   // need to go through the sparse mapping and reference all memory)
-  set<SparseMapping *> sparse;
+  SmallHashSet<SparseMapping *> sparse;
 
   // a list of all resources dirtied by this command buffer
-  set<ResourceId> dirtied;
+  SmallHashSet<ResourceId> dirtied;
 
   // a list of descriptor sets that are bound at any point in this command buffer
   // used to look up all the frame refs per-desc set and apply them on queue
   // submit with latest binding refs.
-  set<VkDescriptorSet> boundDescSets;
+  SmallHashSet<VkDescriptorSet> boundDescSets;
 
   vector<VkResourceRecord *> subcmds;
 };
@@ -945,7 +946,73 @@ struct DescriptorSetData
   // the refcount has the high-bit set if this resource has sparse
   // mapping information
   static const uint32_t SPARSE_REF_BIT = 0x80000000;
-  map<ResourceId, pair<uint32_t, FrameRefType> > bindFrameRefs;
+  typedef SmallHashMap<ResourceId, pair<uint32_t, FrameRefType> > BindFrameRefs;
+  BindFrameRefs bindFrameRefs;
+
+  // the bind frame refs only need to be applied once per capture, after which only the refs that
+  // have changed need to be applied again when the set is next submitted. This tracks the capture
+  // they were last applied in, and which have changed since. If too many change we fall back to
+  // applying them all.
+  //
+  // Resources with sparse mapping information are always re-applied, as their memory bindings can
+  // change without the set changing.
+  //
+  // Descriptor updates and submits can happen on different threads, even for a set in use when it's
+  // update-after-bind, so bindFrameRefs and all of this tracking must only be accessed with
+  // WrappedVulkan::m_DescSetRefsLock held.
+  uint32_t refsAppliedCapture = 0;
+  uint32_t numSparseRefs = 0;
+  bool allRefsChanged = false;
+  SmallHashSet<ResourceId> changedRefs;
+
+  void MarkRefChanged(ResourceId id)
+  {
+    if(allRefsChanged || refsAppliedCapture == 0)
+      return;
+
+    if(changedRefs.size() >= RDCMAX((size_t)64, bindFrameRefs.size() / 4))
+    {
+      allRefsChanged = true;
+      changedRefs.clear();
+    }
+    else
+    {
+      changedRefs.insert(id);
+    }
+  }
+
+  // calls apply with each bind frame ref that needs to be applied on submit in the given capture.
+  // Returns true if only the refs changed since the last submit were applied, false if they all
+  // were.
+  template <typename ApplyFunc>
+  bool ApplyBindFrameRefs(uint32_t captureGeneration, ApplyFunc apply)
+  {
+    bool incremental = false;
+
+    if(refsAppliedCapture != captureGeneration || allRefsChanged || numSparseRefs > 0)
+    {
+      for(auto refit = bindFrameRefs.begin(); refit != bindFrameRefs.end(); ++refit)
+        apply(refit);
+
+      refsAppliedCapture = captureGeneration;
+      allRefsChanged = false;
+    }
+    else
+    {
+      for(ResourceId id : changedRefs)
+      {
+        auto refit = bindFrameRefs.find(id);
+        if(refit != bindFrameRefs.end())
+          apply(refit);
+      }
+
+      incremental = true;
+    }
+
+    changedRefs.clear();
+
+    return incremental;
+  }
 };
 
 struct PipelineLayoutData
@@ -961,6 +1028,7 @@ struct MemMapState
         needRefData(false),
         mapFlushed(false),
         mapCoherent(false),
+        writeWatched(false),
         mappedPtr(NULL),
         refData(NULL)
   {
@@ -969,6 +1037,8 @@ struct MemMapState
   bool needRefData;
   bool mapFlushed;
   bool mapCoherent;
+  // if writes to the mapped pointer are being watched via WriteWatch
+  bool writeWatched;
   byte *mappedPtr;
   byte *refData;
 };
@@ -1019,6 +1089,7 @@ public:
     cmdInfo->sparse.swap(bakedCommands->cmdInfo->sparse);
   }
 
+  // these must be called with WrappedVulkan::m_DescSetRefsLock held, see DescriptorSetData
   void AddBindFrameRef(ResourceId id, FrameRefType ref, bool hasSparse = false)
   {
     if(id == ResourceId())
@@ -1027,17 +1098,25 @@ public:
       return;
     }
 
-    if((descInfo->bindFrameRefs[id].first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+    pair<uint32_t, FrameRefType> &bindRef = descInfo->bindFrameRefs[id];
+
+    if((bindRef.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
     {
-      descInfo->bindFrameRefs[id] =
-          std::make_pair(1 | (hasSparse ? DescriptorSetData::SPARSE_REF_BIT : 0), ref);
+      if(hasSparse)
+        descInfo->numSparseRefs++;
+
+      bindRef = std::make_pair(1 | (hasSparse ? DescriptorSetData::SPARSE_REF_BIT : 0), ref);
+      descInfo->MarkRefChanged(id);
     }
     else
     {
       // be conservative - mark refs as read before write if we see a write and a read ref on it
-      if(ref == eFrameRef_Write && descInfo->bindFrameRefs[id].second == eFrameRef_Read)
-        descInfo->bindFrameRefs[id].second = eFrameRef_ReadBeforeWrite;
-      descInfo->bindFrameRefs[id].first++;
+      if(ref == eFrameRef_Write && bindRef.second == eFrameRef_Read)
+      {
+        bindRef.second = eFrameRef_ReadBeforeWrite;
+        descInfo->MarkRefChanged(id);
+      }
+      bindRef.first++;
     }
   }
 
@@ -1060,7 +1139,11 @@ public:
     it->second.first--;
 
     if((it->second.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+    {
+      if(it->second.first & DescriptorSetData::SPARSE_REF_BIT)
+        descInfo->numSparseRefs--;
       descInfo->bindFrameRefs.erase(it);
+    }
   }
 
   // we have a lot of 'cold' data in the resource record, as it can be accessed
@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "vk_shader_cache.h"
-#include "common/shader_cache.h"
 #include "data/glsl_shaders.h"
 #include "driver/shaders/spirv/spirv_common.h"
 #include "strings/string_utils.h"
@@ -113,14 +112,9 @@ struct VulkanBlobShaderCallbacks
 } VulkanShaderCacheCallbacks;
 
 VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
+    : m_ShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
+                    VulkanShaderCacheCallbacks)
 {
-  // Load shader cache, if present
-  bool success = LoadShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, VulkanShaderCacheCallbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
-
   m_pDriver = driver;
   m_Device = driver->GetDev();
 
@@ -195,17 +189,6 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
 
 VulkanShaderCache::~VulkanShaderCache()
 {
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    VulkanShaderCacheCallbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      VulkanShaderCacheCallbacks.Destroy(it->second);
-  }
-
   for(size_t i = 0; i < ARRAY_COUNT(m_BuiltinShaderModules); i++)
     m_pDriver->vkDestroyShaderModule(m_Device, m_BuiltinShaderModules[i], NULL);
 }
@@ -225,11 +208,8 @@ std::string VulkanShaderCache::GetSPIRVBlob(const SPIRVCompilationSettings &sett
   typestr[1] += (char)settings.lang;
   hash = strhash(typestr, hash);
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
-  {
-    outBlob = m_ShaderCache[hash];
+  if(m_ShaderCache.Find(hash, outBlob))
     return "";
-  }
 
   SPIRVBlob spirv = new std::vector<uint32_t>();
   std::string errors = CompileSPIRV(settings, sources, *spirv);
@@ -250,10 +230,7 @@ std::string VulkanShaderCache::GetSPIRVBlob(const SPIRVCompilationSettings &sett
   outBlob = spirv;
 
   if(m_CacheShaders)
-  {
-    m_ShaderCache[hash] = spirv;
-    m_ShaderCacheDirty = true;
-  }
+    m_ShaderCache.Insert(hash, spirv);
 
   return errors;
 }
@@ -25,11 +25,14 @@
 #pragma once
 
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "core/core.h"
 #include "vk_core.h"
 
 typedef std::vector<uint32_t> *SPIRVBlob;
 
+struct VulkanBlobShaderCallbacks;
+
 enum class BuiltinShader
 {
   BlitVS,
@@ -83,8 +86,8 @@ private:
   WrappedVulkan *m_pDriver = NULL;
   VkDevice m_Device = VK_NULL_HANDLE;
 
-  bool m_ShaderCacheDirty = false, m_CacheShaders = false;
-  std::map<uint32_t, SPIRVBlob> m_ShaderCache;
+  bool m_CacheShaders = false;
+  PersistentShaderCache<SPIRVBlob, VulkanBlobShaderCallbacks> m_ShaderCache;
 
   SPIRVBlob m_BuiltinShaderBlobs[arraydim<BuiltinShader>()] = {NULL};
   VkShaderModule m_BuiltinShaderModules[arraydim<BuiltinShader>()] = {VK_NULL_HANDLE};
@@ -101,7 +101,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
          sizeof(VkSparseMemoryBind) * numElems);
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
   VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
@@ -182,15 +181,10 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
+  m_InitStateBatch.buffers.insert(m_InitStateBatch.buffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  FinishInitialStateCopy(readbackmem.size);
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
@@ -263,7 +257,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   }
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
   VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
@@ -344,15 +337,10 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
+  m_InitStateBatch.buffers.insert(m_InitStateBatch.buffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  FinishInitialStateCopy(readbackmem.size);
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
@@ -833,6 +833,7 @@ VkResult WrappedVulkan::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
 
     record->bakedCommands = GetResourceManager()->AddResourceRecord(ResourceIDGen::GetNewUniqueID());
     record->bakedCommands->SpecialResource = true;
+    record->bakedCommands->TransientChunks = true;
     record->bakedCommands->Resource = (WrappedVkRes *)commandBuffer;
     record->bakedCommands->cmdInfo = new CmdBufferRecordingInfo();
 
@@ -1085,6 +1086,13 @@ bool WrappedVulkan::Serialise_vkCmdBeginRenderPass(SerialiserType &ser, VkComman
       m_BakedCmdBufferInfo[m_LastCmdBufferID].state.framebuffer =
           GetResID(RenderPassBegin.framebuffer);
 
+      // the pass's load and store ops can write any attachment
+      const VulkanCreationInfo::Framebuffer &fb =
+          m_CreationInfo.m_Framebuffer[GetResID(RenderPassBegin.framebuffer)];
+      for(size_t i = 0; i < fb.attachments.size(); i++)
+        m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(
+            m_CreationInfo.m_ImageView[fb.attachments[i].view].image);
+
       std::vector<VkImageMemoryBarrier> imgBarriers = GetImplicitRenderPassBarriers();
 
       ResourceId cmd = GetResID(commandBuffer);
@@ -1623,7 +1631,9 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
     {
       VkResourceRecord *descSet = GetRecord(pDescriptorSets[i]);
 
-      map<ResourceId, pair<uint32_t, FrameRefType> > &frameRefs = descSet->descInfo->bindFrameRefs;
+      SCOPED_LOCK(m_DescSetRefsLock);
+
+      DescriptorSetData::BindFrameRefs &frameRefs = descSet->descInfo->bindFrameRefs;
 
       for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
       {
@@ -1832,6 +1842,11 @@ bool WrappedVulkan::Serialise_vkCmdUpdateBuffer(SerialiserType &ser, VkCommandBu
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      // these don't add a drawcall, so the write isn't in any resource usage
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -1902,6 +1917,11 @@ bool WrappedVulkan::Serialise_vkCmdFillBuffer(SerialiserType &ser, VkCommandBuff
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      // these don't add a drawcall, so the write isn't in any resource usage
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -2259,6 +2279,11 @@ bool WrappedVulkan::Serialise_vkCmdCopyQueryPoolResults(
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      // these don't add a drawcall, so the write isn't in any resource usage
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -2569,6 +2594,9 @@ bool WrappedVulkan::Serialise_vkCmdExecuteCommands(SerialiserType &ser, VkComman
           parentCmdBufInfo.debugMessages.back().eventId += parentCmdBufInfo.curEventID;
         }
 
+        parentCmdBufInfo.writtenResources.insert(cmdBufInfo.writtenResources.begin(),
+                                                 cmdBufInfo.writtenResources.end());
+
         // only primary command buffers can be submitted
         m_Partial[Secondary].cmdBufferSubmits[cmd].push_back(parentCmdBufInfo.curEventID);
 
@@ -3552,6 +3580,11 @@ bool WrappedVulkan::Serialise_vkCmdWriteBufferMarkerAMD(SerialiserType &ser,
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      // these don't add a drawcall, so the write isn't in any resource usage
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(dstBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -819,6 +819,15 @@ bool WrappedVulkan::Serialise_vkUpdateDescriptorSets(SerialiserType &ser, VkDevi
 
     for(uint32_t i = 0; i < copyCount; i++)
       ReplayDescriptorSetCopy(device, pDescriptorCopies[i]);
+
+    if(IsLoading(m_State))
+    {
+      for(uint32_t i = 0; i < writeCount; i++)
+        AddCheckpointWrite(m_RootEventID, GetResID(pDescriptorWrites[i].dstSet));
+
+      for(uint32_t i = 0; i < copyCount; i++)
+        AddCheckpointWrite(m_RootEventID, GetResID(pDescriptorCopies[i].dstSet));
+    }
   }
 
   return true;
@@ -971,6 +980,8 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
 
       VkResourceRecord *setrecord = GetRecord(pDescriptorCopies[i].srcSet);
 
+      SCOPED_LOCK(m_DescSetRefsLock);
+
       for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
           refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
       {
@@ -989,6 +1000,9 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
   // need to track descriptor set contents whether capframing or idle
   if(IsCaptureMode(m_State))
   {
+    // the sets could be being submitted on another thread, e.g. if they're update-after-bind
+    SCOPED_LOCK(m_DescSetRefsLock);
+
     for(uint32_t i = 0; i < writeCount; i++)
     {
       const VkWriteDescriptorSet &descWrite = pDescriptorWrites[i];
@@ -1258,6 +1272,9 @@ bool WrappedVulkan::Serialise_vkUpdateDescriptorSetWithTemplate(
       writeDesc.dstSet = descriptorSet;
       ReplayDescriptorSetWrite(device, writeDesc);
     }
+
+    if(IsLoading(m_State))
+      AddCheckpointWrite(m_RootEventID, GetResID(descriptorSet));
   }
 
   return true;
@@ -1371,6 +1388,9 @@ void WrappedVulkan::vkUpdateDescriptorSetWithTemplate(
   // need to track descriptor set contents whether capframing or idle
   if(IsCaptureMode(m_State))
   {
+    // the sets could be being submitted on another thread, e.g. if they're update-after-bind
+    SCOPED_LOCK(m_DescSetRefsLock);
+
     for(const VkDescriptorUpdateTemplateEntry &entry : tempInfo->updates)
     {
       VkResourceRecord *record = GetRecord(descriptorSet);
@@ -515,6 +515,8 @@ void WrappedVulkan::Shutdown()
   SubmitSemaphores();
   FlushQ();
 
+  FreeReplayCheckpoints();
+
   // destroy any events we created for waiting on
   for(size_t i = 0; i < m_PersistentEvents.size(); i++)
     ObjDisp(GetDev())->DestroyEvent(Unwrap(GetDev()), m_PersistentEvents[i], NULL);
@@ -194,6 +194,8 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(SerialiserType &ser, VkQueue queue,
 
           GetResourceManager()->ApplyBarriers(m_BakedCmdBufferInfo[cmd].imgbarriers, m_ImageLayouts);
 
+          uint32_t beginEID = m_RootEventID;
+
           std::string name = StringFormat::Fmt("=> %s[%u]: vkBeginCommandBuffer(%s)",
                                                basename.c_str(), c, ToStr(cmd).c_str());
 
@@ -240,6 +242,15 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(SerialiserType &ser, VkQueue queue,
           m_RootEventID += cmdBufInfo.eventCount;
           m_RootDrawcallID += cmdBufInfo.drawCount;
 
+          // writes that aren't tied to a single event, such as render pass load and store ops, are
+          // counted at both ends of the command buffer. Checkpoints are only taken between submits
+          // so this is enough to get the right resources into them.
+          for(ResourceId id : cmdBufInfo.writtenResources)
+          {
+            AddCheckpointWrite(beginEID, id);
+            AddCheckpointWrite(m_RootEventID, id);
+          }
+
           name = StringFormat::Fmt("=> %s[%u]: vkEndCommandBuffer(%s)", basename.c_str(), c,
                                    ToStr(cmd).c_str());
           draw.name = name;
@@ -409,6 +420,8 @@ void WrappedVulkan::InsertDrawsAndRefreshIDs(vector<VulkanDrawcallTreeNode> &cmd
       EventUsage u = it->second;
       u.eventId += m_RootEventID;
       m_ResourceUses[it->first].push_back(u);
+
+      AddCheckpointUsage(it->first, u);
     }
 
     GetDrawcallStack().back()->children.push_back(n);
@@ -586,6 +599,8 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
 
   bool capframe = false;
   set<ResourceId> refdIDs;
+  // descriptor sets whose bind frame refs were already applied and weren't added to refdIDs
+  std::vector<DescriptorSetData *> refdSets;
 
   for(uint32_t s = 0; s < submitCount; s++)
   {
@@ -620,28 +635,32 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
             it != record->bakedCommands->cmdInfo->dirtied.end(); ++it)
           GetResourceManager()->MarkPendingDirty(*it);
 
+        auto applyBindFrameRef = [this, &refdIDs](DescriptorSetData::BindFrameRefs::iterator refit) {
+          refdIDs.insert(refit->first);
+          GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
+
+          if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
+          {
+            VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refit->first);
+
+            GetResourceManager()->MarkSparseMapReferenced(sparserecord->sparseInfo);
+          }
+        };
+
         // for each bound descriptor set, mark it referenced as well as all resources currently
-        // bound to it
+        // bound to it. Once a set's refs have been applied in this capture, only the refs that
+        // changed since then need to be applied - re-applying the same ref has no effect.
         for(auto it = record->bakedCommands->cmdInfo->boundDescSets.begin();
             it != record->bakedCommands->cmdInfo->boundDescSets.end(); ++it)
         {
           GetResourceManager()->MarkResourceFrameReferenced(GetResID(*it), eFrameRef_Read);
 
-          VkResourceRecord *setrecord = GetRecord(*it);
+          DescriptorSetData *descInfo = GetRecord(*it)->descInfo;
 
-          for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
-              refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
-          {
-            refdIDs.insert(refit->first);
-            GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
-
-            if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
-            {
-              VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refit->first);
+          SCOPED_LOCK(m_DescSetRefsLock);
 
-              GetResourceManager()->MarkSparseMapReferenced(sparserecord->sparseInfo);
-            }
-          }
+          if(descInfo->ApplyBindFrameRefs(m_CaptureGeneration, applyBindFrameRef))
+            refdSets.push_back(descInfo);
         }
 
         for(auto it = record->bakedCommands->cmdInfo->sparse.begin();
@@ -701,6 +720,13 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
       maps = m_CoherentMaps;
     }
 
+    std::vector<WriteWatch::Range> dirtyRanges;
+    std::vector<DiffRange> diffs;
+
+    // every flush is serialised separately, so close together changes are flushed together
+    // rather than individually.
+    const size_t flushGapThreshold = 1024;
+
     for(auto it = maps.begin(); it != maps.end(); ++it)
     {
       VkResourceRecord *record = *it;
@@ -710,16 +736,23 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
       if(state.mapCoherent && state.mappedPtr && !state.mapFlushed)
       {
         // only need to flush memory that could affect this submitted batch of work
-        if(refdIDs.find(record->GetResourceID()) == refdIDs.end())
+        bool refd = refdIDs.find(record->GetResourceID()) != refdIDs.end();
+
+        if(!refd && !refdSets.empty())
+        {
+          SCOPED_LOCK(m_DescSetRefsLock);
+
+          for(size_t d = 0; !refd && d < refdSets.size(); d++)
+            refd = refdSets[d]->bindFrameRefs.count(record->GetResourceID()) > 0;
+        }
+
+        if(!refd)
         {
           RDCDEBUG("Map of memory %llu not referenced in this queue - not flushing",
                    record->GetResourceID());
           continue;
         }
 
-        size_t diffStart = 0, diffEnd = 0;
-        bool found = true;
-
 // enabled as this is necessary for programs with very large coherent mappings
 // (> 1GB) as otherwise more than a couple of vkQueueSubmit calls leads to vast
 // memory allocation. There might still be bugs lurking in here though
@@ -730,7 +763,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // the buffer and whenever we then copy into the ref data, e.g. below.
         // during this time, data could be written to the buffer and it won't have
         // been caught in the serialised snapshot, and if it doesn't change then
-        // it *also* won't be caught in any future FindDiffRange() calls.
+        // it *also* won't be caught in any future FindDiffRanges() calls.
         //
         // Likewise once refData is allocated, the call below will also update it
         // with the data serialised out for the same reason.
@@ -743,31 +776,64 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // shouldn't miss anything
         state.needRefData = true;
 
+        // if writes to the map are being watched, we only need to compare the pages written since
+        // the last check. This also resets the watch when we serialise everything below.
+        dirtyRanges.clear();
+        bool watched = state.writeWatched &&
+                       WriteWatch::GetDirtyRanges(state.mappedPtr + state.mapOffset, dirtyRanges);
+
         // if we have a previous set of data, compare.
         // otherwise just serialise it all
-        if(state.refData)
-          found = FindDiffRange((byte *)state.mappedPtr, state.refData, (size_t)state.mapSize,
-                                diffStart, diffEnd);
-        else
+        if(!state.refData || !watched)
 #endif
-          diffEnd = (size_t)state.mapSize;
+        {
+          WriteWatch::Range all = {0, (size_t)state.mapSize};
+          dirtyRanges.clear();
+          dirtyRanges.push_back(all);
+        }
+
+        bool anyFound = false;
 
-        if(found)
+        for(const WriteWatch::Range &dirty : dirtyRanges)
         {
-          // MULTIDEVICE should find the device for this queue.
-          // MULTIDEVICE only want to flush maps associated with this queue
-          VkDevice dev = GetDev();
+          if(state.refData)
+          {
+            FindDiffRanges(state.mappedPtr + state.mapOffset + dirty.start,
+                           state.refData + dirty.start, dirty.end - dirty.start, flushGapThreshold,
+                           diffs);
+          }
+          else
+          {
+            DiffRange all = {0, dirty.end - dirty.start};
+            diffs.clear();
+            diffs.push_back(all);
+          }
 
+          for(const DiffRange &diff : diffs)
           {
-            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
-                   (uint64_t)diffStart, (uint64_t)diffEnd);
-            VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
-                                         (VkDeviceMemory)(uint64_t)record->Resource,
-                                         state.mapOffset + diffStart, diffEnd - diffStart};
-            vkFlushMappedMemoryRanges(dev, 1, &range);
-            state.mapFlushed = false;
+            size_t diffStart = dirty.start + diff.start;
+            size_t diffEnd = dirty.start + diff.end;
+
+            anyFound = true;
+
+            // MULTIDEVICE should find the device for this queue.
+            // MULTIDEVICE only want to flush maps associated with this queue
+            VkDevice dev = GetDev();
+
+            {
+              RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
+                     (uint64_t)diffStart, (uint64_t)diffEnd);
+              VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
+                                           (VkDeviceMemory)(uint64_t)record->Resource,
+                                           state.mapOffset + diffStart, diffEnd - diffStart};
+              vkFlushMappedMemoryRanges(dev, 1, &range);
+              state.mapFlushed = false;
+            }
           }
+        }
 
+        if(anyFound)
+        {
           GetResourceManager()->MarkPendingDirty(record->GetResourceID());
         }
         else
@@ -486,6 +486,13 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
       wrapped->record->memMapState->refData = NULL;
     }
 
+    if(wrapped->record->memMapState && wrapped->record->memMapState->writeWatched)
+    {
+      MemMapState *state = wrapped->record->memMapState;
+      WriteWatch::Unregister(state->mappedPtr + state->mapOffset);
+      state->writeWatched = false;
+    }
+
     {
       SCOPED_LOCK(m_CoherentMapsLock);
 
@@ -528,13 +535,18 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
       state.refData = NULL;
 
       state.mapOffset = offset;
-      state.mapSize = size == VK_WHOLE_SIZE ? memrecord->Length : size;
+      state.mapSize = size == VK_WHOLE_SIZE ? memrecord->Length - offset : size;
       state.mapFlushed = false;
 
       *ppData = realData;
 
       if(state.mapCoherent)
       {
+        // watch writes to large coherent maps so that we only need to compare written pages when
+        // checking for changes. This protects the application's pointer, so if it's enabled any
+        // read()/recv() straight into the map fails - see WriteWatch.
+        state.writeWatched = WriteWatch::Register(realData, (size_t)state.mapSize);
+
         SCOPED_LOCK(m_CoherentMapsLock);
         m_CoherentMaps.push_back(memrecord);
       }
@@ -594,6 +606,9 @@ bool WrappedVulkan::Serialise_vkUnmapMemory(SerialiserType &ser, VkDevice device
 
   SERIALISE_CHECK_READ_ERRORS();
 
+  if(IsLoading(m_State) && memory != VK_NULL_HANDLE)
+    AddCheckpointWrite(m_RootEventID, GetResID(memory));
+
   return true;
 }
 
@@ -608,6 +623,10 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
     RDCASSERT(memrecord->memMapState);
     MemMapState &state = *memrecord->memMapState;
 
+    if(state.writeWatched)
+      WriteWatch::Unregister(state.mappedPtr + state.mapOffset);
+    state.writeWatched = false;
+
     {
       // decide atomically if this chunk should be in-frame or not
       // so that we're not in the else branch but haven't marked
@@ -719,14 +738,17 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(SerialiserType &ser, VkD
 
   SERIALISE_CHECK_READ_ERRORS();
 
+  if(IsLoading(m_State) && MemRange.memory != VK_NULL_HANDLE)
+    AddCheckpointWrite(m_RootEventID, GetResID(MemRange.memory));
+
   // if we need to save off this serialised buffer as reference for future comparison,
   // do so now. See the call to vkFlushMappedMemoryRanges in WrappedVulkan::vkQueueSubmit()
   if(ser.IsWriting() && state->needRefData)
   {
     if(!state->refData)
     {
-      // if we're in this case, the range should be for the whole memory region.
-      RDCASSERT(MemRange.offset == 0 && memRangeSize == state->mapSize);
+      // if we're in this case, the range should be for the whole mapped region.
+      RDCASSERT(MemRange.offset == state->mapOffset && memRangeSize == state->mapSize);
 
       // allocate ref data so we can compare next time to minimise serialised data
       state->refData = AllocAlignedBuffer((size_t)state->mapSize);
@@ -739,7 +761,9 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(SerialiserType &ser, VkD
 
     const byte *serialisedData = ser.GetWriter()->GetData() + offs;
 
-    memcpy(state->refData, serialisedData, (size_t)memRangeSize);
+    // refData mirrors the mapped region, so offset to where this range lies within it
+    memcpy(state->refData + (size_t)(MemRange.offset - state->mapOffset), serialisedData,
+           (size_t)memRangeSize);
   }
 
   return true;
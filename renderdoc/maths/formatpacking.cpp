@@ -0,0 +1,284 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+#include "api/replay/renderdoc_replay.h"
+#include "common/common.h"
+#include "formatpacking.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RDOC_SSE2 OPTION_ON
+#include <emmintrin.h>
+#else
+#define RDOC_SSE2 OPTION_OFF
+#endif
+
+#if ENABLED(RDOC_SSE2)
+// converts 4 halfs in the low 64 bits to floats, with the same results as ConvertFromHalf - notably
+// +/-0 both become +0 and infinities become NaN.
+static inline __m128 ConvertFromHalf4(__m128i halfs)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i h = _mm_unpacklo_epi16(halfs, zero);
+
+  __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+  __m128i exponent = _mm_and_si128(h, _mm_set1_epi32(0x7C00));
+  __m128i mantissa = _mm_and_si128(h, _mm_set1_epi32(0x03FF));
+
+  // normals: rebias the exponent and shift everything into place
+  __m128i normal = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13),
+                                 _mm_set1_epi32((127 - 15) << 23));
+
+  // subnormals: the mantissa is exactly representable, so scale it by 2^-24
+  __m128i subnormal = _mm_castps_si128(
+      _mm_mul_ps(_mm_cvtepi32_ps(mantissa), _mm_castsi128_ps(_mm_set1_epi32((127 - 24) << 23))));
+
+  __m128i isSubnormal = _mm_cmpeq_epi32(exponent, zero);
+  __m128i isSpecial = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7C00));
+  __m128i isZero = _mm_cmpeq_epi32(_mm_or_si128(exponent, mantissa), zero);
+
+  __m128i ret = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal),
+                             _mm_andnot_si128(isSubnormal, normal));
+
+  // signed zero and NaN/inf don't keep their sign
+  ret = _mm_or_si128(ret, _mm_andnot_si128(_mm_or_si128(isZero, isSpecial), sign));
+
+  ret = _mm_or_si128(_mm_andnot_si128(isSpecial, ret),
+                     _mm_and_si128(isSpecial, _mm_set1_epi32(0x7F800001)));
+
+  return _mm_castsi128_ps(ret);
+}
+#endif
+
+bool ConvertPixelsToFloat4(const ResourceFormat &fmt, const byte *data, size_t count, float *out)
+{
+  if(fmt.type != ResourceFormatType::Regular || fmt.compCount != 4)
+    return false;
+
+  if(fmt.compByteWidth == 4 && fmt.compType == CompType::Float)
+  {
+    memcpy(out, data, count * sizeof(float) * 4);
+    return true;
+  }
+
+  if(fmt.compByteWidth == 2 && fmt.compType == CompType::Float)
+  {
+    const uint16_t *src = (const uint16_t *)data;
+    size_t i = 0;
+
+#if ENABLED(RDOC_SSE2)
+    for(; i + 2 <= count; i += 2)
+    {
+      __m128i halfs = _mm_loadu_si128((const __m128i *)(src + i * 4));
+
+      _mm_storeu_ps(out + i * 4, ConvertFromHalf4(halfs));
+      _mm_storeu_ps(out + i * 4 + 4, ConvertFromHalf4(_mm_srli_si128(halfs, 8)));
+    }
+#endif
+
+    for(; i < count; i++)
+      for(size_t c = 0; c < 4; c++)
+        out[i * 4 + c] = ConvertFromHalf(src[i * 4 + c]);
+
+    return true;
+  }
+
+  if(fmt.compByteWidth == 1 && fmt.compType == CompType::UNorm)
+  {
+    const uint8_t *src = (const uint8_t *)data;
+
+    // sRGB goes through the lookup table, which is as fast as anything else
+    if(fmt.srgbCorrected)
+    {
+      for(size_t i = 0; i < count * 4; i++)
+        out[i] = SRGB8_lookuptable[src[i]];
+
+      return true;
+    }
+
+    size_t i = 0;
+
+#if ENABLED(RDOC_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(255.0f);
+
+    // 4 pixels at a time
+    for(; i + 4 <= count; i += 4)
+    {
+      __m128i bytes = _mm_loadu_si128((const __m128i *)(src + i * 4));
+
+      __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+      __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+      _mm_storeu_ps(out + i * 4 + 0, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+      _mm_storeu_ps(out + i * 4 + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+      _mm_storeu_ps(out + i * 4 + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+      _mm_storeu_ps(out + i * 4 + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+    }
+#endif
+
+    for(i *= 4; i < count * 4; i++)
+      out[i] = float(src[i]) / 255.0f;
+
+    return true;
+  }
+
+  return false;
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include <vector>
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check vectorised pixel conversion matches per-component", "[format]")
+{
+  ResourceFormat fmt;
+  fmt.type = ResourceFormatType::Regular;
+  fmt.compCount = 4;
+
+  SECTION("half floats")
+  {
+    fmt.compType = CompType::Float;
+    fmt.compByteWidth = 2;
+
+    // every possible half, plus some left over to go down the tail path
+    std::vector<uint16_t> halfs(65536 + 12);
+    for(size_t i = 0; i < halfs.size(); i++)
+      halfs[i] = uint16_t(i & 0xffff);
+
+    size_t count = halfs.size() / 4;
+    std::vector<float> out(count * 4);
+
+    REQUIRE(ConvertPixelsToFloat4(fmt, (const byte *)halfs.data(), count, out.data()));
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < out.size(); i++)
+    {
+      float expected = ConvertComponent(fmt, (const byte *)&halfs[i]);
+      if(memcmp(&expected, &out[i], sizeof(float)) != 0)
+        mismatches++;
+    }
+
+    CHECK(mismatches == 0);
+  };
+
+  SECTION("unorm bytes")
+  {
+    fmt.compType = CompType::UNorm;
+    fmt.compByteWidth = 1;
+
+    std::vector<byte> bytes(256 + 12);
+    for(size_t i = 0; i < bytes.size(); i++)
+      bytes[i] = byte(i & 0xff);
+
+    size_t count = bytes.size() / 4;
+    std::vector<float> out(count * 4);
+
+    for(bool srgb : {false, true})
+    {
+      fmt.srgbCorrected = srgb;
+
+      REQUIRE(ConvertPixelsToFloat4(fmt, bytes.data(), count, out.data()));
+
+      size_t mismatches = 0;
+      for(size_t i = 0; i < out.size(); i++)
+      {
+        float expected = ConvertComponent(fmt, &bytes[i]);
+        if(memcmp(&expected, &out[i], sizeof(float)) != 0)
+          mismatches++;
+      }
+
+      CHECK(mismatches == 0);
+    }
+  };
+
+  SECTION("unhandled formats")
+  {
+    float out[4];
+    byte data[16] = {};
+
+    fmt.compType = CompType::UNorm;
+    fmt.compByteWidth = 2;
+    CHECK_FALSE(ConvertPixelsToFloat4(fmt, data, 1, out));
+
+    fmt.compByteWidth = 1;
+    fmt.compCount = 3;
+    CHECK_FALSE(ConvertPixelsToFloat4(fmt, data, 1, out));
+
+    fmt.compCount = 4;
+    fmt.type = ResourceFormatType::R10G10B10A2;
+    CHECK_FALSE(ConvertPixelsToFloat4(fmt, data, 1, out));
+  };
+};
+
+TEST_CASE("Benchmark pixel conversion", "[format][!benchmark]")
+{
+  const size_t numPixels = 1024 * 1024;
+
+  std::vector<byte> rgba8(numPixels * 4);
+  std::vector<uint16_t> rgba16f(numPixels * 4);
+
+  for(size_t i = 0; i < numPixels * 4; i++)
+  {
+    rgba8[i] = byte((i * 7) & 0xff);
+    rgba16f[i] = ConvertToHalf(float(i % 4096) / 1024.0f);
+  }
+
+  ResourceFormat fmt;
+  fmt.type = ResourceFormatType::Regular;
+  fmt.compCount = 4;
+  fmt.compType = CompType::Float;
+  fmt.compByteWidth = 2;
+
+  std::vector<float> out(numPixels * 4);
+
+  BENCHMARK("RGBA16F to float: per-component")
+  {
+    for(size_t i = 0; i < numPixels * 4; i++)
+      out[i] = ConvertComponent(fmt, (const byte *)&rgba16f[i]);
+  }
+
+  BENCHMARK("RGBA16F to float: vectorised")
+  {
+    ConvertPixelsToFloat4(fmt, (const byte *)rgba16f.data(), numPixels, out.data());
+  }
+
+  fmt.compType = CompType::UNorm;
+  fmt.compByteWidth = 1;
+
+  BENCHMARK("RGBA8 to float: per-component")
+  {
+    for(size_t i = 0; i < numPixels * 4; i++)
+      out[i] = ConvertComponent(fmt, &rgba8[i]);
+  }
+
+  BENCHMARK("RGBA8 to float: vectorised")
+  {
+    ConvertPixelsToFloat4(fmt, rgba8.data(), numPixels, out.data());
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
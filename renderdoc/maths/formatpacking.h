@@ -167,4 +167,8 @@ inline float ConvertFromSRGB8(uint8_t comp)
 struct ResourceFormat;
 float ConvertComponent(const ResourceFormat &fmt, const byte *data);
 
+// converts count tightly packed pixels to RGBA floats, giving the same results as ConvertComponent.
+// Only common 4-component formats are handled - returns false for anything else.
+bool ConvertPixelsToFloat4(const ResourceFormat &fmt, const byte *data, size_t count, float *out);
+
 #include "half_convert.h"
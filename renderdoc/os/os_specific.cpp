@@ -25,6 +25,7 @@
 
 #include "os/os_specific.h"
 #include <stdarg.h>
+#include "3rdparty/zstd/xxhash.h"
 #include "strings/string_utils.h"
 
 using std::string;
@@ -152,6 +153,12 @@ string Callstack::AddressDetails::formattedString(const char *commonPath)
   return fmt;
 }
 
+string Callstack::GetResolveCacheFilename(const byte *moduleDB, size_t DBSize)
+{
+  return FileIO::GetTempFolderFilename() +
+         StringFormat::Fmt("RenderDoc/%016llx.resolvecache", XXH64(moduleDB, DBSize, 0));
+}
+
 string OSUtility::MakeMachineIdentString(uint64_t ident)
 {
   string ret = "";
@@ -444,6 +451,16 @@ TEST_CASE("Test OS-specific functions", "[osspecific]")
       }
     };
 #endif
+
+    SECTION("Trailing zeroes")
+    {
+      CHECK(Bits::CountTrailingZeroes(0U) == 32);
+      CHECK(Bits::CountTrailingZeroes(1U) == 0);
+      CHECK(Bits::CountTrailingZeroes(6U) == 1);
+      CHECK(Bits::CountTrailingZeroes(0x80U) == 7);
+      CHECK(Bits::CountTrailingZeroes(0x80000000U) == 31);
+      CHECK(Bits::CountTrailingZeroes(0xffff0000U) == 16);
+    };
   };
 
   const int numThreads = 8;
@@ -107,6 +107,50 @@ private:
   data m_Data;
 };
 
+// a lock allowing any number of readers or a single writer. Unlike CriticalSection it is not
+// recursive, a thread must not take it again while holding it.
+template <class data>
+class RWLockTemplate
+{
+public:
+  RWLockTemplate();
+  ~RWLockTemplate();
+  void WriteLock();
+  void WriteUnlock();
+  void ReadLock();
+  void ReadUnlock();
+
+private:
+  // no copying
+  RWLockTemplate &operator=(const RWLockTemplate &other);
+  RWLockTemplate(const RWLockTemplate &other);
+
+  data m_Data;
+};
+
+// a counting semaphore, for a thread to sleep until there's something for it to do instead of
+// polling.
+template <class data>
+class SemaphoreTemplate
+{
+public:
+  SemaphoreTemplate();
+  ~SemaphoreTemplate();
+
+  // increment the count, waking up to that many waiting threads
+  void Wake(uint32_t count = 1);
+
+  // wait until the count is non-zero, then decrement it
+  void Wait();
+
+private:
+  // no copying
+  SemaphoreTemplate &operator=(const SemaphoreTemplate &other);
+  SemaphoreTemplate(const SemaphoreTemplate &other);
+
+  data m_Data;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
@@ -114,7 +158,8 @@ uint64_t AllocateTLSSlot();
 void *GetTLSValue(uint64_t slot);
 void SetTLSValue(uint64_t slot, void *value);
 
-// must typedef CriticalSectionTemplate<X> CriticalSection
+// must typedef CriticalSectionTemplate<X> CriticalSection, RWLockTemplate<Y> RWLock and
+// SemaphoreTemplate<Z> Semaphore
 
 typedef uint64_t ThreadHandle;
 ThreadHandle CreateThread(std::function<void()> entryFunc);
@@ -123,12 +168,51 @@ void JoinThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// returns the number of logical processors available, always at least 1
+uint32_t GetNumCores();
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
 void ReleaseModuleExitThread();
 };
 
+// Tracks which pages of a region of memory have been written, so that large persistent/coherent
+// maps can be checked for changes without comparing the whole region each time.
+//
+// This is optional - IsEnabled() returns false on platforms where it isn't implemented, or when
+// it hasn't been enabled. Callers must fall back to treating the whole region as dirty.
+//
+// On linux it's enabled with RENDERDOC_WRITE_WATCH=1 and works by write-protecting the region, so
+// system calls that write straight into watched memory (e.g. read() or recv() into a mapping) fail
+// with EFAULT instead of being tracked. See posix_writewatch.cpp.
+namespace WriteWatch
+{
+struct Range
+{
+  size_t start;
+  size_t end;
+};
+
+bool IsEnabled();
+
+size_t GetPageSize();
+
+// begin tracking writes to [base, base+size). The region is initially entirely dirty. Returns
+// false if the region can't be tracked.
+//
+// Only pages entirely within the region are protected, so memory around it is never affected. Any
+// partial page at the start or end of the region can't be watched and is always returned as dirty.
+bool Register(void *base, size_t size);
+void Unregister(void *base);
+
+// returns the byte ranges within the region that have been written to since the last call, sorted
+// and merged, relative to base. Ranges are page granular but clipped to the region. Tracking is
+// reset so that only new writes are returned next time. Returns false if the region isn't
+// tracked.
+bool GetDirtyRanges(void *base, std::vector<Range> &ranges);
+};
+
 namespace Network
 {
 class Socket
@@ -197,6 +281,7 @@ int64_t Inc64(volatile int64_t *i);
 int64_t Dec64(volatile int64_t *i);
 int64_t ExchAdd64(volatile int64_t *i, int64_t a);
 int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal);
+void *CmpExchPtr(void *volatile *dest, void *oldVal, void *newVal);
 };
 
 namespace Callstack
@@ -226,6 +311,18 @@ class StackResolver
 public:
   virtual ~StackResolver() {}
   virtual AddressDetails GetAddr(uint64_t addr) = 0;
+
+  // resolves several addresses at once, which can be much faster than one at a time
+  virtual void GetAddrs(const uint64_t *addrs, size_t num, AddressDetails *details)
+  {
+    for(size_t i = 0; i < num; i++)
+      details[i] = GetAddr(addrs[i]);
+  }
+
+  // loads/saves previously resolved addresses, so they don't have to be resolved again. Not all
+  // resolvers support caching.
+  virtual bool LoadCache(const char *filename) { return false; }
+  virtual bool SaveCache(const char *filename) { return false; }
 };
 
 void Init();
@@ -235,6 +332,10 @@ Stackwalk *Create();
 
 StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCallback);
 
+// where resolved addresses for a capture are cached. This is in the temp folder, keyed by a hash of
+// the capture's module database so every copy of the same capture shares it.
+string GetResolveCacheFilename(const byte *moduleDB, size_t DBSize);
+
 bool GetLoadedModules(byte *buf, size_t &size);
 };    // namespace Callstack
 
@@ -278,12 +379,21 @@ void fseek64(FILE *f, uint64_t offset, int origin);
 
 void ftruncateat(FILE *f, uint64_t length);
 
+// takes an exclusive lock on an open file that other processes can also lock, blocking until it's
+// available. It only excludes other lockers, not reads or writes, and is released on close.
+bool lockfile(FILE *f);
+
 bool fflush(FILE *f);
 
 bool feof(FILE *f);
 
 int fclose(FILE *f);
 
+// maps a whole file into memory, read-only. Returns NULL if the file is empty or couldn't be mapped.
+// The file must not be modified while it's mapped.
+const byte *MapFile(const char *filename, uint64_t &size);
+void UnmapFile(const byte *data, uint64_t size);
+
 // functions for atomically appending to a log that may be in use in multiple
 // processes
 bool logfile_open(const char *filename);
@@ -415,6 +525,7 @@ inline uint32_t CountLeadingZeroes(uint32_t value);
 #if ENABLED(RDOC_X64)
 inline uint64_t CountLeadingZeroes(uint64_t value);
 #endif
+inline uint32_t CountTrailingZeroes(uint32_t value);
 };
 
 // must #define:
@@ -25,9 +25,14 @@
 #include <execinfo.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <vector>
+#include "common/threading.h"
 #include "os/os_specific.h"
+#include "os/posix/linux/linux_symbolizer.h"
+#include "serialise/streamio.h"
 
 void *renderdocBase = NULL;
 void *renderdocEnd = NULL;
@@ -142,83 +147,238 @@ struct LookupModule
 {
   uint64_t base;
   uint64_t end;
-  char path[2048];
+  // the offset in the module file that base corresponds to
+  uint64_t offset;
+  std::string path;
 };
 
+static const uint32_t ResolveCacheMagic = MAKE_FOURCC('R', 'D', 'S', 'C');
+static const uint32_t ResolveCacheVersion = 1;
+
+static void WriteString(StreamWriter &writer, const std::string &str)
+{
+  writer.Write((uint32_t)str.size());
+  writer.Write(str.data(), str.size());
+}
+
+static bool ReadString(StreamReader &reader, std::string &str)
+{
+  uint32_t len = 0;
+  if(!reader.Read(len) || len > reader.GetSize() - reader.GetOffset())
+    return false;
+
+  str.resize(len);
+  return reader.Read(&str[0], len);
+}
+
 class LinuxResolver : public Callstack::StackResolver
 {
 public:
-  LinuxResolver(vector<LookupModule> modules) { m_Modules = modules; }
-  Callstack::AddressDetails GetAddr(uint64_t addr)
+  LinuxResolver(const std::vector<LookupModule> &modules)
+      : m_Modules(modules), m_Symbolizers(modules.size(), NULL)
   {
-    EnsureCached(addr);
+  }
 
-    return m_Cache[addr];
+  ~LinuxResolver()
+  {
+    for(ElfSymbolizer *sym : m_Symbolizers)
+      delete sym;
   }
 
-private:
-  void EnsureCached(uint64_t addr)
+  Callstack::AddressDetails GetAddr(uint64_t addr)
   {
-    auto it = m_Cache.insert(
-        std::pair<uint64_t, Callstack::AddressDetails>(addr, Callstack::AddressDetails()));
-    if(!it.second)
-      return;
+    Callstack::AddressDetails ret;
+    GetAddrs(&addr, 1, &ret);
+    return ret;
+  }
 
-    Callstack::AddressDetails &ret = it.first->second;
+  void GetAddrs(const uint64_t *addrs, size_t num, Callstack::AddressDetails *details)
+  {
+    // find the addresses we haven't seen before
+    std::vector<uint64_t> uncached;
+    for(size_t i = 0; i < num; i++)
+      if(m_Cache.find(addrs[i]) == m_Cache.end())
+        uncached.push_back(addrs[i]);
 
-    ret.filename = "Unknown";
-    ret.line = 0;
-    ret.function = StringFormat::Fmt("0x%08llx", addr);
+    std::sort(uncached.begin(), uncached.end());
+    uncached.erase(std::unique(uncached.begin(), uncached.end()), uncached.end());
 
-    for(size_t i = 0; i < m_Modules.size(); i++)
+    if(!uncached.empty())
     {
-      if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
+      // load any modules we need that haven't been loaded yet. This is by far the most expensive
+      // part, so modules are loaded in parallel.
+      std::vector<size_t> toLoad;
+      for(uint64_t addr : uncached)
       {
-        uint64_t relative = addr - m_Modules[i].base;
-        string cmd =
-            StringFormat::Fmt("addr2line -j.text -fCe \"%s\" 0x%llx", m_Modules[i].path, relative);
+        int mod = FindModule(addr);
+        if(mod >= 0 && m_Symbolizers[mod] == NULL &&
+           std::find(toLoad.begin(), toLoad.end(), size_t(mod)) == toLoad.end())
+          toLoad.push_back(size_t(mod));
+      }
 
-        FILE *f = ::popen(cmd.c_str(), "r");
+      Threading::JobPool &pool = Threading::JobPool::Shared();
 
-        char result[2048] = {0};
-        fread(result, 1, 2047, f);
+      pool.ParallelFor(toLoad.size(), pool.GetNumThreads(), [this, &toLoad](size_t i) {
+        m_Symbolizers[toLoad[i]] = new ElfSymbolizer(m_Modules[toLoad[i]].path);
+      });
 
-        fclose(f);
+      std::vector<Callstack::AddressDetails> resolved(uncached.size());
 
-        char *line2 = strchr(result, '\n');
-        if(line2)
-        {
-          *line2 = 0;
-          line2++;
-        }
+      pool.ParallelFor(uncached.size(), pool.GetNumThreads(),
+                       [this, &uncached, &resolved](size_t i) {
+                         resolved[i] = Resolve(uncached[i]);
+                       });
 
-        ret.function = result;
+      for(size_t i = 0; i < uncached.size(); i++)
+        m_Cache[uncached[i]] = resolved[i];
 
-        if(line2)
-        {
-          char *last = line2 + strlen(line2) - 1;
-          uint32_t mul = 1;
-          ret.line = 0;
-          while(*last >= '0' && *last <= '9')
-          {
-            ret.line += mul * (uint32_t(*last) - uint32_t('0'));
-            *last = 0;
-            last--;
-            mul *= 10;
-          }
-          if(*last == ':')
-            *last = 0;
-
-          ret.filename = line2;
-        }
+      m_CacheDirty = true;
+    }
 
-        break;
+    for(size_t i = 0; i < num; i++)
+      details[i] = m_Cache[addrs[i]];
+  }
+
+  bool LoadCache(const char *filename)
+  {
+    FILE *f = FileIO::fopen(filename, "rb");
+    if(!f)
+      return false;
+
+    StreamReader reader(f);
+
+    uint32_t magic = 0, version = 0, numModules = 0;
+    reader.Read(magic);
+    reader.Read(version);
+    reader.Read(numModules);
+
+    if(reader.IsErrored() || magic != ResolveCacheMagic || version != ResolveCacheVersion ||
+       numModules != m_Modules.size())
+      return false;
+
+    // the cache is only valid if every module is unchanged since it was written
+    for(const LookupModule &mod : m_Modules)
+    {
+      std::string path;
+      uint64_t timestamp = 0;
+      if(!ReadString(reader, path) || !reader.Read(timestamp) || path != mod.path ||
+         timestamp != FileIO::GetModifiedTimestamp(mod.path))
+      {
+        RDCLOG("Ignoring stale callstack resolve cache '%s'", filename);
+        return false;
       }
     }
+
+    uint64_t numEntries = 0;
+    reader.Read(numEntries);
+
+    std::map<uint64_t, Callstack::AddressDetails> cache;
+
+    for(uint64_t i = 0; i < numEntries && !reader.IsErrored(); i++)
+    {
+      uint64_t addr = 0;
+      Callstack::AddressDetails details;
+
+      reader.Read(addr);
+      reader.Read(details.line);
+      if(!ReadString(reader, details.function) || !ReadString(reader, details.filename))
+        return false;
+
+      cache[addr] = details;
+    }
+
+    if(reader.IsErrored())
+      return false;
+
+    m_Cache.insert(cache.begin(), cache.end());
+
+    return true;
+  }
+
+  bool SaveCache(const char *filename)
+  {
+    if(!m_CacheDirty)
+      return true;
+
+    FileIO::CreateParentDirectory(filename);
+
+    FILE *f = FileIO::fopen(filename, "wb");
+    if(!f)
+    {
+      RDCWARN("Couldn't write callstack resolve cache '%s'", filename);
+      return false;
+    }
+
+    StreamWriter writer(f, Ownership::Stream);
+
+    writer.Write(ResolveCacheMagic);
+    writer.Write(ResolveCacheVersion);
+    writer.Write((uint32_t)m_Modules.size());
+
+    for(const LookupModule &mod : m_Modules)
+    {
+      WriteString(writer, mod.path);
+      writer.Write(FileIO::GetModifiedTimestamp(mod.path));
+    }
+
+    writer.Write((uint64_t)m_Cache.size());
+
+    for(auto it = m_Cache.begin(); it != m_Cache.end(); ++it)
+    {
+      writer.Write(it->first);
+      writer.Write(it->second.line);
+      WriteString(writer, it->second.function);
+      WriteString(writer, it->second.filename);
+    }
+
+    if(writer.IsErrored())
+      return false;
+
+    m_CacheDirty = false;
+
+    return true;
+  }
+
+private:
+  int FindModule(uint64_t addr) const
+  {
+    for(size_t i = 0; i < m_Modules.size(); i++)
+      if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
+        return int(i);
+
+    return -1;
+  }
+
+  Callstack::AddressDetails Resolve(uint64_t addr) const
+  {
+    Callstack::AddressDetails ret;
+
+    ret.filename = "Unknown";
+    ret.line = 0;
+    ret.function = StringFormat::Fmt("0x%08llx", addr);
+
+    int mod = FindModule(addr);
+
+    if(mod < 0 || !m_Symbolizers[mod]->IsValid())
+      return ret;
+
+    const LookupModule &module = m_Modules[mod];
+
+    // callstack addresses are return addresses, so look up the byte before to find the call
+    // itself rather than whatever follows it.
+    uint64_t address = 0;
+    if(m_Symbolizers[mod]->FileOffsetToAddress(addr - module.base + module.offset, address))
+      m_Symbolizers[mod]->Resolve(address - 1, ret);
+
+    return ret;
   }
 
   std::vector<LookupModule> m_Modules;
+  // created the first time an address in the module is resolved
+  std::vector<ElfSymbolizer *> m_Symbolizers;
+
   std::map<uint64_t, Callstack::AddressDetails> m_Cache;
+  bool m_CacheDirty = false;
 };
 
 StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCallback progress)
@@ -247,21 +407,23 @@ StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCal
 
     // find .text segments
     {
-      long unsigned int base = 0, end = 0;
+      long unsigned int base = 0, end = 0, offset = 0;
 
       int inode = 0;
       int offs = 0;
       //                        base-end   perms offset devid   inode offs
-      int num = sscanf(search, "%lx-%lx  r-xp  %*x    %*x:%*x %d    %n", &base, &end, &inode, &offs);
+      int num = sscanf(search, "%lx-%lx  r-xp  %lx    %*x:%*x %d    %n", &base, &end, &offset,
+                       &inode, &offs);
 
       // we don't care about inode actually, we ust use it to verify that
-      // we read all 3 params (and so perms == r-xp)
-      if(num == 3 && offs > 0)
+      // we read all 4 params (and so perms == r-xp)
+      if(num == 4 && offs > 0)
       {
-        LookupModule mod = {0};
+        LookupModule mod;
 
         mod.base = (uint64_t)base;
         mod.end = (uint64_t)end;
+        mod.offset = (uint64_t)offset;
 
         search += offs;
         while(search < dbend && (*search == ' ' || *search == '\t'))
@@ -269,54 +431,14 @@ StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCal
 
         if(search < dbend && *search != '[' && *search != 0 && *search != '\n')
         {
-          size_t n = ARRAY_COUNT(mod.path) - 1;
-          mod.path[n] = 0;
-          for(size_t i = 0; i < n; i++)
-          {
-            if(search[i] == 0 || search[i] == '\n')
-            {
-              mod.path[i] = 0;
-              break;
-            }
-            if(search + i >= dbend)
-            {
-              mod.path[i] = 0;
-              break;
-            }
-            mod.path[i] = search[i];
-          }
-
-          // addr2line wants offsets relative to text section, have to find offset of .text section
-          // in this
-          // mmapped section
-
-          int textoffs = 0;
-          string cmd = StringFormat::Fmt("readelf -WS \"%s\"", mod.path);
-
-          FILE *f = ::popen(cmd.c_str(), "r");
-
-          char result[4096] = {0};
-          fread(result, 1, 4095, f);
-
-          fclose(f);
-
-          // find .text line
-          char *find = strstr(result, ".text");
-
-          if(find)
-          {
-            find += 5;
-
-            while(isalpha(*find) || isspace(*find))
-              find++;
-
-            // virtual address is listed first, we want the offset
-            sscanf(find, "%*x %x", &textoffs);
-
-            mod.base += textoffs;
-
-            modules.push_back(mod);
-          }
+          char *pathEnd = search;
+          while(pathEnd < dbend && *pathEnd != 0 && *pathEnd != '\n')
+            pathEnd++;
+
+          mod.path.assign(search, pathEnd);
+
+          // the module itself isn't read until an address inside it is resolved
+          modules.push_back(mod);
         }
       }
     }
@@ -335,3 +457,54 @@ StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCal
   return new LinuxResolver(modules);
 }
 };
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+// not static, so that it's in the dynamic symbol table even if the full one has been stripped
+void LinuxCallstackTestFunction()
+{
+}
+
+TEST_CASE("Check callstack resolving", "[callstack]")
+{
+  size_t size = 0;
+  Callstack::GetLoadedModules(NULL, size);
+
+  // leave room in case more is mapped while we're reading
+  std::vector<byte> moduleDB(size * 2);
+  size = 0;
+  Callstack::GetLoadedModules(moduleDB.data(), size);
+
+  Callstack::StackResolver *resolver = Callstack::MakeResolver(moduleDB.data(), size, NULL);
+  REQUIRE(resolver);
+
+  // resolved addresses are treated as return addresses, so point just after the function start
+  uint64_t addrs[] = {
+      (uint64_t)&LinuxCallstackTestFunction + 1, 0x10,
+  };
+
+  Callstack::AddressDetails details[2];
+  resolver->GetAddrs(addrs, 2, details);
+
+  CHECK(details[0].function.find("LinuxCallstackTestFunction") != std::string::npos);
+  CHECK(details[1].function == "0x00000010");
+
+  // resolving again comes from the cache and gives the same results
+  CHECK(resolver->GetAddr(addrs[0]).function == details[0].function);
+
+  std::string cacheFile = FileIO::GetTempFolderFilename() + "/renderdoc_resolve_cache_test";
+
+  CHECK(resolver->SaveCache(cacheFile.c_str()));
+  delete resolver;
+
+  resolver = Callstack::MakeResolver(moduleDB.data(), size, NULL);
+  CHECK(resolver->LoadCache(cacheFile.c_str()));
+  CHECK(resolver->GetAddr(addrs[0]).function == details[0].function);
+  delete resolver;
+
+  FileIO::Delete(cacheFile.c_str());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,912 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "linux_symbolizer.h"
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include "miniz/miniz.h"
+#include "strings/string_utils.h"
+
+namespace
+{
+template <typename Ehdr_, typename Shdr_, typename Phdr_, typename Sym_, typename Chdr_>
+struct ElfTypes
+{
+  typedef Ehdr_ Ehdr;
+  typedef Shdr_ Shdr;
+  typedef Phdr_ Phdr;
+  typedef Sym_ Sym;
+  typedef Chdr_ Chdr;
+};
+
+typedef ElfTypes<Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr, Elf32_Sym, Elf32_Chdr> Elf32Types;
+typedef ElfTypes<Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr, Elf64_Sym, Elf64_Chdr> Elf64Types;
+
+// the DWARF constants we need when parsing line tables
+enum
+{
+  DW_LNS_copy = 0x01,
+  DW_LNS_advance_pc = 0x02,
+  DW_LNS_advance_line = 0x03,
+  DW_LNS_set_file = 0x04,
+  DW_LNS_set_column = 0x05,
+  DW_LNS_negate_stmt = 0x06,
+  DW_LNS_set_basic_block = 0x07,
+  DW_LNS_const_add_pc = 0x08,
+  DW_LNS_fixed_advance_pc = 0x09,
+  DW_LNS_set_prologue_end = 0x0a,
+  DW_LNS_set_epilogue_begin = 0x0b,
+  DW_LNS_set_isa = 0x0c,
+
+  DW_LNE_end_sequence = 0x01,
+  DW_LNE_set_address = 0x02,
+
+  DW_LNCT_path = 0x1,
+  DW_LNCT_directory_index = 0x2,
+
+  DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06,
+  DW_FORM_data8 = 0x07,
+  DW_FORM_string = 0x08,
+  DW_FORM_block = 0x09,
+  DW_FORM_data1 = 0x0b,
+  DW_FORM_strp = 0x0e,
+  DW_FORM_udata = 0x0f,
+  DW_FORM_strx = 0x1a,
+  DW_FORM_data16 = 0x1e,
+  DW_FORM_line_strp = 0x1f,
+  DW_FORM_strx1 = 0x25,
+  DW_FORM_strx2 = 0x26,
+  DW_FORM_strx3 = 0x27,
+  DW_FORM_strx4 = 0x28,
+};
+
+// bounds-checked reading of DWARF data. Any read past the end sets the error flag and returns
+// zero, so parsing can check for errors once per unit rather than on every read.
+struct DataCursor
+{
+  DataCursor(const byte *begin, const byte *e) : cur(begin), end(e) {}
+  const byte *cur;
+  const byte *end;
+  bool error = false;
+
+  template <typename T>
+  T Read()
+  {
+    T ret = T();
+    if(size_t(end - cur) < sizeof(T))
+    {
+      error = true;
+      cur = end;
+      return ret;
+    }
+    memcpy(&ret, cur, sizeof(T));
+    cur += sizeof(T);
+    return ret;
+  }
+
+  uint64_t ReadULEB()
+  {
+    uint64_t ret = 0;
+    uint32_t shift = 0;
+    while(cur < end)
+    {
+      byte b = *(cur++);
+      if(shift < 64)
+        ret |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+      if((b & 0x80) == 0)
+        return ret;
+    }
+    error = true;
+    return ret;
+  }
+
+  int64_t ReadSLEB()
+  {
+    int64_t ret = 0;
+    uint32_t shift = 0;
+    while(cur < end)
+    {
+      byte b = *(cur++);
+      if(shift < 64)
+        ret |= int64_t(b & 0x7f) << shift;
+      shift += 7;
+      if((b & 0x80) == 0)
+      {
+        if(shift < 64 && (b & 0x40))
+          ret |= -(int64_t(1) << shift);
+        return ret;
+      }
+    }
+    error = true;
+    return ret;
+  }
+
+  const char *ReadString()
+  {
+    const byte *str = cur;
+    while(cur < end && *cur)
+      cur++;
+
+    if(cur >= end)
+    {
+      error = true;
+      return "";
+    }
+
+    cur++;
+    return (const char *)str;
+  }
+
+  uint64_t ReadOffset(bool dwarf64) { return dwarf64 ? Read<uint64_t>() : Read<uint32_t>(); }
+  void Skip(uint64_t bytes)
+  {
+    if(bytes > uint64_t(end - cur))
+    {
+      error = true;
+      cur = end;
+      return;
+    }
+    cur += bytes;
+  }
+};
+
+const char *StringAt(const byte *strings, size_t size, uint64_t offset)
+{
+  if(strings == NULL || offset >= size)
+    return "";
+
+  // the string must be terminated inside the section
+  if(memchr(strings + offset, 0, size_t(size - offset)) == NULL)
+    return "";
+
+  return (const char *)strings + offset;
+}
+
+std::string Demangle(const char *name)
+{
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+
+  if(status != 0 || demangled == NULL)
+    return name;
+
+  std::string ret = demangled;
+  free(demangled);
+  return ret;
+}
+};
+
+ElfSymbolizer::ElfSymbolizer(const std::string &path)
+{
+  MappedFile file;
+  if(!MapFile(path, file))
+    return;
+
+  m_Files.push_back(file);
+
+  if(file.data[EI_CLASS] == ELFCLASS64)
+    m_Valid = Parse<Elf64Types>(file, true);
+  else
+    m_Valid = Parse<Elf32Types>(file, true);
+
+  if(!m_Valid)
+  {
+    RDCWARN("Couldn't parse '%s' as an ELF module", path.c_str());
+    return;
+  }
+
+  // stripped modules keep their full symbols and line tables in a separate debug file
+  if(!m_HasSymtab || m_LineRows.empty())
+  {
+    std::string debugPath = FindDebugFile(path);
+
+    MappedFile debugFile;
+    if(!debugPath.empty() && MapFile(debugPath, debugFile))
+    {
+      m_Files.push_back(debugFile);
+
+      if(debugFile.data[EI_CLASS] == ELFCLASS64)
+        Parse<Elf64Types>(debugFile, false);
+      else
+        Parse<Elf32Types>(debugFile, false);
+    }
+  }
+
+  // sort symbols by address, preferring sized symbols where several share an address
+  std::sort(m_Symbols.begin(), m_Symbols.end(), [](const Symbol &a, const Symbol &b) {
+    if(a.address != b.address)
+      return a.address < b.address;
+    return a.size > b.size;
+  });
+  m_Symbols.erase(std::unique(m_Symbols.begin(), m_Symbols.end(),
+                              [](const Symbol &a, const Symbol &b) { return a.address == b.address; }),
+                  m_Symbols.end());
+
+  // sequence ends sort before sequences that start at the same address, so that a lookup finds the
+  // start of the next sequence.
+  std::stable_sort(m_LineRows.begin(), m_LineRows.end(), [](const LineRow &a, const LineRow &b) {
+    if(a.address != b.address)
+      return a.address < b.address;
+    return a.endSequence && !b.endSequence;
+  });
+}
+
+ElfSymbolizer::~ElfSymbolizer()
+{
+  for(MappedFile &file : m_Files)
+    UnmapFile(file);
+}
+
+bool ElfSymbolizer::MapFile(const std::string &path, MappedFile &file)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat st = {};
+  if(fstat(fd, &st) != 0 || st.st_size < EI_NIDENT)
+  {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(data == MAP_FAILED)
+    return false;
+
+  file.data = (byte *)data;
+  file.size = size_t(st.st_size);
+
+  if(memcmp(file.data, ELFMAG, SELFMAG) != 0 || file.data[EI_DATA] != ELFDATA2LSB ||
+     (file.data[EI_CLASS] != ELFCLASS32 && file.data[EI_CLASS] != ELFCLASS64))
+  {
+    UnmapFile(file);
+    return false;
+  }
+
+  return true;
+}
+
+void ElfSymbolizer::UnmapFile(MappedFile &file)
+{
+  if(file.data)
+    munmap(file.data, file.size);
+  file.data = NULL;
+  file.size = 0;
+}
+
+template <typename ElfTypes>
+bool ElfSymbolizer::Parse(const MappedFile &file, bool primary)
+{
+  typedef typename ElfTypes::Ehdr Ehdr;
+  typedef typename ElfTypes::Shdr Shdr;
+  typedef typename ElfTypes::Phdr Phdr;
+  typedef typename ElfTypes::Sym Sym;
+  typedef typename ElfTypes::Chdr Chdr;
+
+  if(file.size < sizeof(Ehdr))
+    return false;
+
+  const Ehdr *ehdr = (const Ehdr *)file.data;
+
+  if(primary)
+  {
+    if(ehdr->e_phoff + uint64_t(ehdr->e_phnum) * sizeof(Phdr) > file.size)
+      return false;
+
+    const Phdr *phdrs = (const Phdr *)(file.data + ehdr->e_phoff);
+
+    for(uint16_t i = 0; i < ehdr->e_phnum; i++)
+    {
+      if(phdrs[i].p_type == PT_LOAD)
+        m_Segments.push_back({phdrs[i].p_offset, phdrs[i].p_vaddr, phdrs[i].p_filesz});
+    }
+  }
+
+  if(ehdr->e_shoff == 0 || ehdr->e_shoff + uint64_t(ehdr->e_shnum) * sizeof(Shdr) > file.size ||
+     ehdr->e_shstrndx >= ehdr->e_shnum)
+  {
+    // without section headers we can still convert addresses, just not find any symbols
+    return primary;
+  }
+
+  const Shdr *sections = (const Shdr *)(file.data + ehdr->e_shoff);
+
+  auto getSectionData = [this, &file](const Shdr &section, const byte *&data, size_t &size) {
+    data = NULL;
+    size = 0;
+
+    if(section.sh_type == SHT_NOBITS || section.sh_offset + section.sh_size > file.size)
+      return false;
+
+    data = file.data + section.sh_offset;
+    size = size_t(section.sh_size);
+
+    if(section.sh_flags & SHF_COMPRESSED)
+    {
+      if(size < sizeof(Chdr))
+        return false;
+
+      const Chdr *chdr = (const Chdr *)data;
+
+      if(chdr->ch_type != ELFCOMPRESS_ZLIB)
+        return false;
+
+      m_DecompressedSections.push_back(std::vector<byte>());
+      std::vector<byte> &decompressed = m_DecompressedSections.back();
+      decompressed.resize(size_t(chdr->ch_size));
+
+      mz_ulong destSize = (mz_ulong)decompressed.size();
+      if(mz_uncompress(decompressed.data(), &destSize, data + sizeof(Chdr),
+                       mz_ulong(size - sizeof(Chdr))) != MZ_OK)
+      {
+        m_DecompressedSections.pop_back();
+        data = NULL;
+        size = 0;
+        return false;
+      }
+
+      data = decompressed.data();
+      size = decompressed.size();
+    }
+
+    return true;
+  };
+
+  const byte *sectionNames = NULL;
+  size_t sectionNamesSize = 0;
+  getSectionData(sections[ehdr->e_shstrndx], sectionNames, sectionNamesSize);
+
+  const Shdr *symtab = NULL, *dynsym = NULL, *debugLine = NULL, *debugLineStr = NULL,
+             *debugStr = NULL;
+
+  for(uint16_t i = 0; i < ehdr->e_shnum; i++)
+  {
+    const Shdr &section = sections[i];
+    const char *name = StringAt(sectionNames, sectionNamesSize, section.sh_name);
+
+    if(section.sh_type == SHT_SYMTAB)
+      symtab = &section;
+    else if(section.sh_type == SHT_DYNSYM)
+      dynsym = &section;
+    else if(!strcmp(name, ".debug_line"))
+      debugLine = &section;
+    else if(!strcmp(name, ".debug_line_str"))
+      debugLineStr = &section;
+    else if(!strcmp(name, ".debug_str"))
+      debugStr = &section;
+
+    if(primary && section.sh_type == SHT_NOTE && !strcmp(name, ".note.gnu.build-id"))
+    {
+      const byte *data = NULL;
+      size_t size = 0;
+      if(getSectionData(section, data, size) && size >= sizeof(Elf32_Nhdr))
+      {
+        const Elf32_Nhdr *note = (const Elf32_Nhdr *)data;
+        size_t descOffset = sizeof(Elf32_Nhdr) + AlignUp4(note->n_namesz);
+
+        if(note->n_type == NT_GNU_BUILD_ID && descOffset + note->n_descsz <= size)
+          m_BuildID.assign(data + descOffset, data + descOffset + note->n_descsz);
+      }
+    }
+    else if(primary && !strcmp(name, ".gnu_debuglink"))
+    {
+      const byte *data = NULL;
+      size_t size = 0;
+      if(getSectionData(section, data, size))
+        m_DebugLink = StringAt(data, size, 0);
+    }
+  }
+
+  // prefer the full symbol table, the dynamic symbols only contain exported functions
+  const Shdr *symbols = symtab ? symtab : dynsym;
+
+  if(symtab)
+    m_HasSymtab = true;
+
+  if(symbols && symbols->sh_link < ehdr->e_shnum && symbols->sh_entsize == sizeof(Sym))
+  {
+    const byte *symData = NULL, *strData = NULL;
+    size_t symSize = 0, strSize = 0;
+
+    if(getSectionData(*symbols, symData, symSize) &&
+       getSectionData(sections[symbols->sh_link], strData, strSize))
+    {
+      const Sym *syms = (const Sym *)symData;
+      size_t numSyms = symSize / sizeof(Sym);
+
+      for(size_t i = 0; i < numSyms; i++)
+      {
+        const Sym &sym = syms[i];
+        unsigned char type = ELF64_ST_TYPE(sym.st_info);
+
+        if((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_shndx == SHN_UNDEF ||
+           sym.st_value == 0)
+          continue;
+
+        const char *name = StringAt(strData, strSize, sym.st_name);
+        if(name[0] == 0)
+          continue;
+
+        m_Symbols.push_back({sym.st_value, sym.st_size, name});
+      }
+    }
+  }
+
+  if(m_LineRows.empty() && debugLine)
+  {
+    const byte *lineData = NULL, *lineStrData = NULL, *strData = NULL;
+    size_t lineSize = 0, lineStrSize = 0, strSize = 0;
+
+    getSectionData(*debugLine, lineData, lineSize);
+    if(debugLineStr)
+      getSectionData(*debugLineStr, lineStrData, lineStrSize);
+    if(debugStr)
+      getSectionData(*debugStr, strData, strSize);
+
+    if(lineData)
+      ParseLineTables(lineData, lineSize, lineStrData, lineStrSize, strData, strSize, m_LineFiles,
+                      m_LineRows);
+  }
+
+  return true;
+}
+
+std::string ElfSymbolizer::FindDebugFile(const std::string &path) const
+{
+  std::vector<std::string> candidates;
+
+  if(m_BuildID.size() > 1)
+  {
+    std::string hex;
+    for(size_t i = 1; i < m_BuildID.size(); i++)
+      hex += StringFormat::Fmt("%02x", m_BuildID[i]);
+
+    candidates.push_back(
+        StringFormat::Fmt("/usr/lib/debug/.build-id/%02x/%s.debug", m_BuildID[0], hex.c_str()));
+  }
+
+  if(!m_DebugLink.empty())
+  {
+    std::string dir = dirname(path);
+
+    candidates.push_back(dir + "/" + m_DebugLink);
+    candidates.push_back(dir + "/.debug/" + m_DebugLink);
+    candidates.push_back("/usr/lib/debug" + dir + "/" + m_DebugLink);
+  }
+
+  for(const std::string &candidate : candidates)
+  {
+    if(candidate != path && FileIO::exists(candidate.c_str()))
+      return candidate;
+  }
+
+  return "";
+}
+
+void ElfSymbolizer::ParseLineTables(const byte *data, size_t size, const byte *lineStr,
+                                    size_t lineStrSize, const byte *str, size_t strSize,
+                                    std::vector<std::string> &files, std::vector<LineRow> &rows)
+{
+  // files are shared between all units, since most of them include the same headers
+  std::map<std::string, uint32_t> fileLookup;
+  for(size_t i = 0; i < files.size(); i++)
+    fileLookup[files[i]] = uint32_t(i);
+
+  auto addFile = [&files, &fileLookup](const std::string &dir, const char *name) {
+    std::string path = name;
+    if(name[0] != '/' && !dir.empty())
+      path = dir + "/" + name;
+
+    auto it = fileLookup.find(path);
+    if(it != fileLookup.end())
+      return it->second;
+
+    uint32_t idx = uint32_t(files.size());
+    files.push_back(path);
+    fileLookup[path] = idx;
+    return idx;
+  };
+
+  DataCursor section(data, data + size);
+
+  std::vector<LineRow> sequence;
+
+  while(section.cur < section.end && !section.error)
+  {
+    bool dwarf64 = false;
+    uint64_t unitLength = section.Read<uint32_t>();
+    if(unitLength == 0xffffffff)
+    {
+      dwarf64 = true;
+      unitLength = section.Read<uint64_t>();
+    }
+
+    if(section.error || unitLength > uint64_t(section.end - section.cur))
+      break;
+
+    DataCursor unit(section.cur, section.cur + unitLength);
+    section.cur += unitLength;
+
+    uint16_t version = unit.Read<uint16_t>();
+    if(version < 2 || version > 5)
+      continue;
+
+    uint8_t addressSize = 8;
+    if(version >= 5)
+    {
+      addressSize = unit.Read<uint8_t>();
+      unit.Read<uint8_t>();    // segment_selector_size
+    }
+
+    uint64_t headerLength = unit.ReadOffset(dwarf64);
+    if(unit.error || headerLength > uint64_t(unit.end - unit.cur))
+      continue;
+
+    const byte *program = unit.cur + headerLength;
+
+    uint8_t minInstLength = unit.Read<uint8_t>();
+    if(version >= 4)
+      unit.Read<uint8_t>();    // maximum_operations_per_instruction, only used for VLIW
+    unit.Read<uint8_t>();      // default_is_stmt
+    int8_t lineBase = unit.Read<int8_t>();
+    uint8_t lineRange = unit.Read<uint8_t>();
+    uint8_t opcodeBase = unit.Read<uint8_t>();
+
+    if(unit.error || lineRange == 0 || opcodeBase == 0)
+      continue;
+
+    std::vector<uint8_t> opcodeLengths(opcodeBase - 1);
+    for(uint8_t &len : opcodeLengths)
+      len = unit.Read<uint8_t>();
+
+    std::vector<std::string> dirs;
+    // the global file index for each file index in this unit, or ~0U if unknown
+    std::vector<uint32_t> unitFiles;
+
+    if(version >= 5)
+    {
+      // directories and files are described by a list of (content, form) pairs
+      auto readEntries = [&](bool isFiles) {
+        std::vector<std::pair<uint64_t, uint64_t>> formats;
+        uint8_t formatCount = unit.Read<uint8_t>();
+        for(uint8_t f = 0; f < formatCount; f++)
+        {
+          uint64_t content = unit.ReadULEB();
+          uint64_t form = unit.ReadULEB();
+          formats.push_back({content, form});
+        }
+
+        uint64_t count = unit.ReadULEB();
+        for(uint64_t e = 0; e < count && !unit.error; e++)
+        {
+          const char *path = "";
+          uint64_t dirIndex = 0;
+
+          for(const std::pair<uint64_t, uint64_t> &format : formats)
+          {
+            uint64_t value = 0;
+            const char *string = NULL;
+
+            switch(format.second)
+            {
+              case DW_FORM_string: string = unit.ReadString(); break;
+              case DW_FORM_line_strp:
+                string = StringAt(lineStr, lineStrSize, unit.ReadOffset(dwarf64));
+                break;
+              case DW_FORM_strp: string = StringAt(str, strSize, unit.ReadOffset(dwarf64)); break;
+              case DW_FORM_udata: value = unit.ReadULEB(); break;
+              case DW_FORM_data1: value = unit.Read<uint8_t>(); break;
+              case DW_FORM_data2: value = unit.Read<uint16_t>(); break;
+              case DW_FORM_data4: value = unit.Read<uint32_t>(); break;
+              case DW_FORM_data8: value = unit.Read<uint64_t>(); break;
+              case DW_FORM_data16: unit.Skip(16); break;
+              case DW_FORM_block: unit.Skip(unit.ReadULEB()); break;
+              // string indices need .debug_str_offsets and the unit's base, which we don't have
+              case DW_FORM_strx: unit.ReadULEB(); break;
+              case DW_FORM_strx1: unit.Skip(1); break;
+              case DW_FORM_strx2: unit.Skip(2); break;
+              case DW_FORM_strx3: unit.Skip(3); break;
+              case DW_FORM_strx4: unit.Skip(4); break;
+              default: unit.error = true; break;
+            }
+
+            if(format.first == DW_LNCT_path && string)
+              path = string;
+            else if(format.first == DW_LNCT_directory_index)
+              dirIndex = value;
+          }
+
+          if(isFiles)
+            unitFiles.push_back(addFile(dirIndex < dirs.size() ? dirs[dirIndex] : "", path));
+          else
+            dirs.push_back(path);
+        }
+      };
+
+      readEntries(false);
+      readEntries(true);
+    }
+    else
+    {
+      // directory 0 is the compilation directory, which is only recorded in .debug_info
+      dirs.push_back("");
+      for(;;)
+      {
+        const char *dir = unit.ReadString();
+        if(unit.error || dir[0] == 0)
+          break;
+        dirs.push_back(dir);
+      }
+
+      // file indices start at 1
+      unitFiles.push_back(~0U);
+      for(;;)
+      {
+        const char *name = unit.ReadString();
+        if(unit.error || name[0] == 0)
+          break;
+
+        uint64_t dirIndex = unit.ReadULEB();
+        unit.ReadULEB();    // modification time
+        unit.ReadULEB();    // length
+
+        unitFiles.push_back(addFile(dirIndex < dirs.size() ? dirs[dirIndex] : "", name));
+      }
+    }
+
+    if(unit.error)
+      continue;
+
+    unit.cur = program;
+
+    uint64_t address = 0;
+    uint64_t file = 1;
+    int64_t line = 1;
+
+    sequence.clear();
+
+    auto emitRow = [&](bool endSequence) {
+      LineRow row;
+      row.address = address;
+      row.file = file < unitFiles.size() ? unitFiles[(size_t)file] : ~0U;
+      row.line = uint32_t(line);
+      row.endSequence = endSequence;
+      sequence.push_back(row);
+    };
+
+    while(unit.cur < unit.end && !unit.error)
+    {
+      uint8_t opcode = unit.Read<uint8_t>();
+
+      if(opcode >= opcodeBase)
+      {
+        uint8_t adjusted = opcode - opcodeBase;
+        address += (adjusted / lineRange) * minInstLength;
+        line += lineBase + (adjusted % lineRange);
+        emitRow(false);
+        continue;
+      }
+
+      switch(opcode)
+      {
+        case 0:
+        {
+          uint64_t len = unit.ReadULEB();
+          if(len == 0 || len > uint64_t(unit.end - unit.cur))
+          {
+            unit.error = true;
+            break;
+          }
+
+          const byte *next = unit.cur + len;
+          uint8_t extended = unit.Read<uint8_t>();
+
+          if(extended == DW_LNE_end_sequence)
+          {
+            emitRow(true);
+
+            // sequences for functions discarded by the linker are left at address 0
+            if(!sequence.empty() && sequence[0].address != 0)
+              rows.insert(rows.end(), sequence.begin(), sequence.end());
+
+            sequence.clear();
+            address = 0;
+            file = 1;
+            line = 1;
+          }
+          else if(extended == DW_LNE_set_address)
+          {
+            if(len - 1 == 4 || addressSize == 4)
+              address = unit.Read<uint32_t>();
+            else
+              address = unit.Read<uint64_t>();
+          }
+
+          unit.cur = next;
+          break;
+        }
+        case DW_LNS_copy: emitRow(false); break;
+        case DW_LNS_advance_pc: address += unit.ReadULEB() * minInstLength; break;
+        case DW_LNS_advance_line: line += unit.ReadSLEB(); break;
+        case DW_LNS_set_file: file = unit.ReadULEB(); break;
+        case DW_LNS_set_column: unit.ReadULEB(); break;
+        case DW_LNS_negate_stmt:
+        case DW_LNS_set_basic_block:
+        case DW_LNS_set_prologue_end:
+        case DW_LNS_set_epilogue_begin: break;
+        case DW_LNS_const_add_pc: address += ((255 - opcodeBase) / lineRange) * minInstLength; break;
+        case DW_LNS_fixed_advance_pc: address += unit.Read<uint16_t>(); break;
+        case DW_LNS_set_isa: unit.ReadULEB(); break;
+        default:
+          // skip unknown standard opcodes using their declared operand counts
+          for(uint8_t i = 0; i < opcodeLengths[opcode - 1]; i++)
+            unit.ReadULEB();
+          break;
+      }
+    }
+  }
+}
+
+bool ElfSymbolizer::FileOffsetToAddress(uint64_t offset, uint64_t &address) const
+{
+  for(const LoadSegment &seg : m_Segments)
+  {
+    if(offset >= seg.offset && offset < seg.offset + seg.size)
+    {
+      address = offset - seg.offset + seg.address;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ElfSymbolizer::Resolve(uint64_t address, Callstack::AddressDetails &details) const
+{
+  bool found = false;
+
+  auto sym = std::upper_bound(m_Symbols.begin(), m_Symbols.end(), address,
+                              [](uint64_t addr, const Symbol &s) { return addr < s.address; });
+
+  if(sym != m_Symbols.begin())
+  {
+    --sym;
+
+    if(sym->size == 0 || address < sym->address + sym->size)
+    {
+      details.function = Demangle(sym->name);
+      found = true;
+    }
+  }
+
+  auto row = std::upper_bound(m_LineRows.begin(), m_LineRows.end(), address,
+                              [](uint64_t addr, const LineRow &r) { return addr < r.address; });
+
+  if(row != m_LineRows.begin())
+  {
+    --row;
+
+    if(!row->endSequence)
+    {
+      if(row->file < m_LineFiles.size())
+        details.filename = m_LineFiles[row->file];
+      details.line = row->line;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check DWARF line table parsing", "[symbolizer]")
+{
+  // a minimal version 4 line table for two files, with a sequence covering 0x1000-0x1020 and a
+  // discarded sequence at address 0.
+  std::vector<byte> unit = {
+      // version
+      4, 0,
+      // header_length, filled in below
+      0, 0, 0, 0,
+      // minimum_instruction_length, maximum_operations_per_instruction, default_is_stmt
+      1, 1, 1,
+      // line_base, line_range, opcode_base
+      byte(-5), 14, 13,
+      // standard_opcode_lengths
+      0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1,
+      // include_directories
+      '/', 's', 'r', 'c', 0, 0,
+      // file_names
+      'a', '.', 'c', 'p', 'p', 0, 1, 0, 0, 'b', '.', 'h', 0, 0, 0, 0, 0,
+  };
+
+  uint32_t headerLength = uint32_t(unit.size() - 6);
+  memcpy(&unit[2], &headerLength, sizeof(headerLength));
+
+  const byte program[] = {
+      // DW_LNE_set_address 0x1000
+      0, 9, DW_LNE_set_address, 0x00, 0x10, 0, 0, 0, 0, 0, 0,
+      // DW_LNS_advance_line 9, DW_LNS_copy -> line 10 at 0x1000
+      DW_LNS_advance_line, 9, DW_LNS_copy,
+      // DW_LNS_advance_pc 8, DW_LNS_advance_line 2, DW_LNS_copy -> line 12 at 0x1008
+      DW_LNS_advance_pc, 8, DW_LNS_advance_line, 2, DW_LNS_copy,
+      // DW_LNS_set_file 2, DW_LNS_advance_pc 8, DW_LNS_copy -> b.h line 12 at 0x1010
+      DW_LNS_set_file, 2, DW_LNS_advance_pc, 8, DW_LNS_copy,
+      // DW_LNS_advance_pc 16, DW_LNE_end_sequence at 0x1020
+      DW_LNS_advance_pc, 16, 0, 1, DW_LNE_end_sequence,
+      // a discarded sequence at address 0
+      0, 9, DW_LNE_set_address, 0, 0, 0, 0, 0, 0, 0, 0, DW_LNS_copy, DW_LNS_advance_pc, 4, 0, 1,
+      DW_LNE_end_sequence,
+  };
+
+  unit.insert(unit.end(), program, program + sizeof(program));
+
+  std::vector<byte> section(4);
+  uint32_t unitLength = uint32_t(unit.size());
+  memcpy(section.data(), &unitLength, sizeof(unitLength));
+  section.insert(section.end(), unit.begin(), unit.end());
+
+  std::vector<std::string> files;
+  std::vector<ElfSymbolizer::LineRow> rows;
+  ElfSymbolizer::ParseLineTables(section.data(), section.size(), NULL, 0, NULL, 0, files, rows);
+
+  REQUIRE(files.size() == 2);
+  CHECK(files[0] == "/src/a.cpp");
+  CHECK(files[1] == "b.h");
+
+  REQUIRE(rows.size() == 4);
+  CHECK(rows[0].address == 0x1000);
+  CHECK(rows[0].line == 10);
+  CHECK(rows[0].file == 0);
+  CHECK(rows[1].address == 0x1008);
+  CHECK(rows[1].line == 12);
+  CHECK(rows[2].address == 0x1010);
+  CHECK(rows[2].file == 1);
+  CHECK(rows[3].address == 0x1020);
+  CHECK(rows[3].endSequence);
+
+  // a truncated section must not read out of bounds
+  files.clear();
+  rows.clear();
+  ElfSymbolizer::ParseLineTables(section.data(), section.size() - 20, NULL, 0, NULL, 0, files, rows);
+  CHECK(rows.empty());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,108 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "os/os_specific.h"
+
+// Looks up function names and source lines in an ELF module, by reading its symbol tables and
+// DWARF line tables directly. If the module has been stripped, a separate debug file found via
+// its build-id or .gnu_debuglink is used instead.
+//
+// The module is mapped once and parsed into sorted tables, after which Resolve() only reads and is
+// safe to call from several threads at once.
+class ElfSymbolizer
+{
+public:
+  ElfSymbolizer(const std::string &path);
+  ~ElfSymbolizer();
+
+  bool IsValid() const { return m_Valid; }
+  // converts an offset into the module file, as listed in /proc/<pid>/maps, to the corresponding
+  // virtual address in the module.
+  bool FileOffsetToAddress(uint64_t offset, uint64_t &address) const;
+
+  // looks up the function and source line containing address. Returns false if neither could be
+  // found, in which case details is left untouched.
+  bool Resolve(uint64_t address, Callstack::AddressDetails &details) const;
+
+  // parses a .debug_line section. Exposed for testing.
+  struct LineRow
+  {
+    uint64_t address;
+    uint32_t file;
+    uint32_t line;
+    bool endSequence;
+  };
+
+  static void ParseLineTables(const byte *data, size_t size, const byte *lineStr,
+                              size_t lineStrSize, const byte *str, size_t strSize,
+                              std::vector<std::string> &files, std::vector<LineRow> &rows);
+
+private:
+  struct MappedFile
+  {
+    byte *data = NULL;
+    size_t size = 0;
+  };
+
+  struct Symbol
+  {
+    uint64_t address;
+    uint64_t size;
+    const char *name;
+  };
+
+  struct LoadSegment
+  {
+    uint64_t offset;
+    uint64_t address;
+    uint64_t size;
+  };
+
+  static bool MapFile(const std::string &path, MappedFile &file);
+  static void UnmapFile(MappedFile &file);
+
+  template <typename ElfTypes>
+  bool Parse(const MappedFile &file, bool primary);
+
+  std::string FindDebugFile(const std::string &path) const;
+
+  bool m_Valid = false;
+  bool m_HasSymtab = false;
+
+  std::vector<MappedFile> m_Files;
+  // decompressed copies of any compressed sections we read
+  std::vector<std::vector<byte>> m_DecompressedSections;
+
+  std::vector<LoadSegment> m_Segments;
+  std::vector<Symbol> m_Symbols;
+  std::vector<std::string> m_LineFiles;
+  std::vector<LineRow> m_LineRows;
+
+  std::vector<byte> m_BuildID;
+  std::string m_DebugLink;
+};
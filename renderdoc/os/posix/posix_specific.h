@@ -83,6 +83,14 @@ struct pthreadLockData
   pthread_mutexattr_t attr;
 };
 typedef CriticalSectionTemplate<pthreadLockData> CriticalSection;
+typedef RWLockTemplate<pthread_rwlock_t> RWLock;
+struct pthreadSemaphoreData
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t count;
+};
+typedef SemaphoreTemplate<pthreadSemaphoreData> Semaphore;
 };
 
 namespace Bits
@@ -98,4 +106,9 @@ inline uint64_t CountLeadingZeroes(uint64_t value)
   return value == 0 ? 64 : __builtin_clzl(value);
 }
 #endif
+
+inline uint32_t CountTrailingZeroes(uint32_t value)
+{
+  return value == 0 ? 32 : __builtin_ctz(value);
+}
 };
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -455,6 +456,11 @@ void ftruncateat(FILE *f, uint64_t length)
   ::ftruncate(fd, (off_t)length);
 }
 
+bool lockfile(FILE *f)
+{
+  return ::flock(::fileno(f), LOCK_EX) == 0;
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
@@ -465,6 +471,39 @@ int fclose(FILE *f)
   return ::fclose(f);
 }
 
+const byte *MapFile(const char *filename, uint64_t &size)
+{
+  size = 0;
+
+  int fd = open(filename, O_RDONLY);
+  if(fd < 0)
+    return NULL;
+
+  struct ::stat st = {};
+  if(fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  // the mapping keeps its own reference to the file, so we can close it straight away
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(data == MAP_FAILED)
+    return NULL;
+
+  size = (uint64_t)st.st_size;
+
+  return (const byte *)data;
+}
+
+void UnmapFile(const byte *data, uint64_t size)
+{
+  if(data)
+    munmap((void *)data, (size_t)size);
+}
+
 bool exists(const char *filename)
 {
   struct ::stat st;
@@ -64,6 +64,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return __sync_val_compare_and_swap(dest, oldVal, newVal);
 }
+
+void *CmpExchPtr(void *volatile *dest, void *oldVal, void *newVal)
+{
+  return __sync_val_compare_and_swap(dest, oldVal, newVal);
+}
 };
 
 namespace Threading
@@ -101,6 +106,80 @@ void CriticalSection::Unlock()
   pthread_mutex_unlock(&m_Data.lock);
 }
 
+template <>
+RWLock::RWLockTemplate()
+{
+  pthread_rwlock_init(&m_Data, NULL);
+}
+
+template <>
+RWLock::~RWLockTemplate()
+{
+  pthread_rwlock_destroy(&m_Data);
+}
+
+template <>
+void RWLock::WriteLock()
+{
+  pthread_rwlock_wrlock(&m_Data);
+}
+
+template <>
+void RWLock::WriteUnlock()
+{
+  pthread_rwlock_unlock(&m_Data);
+}
+
+template <>
+void RWLock::ReadLock()
+{
+  pthread_rwlock_rdlock(&m_Data);
+}
+
+template <>
+void RWLock::ReadUnlock()
+{
+  pthread_rwlock_unlock(&m_Data);
+}
+
+// pthread condition variables rather than sem_t, since unnamed semaphores aren't available on apple
+template <>
+Semaphore::SemaphoreTemplate()
+{
+  pthread_mutex_init(&m_Data.lock, NULL);
+  pthread_cond_init(&m_Data.cond, NULL);
+  m_Data.count = 0;
+}
+
+template <>
+Semaphore::~SemaphoreTemplate()
+{
+  pthread_cond_destroy(&m_Data.cond);
+  pthread_mutex_destroy(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Wake(uint32_t count)
+{
+  pthread_mutex_lock(&m_Data.lock);
+  m_Data.count += count;
+  if(count == 1)
+    pthread_cond_signal(&m_Data.cond);
+  else
+    pthread_cond_broadcast(&m_Data.cond);
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Wait()
+{
+  pthread_mutex_lock(&m_Data.lock);
+  while(m_Data.count == 0)
+    pthread_cond_wait(&m_Data.cond, &m_Data.lock);
+  m_Data.count--;
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -243,4 +322,11 @@ void Sleep(uint32_t milliseconds)
 {
   usleep(milliseconds * 1000);
 }
+
+uint32_t GetNumCores()
+{
+  long ret = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return ret > 0 ? (uint32_t)ret : 1;
+}
 };
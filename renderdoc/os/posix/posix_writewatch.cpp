@@ -0,0 +1,497 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "common/threading.h"
+#include "os/os_specific.h"
+
+// Write watching is implemented by write-protecting every whole page in a watched region. The first
+// write to a page faults, and our SIGSEGV handler marks the page dirty and makes it writeable
+// again so the write can continue. Fetching the dirty ranges re-protects the dirty pages.
+//
+// Only writes from user code fault. When the kernel writes into a protected page on the program's
+// behalf, e.g. read(2) or recv(2) directly into a mapped buffer, the system call fails with EFAULT
+// instead and the program's I/O fails. This is why it's opt-in with RENDERDOC_WRITE_WATCH=1, and
+// should only be enabled for programs that don't do I/O straight into mapped memory.
+//
+// The fault handler must be async-signal-safe, so regions live in a fixed-size table and the
+// handler only reads the table and sets flags. Registration and unregistration are serialised by
+// a lock and never free anything the handler could be looking at.
+
+namespace
+{
+static const int32_t MaxRegions = 256;
+
+enum RegionState
+{
+  RegionFree = 0,
+  RegionBusy = 1,
+  RegionActive = 2,
+};
+
+struct WatchedRegion
+{
+  volatile int32_t state;
+
+  // the registered pointer and size
+  byte *base;
+  size_t size;
+
+  // the whole pages within the region, which are the only ones protected
+  uintptr_t firstPage;
+  size_t numPages;
+
+  // one flag per page, non-zero if the page has been written
+  volatile int32_t *dirty;
+};
+
+WatchedRegion regions[MaxRegions] = {};
+
+// the number of fault handlers currently running, so we don't free a region under them
+volatile int32_t handlersRunning = 0;
+
+uintptr_t pageSize = 0;
+
+// -1 until checked, then whether write watching is enabled
+int enabled = -1;
+
+Threading::CriticalSection regionLock;
+bool handlerInstalled = false;
+struct sigaction prevHandler = {};
+
+void WriteFaultHandler(int sig, siginfo_t *info, void *context)
+{
+  __sync_add_and_fetch(&handlersRunning, 1);
+
+  uintptr_t page = uintptr_t(info->si_addr) & ~(pageSize - 1);
+
+  bool handled = false;
+
+  for(int32_t i = 0; i < MaxRegions; i++)
+  {
+    WatchedRegion &r = regions[i];
+
+    if(r.state != RegionActive || page < r.firstPage || page >= r.firstPage + r.numPages * pageSize)
+      continue;
+
+    // make the page writeable before marking it dirty. If we raced with GetDirtyRanges the page is
+    // either still dirty and will be re-protected, or it's re-protected and the write will fault
+    // again.
+    if(!handled)
+      mprotect((void *)page, pageSize, PROT_READ | PROT_WRITE);
+
+    handled = true;
+
+    __sync_lock_test_and_set(&r.dirty[(page - r.firstPage) / pageSize], 1);
+  }
+
+  // a region being registered or unregistered can't be checked, but Unregister makes its pages
+  // writeable before it's marked busy. Return to retry the write, which either succeeds or faults
+  // again once no region is busy and it can be checked properly.
+  if(!handled)
+  {
+    for(int32_t i = 0; i < MaxRegions; i++)
+    {
+      if(regions[i].state == RegionBusy)
+      {
+        handled = true;
+        break;
+      }
+    }
+  }
+
+  __sync_sub_and_fetch(&handlersRunning, 1);
+
+  if(handled)
+    return;
+
+  // not one of ours, pass it on to whoever was there before
+  if(prevHandler.sa_flags & SA_SIGINFO)
+  {
+    prevHandler.sa_sigaction(sig, info, context);
+  }
+  else if(prevHandler.sa_handler == SIG_DFL || prevHandler.sa_handler == SIG_IGN)
+  {
+    // restore the default behaviour and return, so that the faulting instruction runs again and
+    // the process crashes as it would have without us.
+    signal(sig, SIG_DFL);
+  }
+  else
+  {
+    prevHandler.sa_handler(sig);
+  }
+}
+
+WatchedRegion *FindRegion(void *base)
+{
+  for(int32_t i = 0; i < MaxRegions; i++)
+    if(regions[i].state == RegionActive && regions[i].base == base)
+      return &regions[i];
+
+  return NULL;
+}
+};
+
+bool WriteWatch::IsEnabled()
+{
+#if ENABLED(RDOC_LINUX)
+  if(enabled == -1)
+  {
+    // opt-in, since system calls writing into watched memory fail with EFAULT. See above.
+    const char *var = Process::GetEnvVariable("RENDERDOC_WRITE_WATCH");
+    enabled = (var && var[0] == '1') ? 1 : 0;
+
+    if(enabled)
+      RDCLOG("Using page protection to watch writes to persistently mapped memory");
+  }
+
+  return enabled == 1;
+#else
+  return false;
+#endif
+}
+
+size_t WriteWatch::GetPageSize()
+{
+  return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+bool WriteWatch::Register(void *base, size_t size)
+{
+  if(!IsEnabled() || base == NULL || size == 0)
+    return false;
+
+  SCOPED_LOCK(regionLock);
+
+  if(!handlerInstalled)
+  {
+    pageSize = (uintptr_t)GetPageSize();
+
+    struct sigaction action = {};
+    action.sa_sigaction = &WriteFaultHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if(sigaction(SIGSEGV, &action, &prevHandler) != 0)
+    {
+      RDCERR("Couldn't install write watch fault handler: %d", errno);
+      return false;
+    }
+
+    handlerInstalled = true;
+  }
+
+  WatchedRegion *region = NULL;
+
+  for(int32_t i = 0; i < MaxRegions; i++)
+  {
+    if(regions[i].state == RegionFree)
+    {
+      region = &regions[i];
+      break;
+    }
+  }
+
+  if(region == NULL)
+  {
+    RDCWARN("Too many regions being write-watched, falling back to full comparisons");
+    return false;
+  }
+
+  // mapped pointers needn't be page aligned, and protecting a partial page would also protect
+  // whatever else shares it.
+  uintptr_t firstPage = (uintptr_t(base) + pageSize - 1) & ~(pageSize - 1);
+  uintptr_t endPage = (uintptr_t(base) + size) & ~(pageSize - 1);
+
+  if(endPage <= firstPage)
+    return false;
+
+  region->state = RegionBusy;
+
+  region->base = (byte *)base;
+  region->size = size;
+  region->firstPage = firstPage;
+  region->numPages = (endPage - firstPage) / pageSize;
+
+  // everything starts out dirty and writeable, so the first GetDirtyRanges returns the whole
+  // region and protects it.
+  int32_t *dirty = new int32_t[region->numPages];
+  for(size_t p = 0; p < region->numPages; p++)
+    dirty[p] = 1;
+
+  region->dirty = dirty;
+
+  __sync_synchronize();
+
+  region->state = RegionActive;
+
+  return true;
+}
+
+void WriteWatch::Unregister(void *base)
+{
+  if(!IsEnabled())
+    return;
+
+  SCOPED_LOCK(regionLock);
+
+  WatchedRegion *region = FindRegion(base);
+
+  if(!region)
+    return;
+
+  // make everything writeable first, while the region is still active, so that nothing can fault
+  // on one of its pages once the handler stops looking at it.
+  mprotect((void *)region->firstPage, region->numPages * pageSize, PROT_READ | PROT_WRITE);
+
+  region->state = RegionBusy;
+
+  __sync_synchronize();
+
+  // wait for any handler that might have seen the region as active
+  while(handlersRunning > 0)
+    Threading::Sleep(0);
+
+  delete[] region->dirty;
+  region->dirty = NULL;
+  region->base = NULL;
+
+  __sync_synchronize();
+
+  region->state = RegionFree;
+}
+
+bool WriteWatch::GetDirtyRanges(void *base, std::vector<Range> &ranges)
+{
+  ranges.clear();
+
+  if(!IsEnabled())
+    return false;
+
+  SCOPED_LOCK(regionLock);
+
+  WatchedRegion *region = FindRegion(base);
+
+  if(!region)
+    return false;
+
+  uintptr_t regionStart = uintptr_t(region->base);
+  uintptr_t regionEnd = regionStart + region->size;
+  uintptr_t watchedEnd = region->firstPage + region->numPages * pageSize;
+
+  // the partial pages at either end aren't protected, so they're always dirty. Runs of dirty pages
+  // that touch them are merged in.
+  if(region->firstPage > regionStart)
+    ranges.push_back({0, size_t(region->firstPage - regionStart)});
+
+  size_t p = 0;
+  while(p < region->numPages)
+  {
+    // clear the flag before re-protecting. Any write that lands in between is still before we
+    // return, so the caller will see it when it compares.
+    if(__sync_lock_test_and_set(&region->dirty[p], 0) == 0)
+    {
+      p++;
+      continue;
+    }
+
+    size_t runStart = p++;
+
+    while(p < region->numPages && __sync_lock_test_and_set(&region->dirty[p], 0) != 0)
+      p++;
+
+    uintptr_t start = region->firstPage + runStart * pageSize;
+    uintptr_t end = region->firstPage + p * pageSize;
+
+    mprotect((void *)start, end - start, PROT_READ);
+
+    Range range;
+    range.start = size_t(start - regionStart);
+    range.end = size_t(end - regionStart);
+
+    if(!ranges.empty() && ranges.back().end == range.start)
+      ranges.back().end = range.end;
+    else
+      ranges.push_back(range);
+  }
+
+  if(watchedEnd < regionEnd)
+  {
+    Range tail = {size_t(watchedEnd - regionStart), size_t(regionEnd - regionStart)};
+
+    if(!ranges.empty() && ranges.back().end == tail.start)
+      ranges.back().end = tail.end;
+    else
+      ranges.push_back(tail);
+  }
+
+  return true;
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check write watching", "[writewatch]")
+{
+#if ENABLED(RDOC_LINUX)
+  // write watching is opt-in for capturing, but always test it where it's implemented
+  int wasEnabled = WriteWatch::IsEnabled() ? 1 : 0;
+  enabled = 1;
+#else
+  if(!WriteWatch::IsEnabled())
+    return;
+#endif
+
+  const size_t page = WriteWatch::GetPageSize();
+  const size_t size = page * 16;
+
+  byte *mem = AllocAlignedBuffer(size, page);
+  memset(mem, 0, size);
+
+  std::vector<WriteWatch::Range> ranges;
+
+  REQUIRE(WriteWatch::Register(mem, size));
+
+  // initially everything is dirty
+  CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+  REQUIRE(ranges.size() == 1);
+  CHECK(ranges[0].start == 0);
+  CHECK(ranges[0].end == size);
+
+  // nothing written since
+  CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+  CHECK(ranges.empty());
+
+  // write to two adjacent pages and one separate page
+  mem[page * 3 + 10] = 1;
+  mem[page * 4] = 2;
+  mem[page * 10 + page - 1] = 3;
+
+  CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+  REQUIRE(ranges.size() == 2);
+  CHECK(ranges[0].start == page * 3);
+  CHECK(ranges[0].end == page * 5);
+  CHECK(ranges[1].start == page * 10);
+  CHECK(ranges[1].end == page * 11);
+
+  // writes must have landed
+  CHECK(mem[page * 3 + 10] == 1);
+  CHECK(mem[page * 4] == 2);
+  CHECK(mem[page * 10 + page - 1] == 3);
+
+  // pages are watched again after being returned
+  mem[page * 4] = 4;
+
+  CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+  REQUIRE(ranges.size() == 1);
+  CHECK(ranges[0].start == page * 4);
+  CHECK(ranges[0].end == page * 5);
+
+  WriteWatch::Unregister(mem);
+
+  // memory is writeable and no longer tracked
+  mem[0] = 5;
+  CHECK_FALSE(WriteWatch::GetDirtyRanges(mem, ranges));
+
+  // a region that isn't page aligned, like a mapping at an offset into an allocation
+  byte *unaligned = mem + page + 100;
+  const size_t unalignedSize = page * 4;
+
+  REQUIRE(WriteWatch::Register(unaligned, unalignedSize));
+
+  CHECK(WriteWatch::GetDirtyRanges(unaligned, ranges));
+  REQUIRE(ranges.size() == 1);
+  CHECK(ranges[0].start == 0);
+  CHECK(ranges[0].end == unalignedSize);
+
+  // the partial first and last pages are always dirty, whole pages are only dirty once written
+  CHECK(WriteWatch::GetDirtyRanges(unaligned, ranges));
+  REQUIRE(ranges.size() == 2);
+  CHECK(ranges[0].start == 0);
+  CHECK(ranges[0].end == page - 100);
+  CHECK(ranges[1].start == page * 3 + page - 100);
+  CHECK(ranges[1].end == unalignedSize);
+
+  unaligned[page * 2] = 6;
+
+  CHECK(WriteWatch::GetDirtyRanges(unaligned, ranges));
+  REQUIRE(ranges.size() == 3);
+  CHECK(ranges[1].start == page * 2 - 100);
+  CHECK(ranges[1].end == page * 3 - 100);
+
+  // memory sharing the partial pages isn't protected
+  mem[page] = 7;
+  mem[page * 5 + 50] = 8;
+  CHECK(mem[page] == 7);
+
+  WriteWatch::Unregister(unaligned);
+
+  // regions without a whole page can't be watched
+  CHECK_FALSE(WriteWatch::Register(mem + 100, page));
+
+  // a fault that raced with Unregister finds the region busy rather than active. Its pages are
+  // already writeable so the handler must just return to retry the write, and stay installed.
+  {
+    REQUIRE(WriteWatch::Register(mem, size));
+
+    WatchedRegion *region = FindRegion(mem);
+    REQUIRE(region);
+
+    mprotect((void *)region->firstPage, region->numPages * pageSize, PROT_READ | PROT_WRITE);
+    region->state = RegionBusy;
+
+    siginfo_t info = {};
+    info.si_addr = mem + page * 2;
+    WriteFaultHandler(SIGSEGV, &info, NULL);
+
+    struct sigaction current = {};
+    sigaction(SIGSEGV, NULL, &current);
+    CHECK(current.sa_sigaction == &WriteFaultHandler);
+
+    region->state = RegionActive;
+    WriteWatch::Unregister(mem);
+
+    // watching still works afterwards
+    REQUIRE(WriteWatch::Register(mem, size));
+    CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+    mem[page * 2] = 9;
+    CHECK(WriteWatch::GetDirtyRanges(mem, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].start == page * 2);
+    WriteWatch::Unregister(mem);
+  }
+
+  FreeAlignedBuffer(mem);
+
+#if ENABLED(RDOC_LINUX)
+  enabled = wasEnabled;
+#endif
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -1582,3 +1582,32 @@ uint32_t Process::GetCurrentPID()
 {
   return (uint32_t)GetCurrentProcessId();
 }
+
+// write watching isn't implemented on windows yet, callers fall back to full comparisons
+bool WriteWatch::IsEnabled()
+{
+  return false;
+}
+
+size_t WriteWatch::GetPageSize()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+
+  return (size_t)info.dwPageSize;
+}
+
+bool WriteWatch::Register(void *base, size_t size)
+{
+  return false;
+}
+
+void WriteWatch::Unregister(void *base)
+{
+}
+
+bool WriteWatch::GetDirtyRanges(void *base, std::vector<Range> &ranges)
+{
+  ranges.clear();
+  return false;
+}
@@ -618,6 +618,19 @@ void ftruncateat(FILE *f, uint64_t length)
   ::_chsize_s(fd, (int64_t)length);
 }
 
+bool lockfile(FILE *f)
+{
+  HANDLE h = (HANDLE)::_get_osfhandle(::_fileno(f));
+
+  // file locks on windows are mandatory, so lock a byte far beyond the end of any real file so that
+  // reads and writes aren't blocked.
+  OVERLAPPED overlapped = {};
+  overlapped.Offset = 0xffffffff;
+  overlapped.OffsetHigh = 0x7fffffff;
+
+  return LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped) == TRUE;
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
@@ -628,6 +641,48 @@ int fclose(FILE *f)
   return ::fclose(f);
 }
 
+const byte *MapFile(const char *filename, uint64_t &size)
+{
+  size = 0;
+
+  wstring wfn = StringFormat::UTF82Wide(string(filename));
+  HANDLE file = CreateFileW(wfn.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  LARGE_INTEGER fileSize = {};
+  if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+
+  if(mapping == NULL)
+    return NULL;
+
+  // the view keeps the mapping alive, so we don't need to hold onto either handle
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+
+  if(data == NULL)
+    return NULL;
+
+  size = (uint64_t)fileSize.QuadPart;
+
+  return (const byte *)data;
+}
+
+void UnmapFile(const byte *data, uint64_t size)
+{
+  if(data)
+    UnmapViewOfFile(data);
+}
+
 static HANDLE logHandle = NULL;
 
 bool logfile_open(const char *filename)
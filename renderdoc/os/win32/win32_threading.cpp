@@ -77,6 +77,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return (int32_t)InterlockedCompareExchange((volatile LONG *)dest, newVal, oldVal);
 }
+
+void *CmpExchPtr(void *volatile *dest, void *oldVal, void *newVal)
+{
+  return InterlockedCompareExchangePointer(dest, newVal, oldVal);
+}
 };
 
 namespace Threading
@@ -106,6 +111,55 @@ void CriticalSection::Unlock()
   LeaveCriticalSection(&m_Data);
 }
 
+RWLock::RWLockTemplate()
+{
+  InitializeSRWLock(&m_Data);
+}
+
+RWLock::~RWLockTemplate()
+{
+}
+
+void RWLock::WriteLock()
+{
+  AcquireSRWLockExclusive(&m_Data);
+}
+
+void RWLock::WriteUnlock()
+{
+  ReleaseSRWLockExclusive(&m_Data);
+}
+
+void RWLock::ReadLock()
+{
+  AcquireSRWLockShared(&m_Data);
+}
+
+void RWLock::ReadUnlock()
+{
+  ReleaseSRWLockShared(&m_Data);
+}
+
+Semaphore::SemaphoreTemplate()
+{
+  m_Data = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL);
+}
+
+Semaphore::~SemaphoreTemplate()
+{
+  CloseHandle(m_Data);
+}
+
+void Semaphore::Wake(uint32_t count)
+{
+  ReleaseSemaphore(m_Data, (LONG)count, NULL);
+}
+
+void Semaphore::Wait()
+{
+  WaitForSingleObject(m_Data, INFINITE);
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -251,4 +305,12 @@ void Sleep(uint32_t milliseconds)
 {
   ::Sleep((DWORD)milliseconds);
 }
+
+uint32_t GetNumCores()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
 };
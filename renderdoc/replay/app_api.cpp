@@ -26,6 +26,7 @@
 #include "api/app/renderdoc_app.h"
 #include "api/replay/renderdoc_replay.h"    // for RENDERDOC_API to export the RENDERDOC_GetAPI function
 #include "common/common.h"
+#include "core/capture_writer.h"
 #include "core/core.h"
 #include "hooks/hooks.h"
 
@@ -73,11 +74,16 @@ static const char *GetCaptureFilePathTemplate()
 
 static uint32_t GetNumCaptures()
 {
+  // captures are written in the background, make sure they're all complete before returning them
+  CaptureWriter::WaitForPendingWrites();
+
   return (uint32_t)RenderDoc::Inst().GetCaptures().size();
 }
 
 static uint32_t GetCapture(uint32_t idx, char *filename, uint32_t *pathlength, uint64_t *timestamp)
 {
+  CaptureWriter::WaitForPendingWrites();
+
   vector<CaptureData> caps = RenderDoc::Inst().GetCaptures();
 
   if(idx >= (uint32_t)caps.size())
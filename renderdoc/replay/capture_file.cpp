@@ -180,6 +180,7 @@ private:
 
   RDCFile *m_RDC = NULL;
   Callstack::StackResolver *m_Resolver = NULL;
+  std::string m_ResolveCachePath;
 
   SDFile m_StructuredData;
 
@@ -193,6 +194,9 @@ CaptureFile::CaptureFile()
 
 CaptureFile::~CaptureFile()
 {
+  if(m_Resolver)
+    m_Resolver->SaveCache(m_ResolveCachePath.c_str());
+
   SAFE_DELETE(m_RDC);
   SAFE_DELETE(m_Resolver);
 }
@@ -473,7 +477,7 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
     }
 
     SectionProperties frameCapture;
-    frameCapture.flags = SectionFlags::ZstdCompressed;
+    frameCapture.flags = SectionFlags::ZstdCompressed | SectionFlags::BlockIndexed;
     frameCapture.type = SectionType::FrameCapture;
     frameCapture.name = ToStr(frameCapture.type);
     frameCapture.version = file->version;
@@ -494,7 +498,7 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
   {
     // otherwise write it straight, but compress it to zstd
     SectionProperties props = m_RDC->GetSectionProperties(frameCaptureIndex);
-    props.flags = SectionFlags::ZstdCompressed;
+    props.flags = SectionFlags::ZstdCompressed | SectionFlags::BlockIndexed;
 
     StreamWriter *writer = output.WriteSection(props);
     StreamReader *reader = m_RDC->ReadSection(frameCaptureIndex);
@@ -776,6 +780,9 @@ bool CaptureFile::InitResolver(RENDERDOC_ProgressCallback progress)
     return false;
   }
 
+  m_ResolveCachePath = Callstack::GetResolveCacheFilename(buf.data(), buf.size());
+  m_Resolver->LoadCache(m_ResolveCachePath.c_str());
+
   return true;
 }
 
@@ -792,12 +799,12 @@ rdcarray<rdcstr> CaptureFile::GetResolve(const rdcarray<uint64_t> &callstack)
     return ret;
   }
 
+  std::vector<Callstack::AddressDetails> details(callstack.size());
+  m_Resolver->GetAddrs(callstack.data(), callstack.size(), details.data());
+
   ret.reserve(callstack.size());
-  for(uint64_t frame : callstack)
-  {
-    Callstack::AddressDetails info = m_Resolver->GetAddr(frame);
+  for(Callstack::AddressDetails &info : details)
     ret.push_back(info.formattedString());
-  }
 
   return ret;
 }
@@ -354,14 +354,36 @@ void DoSerialise(SerialiserType &ser, ShaderDebugState &el)
   SIZE_CHECK(56);
 }
 
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, ShaderVariableChange &el)
+{
+  SERIALISE_MEMBER(index);
+  SERIALISE_MEMBER(value.u64v);
+
+  SIZE_CHECK(136);
+}
+
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, ShaderDebugStep &el)
+{
+  SERIALISE_MEMBER(nextInstruction);
+  SERIALISE_MEMBER(flags);
+  SERIALISE_MEMBER(keyframe);
+  SERIALISE_MEMBER(firstChange);
+
+  SIZE_CHECK(16);
+}
+
 template <typename SerialiserType>
 void DoSerialise(SerialiserType &ser, ShaderDebugTrace &el)
 {
   SERIALISE_MEMBER(inputs);
   SERIALISE_MEMBER(constantBlocks);
-  SERIALISE_MEMBER(states);
+  SERIALISE_MEMBER(steps);
+  SERIALISE_MEMBER(keyframes);
+  SERIALISE_MEMBER(changes);
 
-  SIZE_CHECK(48);
+  SIZE_CHECK(80);
 }
 
 template <typename SerialiserType>
@@ -2095,6 +2117,8 @@ INSTANTIATE_SERIALISE_TYPE(ShaderDebugInfo)
 INSTANTIATE_SERIALISE_TYPE(ShaderReflection)
 INSTANTIATE_SERIALISE_TYPE(ShaderVariable)
 INSTANTIATE_SERIALISE_TYPE(ShaderDebugState)
+INSTANTIATE_SERIALISE_TYPE(ShaderVariableChange)
+INSTANTIATE_SERIALISE_TYPE(ShaderDebugStep)
 INSTANTIATE_SERIALISE_TYPE(ShaderDebugTrace)
 INSTANTIATE_SERIALISE_TYPE(ResourceDescription)
 INSTANTIATE_SERIALISE_TYPE(TextureDescription)
@@ -26,7 +26,9 @@
 #include "replay_controller.h"
 #include <string.h>
 #include <time.h>
+#include <deque>
 #include "common/dds_readwrite.h"
+#include "common/threading.h"
 #include "driver/ihv/amd/amd_isa.h"
 #include "driver/ihv/amd/amd_rgp.h"
 #include "jpeg-compressor/jpgd.h"
@@ -277,6 +279,18 @@ const SDFile &ReplayController::GetStructuredFile()
   return m_pDevice->GetStructuredFile();
 }
 
+const SDChunk *ReplayController::GetStructuredChunk(uint32_t chunkIndex)
+{
+  const SDFile &file = m_pDevice->GetStructuredFile();
+
+  if(chunkIndex >= file.chunks.size())
+    return NULL;
+
+  m_pDevice->LoadStructuredChunk(chunkIndex);
+
+  return file.chunks[chunkIndex];
+}
+
 DrawcallDescription *ReplayController::GetDrawcallByEID(uint32_t eventId)
 {
   if(eventId >= m_Drawcalls.size())
@@ -399,9 +413,98 @@ bytebuf ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint
   return ret;
 }
 
-bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
+// everything needed to write a texture to disk once its data has been read back, so that encoding
+// doesn't need the replay device.
+struct TextureSaveJob
+{
+  TextureSaveJob() = default;
+  TextureSaveJob(const TextureSaveJob &) = delete;
+  TextureSaveJob &operator=(const TextureSaveJob &) = delete;
+  ~TextureSaveJob()
+  {
+    for(byte *b : subdata)
+      delete[] b;
+  }
+
+  TextureSave sd;
+  TextureDescription td;
+  vector<byte *> subdata;
+  uint32_t rowPitch = 0;
+  uint32_t numMips = 1;
+  uint32_t numSlices = 1;
+  bool singleSlice = false;
+};
+
+static bool EncodeSavedTexture(TextureSaveJob &job, const char *path);
+
+// encodes and writes texture save jobs on the shared job pool. The number in flight is capped so
+// that read-back data can't build up faster than it's written out.
+class TextureSaveQueue
+{
+public:
+  TextureSaveQueue(uint32_t maxJobs) : m_MaxJobs(maxJobs) {}
+  ~TextureSaveQueue() { Finish(); }
+  // takes ownership of the job, and writes the result to success once it's done
+  void Push(TextureSaveJob *job, const std::string &path, bool *success)
+  {
+    if(m_MaxJobs == 0)
+    {
+      *success = EncodeSavedTexture(*job, path.c_str());
+      delete job;
+      return;
+    }
+
+    while(m_InFlight.size() >= m_MaxJobs)
+      Complete();
+
+    InFlight *work = new InFlight;
+    work->save = job;
+    work->path = path;
+    work->success = success;
+    work->job = Threading::JobPool::Shared().Submit(
+        [work]() { work->result = EncodeSavedTexture(*work->save, work->path.c_str()); });
+
+    m_InFlight.push_back(work);
+  }
+
+  // wait for all pending jobs to complete
+  void Finish()
+  {
+    while(!m_InFlight.empty())
+      Complete();
+  }
+
+private:
+  struct InFlight
+  {
+    Threading::JobPool::JobHandle job;
+    TextureSaveJob *save;
+    std::string path;
+    bool *success;
+    bool result = false;
+  };
+
+  void Complete()
+  {
+    InFlight *work = m_InFlight.front();
+    m_InFlight.pop_front();
+
+    Threading::JobPool::Shared().Wait(work->job);
+
+    *work->success = work->result;
+
+    delete work->save;
+    delete work;
+  }
+
+  uint32_t m_MaxJobs;
+  std::deque<InFlight *> m_InFlight;
+};
+
+bool ReplayController::FetchTextureForSave(const TextureSave &saveData, TextureSaveJob &job)
 {
-  TextureSave sd = saveData;    // mutable copy
+  TextureSave &sd = job.sd;
+  sd = saveData;    // mutable copy
   ResourceId liveid = m_pDevice->GetLiveID(sd.resourceId);
 
   if(liveid == ResourceId())
@@ -410,9 +513,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     return false;
   }
 
-  TextureDescription td = m_pDevice->GetTexture(liveid);
-
-  bool success = false;
+  TextureDescription &td = job.td;
+  td = m_pDevice->GetTexture(liveid);
 
   // clamp sample/mip/slice indices
   if(td.msSamp == 1)
@@ -493,12 +595,15 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   // down a multisampled texture for writing as a single 'image' elsewhere)
   uint32_t sliceOffset = 0;
   uint32_t sliceStride = 1;
-  uint32_t numSlices = td.arraysize * td.depth;
+  uint32_t &numSlices = job.numSlices;
+  numSlices = td.arraysize * td.depth;
 
   uint32_t mipOffset = 0;
-  uint32_t numMips = td.mips;
+  uint32_t &numMips = job.numMips;
+  numMips = td.mips;
 
-  bool singleSlice = (sd.slice.sliceIndex != -1);
+  bool &singleSlice = job.singleSlice;
+  singleSlice = (sd.slice.sliceIndex != -1);
 
   // set which slices/mips we need
   if(multisampled)
@@ -560,7 +665,7 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     // otherwise take all mips, as by default
   }
 
-  vector<byte *> subdata;
+  vector<byte *> &subdata = job.subdata;
 
   bool downcast = false;
 
@@ -596,7 +701,7 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     td.format.type = ResourceFormatType::Regular;
   }
 
-  uint32_t rowPitch = 0;
+  uint32_t &rowPitch = job.rowPitch;
   uint32_t slicePitch = 0;
 
   bool blockformat = false;
@@ -668,10 +773,6 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       if(data.empty())
       {
         RDCERR("Couldn't get bytes for mip %u, slice %u", mip, slice);
-
-        for(size_t i = 0; i < subdata.size(); i++)
-          delete[] subdata[i];
-
         return false;
       }
 
@@ -730,6 +831,21 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     }
   }
 
+  return true;
+}
+
+static bool EncodeSavedTexture(TextureSaveJob &job, const char *path)
+{
+  TextureSave &sd = job.sd;
+  TextureDescription &td = job.td;
+  vector<byte *> &subdata = job.subdata;
+  uint32_t &rowPitch = job.rowPitch;
+  const uint32_t numMips = job.numMips;
+  const uint32_t numSlices = job.numSlices;
+  const bool singleSlice = job.singleSlice;
+
+  bool success = false;
+
   // should have been handled above, but verify incoming data is RGBA8
   if(sd.slice.slicesAsGrid && td.format.compByteWidth == 1 && td.format.compCount == 4)
   {
@@ -756,15 +872,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       uint32_t xoffs = gridx * sliceWidth;
 
       for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
-          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
-
-          *dstpix = *srcpix;
-        }
-      }
+        memcpy(&combinedData[((y + yoffs) * td.width + xoffs) * 4], &subdata[i][y * sliceWidth * 4],
+               sliceWidth * 4);
 
       delete[] subdata[i];
     }
@@ -812,15 +921,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       uint32_t xoffs = gridx[i] * sliceWidth;
 
       for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
-          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
-
-          *dstpix = *srcpix;
-        }
-      }
+        memcpy(&combinedData[((y + yoffs) * td.width + xoffs) * 4], &subdata[i][y * sliceWidth * 4],
+               sliceWidth * 4);
 
       delete[] subdata[i];
     }
@@ -862,6 +964,19 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   {
     byte *nonalpha = new byte[td.width * td.height * 3];
 
+    // the background colours are constant, so convert them to gamma space once up front
+    Vec4f bgCol[3] = {
+        Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z), RenderDoc::Inst().LightCheckerboardColor(),
+        RenderDoc::Inst().DarkCheckerboardColor(),
+    };
+
+    for(Vec4f &col : bgCol)
+    {
+      col.x = powf(col.x, 1.0f / 2.2f);
+      col.y = powf(col.y, 1.0f / 2.2f);
+      col.z = powf(col.z, 1.0f / 2.2f);
+    }
+
     for(uint32_t y = 0; y < td.height; y++)
     {
       for(uint32_t x = 0; x < td.width; x++)
@@ -873,24 +988,19 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
 
         if(sd.alpha != AlphaMapping::Discard)
         {
-          Vec4f col = Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z);
+          const Vec4f *col = &bgCol[0];
           if(sd.alpha == AlphaMapping::BlendToCheckerboard)
           {
             bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
-            col = lightSquare ? RenderDoc::Inst().LightCheckerboardColor()
-                              : RenderDoc::Inst().DarkCheckerboardColor();
+            col = lightSquare ? &bgCol[1] : &bgCol[2];
           }
 
-          col.x = powf(col.x, 1.0f / 2.2f);
-          col.y = powf(col.y, 1.0f / 2.2f);
-          col.z = powf(col.z, 1.0f / 2.2f);
-
           FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f,
                                           float(a) / 255.0f);
 
-          pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
-          pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
-          pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
+          pixel.x = pixel.x * pixel.w + col->x * (1.0f - pixel.w);
+          pixel.y = pixel.y * pixel.w + col->y * (1.0f - pixel.w);
+          pixel.z = pixel.z * pixel.w + col->z * (1.0f - pixel.w);
 
           r = byte(pixel.x * 255.0f);
           g = byte(pixel.y * 255.0f);
@@ -1058,54 +1168,79 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       if(saveFmt.compType == CompType::Depth && pixStride == 3)
         pixStride = 4;
 
+      std::vector<float> rowData(td.width * 4);
+
       for(uint32_t y = 0; y < td.height; y++)
       {
-        for(uint32_t x = 0; x < td.width; x++)
-        {
-          float r = 0.0f;
-          float g = 0.0f;
-          float b = 0.0f;
-          float a = 1.0f;
+        float *rgba = rowData.data();
 
-          if(saveFmt.type == ResourceFormatType::R10G10B10A2)
+        // common formats are converted a whole row at a time, anything else goes pixel by pixel
+        if(ConvertPixelsToFloat4(saveFmt, srcData, td.width, rgba))
+        {
+          srcData += pixStride * td.width;
+        }
+        else
+        {
+          for(uint32_t x = 0; x < td.width; x++)
           {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec4f vec = ConvertFromR10G10B10A2(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = vec.w;
-
-            srcData += 4;
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            float a = 1.0f;
+
+            if(saveFmt.type == ResourceFormatType::R10G10B10A2)
+            {
+              uint32_t *u32 = (uint32_t *)srcData;
+
+              Vec4f vec = ConvertFromR10G10B10A2(*u32);
+
+              r = vec.x;
+              g = vec.y;
+              b = vec.z;
+              a = vec.w;
+
+              srcData += 4;
+            }
+            else if(saveFmt.type == ResourceFormatType::R11G11B10)
+            {
+              uint32_t *u32 = (uint32_t *)srcData;
+
+              Vec3f vec = ConvertFromR11G11B10(*u32);
+
+              r = vec.x;
+              g = vec.y;
+              b = vec.z;
+              a = 1.0f;
+
+              srcData += 4;
+            }
+            else
+            {
+              if(saveFmt.compCount >= 1)
+                r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
+              if(saveFmt.compCount >= 2)
+                g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
+              if(saveFmt.compCount >= 3)
+                b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
+              if(saveFmt.compCount >= 4)
+                a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
+
+              srcData += pixStride;
+            }
+
+            rgba[x * 4 + 0] = r;
+            rgba[x * 4 + 1] = g;
+            rgba[x * 4 + 2] = b;
+            rgba[x * 4 + 3] = a;
           }
-          else if(saveFmt.type == ResourceFormatType::R11G11B10)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec3f vec = ConvertFromR11G11B10(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = 1.0f;
+        }
 
-            srcData += 4;
-          }
-          else
-          {
-            if(saveFmt.compCount >= 1)
-              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
-            if(saveFmt.compCount >= 2)
-              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
-            if(saveFmt.compCount >= 3)
-              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
-            if(saveFmt.compCount >= 4)
-              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
-
-            srcData += pixStride;
-          }
+        for(uint32_t x = 0; x < td.width; x++)
+        {
+          float r = rgba[x * 4 + 0];
+          float g = rgba[x * 4 + 1];
+          float b = rgba[x * 4 + 2];
+          float a = rgba[x * 4 + 3];
 
           if(saveFmt.bgraOrder)
             std::swap(r, b);
@@ -1223,12 +1358,57 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
     FileIO::fclose(f);
   }
 
-  for(size_t i = 0; i < subdata.size(); i++)
-    delete[] subdata[i];
-
   return success;
 }
 
+bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
+{
+  TextureSaveJob job;
+
+  if(!FetchTextureForSave(saveData, job))
+    return false;
+
+  return EncodeSavedTexture(job, path);
+}
+
+rdcarray<bool> ReplayController::SaveTextures(const rdcarray<TextureSave> &saveData,
+                                              const rdcarray<rdcstr> &paths)
+{
+  rdcarray<bool> ret;
+
+  if(saveData.size() != paths.size())
+  {
+    RDCERR("Mismatched number of textures (%zu) and paths (%zu) to save", saveData.size(),
+           paths.size());
+    return ret;
+  }
+
+  ret.resize(saveData.size());
+
+  for(size_t i = 0; i < ret.size(); i++)
+    ret[i] = false;
+
+  // read-back has to happen here, but each texture is encoded and written while the next is read
+  TextureSaveQueue queue(RDCMIN(8U, Threading::JobPool::Shared().GetNumThreads()));
+
+  for(size_t i = 0; i < saveData.size(); i++)
+  {
+    TextureSaveJob *job = new TextureSaveJob;
+
+    if(!FetchTextureForSave(saveData[i], *job))
+    {
+      delete job;
+      continue;
+    }
+
+    queue.Push(job, paths[i], &ret[i]);
+  }
+
+  queue.Finish();
+
+  return ret;
+}
+
 rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, uint32_t x,
                                                            uint32_t y, uint32_t slice, uint32_t mip,
                                                            uint32_t sampleIdx, CompType typeHint)
@@ -1737,3 +1917,94 @@ void ReplayController::FetchPipelineState()
   m_GLPipelineState = &m_pDevice->GetGLPipelineState();
   m_VulkanPipelineState = &m_pDevice->GetVulkanPipelineState();
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Benchmark saving textures", "[format][!benchmark]")
+{
+  const uint32_t dim = 1024;
+  const size_t numPixels = dim * dim;
+
+  std::vector<byte> rgba8(numPixels * 4);
+  std::vector<uint16_t> rgba16f(numPixels * 4);
+
+  for(size_t i = 0; i < numPixels * 4; i++)
+  {
+    rgba8[i] = byte((i * 7) & 0xff);
+    rgba16f[i] = ConvertToHalf(float(i % 4096) / 1024.0f);
+  }
+
+  // a batch of textures, half PNGs and half EXRs, as a multi-texture save would produce
+  const size_t numTextures = 8;
+  std::string folder = FileIO::GetTempFolderFilename();
+
+  auto makeJob = [&](size_t i) {
+    TextureSaveJob *job = new TextureSaveJob;
+    job->td.width = job->td.height = dim;
+    job->td.format.type = ResourceFormatType::Regular;
+    job->td.format.compCount = 4;
+    job->rowPitch = dim * 4;
+
+    if(i % 2 == 0)
+    {
+      job->sd.destType = FileType::PNG;
+      job->td.format.compType = CompType::UNorm;
+      job->td.format.compByteWidth = 1;
+      job->subdata.push_back(new byte[rgba8.size()]);
+      memcpy(job->subdata[0], rgba8.data(), rgba8.size());
+    }
+    else
+    {
+      job->sd.destType = FileType::EXR;
+      job->td.format.compType = CompType::Float;
+      job->td.format.compByteWidth = 2;
+      job->rowPitch *= 2;
+      job->subdata.push_back(new byte[rgba16f.size() * 2]);
+      memcpy(job->subdata[0], rgba16f.data(), rgba16f.size() * 2);
+    }
+
+    return job;
+  };
+
+  std::vector<std::string> paths;
+  for(size_t i = 0; i < numTextures; i++)
+    paths.push_back(
+        StringFormat::Fmt("%s/renderdoc_save_bench_%zu.%s", folder.c_str(), i, i % 2 ? "exr" : "png"));
+
+  uint32_t threads = RDCMIN(8U, Threading::JobPool::Shared().GetNumThreads());
+
+  bool success[numTextures] = {};
+
+  for(uint32_t maxJobs : {0U, threads})
+  {
+    uint64_t bytes = 0;
+
+    PerformanceTimer timer;
+
+    {
+      TextureSaveQueue queue(maxJobs);
+      for(size_t i = 0; i < numTextures; i++)
+      {
+        bytes += numPixels * (i % 2 ? 8 : 4);
+        queue.Push(makeJob(i), paths[i], &success[i]);
+      }
+      queue.Finish();
+    }
+
+    double ms = timer.GetMilliseconds();
+
+    WARN("Saving " << numTextures << " " << dim << "x" << dim << " textures with "
+                   << RDCMAX(1U, maxJobs) << " thread(s): " << ms << " ms, "
+                   << (double(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) << " MB/s");
+
+    for(size_t i = 0; i < numTextures; i++)
+      CHECK(success[i]);
+  }
+
+  for(const std::string &p : paths)
+    FileIO::Delete(p.c_str());
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -33,6 +33,7 @@
 #include "replay/replay_driver.h"
 
 struct ReplayController;
+struct TextureSaveJob;
 
 struct ReplayOutput : public IReplayOutput
 {
@@ -158,6 +159,7 @@ public:
 
   FrameDescription GetFrameInfo();
   const SDFile &GetStructuredFile();
+  const SDChunk *GetStructuredChunk(uint32_t chunkIndex);
   rdcarray<DrawcallDescription> GetDrawcalls();
   rdcarray<CounterResult> FetchCounters(const rdcarray<GPUCounter> &counters);
   rdcarray<GPUCounter> EnumerateCounters();
@@ -186,6 +188,7 @@ public:
   bytebuf GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip);
 
   bool SaveTexture(const TextureSave &saveData, const char *path);
+  rdcarray<bool> SaveTextures(const rdcarray<TextureSave> &saveData, const rdcarray<rdcstr> &paths);
 
   rdcarray<ShaderVariable> GetCBufferVariableContents(ResourceId shader, const char *entryPoint,
                                                       uint32_t cbufslot, ResourceId buffer,
@@ -208,6 +211,8 @@ private:
 
   DrawcallDescription *GetDrawcallByEID(uint32_t eventId);
 
+  bool FetchTextureForSave(const TextureSave &saveData, TextureSaveJob &job);
+
   IReplayDriver *GetDevice() { return m_pDevice; }
   FrameRecord m_FrameRecord;
   vector<DrawcallDescription *> m_Drawcalls;
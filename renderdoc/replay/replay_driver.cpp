@@ -203,6 +203,64 @@ void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, u
 #undef IDX_VALUE
 }
 
+bool ShaderDebugTraceBuilder::SameLayout(const ShaderVariable &a, const ShaderVariable &b)
+{
+  // members are compared separately as they are flattened too, only their count matters here.
+  return a.rows == b.rows && a.columns == b.columns && a.type == b.type &&
+         a.displayAsHex == b.displayAsHex && a.isStruct == b.isStruct &&
+         a.rowMajor == b.rowMajor && a.members.count() == b.members.count() && a.name == b.name;
+}
+
+void ShaderDebugTraceBuilder::AddState(const ShaderDebugState &state)
+{
+  ShaderDebugStep step;
+  step.nextInstruction = state.nextInstruction;
+  step.flags = state.flags;
+  step.keyframe = -1;
+  step.firstChange = (uint32_t)m_Trace.changes.count();
+
+  ShaderDebugTrace::FlattenVariables(state, m_Vars);
+
+  bool keyframe = m_SinceKeyframe >= KeyframeInterval || m_Vars.count() != m_LastVars.count() ||
+                  state.registers.count() != m_Last.registers.count() ||
+                  state.outputs.count() != m_Last.outputs.count();
+
+  for(int32_t i = 0; !keyframe && i < m_Vars.count(); i++)
+    keyframe = !SameLayout(*m_Vars[i], *m_LastVars[i]);
+
+  if(keyframe)
+  {
+    step.keyframe = m_Trace.keyframes.count();
+    m_Trace.keyframes.push_back(state);
+    m_SinceKeyframe = 0;
+
+    m_Last = state;
+    ShaderDebugTrace::FlattenVariables(m_Last, m_LastVars);
+  }
+  else
+  {
+    for(int32_t i = 0; i < m_Vars.count(); i++)
+    {
+      const ShaderVariable &var = *m_Vars[i];
+
+      if(var.members.empty() && memcmp(&var.value, &m_LastVars[i]->value, sizeof(var.value)))
+      {
+        ShaderVariableChange change;
+        change.index = (uint32_t)i;
+        change.value = var.value;
+        m_Trace.changes.push_back(change);
+
+        // the layout is unchanged so we can keep our copy up to date in place
+        m_LastVars[i]->value = var.value;
+      }
+    }
+
+    m_SinceKeyframe++;
+  }
+
+  m_Trace.steps.push_back(step);
+}
+
 FloatVector HighlightCache::InterpretVertex(const byte *data, uint32_t vert, const MeshDisplay &cfg,
                                             const byte *end, bool useidx, bool &valid)
 {
@@ -744,3 +802,69 @@ bool HighlightCache::FetchHighlightPositions(const MeshDisplay &cfg, FloatVector
 
   return valid;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Check shader debug traces reconstruct each step", "[shaderdebug]")
+{
+  std::vector<ShaderDebugState> states;
+
+  ShaderDebugState state;
+  state.nextInstruction = 0;
+  state.flags = ShaderEvents::NoEvent;
+  state.registers.push_back(ShaderVariable("r0", 0.0f, 0.0f, 0.0f, 0.0f));
+  state.registers.push_back(ShaderVariable("r1", 1U, 2U, 3U, 4U));
+  state.outputs.push_back(ShaderVariable("o0", 0.0f, 0.0f, 0.0f, 0.0f));
+
+  ShaderVariable temp;
+  temp.name = "x0";
+  temp.members.push_back(ShaderVariable("[0]", 0, 0, 0, 0));
+  temp.members.push_back(ShaderVariable("[1]", 0, 0, 0, 0));
+  state.indexableTemps.push_back(temp);
+
+  states.push_back(state);
+
+  for(uint32_t i = 1; i < 300; i++)
+  {
+    state.nextInstruction = i;
+    state.flags = (i % 7) == 0 ? ShaderEvents::SampleLoadGather : ShaderEvents::NoEvent;
+
+    // change something different each step, sometimes nothing
+    if(i % 3 == 0)
+      state.registers[0].value.f.x = float(i);
+    if(i % 5 == 0)
+      state.indexableTemps[0].members[i % 2].value.i.y = int32_t(i);
+    if(i % 11 == 0)
+      state.outputs[0].value.f.w = 1.0f / float(i);
+
+    // change the layout partway through, which must force a keyframe
+    if(i == 150)
+      state.registers.push_back(ShaderVariable("r2", 5U, 6U, 7U, 8U));
+
+    states.push_back(state);
+  }
+
+  ShaderDebugTrace trace;
+  ShaderDebugTraceBuilder builder(trace);
+
+  for(const ShaderDebugState &s : states)
+    builder.AddState(s);
+
+  REQUIRE(trace.GetNumStates() == (int)states.size());
+
+  // much less storage than a keyframe for every step
+  CHECK(trace.keyframes.count() < 10);
+  CHECK(trace.steps[150].keyframe >= 0);
+
+  for(int i = 0; i < trace.GetNumStates(); i++)
+  {
+    CHECK(trace.GetNextInstruction(i) == states[i].nextInstruction);
+    CHECK(trace.GetFlags(i) == states[i].flags);
+    bool matches = trace.GetState(i) == states[i];
+    CHECK(matches);
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
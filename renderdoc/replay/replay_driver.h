@@ -122,6 +122,8 @@ public:
   virtual ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers) = 0;
   virtual void ReplayLog(uint32_t endEventID, ReplayLogType replayType) = 0;
   virtual const SDFile &GetStructuredFile() = 0;
+  // if the given chunk in the structured file was loaded lazily, fill in its contents
+  virtual void LoadStructuredChunk(uint32_t chunkIndex) = 0;
 
   virtual vector<uint32_t> GetPassEvents(uint32_t eventId) = 0;
 
@@ -233,6 +235,35 @@ DrawcallDescription *SetupDrawcallPointers(std::vector<DrawcallDescription *> *d
 void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, uint16_t *idx16,
                                uint32_t *idx32, std::vector<uint32_t> &patchedIndices);
 
+// accumulates shader debugging states into a ShaderDebugTrace, storing a full keyframe every so
+// often and only the changed variable values in between.
+class ShaderDebugTraceBuilder
+{
+public:
+  ShaderDebugTraceBuilder(ShaderDebugTrace &trace) : m_Trace(trace)
+  {
+    m_Trace.steps.clear();
+    m_Trace.keyframes.clear();
+    m_Trace.changes.clear();
+  }
+
+  // the maximum number of steps between keyframes, which bounds how many steps GetState() has to
+  // apply to reconstruct a state.
+  static const int32_t KeyframeInterval = 64;
+
+  void AddState(const ShaderDebugState &state);
+
+private:
+  static bool SameLayout(const ShaderVariable &a, const ShaderVariable &b);
+
+  ShaderDebugTrace &m_Trace;
+
+  ShaderDebugState m_Last;
+  rdcarray<ShaderVariable *> m_LastVars;
+  rdcarray<const ShaderVariable *> m_Vars;
+  int32_t m_SinceKeyframe = KeyframeInterval;
+};
+
 // simple cache for when we need buffer data for highlighting
 // vertices, typical use will be lots of vertices in the same
 // mesh, not jumping back and forth much between meshes.
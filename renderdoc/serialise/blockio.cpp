@@ -0,0 +1,559 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017-2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "blockio.h"
+#include "lz4/lz4.h"
+#include "zstd/zstd.h"
+
+static const uint32_t MAGIC_BLOCKINDEX = MAKE_FOURCC('R', 'D', 'B', 'I');
+
+namespace
+{
+struct BlockIndexFooter
+{
+  uint32_t magic;
+  BlockCodec codec;
+  uint64_t blockSize;
+  uint64_t numBlocks;
+  uint64_t uncompressedSize;
+};
+};
+
+uint64_t BlockCompression::CompressBound(BlockCodec codec, uint64_t size)
+{
+  if(codec == BlockCodec::LZ4)
+    return LZ4_COMPRESSBOUND(size);
+  else if(codec == BlockCodec::Zstd)
+    return ZSTD_compressBound((size_t)size);
+
+  return 0;
+}
+
+uint64_t BlockCompression::Compress(BlockCodec codec, const byte *src, uint64_t srcSize, byte *dst,
+                                    uint64_t dstSize)
+{
+  if(codec == BlockCodec::LZ4)
+  {
+    int ret = LZ4_compress_default((const char *)src, (char *)dst, (int)srcSize, (int)dstSize);
+
+    if(ret <= 0)
+    {
+      RDCERR("Error compressing: %i", ret);
+      return 0;
+    }
+
+    return (uint64_t)ret;
+  }
+  else if(codec == BlockCodec::Zstd)
+  {
+    // we use the same compression level as the streaming ZSTDCompressor
+    size_t ret = ZSTD_compress(dst, (size_t)dstSize, src, (size_t)srcSize, 7);
+
+    if(ZSTD_isError(ret))
+    {
+      RDCERR("Error compressing: %s", ZSTD_getErrorName(ret));
+      return 0;
+    }
+
+    return (uint64_t)ret;
+  }
+
+  RDCERR("Unknown block codec %u", (uint32_t)codec);
+  return 0;
+}
+
+bool BlockCompression::Decompress(BlockCodec codec, const byte *src, uint64_t srcSize, byte *dst,
+                                  uint64_t dstSize)
+{
+  if(codec == BlockCodec::LZ4)
+  {
+    int ret = LZ4_decompress_safe((const char *)src, (char *)dst, (int)srcSize, (int)dstSize);
+
+    if(ret < 0 || (uint64_t)ret != dstSize)
+    {
+      RDCERR("Error decompressing: %i", ret);
+      return false;
+    }
+
+    return true;
+  }
+  else if(codec == BlockCodec::Zstd)
+  {
+    size_t ret = ZSTD_decompress(dst, (size_t)dstSize, src, (size_t)srcSize);
+
+    if(ZSTD_isError(ret) || (uint64_t)ret != dstSize)
+    {
+      RDCERR("Error decompressing: %s", ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "Short block");
+      return false;
+    }
+
+    return true;
+  }
+
+  RDCERR("Unknown block codec %u", (uint32_t)codec);
+  return false;
+}
+
+BlockCompressor::BlockCompressor(StreamWriter *write, BlockCodec codec, Ownership own,
+                                 uint32_t maxInFlight)
+    : Compressor(write, own)
+{
+  m_Codec = codec;
+
+  m_Slots.resize(maxInFlight > 1 ? maxInFlight + 1 : 1);
+
+  for(BlockSlot &slot : m_Slots)
+  {
+    slot.uncompressed = AllocAlignedBuffer(BlockCompression::BlockSize);
+    slot.compressed =
+        AllocAlignedBuffer(BlockCompression::CompressBound(m_Codec, BlockCompression::BlockSize));
+  }
+
+  // the writer may already have data in it, offsets in the index are relative to our first block
+  m_BaseOffset = m_Write->GetOffset();
+  m_UncompressedSize = 0;
+}
+
+BlockCompressor::~BlockCompressor()
+{
+  for(BlockSlot &slot : m_Slots)
+  {
+    WaitSlot(slot);
+    FreeAlignedBuffer(slot.uncompressed);
+    FreeAlignedBuffer(slot.compressed);
+  }
+}
+
+bool BlockCompressor::Write(const void *data, uint64_t numBytes)
+{
+  if(m_Errored)
+    return false;
+
+  const byte *src = (const byte *)data;
+
+  bool success = true;
+
+  while(success && numBytes > 0)
+  {
+    BlockSlot &slot = m_Slots[m_CurrentSlot];
+
+    // copy whatever will fit in the current block
+    uint64_t partialBytes = RDCMIN(BlockCompression::BlockSize - slot.uncompressedSize, numBytes);
+    memcpy(slot.uncompressed + slot.uncompressedSize, src, (size_t)partialBytes);
+
+    slot.uncompressedSize += partialBytes;
+    m_UncompressedSize += partialBytes;
+    numBytes -= partialBytes;
+    src += partialBytes;
+
+    // only flush full blocks, so that every block but the last is exactly BlockSize
+    if(slot.uncompressedSize == BlockCompression::BlockSize)
+      success &= FlushBlock();
+  }
+
+  return success;
+}
+
+bool BlockCompressor::Finish()
+{
+  // Calling Write() after Finish() is illegal
+  bool success = true;
+
+  if(!m_Errored && m_Slots[m_CurrentSlot].uncompressedSize > 0)
+    success &= FlushBlock();
+
+  // write out any blocks still in flight, oldest first
+  for(size_t i = 0; success && i < m_Slots.size(); i++)
+  {
+    BlockSlot &slot = m_Slots[(m_CurrentSlot + i) % m_Slots.size()];
+    if(slot.pending)
+      success &= WriteSlot(slot);
+  }
+
+  if(!success || m_Errored)
+    return false;
+
+  m_BlockOffsets.push_back(m_Write->GetOffset() - m_BaseOffset);
+
+  BlockIndexFooter footer;
+  footer.magic = MAGIC_BLOCKINDEX;
+  footer.codec = m_Codec;
+  footer.blockSize = BlockCompression::BlockSize;
+  footer.numBlocks = m_BlockOffsets.size() - 1;
+  footer.uncompressedSize = m_UncompressedSize;
+
+  success &= m_Write->Write(m_BlockOffsets.data(), m_BlockOffsets.size() * sizeof(uint64_t));
+  success &= m_Write->Write(footer);
+
+  return success;
+}
+
+void BlockCompressor::SetErrored()
+{
+  for(BlockSlot &slot : m_Slots)
+  {
+    WaitSlot(slot);
+    slot.pending = false;
+  }
+
+  m_Errored = true;
+}
+
+void BlockCompressor::WaitSlot(BlockSlot &slot)
+{
+  if(slot.job)
+  {
+    Threading::JobPool::Shared().Wait(slot.job);
+    slot.job.reset();
+  }
+}
+
+bool BlockCompressor::FlushBlock()
+{
+  BlockSlot &slot = m_Slots[m_CurrentSlot];
+
+  slot.pending = true;
+
+  // compressing synchronously, do it all now
+  if(m_Slots.size() == 1)
+  {
+    slot.compressedSize = BlockCompression::Compress(
+        m_Codec, slot.uncompressed, slot.uncompressedSize, slot.compressed,
+        BlockCompression::CompressBound(m_Codec, BlockCompression::BlockSize));
+
+    return WriteSlot(slot);
+  }
+
+  BlockCodec codec = m_Codec;
+  BlockSlot *s = &slot;
+
+  slot.job = Threading::JobPool::Shared().Submit([codec, s]() {
+    s->compressedSize = BlockCompression::Compress(
+        codec, s->uncompressed, s->uncompressedSize, s->compressed,
+        BlockCompression::CompressBound(codec, BlockCompression::BlockSize));
+  });
+
+  // move on to the next slot. If it's still in flight it's the oldest block, so wait for it and
+  // write it out before it can be re-used. This is what stops us running unboundedly ahead.
+  m_CurrentSlot = (m_CurrentSlot + 1) % m_Slots.size();
+
+  BlockSlot &next = m_Slots[m_CurrentSlot];
+
+  if(next.pending)
+    return WriteSlot(next);
+
+  return true;
+}
+
+bool BlockCompressor::WriteSlot(BlockSlot &slot)
+{
+  WaitSlot(slot);
+
+  slot.pending = false;
+
+  if(slot.compressedSize == 0)
+  {
+    SetErrored();
+    return false;
+  }
+
+  m_BlockOffsets.push_back(m_Write->GetOffset() - m_BaseOffset);
+
+  bool success = m_Write->Write(slot.compressed, slot.compressedSize);
+
+  slot.uncompressedSize = 0;
+  slot.compressedSize = 0;
+
+  if(!success)
+    SetErrored();
+
+  return success;
+}
+
+BlockDecompressor::BlockDecompressor(StreamReader *read, Ownership own) : Decompressor(read, own)
+{
+  BlockIndexFooter footer = {};
+
+  uint64_t size = m_Read->GetSize();
+
+  if(size >= sizeof(footer))
+  {
+    m_Read->SetOffset(size - sizeof(footer));
+    m_Read->Read(footer);
+  }
+
+  if(m_Read->IsErrored() || footer.magic != MAGIC_BLOCKINDEX ||
+     (footer.codec != BlockCodec::LZ4 && footer.codec != BlockCodec::Zstd) ||
+     footer.blockSize == 0 || footer.blockSize > 64 * 1024 * 1024 ||
+     footer.numBlocks >= size / sizeof(uint64_t) ||
+     (footer.numBlocks + 1) * sizeof(uint64_t) + sizeof(footer) > size)
+  {
+    RDCERR("Invalid block index footer");
+    SetErrored();
+    return;
+  }
+
+  m_Codec = footer.codec;
+  m_BlockSize = footer.blockSize;
+  m_UncompressedSize = footer.uncompressedSize;
+
+  m_BlockOffsets.resize((size_t)footer.numBlocks + 1);
+
+  uint64_t indexSize = m_BlockOffsets.size() * sizeof(uint64_t);
+
+  m_Read->SetOffset(size - sizeof(footer) - indexSize);
+  m_Read->Read(m_BlockOffsets.data(), indexSize);
+
+  // every block but the last must be full, and the last must be non-empty
+  bool sizeValid = footer.numBlocks == 0
+                       ? m_UncompressedSize == 0
+                       : (m_UncompressedSize > (footer.numBlocks - 1) * m_BlockSize &&
+                          m_UncompressedSize <= footer.numBlocks * m_BlockSize);
+
+  if(m_Read->IsErrored() || m_BlockOffsets.back() > size - sizeof(footer) - indexSize || !sizeValid)
+  {
+    RDCERR("Invalid block index");
+    SetErrored();
+    return;
+  }
+
+  m_Read->SetOffset(0);
+  m_ReadPos = 0;
+
+  for(BlockSlot &slot : m_Slots)
+  {
+    slot.compressed = AllocAlignedBuffer(BlockCompression::CompressBound(m_Codec, m_BlockSize));
+    slot.decompressed = AllocAlignedBuffer(m_BlockSize);
+  }
+}
+
+BlockDecompressor::~BlockDecompressor()
+{
+  for(BlockSlot &slot : m_Slots)
+  {
+    WaitSlot(slot);
+    FreeAlignedBuffer(slot.compressed);
+    FreeAlignedBuffer(slot.decompressed);
+  }
+}
+
+void BlockDecompressor::SetErrored()
+{
+  for(BlockSlot &slot : m_Slots)
+    WaitSlot(slot);
+
+  m_Errored = true;
+  m_Current = NULL;
+}
+
+void BlockDecompressor::WaitSlot(BlockSlot &slot)
+{
+  if(slot.job)
+  {
+    Threading::JobPool::Shared().Wait(slot.job);
+    slot.job.reset();
+  }
+}
+
+bool BlockDecompressor::ReadCompressedBlock(BlockSlot &slot, uint64_t block)
+{
+  WaitSlot(slot);
+
+  slot.block = block;
+  slot.success = false;
+  slot.compressedSize = m_BlockOffsets[(size_t)block + 1] - m_BlockOffsets[(size_t)block];
+  slot.decompressedSize = RDCMIN(m_BlockSize, m_UncompressedSize - block * m_BlockSize);
+
+  if(slot.compressedSize > BlockCompression::CompressBound(m_Codec, m_BlockSize))
+  {
+    RDCERR("Invalid compressed block size %llu", slot.compressedSize);
+    return false;
+  }
+
+  // blocks are almost always read in order, so avoid seeking which would discard the reader's
+  // buffered data.
+  if(m_ReadPos != m_BlockOffsets[(size_t)block])
+    m_Read->SetOffset(m_BlockOffsets[(size_t)block]);
+
+  m_Read->Read(slot.compressed, slot.compressedSize);
+  m_ReadPos = m_BlockOffsets[(size_t)block + 1];
+
+  return !m_Read->IsErrored();
+}
+
+bool BlockDecompressor::FillBlock(uint64_t block)
+{
+  if(m_Errored)
+    return false;
+
+  if(block >= m_BlockOffsets.size() - 1)
+  {
+    RDCERR("Reading off the end of block-indexed data");
+    SetErrored();
+    return false;
+  }
+
+  BlockSlot &slot = m_Slots[block % PrefetchDepth];
+
+  if(slot.block == block)
+  {
+    // the block has already been prefetched, wait for it to finish
+    WaitSlot(slot);
+  }
+  else
+  {
+    // decompress the block on this thread
+    if(ReadCompressedBlock(slot, block))
+      slot.success = BlockCompression::Decompress(m_Codec, slot.compressed, slot.compressedSize,
+                                                  slot.decompressed, slot.decompressedSize);
+  }
+
+  if(!slot.success)
+  {
+    slot.block = ~0ULL;
+    SetErrored();
+    return false;
+  }
+
+  m_Current = &slot;
+  m_CurrentOffset = 0;
+
+  // kick off decompression of the next blocks while this one is consumed
+  Prefetch(block);
+
+  return true;
+}
+
+void BlockDecompressor::Prefetch(uint64_t block)
+{
+  for(uint64_t next = block + 1; next < block + PrefetchDepth; next++)
+  {
+    if(next >= m_BlockOffsets.size() - 1)
+      break;
+
+    BlockSlot &slot = m_Slots[next % PrefetchDepth];
+
+    // already prefetched or in flight
+    if(slot.block == next)
+      continue;
+
+    // reading the compressed data happens here since the reader is not thread-safe. Only the
+    // decompression is done on the job pool.
+    if(!ReadCompressedBlock(slot, next))
+    {
+      // leave the slot invalid, the error will be hit when we try to read this block
+      slot.block = ~0ULL;
+      break;
+    }
+
+    BlockCodec codec = m_Codec;
+    BlockSlot *s = &slot;
+    slot.job = Threading::JobPool::Shared().Submit([codec, s]() {
+      s->success = BlockCompression::Decompress(codec, s->compressed, s->compressedSize,
+                                                s->decompressed, s->decompressedSize);
+    });
+  }
+}
+
+bool BlockDecompressor::Seek(uint64_t offset)
+{
+  if(m_Errored)
+    return false;
+
+  if(offset > m_UncompressedSize)
+  {
+    RDCERR("Seeking off the end of block-indexed data");
+    return false;
+  }
+
+  // seeking to the end is valid, there's just nothing to read
+  if(offset == m_UncompressedSize)
+  {
+    m_Current = NULL;
+    m_NextBlock = m_BlockOffsets.size() - 1;
+    return true;
+  }
+
+  uint64_t block = offset / m_BlockSize;
+
+  // if the block is resident (or being prefetched), FillBlock will pick it up without any extra
+  // decompression. Otherwise it will decompress the block directly and prefetch from there.
+  if(m_Current == NULL || m_Current->block != block)
+  {
+    if(!FillBlock(block))
+      return false;
+  }
+
+  m_CurrentOffset = offset - block * m_BlockSize;
+
+  return true;
+}
+
+bool BlockDecompressor::Recompress(Compressor *comp)
+{
+  bool success = true;
+
+  for(uint64_t block = 0; success && block < m_BlockOffsets.size() - 1; block++)
+  {
+    success &= FillBlock(block);
+    if(success)
+      success &= comp->Write(m_Current->decompressed, m_Current->decompressedSize);
+  }
+  success &= comp->Finish();
+
+  return success;
+}
+
+bool BlockDecompressor::Read(void *data, uint64_t numBytes)
+{
+  if(m_Errored)
+    return false;
+
+  byte *dst = (byte *)data;
+
+  while(numBytes > 0)
+  {
+    // move onto the next block if we've exhausted this one
+    if(m_Current == NULL || m_CurrentOffset >= m_Current->decompressedSize)
+    {
+      uint64_t nextBlock = m_Current ? m_Current->block + 1 : m_NextBlock;
+
+      if(!FillBlock(nextBlock))
+        return false;
+    }
+
+    uint64_t partialBytes = RDCMIN(m_Current->decompressedSize - m_CurrentOffset, numBytes);
+
+    if(dst)
+    {
+      memcpy(dst, m_Current->decompressed + m_CurrentOffset, (size_t)partialBytes);
+      dst += partialBytes;
+    }
+
+    m_CurrentOffset += partialBytes;
+    numBytes -= partialBytes;
+  }
+
+  return true;
+}
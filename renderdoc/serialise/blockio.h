@@ -0,0 +1,162 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017-2018 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "common/threading.h"
+#include "streamio.h"
+
+// the codec used to compress each independent block
+enum class BlockCodec : uint32_t
+{
+  LZ4 = 1,
+  Zstd = 2,
+};
+
+namespace BlockCompression
+{
+// uncompressed size of every block but the last
+static const uint64_t BlockSize = 1024 * 1024;
+
+// worst-case compressed size of a block of the given size
+uint64_t CompressBound(BlockCodec codec, uint64_t size);
+
+// compress/decompress a single self-contained block. Compress returns the compressed size, or 0
+// on failure. Decompress returns true only if exactly dstSize bytes were decompressed.
+uint64_t Compress(BlockCodec codec, const byte *src, uint64_t srcSize, byte *dst, uint64_t dstSize);
+bool Decompress(BlockCodec codec, const byte *src, uint64_t srcSize, byte *dst, uint64_t dstSize);
+};
+
+/*
+
+ Block-indexed compressed data is a series of independently compressed blocks, followed by an
+ index that allows any block to be located and decompressed without decompressing anything before
+ it:
+
+ byte blocks[];                          // each block is BlockSize bytes uncompressed, except the
+                                         // last which may be smaller
+ uint64_t blockOffsets[numBlocks + 1];   // offset of each compressed block from the start of the
+                                         // data. The last entry is the end of the final block.
+ BlockIndexFooter footer;
+
+ The index is stored as a trailer rather than in the section header since the number of blocks
+ isn't known until the section has been completely written.
+
+*/
+
+// With maxInFlight above one, full blocks are compressed on the shared job pool while the next
+// block is filled, and written out in order once they complete. At most maxInFlight blocks are
+// queued or compressing at once, which bounds memory use regardless of how far the caller runs
+// ahead. How many of those run in parallel depends on the pool's threads. The output is identical
+// regardless of how many blocks are in flight.
+class BlockCompressor : public Compressor
+{
+public:
+  BlockCompressor(StreamWriter *write, BlockCodec codec, Ownership own, uint32_t maxInFlight = 1);
+  ~BlockCompressor();
+
+  bool Write(const void *data, uint64_t numBytes);
+  bool Finish();
+
+private:
+  struct BlockSlot
+  {
+    byte *uncompressed = NULL;
+    byte *compressed = NULL;
+    uint64_t uncompressedSize = 0;
+    uint64_t compressedSize = 0;
+    Threading::JobPool::JobHandle job;
+    bool pending = false;
+  };
+
+  bool FlushBlock();
+  bool WriteSlot(BlockSlot &slot);
+  void WaitSlot(BlockSlot &slot);
+  void SetErrored();
+
+  BlockCodec m_Codec;
+
+  // one slot per block in flight plus the one being filled, or a single slot if compressing
+  // synchronously
+  std::vector<BlockSlot> m_Slots;
+  size_t m_CurrentSlot = 0;
+
+  uint64_t m_BaseOffset;
+  uint64_t m_UncompressedSize;
+  std::vector<uint64_t> m_BlockOffsets;
+
+  bool m_Errored = false;
+};
+
+class BlockDecompressor : public Decompressor
+{
+public:
+  BlockDecompressor(StreamReader *read, Ownership own);
+  ~BlockDecompressor();
+
+  bool Recompress(Compressor *comp);
+  bool Read(void *data, uint64_t numBytes);
+  bool Seek(uint64_t offset);
+
+  uint64_t GetUncompressedSize() const { return m_UncompressedSize; }
+private:
+  // how many blocks can be in flight at once, including the one currently being read from
+  static const uint32_t PrefetchDepth = 4;
+
+  struct BlockSlot
+  {
+    uint64_t block = ~0ULL;
+    byte *compressed = NULL;
+    byte *decompressed = NULL;
+    uint64_t compressedSize = 0;
+    uint64_t decompressedSize = 0;
+    Threading::JobPool::JobHandle job;
+    bool success = false;
+  };
+
+  bool ReadCompressedBlock(BlockSlot &slot, uint64_t block);
+  void WaitSlot(BlockSlot &slot);
+  bool FillBlock(uint64_t block);
+  void Prefetch(uint64_t block);
+  void SetErrored();
+
+  BlockCodec m_Codec;
+  uint64_t m_BlockSize = 0;
+  uint64_t m_UncompressedSize = 0;
+  std::vector<uint64_t> m_BlockOffsets;
+
+  // where the compressed stream is positioned, to avoid unnecessary seeks
+  uint64_t m_ReadPos = 0;
+
+  BlockSlot m_Slots[PrefetchDepth];
+
+  // the block currently being read from, and the offset within it
+  BlockSlot *m_Current = NULL;
+  uint64_t m_CurrentOffset = 0;
+
+  // the block to read next if there is no current block
+  uint64_t m_NextBlock = 0;
+
+  bool m_Errored = false;
+};
@@ -25,6 +25,7 @@
 #include <utility>
 #include "common/common.h"
 #include "serialise/rdcfile.h"
+#include "serialise/serialiser.h"
 
 #include "3rdparty/miniz/miniz.h"
 #include "3rdparty/pugixml/pugixml.hpp"
@@ -59,6 +60,7 @@ struct xml_file_writer : pugi::xml_writer
   }
 
   void write(const void *data, size_t size) { stream.Write(data, size); }
+  void write(const char *str) { stream.Write(str, strlen(str)); }
 };
 
 // avoid &, <, and > since they throw off the ascii alignment
@@ -80,9 +82,13 @@ static constexpr byte FromHex(const char c)
                                      : (c >= 'a' && c <= 'f' ? byte(c - 'a') + 10 : 0));
 }
 
-static void HexEncode(const std::vector<byte> &in, std::string &out)
+static const size_t hexBytesPerLine = 32;
+
+// encodes data as hex, appending to out. Data can be encoded in several calls as long as every call
+// but the last is a multiple of hexBytesPerLine, so that lines are never split.
+static void HexEncode(const byte *in, size_t len, std::string &out)
 {
-  const size_t bytesPerLine = 32;
+  const size_t bytesPerLine = hexBytesPerLine;
   const size_t bytesPerGroup = 4;
 
   const char digit[] = "0123456789ABCDEF";
@@ -90,18 +96,17 @@ static void HexEncode(const std::vector<byte> &in, std::string &out)
   // - 3 characters per byte (two for hex, 1 for ascii),
   // - 4 characters per line (3x space between hex and ascii, newline)
   // - 1 character per group (space)
-  // - 2 characters for leading/trailing newline
-  out.reserve(in.size() * 3 + (in.size() / bytesPerLine) * 4 + (in.size() / bytesPerGroup) + 2);
-
-  // leading newline
-  out = "\n";
+  // - 1 character for trailing newline
+  out.reserve(out.size() + len * 3 + (len / bytesPerLine) * 4 + (len / bytesPerGroup) + 1);
 
   // accumulate ascii representation for each line
   std::string ascii;
 
   size_t i = 0;
-  for(byte c : in)
+  for(const byte *end = in + len; in < end; in++)
   {
+    byte c = *in;
+
     out.push_back(digit[(c & 0xf0) >> 4]);
     out.push_back(digit[(c & 0x0f) >> 0]);
 
@@ -265,16 +270,158 @@ static void Obj2XML(pugi::xml_node &parent, SDObject &child)
   }
 }
 
+// writes text content with the same escaping pugixml uses for pcdata
+static void WriteEscapedXML(xml_file_writer &writer, const char *str, size_t len)
+{
+  const char *end = str + len;
+
+  while(str < end)
+  {
+    const char *run = str;
+
+    while(str < end && *str != '&' && *str != '<' && *str != '>' &&
+          ((byte)*str >= 32 || *str == '\t' || *str == '\r' || *str == '\n'))
+      str++;
+
+    writer.write(run, str - run);
+
+    if(str == end)
+      break;
+
+    if(*str == '&')
+      writer.write("&amp;");
+    else if(*str == '<')
+      writer.write("&lt;");
+    else if(*str == '>')
+      writer.write("&gt;");
+    else
+      writer.write(StringFormat::Fmt("&#%u;", (uint32_t)(byte)*str).c_str());
+
+    str++;
+  }
+}
+
+// sections can be large, so their contents are streamed straight through to the file in blocks
+// rather than being built up as a node.
+static void Section2XML(xml_file_writer &writer, const SectionProperties &props,
+                        StreamReader *reader)
+{
+  writer.write("\t<section");
+
+  if(props.flags & SectionFlags::ASCIIStored)
+    writer.write(" ascii=\"\"");
+  if(props.flags & SectionFlags::LZ4Compressed)
+    writer.write(" lz4=\"\"");
+  if(props.flags & SectionFlags::ZstdCompressed)
+    writer.write(" zstd=\"\"");
+  if(props.flags & SectionFlags::BlockIndexed)
+    writer.write(" blockindexed=\"\"");
+
+  writer.write(">\n\t\t<name>");
+  WriteEscapedXML(writer, props.name.c_str(), props.name.size());
+  writer.write("</name>\n");
+
+  writer.write(StringFormat::Fmt("\t\t<version>%llu</version>\n", props.version).c_str());
+  writer.write(StringFormat::Fmt("\t\t<type>%u</type>\n", (uint32_t)props.type).c_str());
+
+  writer.write("\t\t<data>");
+
+  // must be a multiple of the bytes in a hex line
+  const uint64_t blockSize = 1024 * hexBytesPerLine;
+
+  std::vector<byte> contents;
+  contents.resize((size_t)RDCMIN(blockSize, reader->GetSize()));
+
+  std::string encoded;
+
+  // leading newline for hex data
+  if(!(props.flags & SectionFlags::ASCIIStored))
+    writer.write("\n");
+
+  while(!reader->AtEnd())
+  {
+    size_t len = (size_t)RDCMIN(blockSize, reader->GetSize() - reader->GetOffset());
+
+    if(!reader->Read(contents.data(), len))
+      break;
+
+    if(props.flags & SectionFlags::ASCIIStored)
+    {
+      // insert the contents literally, up to any trailing NULL
+      size_t textLen = 0;
+      while(textLen < len && contents[textLen] != 0)
+        textLen++;
+
+      WriteEscapedXML(writer, (const char *)contents.data(), textLen);
+
+      if(textLen < len)
+        break;
+    }
+    else
+    {
+      // encode to simple hex. Not efficient, but easy.
+      encoded.clear();
+      HexEncode(contents.data(), len, encoded);
+      writer.write(encoded.data(), encoded.size());
+    }
+  }
+
+  writer.write("</data>\n\t</section>\n");
+}
+
+static void Chunk2XML(pugi::xml_node &parent, SDChunk *chunk)
+{
+  pugi::xml_node xChunk = parent.append_child("chunk");
+
+  xChunk.append_attribute("id") = chunk->metadata.chunkID;
+  xChunk.append_attribute("name") = chunk->name.c_str();
+  xChunk.append_attribute("length") = chunk->metadata.length;
+  if(chunk->metadata.threadID)
+    xChunk.append_attribute("threadID") = chunk->metadata.threadID;
+  if(chunk->metadata.timestampMicro)
+    xChunk.append_attribute("timestamp") = chunk->metadata.timestampMicro;
+  if(chunk->metadata.durationMicro >= 0)
+    xChunk.append_attribute("duration") = chunk->metadata.durationMicro;
+  if(!chunk->metadata.callstack.empty())
+  {
+    pugi::xml_node stack = xChunk.append_child("callstack");
+
+    for(size_t i = 0; i < chunk->metadata.callstack.size(); i++)
+    {
+      stack.append_child("address").text() = chunk->metadata.callstack[i];
+    }
+  }
+
+  if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
+  {
+    xChunk.append_attribute("opaque") = true;
+
+    RDCASSERT(!chunk->data.children.empty());
+    pugi::xml_node opaque = xChunk.append_child("buffer");
+    opaque.append_attribute("byteLength") = chunk->data.children[0]->type.byteSize;
+    opaque.text() = chunk->data.children[0]->data.basic.u;
+  }
+  else
+  {
+    for(size_t o = 0; o < chunk->data.children.size(); o++)
+      Obj2XML(xChunk, *chunk->data.children[o]);
+  }
+}
+
+// the document is written out as we go, with only one chunk at a time converted to nodes, so that
+// the memory needed doesn't scale with the size of the capture.
 static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, uint64_t version,
                                    const StructuredChunkList &chunks,
                                    RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
+  xml_file_writer writer(filename);
 
-  pugi::xml_node xRoot = doc.append_child("rdc");
+  writer.write("<?xml version=\"1.0\"?>\n<rdc>\n");
+
+  pugi::xml_document doc;
 
   {
-    pugi::xml_node xHeader = xRoot.append_child("header");
+    pugi::xml_node xHeader = doc.append_child("header");
 
     pugi::xml_node xDriver = xHeader.append_child("driver");
     xDriver.append_attribute("id") = (uint32_t)file.GetDriver();
@@ -293,6 +440,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
       xThumbnail.append_attribute("height") = th.height;
       xThumbnail.text() = "thumb.jpg";
     }
+
+    xHeader.print(writer, "\t", pugi::format_default, pugi::encoding_auto, 1);
   }
 
   if(progress)
@@ -308,43 +457,7 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
 
     StreamReader *reader = file.ReadSection(i);
 
-    pugi::xml_node xSection = xRoot.append_child("section");
-
-    if(props.flags & SectionFlags::ASCIIStored)
-      xSection.append_attribute("ascii");
-    if(props.flags & SectionFlags::LZ4Compressed)
-      xSection.append_attribute("lz4");
-    if(props.flags & SectionFlags::ZstdCompressed)
-      xSection.append_attribute("zstd");
-
-    pugi::xml_node name = xSection.append_child("name");
-    name.text() = props.name.c_str();
-
-    pugi::xml_node secVer = xSection.append_child("version");
-    secVer.text() = props.version;
-
-    pugi::xml_node type = xSection.append_child("type");
-    type.text() = (uint32_t)props.type;
-
-    std::vector<byte> contents;
-    contents.resize((size_t)reader->GetSize());
-    reader->Read(contents.data(), reader->GetSize());
-
-    pugi::xml_node data = xSection.append_child("data");
-
-    if(props.flags & SectionFlags::ASCIIStored)
-    {
-      // insert the contents literally
-      data.text().set((char *)contents.data());
-    }
-    else
-    {
-      // encode to simple hex. Not efficient, but easy.
-      std::string hexdata;
-      hexdata.reserve(contents.size() * 2);
-      HexEncode(contents, hexdata);
-      data.text().set(hexdata.c_str());
-    }
+    Section2XML(writer, props, reader);
 
     delete reader;
   }
@@ -352,63 +465,33 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xRoot.append_child("chunks");
-
-  xChunks.append_attribute("version") = version;
+  writer.write(StringFormat::Fmt("\t<chunks version=\"%llu\">\n", version).c_str());
 
   for(size_t c = 0; c < chunks.size(); c++)
   {
-    pugi::xml_node xChunk = xChunks.append_child("chunk");
-    SDChunk *chunk = chunks[c];
+    doc.reset();
 
-    xChunk.append_attribute("id") = chunk->metadata.chunkID;
-    xChunk.append_attribute("name") = chunk->name.c_str();
-    xChunk.append_attribute("length") = chunk->metadata.length;
-    if(chunk->metadata.threadID)
-      xChunk.append_attribute("threadID") = chunk->metadata.threadID;
-    if(chunk->metadata.timestampMicro)
-      xChunk.append_attribute("timestamp") = chunk->metadata.timestampMicro;
-    if(chunk->metadata.durationMicro >= 0)
-      xChunk.append_attribute("duration") = chunk->metadata.durationMicro;
-    if(!chunk->metadata.callstack.empty())
-    {
-      pugi::xml_node stack = xChunk.append_child("callstack");
-
-      for(size_t i = 0; i < chunk->metadata.callstack.size(); i++)
-      {
-        stack.append_child("address").text() = chunk->metadata.callstack[i];
-      }
-    }
+    Chunk2XML(doc, chunks[c]);
 
-    if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
-    {
-      xChunk.append_attribute("opaque") = true;
+    doc.first_child().print(writer, "\t", pugi::format_default, pugi::encoding_auto, 2);
 
-      RDCASSERT(!chunk->data.children.empty());
-      pugi::xml_node opaque = xChunk.append_child("buffer");
-      opaque.append_attribute("byteLength") = chunk->data.children[0]->type.byteSize;
-      opaque.text() = chunk->data.children[0]->data.basic.u;
-    }
-    else
-    {
-      for(size_t o = 0; o < chunk->data.children.size(); o++)
-        Obj2XML(xChunk, *chunk->data.children[o]);
-    }
+    if(writer.stream.IsErrored())
+      return ReplayStatus::FileIOFailed;
 
     if(progress)
       progress(StructuredProgress(0.2f + 0.8f * (float(c) / float(chunks.size()))));
   }
 
-  xml_file_writer writer(filename);
-  doc.save(writer);
+  writer.write("\t</chunks>\n</rdc>\n");
 
   return writer.stream.IsErrored() ? ReplayStatus::FileIOFailed : ReplayStatus::Succeeded;
 }
 
 static SDObject *XML2Obj(pugi::xml_node &obj)
 {
-  SDObject *ret =
-      new SDObject(obj.attribute("name").as_string(), obj.attribute("typename").as_string());
+  // names are interned as there are typically only a few distinct ones repeated many times
+  SDObject *ret = new SDObject(InternString(obj.attribute("name").as_string()),
+                               InternString(obj.attribute("typename").as_string()));
 
   std::string name = obj.name();
 
@@ -440,9 +523,9 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
     ret->type.flags |= SDTypeFlags::Union;
 
   if(obj.attribute("typename"))
-    ret->type.name = obj.attribute("typename").as_string();
+    ret->type.name = InternString(obj.attribute("typename").as_string());
 
-  ret->name = obj.attribute("name").as_string();
+  ret->name = InternString(obj.attribute("name").as_string());
 
   if(ret->type.basetype == SDBasic::Chunk)
   {
@@ -459,7 +542,7 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
       ret->data.children.push_back(XML2Obj(child));
 
       if(ret->type.basetype == SDBasic::Array)
-        ret->data.children.back()->name = "$el";
+        ret->data.children.back()->name = rdcinflexiblestr::Literal("$el");
     }
 
     if(ret->type.basetype == SDBasic::Array && !ret->data.children.empty())
@@ -498,24 +581,382 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
   return ret;
 }
 
-static ReplayStatus XML2Structured(const char *xml, const StructuredBufferList &buffers,
+// reads an xml document from a stream one element at a time, so that only the element currently
+// being processed needs to be held in memory and parsed. The caller walks the tags at the top of the
+// document and reads whichever elements it wants in full.
+class XMLStreamReader
+{
+public:
+  enum class TagType
+  {
+    Open,
+    Close,
+    Empty,
+  };
+
+  XMLStreamReader(StreamReader &reader) : m_Reader(reader) {}
+  // reads the next element tag, skipping over any text, comments, processing instructions or
+  // doctype declarations. Returns false at the end of the document or on malformed input.
+  bool NextTag(TagType &type, std::string &name)
+  {
+    // discard anything we've already processed, once it's a good fraction of the buffer
+    if(m_Pos > 0 && m_Pos >= m_Buf.size() / 2)
+    {
+      m_Buf.erase(0, m_Pos);
+      m_Pos = 0;
+    }
+
+    for(;;)
+    {
+      if(!Find(m_Pos, '<'))
+        return false;
+
+      m_TagStart = m_Pos;
+
+      bool markup = false;
+      if(!SkipMarkup(m_Pos, markup))
+        return false;
+
+      if(markup)
+        continue;
+
+      if(!ReadTag(m_Pos, m_TagType, name))
+        return false;
+
+      type = m_TagType;
+      return true;
+    }
+  }
+
+  // after NextTag returns an open or empty tag, reads the whole element and parses it into doc.
+  // Returns a NULL node if the element couldn't be read or parsed.
+  pugi::xml_node ReadElement(pugi::xml_document &doc)
+  {
+    size_t pos = m_Pos;
+
+    if(m_TagType == TagType::Open)
+    {
+      int depth = 1;
+
+      std::string name;
+      TagType type;
+
+      while(depth > 0)
+      {
+        if(!Find(pos, '<'))
+          return pugi::xml_node();
+
+        bool markup = false;
+        if(!SkipMarkup(pos, markup))
+          return pugi::xml_node();
+
+        if(markup)
+          continue;
+
+        if(!ReadTag(pos, type, name))
+          return pugi::xml_node();
+
+        if(type == TagType::Open)
+          depth++;
+        else if(type == TagType::Close)
+          depth--;
+      }
+    }
+    else if(m_TagType == TagType::Close)
+    {
+      return pugi::xml_node();
+    }
+
+    m_Pos = pos;
+
+    if(!doc.load_buffer(m_Buf.data() + m_TagStart, m_Pos - m_TagStart))
+      return pugi::xml_node();
+
+    return doc.first_child();
+  }
+
+  // parses only the attributes of the last tag returned by NextTag, without reading its contents.
+  pugi::xml_node ReadTagAttributes(pugi::xml_document &doc)
+  {
+    std::string tag = m_Buf.substr(m_TagStart, m_Pos - m_TagStart);
+
+    if(m_TagType == TagType::Open)
+      tag.insert(tag.size() - 1, "/");
+
+    if(!doc.load_buffer(tag.data(), tag.size()))
+      return pugi::xml_node();
+
+    return doc.first_child();
+  }
+
+  float Progress()
+  {
+    return m_Reader.GetSize() ? float(m_Reader.GetOffset()) / float(m_Reader.GetSize()) : 1.0f;
+  }
+
+private:
+  // makes sure the buffer contains the byte at pos, reading more of the stream if needed.
+  bool Available(size_t pos)
+  {
+    while(pos >= m_Buf.size())
+    {
+      if(m_Reader.AtEnd() || m_Reader.IsErrored())
+        return false;
+
+      const uint64_t blockSize = 1024 * 1024;
+      size_t len = (size_t)RDCMIN(blockSize, m_Reader.GetSize() - m_Reader.GetOffset());
+
+      size_t prev = m_Buf.size();
+      m_Buf.resize(prev + len);
+      if(!m_Reader.Read(&m_Buf[prev], len))
+      {
+        m_Buf.resize(prev);
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool Find(size_t &pos, char c)
+  {
+    while(Available(pos))
+    {
+      if(m_Buf[pos] == c)
+        return true;
+      pos++;
+    }
+
+    return false;
+  }
+
+  bool Find(size_t &pos, const char *str)
+  {
+    const size_t len = strlen(str);
+
+    for(;;)
+    {
+      if(!Find(pos, str[0]) || !Available(pos + len - 1))
+        return false;
+
+      if(!m_Buf.compare(pos, len, str))
+      {
+        pos += len;
+        return true;
+      }
+
+      pos++;
+    }
+  }
+
+  bool StartsWith(size_t pos, const char *str)
+  {
+    const size_t len = strlen(str);
+    return Available(pos + len - 1) && !m_Buf.compare(pos, len, str);
+  }
+
+  // if pos is at a comment, CDATA section, processing instruction or declaration, skips over it.
+  bool SkipMarkup(size_t &pos, bool &skipped)
+  {
+    skipped = true;
+
+    if(StartsWith(pos, "<?"))
+      return Find(pos, "?>");
+    if(StartsWith(pos, "<!--"))
+      return Find(pos, "-->");
+    if(StartsWith(pos, "<![CDATA["))
+      return Find(pos, "]]>");
+    if(StartsWith(pos, "<!"))
+      return Find(pos, ">");
+
+    skipped = false;
+    return true;
+  }
+
+  // reads a start, end or empty-element tag at pos, leaving pos just after it.
+  bool ReadTag(size_t &pos, TagType &type, std::string &name)
+  {
+    pos++;
+
+    type = TagType::Open;
+
+    if(Available(pos) && m_Buf[pos] == '/')
+    {
+      type = TagType::Close;
+      pos++;
+    }
+
+    size_t nameStart = pos;
+
+    while(Available(pos) && m_Buf[pos] != '>' && m_Buf[pos] != '/' && m_Buf[pos] != ' ' &&
+          m_Buf[pos] != '\t' && m_Buf[pos] != '\r' && m_Buf[pos] != '\n')
+      pos++;
+
+    name = m_Buf.substr(nameStart, pos - nameStart);
+
+    // skip over attributes, taking care with any quoted values
+    char quote = 0;
+
+    while(Available(pos))
+    {
+      char c = m_Buf[pos++];
+
+      if(quote)
+      {
+        if(c == quote)
+          quote = 0;
+      }
+      else if(c == '"' || c == '\'')
+      {
+        quote = c;
+      }
+      else if(c == '>')
+      {
+        if(type == TagType::Open && m_Buf[pos - 2] == '/')
+          type = TagType::Empty;
+
+        return !name.empty();
+      }
+    }
+
+    return false;
+  }
+
+  StreamReader &m_Reader;
+
+  std::string m_Buf;
+  size_t m_Pos = 0;
+  size_t m_TagStart = 0;
+  TagType m_TagType = TagType::Close;
+};
+
+static void XML2Section(pugi::xml_node &xSection, RDCFile *rdc)
+{
+  SectionProperties props;
+
+  if(xSection.attribute("ascii"))
+    props.flags |= SectionFlags::ASCIIStored;
+  if(xSection.attribute("lz4"))
+    props.flags |= SectionFlags::LZ4Compressed;
+  if(xSection.attribute("zstd"))
+    props.flags |= SectionFlags::ZstdCompressed;
+  if(xSection.attribute("blockindexed"))
+    props.flags |= SectionFlags::BlockIndexed;
+
+  pugi::xml_node name = xSection.child("name");
+  if(!name)
+  {
+    RDCERR("Malformed section, expected name node");
+    return;
+  }
+  props.name = name.text().as_string();
+
+  pugi::xml_node secVer = xSection.child("version");
+  if(!secVer)
+  {
+    RDCERR("Malformed section, expected version node");
+    return;
+  }
+  props.version = secVer.text().as_ullong();
+
+  pugi::xml_node type = xSection.child("type");
+  if(!type)
+  {
+    RDCERR("Malformed section, expected type node");
+    return;
+  }
+  props.type = (SectionType)type.text().as_uint();
+
+  pugi::xml_node data = xSection.child("data");
+  if(!data)
+  {
+    RDCERR("Malformed section, expected data node");
+    return;
+  }
+
+  const char *str = (const char *)data.text().get();
+  size_t len = strlen(str);
+
+  StreamWriter *writer = rdc->WriteSection(props);
+
+  if(props.flags & SectionFlags::ASCIIStored)
+  {
+    writer->Write(str, len);
+  }
+  else
+  {
+    std::vector<byte> decoded;
+    HexDecode(str, str + len, decoded);
+    writer->Write(decoded.data(), decoded.size());
+  }
+
+  writer->Finish();
+  delete writer;
+}
+
+static SDChunk *XML2Chunk(pugi::xml_node &xChunk)
+{
+  SDChunk *chunk = new SDChunk(InternString(xChunk.attribute("name").as_string()));
+
+  chunk->metadata.chunkID = xChunk.attribute("id").as_uint();
+  chunk->metadata.length = xChunk.attribute("length").as_uint();
+  if(xChunk.attribute("threadID"))
+    chunk->metadata.threadID = xChunk.attribute("threadID").as_uint();
+  if(xChunk.attribute("timestamp"))
+    chunk->metadata.timestampMicro = xChunk.attribute("timestamp").as_ullong();
+  if(xChunk.attribute("duration"))
+    chunk->metadata.durationMicro = xChunk.attribute("duration").as_ullong();
+
+  pugi::xml_node callstack = xChunk.child("callstack");
+  if(callstack)
+  {
+    for(pugi::xml_node address = callstack.first_child(); address; address = address.next_sibling())
+      chunk->metadata.callstack.push_back(address.text().as_ullong());
+  }
+
+  if(xChunk.attribute("opaque"))
+  {
+    pugi::xml_node opaque = xChunk.child("buffer");
+
+    chunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
+
+    chunk->data.children.push_back(new SDObject("Opaque chunk", "Byte Buffer"));
+    chunk->data.children[0]->type.basetype = SDBasic::Buffer;
+    chunk->data.children[0]->type.byteSize = opaque.attribute("byteLength").as_ullong();
+    chunk->data.children[0]->data.basic.u = opaque.text().as_ullong();
+  }
+  else
+  {
+    for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
+      chunk->data.children.push_back(XML2Obj(child));
+  }
+
+  return chunk;
+}
+
+static ReplayStatus XML2Structured(StreamReader &reader, const StructuredBufferList &buffers,
                                    RDCFile *rdc, uint64_t &version, StructuredChunkList &chunks,
                                    RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
-  doc.load_string(xml);
+  XMLStreamReader xml(reader);
 
-  pugi::xml_node root = doc.child("rdc");
+  XMLStreamReader::TagType tagType;
+  std::string tagName;
 
-  if(!root)
+  if(!xml.NextTag(tagType, tagName) || tagType != XMLStreamReader::TagType::Open || tagName != "rdc")
   {
     RDCERR("Malformed document, expected rdc node");
     return ReplayStatus::FileCorrupted;
   }
 
-  pugi::xml_node xHeader = root.first_child();
+  pugi::xml_document doc;
 
-  if(strcmp(xHeader.name(), "header"))
+  pugi::xml_node xHeader;
+
+  if(xml.NextTag(tagType, tagName) && tagName == "header")
+    xHeader = xml.ReadElement(doc);
+
+  if(!xHeader)
   {
     RDCERR("Malformed document, expected header node");
     return ReplayStatus::FileCorrupted;
@@ -562,91 +1003,43 @@ static ReplayStatus XML2Structured(const char *xml, const StructuredBufferList &
     rdc->SetData(driver, driverName.c_str(), machineIdent, thumb);
   }
 
-  // push in other sections
-  pugi::xml_node xSection = xHeader.next_sibling();
-
   if(progress)
     progress(StructuredProgress(0.1f));
 
-  while(!strcmp(xSection.name(), "section"))
+  // push in other sections
+  for(;;)
   {
-    SectionProperties props;
-
-    if(xSection.attribute("ascii"))
-      props.flags |= SectionFlags::ASCIIStored;
-    if(xSection.attribute("lz4"))
-      props.flags |= SectionFlags::LZ4Compressed;
-    if(xSection.attribute("zstd"))
-      props.flags |= SectionFlags::ZstdCompressed;
-
-    pugi::xml_node name = xSection.child("name");
-    if(!name)
-    {
-      RDCERR("Malformed section, expected name node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.name = name.text().as_string();
-
-    pugi::xml_node secVer = xSection.child("version");
-    if(!secVer)
-    {
-      RDCERR("Malformed section, expected version node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.version = secVer.text().as_ullong();
-
-    pugi::xml_node type = xSection.child("type");
-    if(!type)
+    if(!xml.NextTag(tagType, tagName))
     {
-      RDCERR("Malformed section, expected type node");
-      xSection = xSection.next_sibling();
-      continue;
-    }
-    props.type = (SectionType)type.text().as_uint();
-
-    pugi::xml_node data = xSection.child("data");
-    if(!data)
-    {
-      RDCERR("Malformed section, expected data node");
-      xSection = xSection.next_sibling();
-      continue;
+      RDCERR("Malformed document, expected chunks node");
+      return ReplayStatus::FileCorrupted;
     }
 
-    const char *str = (const char *)data.text().get();
-    size_t len = strlen(str);
+    if(tagName != "section")
+      break;
 
-    StreamWriter *writer = rdc->WriteSection(props);
+    pugi::xml_node xSection = xml.ReadElement(doc);
 
-    if(props.flags & SectionFlags::ASCIIStored)
+    if(!xSection)
     {
-      writer->Write(str, len);
-    }
-    else
-    {
-      std::vector<byte> decoded;
-      HexDecode(str, str + len, decoded);
-      writer->Write(decoded.data(), decoded.size());
+      RDCERR("Malformed document, couldn't read section");
+      return ReplayStatus::FileCorrupted;
     }
 
-    writer->Finish();
-    delete writer;
-
-    xSection = xSection.next_sibling();
+    XML2Section(xSection, rdc);
   }
 
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xSection;
-
-  if(strcmp(xSection.name(), "chunks"))
+  if(tagName != "chunks" || tagType == XMLStreamReader::TagType::Close)
   {
     RDCERR("Malformed document, expected chunks node");
     return ReplayStatus::FileCorrupted;
   }
 
+  pugi::xml_node xChunks = xml.ReadTagAttributes(doc);
+
   if(!xChunks.attribute("version"))
   {
     RDCERR("Malformed document, expected version attribute");
@@ -655,59 +1048,33 @@ static ReplayStatus XML2Structured(const char *xml, const StructuredBufferList &
 
   version = xChunks.attribute("version").as_ullong();
 
-  size_t chunkIdx = 0;
-  size_t numChunks = std::distance(xChunks.begin(), xChunks.end());
+  // an empty chunks node has nothing more to read
+  if(tagType == XMLStreamReader::TagType::Empty)
+    return ReplayStatus::Succeeded;
 
-  for(pugi::xml_node xChunk = xChunks.first_child(); xChunk; xChunk = xChunk.next_sibling())
+  for(;;)
   {
-    if(strcmp(xChunk.name(), "chunk"))
-      return ReplayStatus::FileCorrupted;
-
-    SDChunk *chunk = new SDChunk(xChunk.attribute("name").as_string());
-
-    chunk->metadata.chunkID = xChunk.attribute("id").as_uint();
-    chunk->metadata.length = xChunk.attribute("length").as_uint();
-    if(xChunk.attribute("threadID"))
-      chunk->metadata.threadID = xChunk.attribute("threadID").as_uint();
-    if(xChunk.attribute("timestamp"))
-      chunk->metadata.timestampMicro = xChunk.attribute("timestamp").as_ullong();
-    if(xChunk.attribute("duration"))
-      chunk->metadata.durationMicro = xChunk.attribute("duration").as_ullong();
-
-    pugi::xml_node callstack = xChunk.child("callstack");
-    if(callstack)
+    if(!xml.NextTag(tagType, tagName))
     {
-      size_t i = 0;
-      for(pugi::xml_node address = callstack.first_child(); address; address = address.next_sibling())
-      {
-        chunk->metadata.callstack.push_back(address.text().as_ullong());
-        i++;
-      }
+      RDCERR("Malformed document, unterminated chunks node");
+      return ReplayStatus::FileCorrupted;
     }
 
-    if(xChunk.attribute("opaque"))
-    {
-      pugi::xml_node opaque = xChunk.child("buffer");
+    if(tagType == XMLStreamReader::TagType::Close)
+      break;
 
-      chunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
+    if(tagName != "chunk")
+      return ReplayStatus::FileCorrupted;
 
-      chunk->data.children.push_back(new SDObject("Opaque chunk", "Byte Buffer"));
-      chunk->data.children[0]->type.basetype = SDBasic::Buffer;
-      chunk->data.children[0]->type.byteSize = opaque.attribute("byteLength").as_ullong();
-      chunk->data.children[0]->data.basic.u = opaque.text().as_ullong();
-    }
-    else
-    {
-      for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
-        chunk->data.children.push_back(XML2Obj(child));
-    }
+    pugi::xml_node xChunk = xml.ReadElement(doc);
 
-    chunks.push_back(chunk);
+    if(!xChunk)
+      return ReplayStatus::FileCorrupted;
 
-    if(progress)
-      progress(StructuredProgress(0.2f + 0.8f * (float(chunkIdx) / float(numChunks))));
+    chunks.push_back(XML2Chunk(xChunk));
 
-    chunkIdx++;
+    if(progress)
+      progress(StructuredProgress(0.2f + 0.8f * xml.Progress()));
   }
 
   return ReplayStatus::Succeeded;
@@ -781,6 +1148,12 @@ static bool ZIP2Buffers(const std::string &filename, StructuredBufferList &buffe
 
       byte *buf = (byte *)mz_zip_reader_extract_to_heap(&zip, i, &sz, 0);
 
+      if(!buf)
+      {
+        RDCERR("Failed to extract %s from zip", zstat.m_filename);
+        continue;
+      }
+
       if(strcmp(zstat.m_filename, "thumb.jpg"))
       {
         int bufname = atoi(zstat.m_filename);
@@ -798,6 +1171,9 @@ static bool ZIP2Buffers(const std::string &filename, StructuredBufferList &buffe
         buffers.back()->assign(buf, sz);
       }
 
+      // free the extracted copy now, rather than holding every buffer in memory twice
+      zip.m_pFree(zip.m_pAlloc_opaque, buf);
+
       if(progress)
         progress(BufferProgress(float(i) / float(numfiles)));
     }
@@ -821,12 +1197,7 @@ ReplayStatus importXMLZ(const char *filename, StreamReader &reader, RDCFile *rdc
     }
   }
 
-  uint64_t len = reader.GetSize();
-  char *buf = new char[(size_t)len + 1];
-  reader.Read(buf, (size_t)len);
-  buf[len] = 0;
-
-  return XML2Structured(buf, structData.buffers, rdc, structData.version, structData.chunks,
+  return XML2Structured(reader, structData.buffers, rdc, structData.version, structData.chunks,
                         progress);
 }
 
@@ -863,4 +1234,139 @@ static ConversionRegistration XMLOnlyConversionRegistration(
         R"(Stores the structured data in an xml tree, with large buffer data omitted - that makes it
 easier to work with but it cannot then be imported.)",
         false,
-    });
\ No newline at end of file
+    });
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Round-trip structured data through streamed XML", "[serialiser][xml]")
+{
+  std::string filename = FileIO::GetTempFolderFilename() + "/renderdoc_xml_roundtrip.xml";
+
+  RDCFile rdc;
+  rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0x1234, NULL);
+
+  std::string notes = "Notes with <markup> & \"quotes\"\nover several lines";
+
+  // large enough to be streamed in several blocks, and not a whole number of hex lines
+  std::vector<byte> binary;
+  binary.resize(70001);
+  for(size_t i = 0; i < binary.size(); i++)
+    binary[i] = byte((i * 7) & 0xff);
+
+  {
+    SectionProperties props;
+    props.type = SectionType::Notes;
+    props.name = ToStr(props.type);
+    props.flags = SectionFlags::ASCIIStored;
+    props.version = 1;
+
+    StreamWriter *writer = rdc.WriteSection(props);
+    writer->Write(notes.c_str(), notes.size());
+    writer->Finish();
+    delete writer;
+
+    props.type = SectionType::ResolveDatabase;
+    props.name = ToStr(props.type);
+    props.flags = SectionFlags::NoFlags;
+    props.version = 2;
+
+    writer = rdc.WriteSection(props);
+    writer->Write(binary.data(), binary.size());
+    writer->Finish();
+    delete writer;
+  }
+
+  SDFile file;
+  file.version = 0x42;
+
+  for(uint32_t i = 0; i < 50; i++)
+  {
+    SDChunk *chunk = new SDChunk("TestChunk");
+    chunk->metadata.chunkID = 1000 + i;
+    chunk->metadata.length = 64;
+
+    chunk->data.children.push_back(makeSDUInt32("index", i));
+    chunk->data.children.push_back(makeSDString("text", "<tricky> & \"quoted\" text"));
+
+    SDObject *values = makeSDArray("values");
+    for(uint32_t j = 0; j < i % 4; j++)
+      values->data.children.push_back(makeSDFloat("$el", float(j) * 1.5f));
+    chunk->data.children.push_back(values);
+
+    file.chunks.push_back(chunk);
+  }
+
+  // a chunk without any contents is written as an empty element
+  file.chunks.push_back(new SDChunk("EmptyChunk"));
+
+  REQUIRE(exportXMLOnly(filename.c_str(), rdc, file, NULL) == ReplayStatus::Succeeded);
+
+  RDCFile importedRDC;
+  SDFile imported;
+
+  {
+    StreamReader reader(FileIO::fopen(filename.c_str(), "rb"));
+    CHECK(importXMLZ(NULL, reader, &importedRDC, imported, NULL) == ReplayStatus::Succeeded);
+  }
+
+  FileIO::Delete(filename.c_str());
+
+  CHECK(importedRDC.GetDriver() == RDCDriver::Vulkan);
+  CHECK(importedRDC.GetDriverName() == "Vulkan");
+  CHECK(importedRDC.GetMachineIdent() == 0x1234);
+
+  REQUIRE(importedRDC.NumSections() == 2);
+
+  {
+    StreamReader *reader = importedRDC.ReadSection(0);
+
+    std::string readNotes;
+    readNotes.resize((size_t)reader->GetSize());
+    reader->Read(&readNotes[0], reader->GetSize());
+    delete reader;
+
+    CHECK(importedRDC.GetSectionProperties(0).type == SectionType::Notes);
+    CHECK(readNotes == notes);
+
+    reader = importedRDC.ReadSection(1);
+
+    std::vector<byte> readBinary;
+    readBinary.resize((size_t)reader->GetSize());
+    reader->Read(readBinary.data(), reader->GetSize());
+    delete reader;
+
+    CHECK(importedRDC.GetSectionProperties(1).type == SectionType::ResolveDatabase);
+    CHECK(importedRDC.GetSectionProperties(1).version == 2);
+    CHECK(readBinary == binary);
+  }
+
+  CHECK(imported.version == 0x42);
+  REQUIRE(imported.chunks.size() == file.chunks.size());
+
+  for(size_t c = 0; c < file.chunks.size(); c++)
+  {
+    SDChunk *a = file.chunks[c];
+    SDChunk *b = imported.chunks[c];
+
+    CHECK(std::string(b->name.c_str()) == a->name.c_str());
+    CHECK(b->metadata.chunkID == a->metadata.chunkID);
+    REQUIRE(b->data.children.size() == a->data.children.size());
+
+    if(a->data.children.empty())
+      continue;
+
+    CHECK(b->data.children[0]->data.basic.u == a->data.children[0]->data.basic.u);
+    CHECK(b->data.children[1]->data.str == a->data.children[1]->data.str);
+
+    SDObject *aValues = a->data.children[2];
+    SDObject *bValues = b->data.children[2];
+
+    REQUIRE(bValues->data.children.size() == aValues->data.children.size());
+
+    for(size_t j = 0; j < aValues->data.children.size(); j++)
+      CHECK(bValues->data.children[j]->data.basic.d == aValues->data.children[j]->data.basic.d);
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -29,6 +29,7 @@
 #if ENABLED(ENABLE_UNIT_TESTS)
 
 #include "3rdparty/catch/catch.hpp"
+#include "blockio.h"
 
 TEST_CASE("Test LZ4 compression/decompression", "[streamio][lz4]")
 {
@@ -190,4 +191,177 @@ TEST_CASE("Test ZSTD compression/decompression", "[streamio][zstd]")
   delete[] randomData;
 };
 
+TEST_CASE("Test block-indexed compression/decompression", "[streamio][blockindexed]")
+{
+  const uint64_t blockSize = BlockCompression::BlockSize;
+
+  // use a size that isn't a multiple of the block size so the last block is partial
+  const uint64_t dataSize = blockSize * 5 + 12345;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  // mostly short runs so every codec can compress it, with some noise mixed in
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 97) ? byte((i / 16) & 0xff) : byte(rand() & 0xff);
+
+  for(BlockCodec codec : {BlockCodec::LZ4, BlockCodec::Zstd})
+  {
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writer(new BlockCompressor(&buf, codec, Ownership::Nothing), Ownership::Stream);
+
+      // write in odd-sized pieces to make sure writes spanning blocks work
+      for(uint64_t offs = 0; offs < dataSize; offs += 77777)
+        writer.Write(data + offs, RDCMIN<uint64_t>(77777, dataSize - offs));
+
+      CHECK(writer.GetOffset() == dataSize);
+      CHECK_FALSE(writer.IsErrored());
+
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    CHECK(buf.GetOffset() < dataSize);
+
+    // compressing with several blocks in flight must produce exactly the same output
+    {
+      StreamWriter threadedBuf(StreamWriter::DefaultScratchSize);
+
+      {
+        StreamWriter writer(new BlockCompressor(&threadedBuf, codec, Ownership::Nothing, 4),
+                            Ownership::Stream);
+
+        for(uint64_t offs = 0; offs < dataSize; offs += 77777)
+          writer.Write(data + offs, RDCMIN<uint64_t>(77777, dataSize - offs));
+
+        writer.Finish();
+
+        CHECK_FALSE(writer.IsErrored());
+      }
+
+      REQUIRE(threadedBuf.GetOffset() == buf.GetOffset());
+      CHECK_FALSE(memcmp(threadedBuf.GetData(), buf.GetData(), (size_t)buf.GetOffset()));
+    }
+
+    byte *readData = new byte[(size_t)dataSize];
+
+    // read back sequentially
+    {
+      StreamReader reader(
+          new BlockDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream),
+          dataSize, Ownership::Stream);
+
+      reader.Read(readData, dataSize);
+
+      CHECK_FALSE(reader.IsErrored());
+      CHECK(reader.AtEnd());
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+    }
+
+    // seek around and read from random locations
+    {
+      StreamReader reader(
+          new BlockDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream),
+          dataSize, Ownership::Stream);
+
+      // seek forwards past several blocks, backwards, and within the same block
+      uint64_t offsets[] = {blockSize * 4 + 100, 50, blockSize * 2 - 10, blockSize * 2 + 500,
+                            dataSize - 1000, blockSize * 5};
+
+      for(uint64_t offs : offsets)
+      {
+        reader.SetOffset(offs);
+        CHECK(reader.GetOffset() == offs);
+
+        reader.Read(readData, 1000);
+
+        CHECK_FALSE(reader.IsErrored());
+        CHECK_FALSE(memcmp(readData, data + offs, 1000));
+      }
+
+      reader.SetOffset(dataSize);
+      CHECK(reader.AtEnd());
+      CHECK_FALSE(reader.IsErrored());
+    }
+
+    // recompress to a streaming codec
+    {
+      BlockDecompressor decomp(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream);
+
+      StreamWriter recomp(StreamWriter::DefaultScratchSize);
+      {
+        LZ4Compressor comp(&recomp, Ownership::Nothing);
+        CHECK(decomp.Recompress(&comp));
+      }
+
+      StreamReader reader(
+          new LZ4Decompressor(new StreamReader(recomp.GetData(), recomp.GetOffset()),
+                              Ownership::Stream),
+          dataSize, Ownership::Stream);
+
+      reader.Read(readData, dataSize);
+
+      CHECK_FALSE(reader.IsErrored());
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+    }
+
+    delete[] readData;
+  }
+
+  delete[] data;
+};
+
+TEST_CASE("Benchmark compression throughput", "[streamio][!benchmark]")
+{
+  // 256MB of data that compresses moderately well, similar to typical buffer/texture contents
+  const uint64_t dataSize = 256 * 1024 * 1024;
+
+  byte *data = AllocAlignedBuffer(dataSize);
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = (i % 7) ? byte((i >> 4) & 0xff) : byte(rand() & 0xff);
+
+  // writes to a scratch buffer and discards, so that we're only measuring compression
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  auto compress = [&](Compressor *comp) {
+    buf.Rewind();
+
+    StreamWriter writer(comp, Ownership::Stream);
+
+    for(uint64_t offs = 0; offs < dataSize; offs += 64 * 1024)
+      writer.Write(data + offs, 64 * 1024);
+
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  };
+
+  BENCHMARK("LZ4Compressor") { compress(new LZ4Compressor(&buf, Ownership::Nothing)); }
+
+  BENCHMARK("ZSTDCompressor") { compress(new ZSTDCompressor(&buf, Ownership::Nothing)); }
+
+  // blocks are compressed on the shared job pool, so the parallelism is capped by its thread count
+  // as well as by how many blocks are allowed in flight.
+  for(uint32_t maxInFlight : {1U, 4U, 16U})
+  {
+    BENCHMARK(StringFormat::Fmt("BlockCompressor LZ4, %u in-flight blocks", maxInFlight))
+    {
+      compress(new BlockCompressor(&buf, BlockCodec::LZ4, Ownership::Nothing, maxInFlight));
+    }
+  }
+
+  for(uint32_t maxInFlight : {1U, 4U, 16U})
+  {
+    BENCHMARK(StringFormat::Fmt("BlockCompressor Zstd, %u in-flight blocks", maxInFlight))
+    {
+      compress(new BlockCompressor(&buf, BlockCodec::Zstd, Ownership::Nothing, maxInFlight));
+    }
+  }
+
+  FreeAlignedBuffer(data);
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -27,6 +27,7 @@
 #include "3rdparty/stb/stb_image.h"
 #include "api/replay/version.h"
 #include "common/dds_readwrite.h"
+#include "blockio.h"
 #include "lz4io.h"
 #include "zstdio.h"
 
@@ -48,13 +49,14 @@ bool is_exr_file(FILE *f)
 /*
 
  -----------------------------
- File format for version 0x100:
+ File format for version 0x101. Version 0x100 is identical except that no section may have the
+ BlockIndexed flag:
 
  RDCHeader
  {
    uint64_t MAGIC_HEADER;
 
-   uint32_t version = 0x00000100;
+   uint32_t version = 0x00000101;
    uint32_t headerLength; // length of this header, from the start of the file. Allows adding new
                           // fields without breaking compatibilty
    char progVersion[16]; // string "v0.34" or similar with 0s after the string
@@ -315,7 +317,7 @@ void RDCFile::Init(StreamReader &reader)
 
   m_SerVer = header.version;
 
-  if(m_SerVer != SERIALISE_VERSION)
+  if(m_SerVer < V1_0_VERSION || m_SerVer > SERIALISE_VERSION)
   {
     if(header.version < V1_0_VERSION)
     {
@@ -559,6 +561,12 @@ void RDCFile::Init(StreamReader &reader)
       loc.dataOffset = reader.GetOffset();
       loc.diskLength = sectionHeader.sectionCompressedLength;
 
+      if((props.flags & SectionFlags::BlockIndexed) && m_SerVer < BLOCK_INDEXED_VERSION)
+      {
+        RETURNERROR(ContainerError::Corrupt, "Block-indexed section '%s' in version %u capture",
+                    props.name.c_str(), m_SerVer);
+      }
+
       m_Sections.push_back(props);
       m_SectionLocations.push_back(loc);
 
@@ -727,7 +735,14 @@ StreamReader *RDCFile::ReadSection(int index) const
 
   StreamReader *compReader = NULL;
 
-  if(props.flags & SectionFlags::LZ4Compressed)
+  if(props.flags & SectionFlags::BlockIndexed)
+  {
+    // the codec is stored in the block index itself, so we don't need to check which compression
+    // flag is set
+    compReader = new StreamReader(new BlockDecompressor(fileReader, Ownership::Stream),
+                                  props.uncompressedSize, Ownership::Stream);
+  }
+  else if(props.flags & SectionFlags::LZ4Compressed)
   {
     // the user will delete the compressed reader, and then it will delete the compressor and the
     // file reader
@@ -1050,7 +1065,20 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
 
   StreamWriter *compWriter = NULL;
 
-  if(props.flags & SectionFlags::LZ4Compressed)
+  if(props.flags & SectionFlags::BlockIndexed)
+  {
+    BlockCodec codec =
+        (props.flags & SectionFlags::ZstdCompressed) ? BlockCodec::Zstd : BlockCodec::LZ4;
+
+    // compress blocks in parallel across the available cores. Each block in flight needs a couple
+    // of blocks worth of memory so we cap it to keep the footprint reasonable on very wide
+    // machines.
+    uint32_t maxInFlight = RDCMIN(Threading::GetNumCores(), 16U);
+
+    compWriter = new StreamWriter(
+        new BlockCompressor(fileWriter, codec, Ownership::Stream, maxInFlight), Ownership::Stream);
+  }
+  else if(props.flags & SectionFlags::LZ4Compressed)
   {
     // the user will delete the compressed writer, and then it will delete the compressor and the
     // file writer
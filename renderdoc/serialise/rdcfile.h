@@ -52,12 +52,16 @@ public:
   // version number of overall file format or chunk organisation. If the contents/meaning/order of
   // chunks have changed this does not need to be bumped, there are version numbers within each
   // API that interprets the stream that can be bumped.
-  static const uint32_t SERIALISE_VERSION = 0x00000100;
+  static const uint32_t SERIALISE_VERSION = 0x00000101;
 
   // this must never be changed - files before this were in the v0.x series and didn't have embedded
   // version numbers
   static const uint32_t V1_0_VERSION = 0x00000100;
 
+  // the first version that can contain SectionFlags::BlockIndexed sections. Older versions are
+  // still read, but older programs must reject files that may contain them.
+  static const uint32_t BLOCK_INDEXED_VERSION = 0x00000101;
+
   ~RDCFile();
 
   // opens an existing file for read and/or modification. Error if file doesn't exist
@@ -86,6 +90,9 @@ public:
   StreamReader *ReadSection(int index) const;
   StreamWriter *WriteSection(const SectionProperties &props);
 
+  // the file this was opened from, empty if it was opened from memory
+  const std::string &GetFilename() const { return m_Filename; }
+
   // Only valid if GetDriver returns RDCDriver::Image, passes over the underlying FILE * for use
   // loading the image directly, since the RDC container isn't there to read from a section.
   FILE *StealImageFileHandle(std::string &filename);
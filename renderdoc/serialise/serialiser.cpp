@@ -36,6 +36,283 @@ int64_t Chunk::m_TotalMem = 0;
 
 #endif
 
+/////////////////////////////////////////////////////////////
+// Chunk allocation
+
+namespace
+{
+// the size of the pages that small allocations are packed into. Anything larger than a quarter of
+// a page gets a page to itself, so we don't waste much of a page when moving to the next one.
+static const size_t ChunkPageSize = 64 * 1024;
+static const size_t ChunkMaxPacked = ChunkPageSize / 4;
+
+struct ChunkPage
+{
+  // one reference for each live allocation in the page, plus one for the thread arena while it's
+  // still allocating from the page.
+  volatile int32_t refs;
+  uint32_t padding;
+};
+
+// stored immediately before every allocation
+struct ChunkAllocHeader
+{
+  ChunkPage *page;
+  volatile int32_t refs;
+  // true if the allocation is packed into a shared page, rather than having a page to itself
+  uint32_t packed;
+};
+
+struct ChunkArena
+{
+  ChunkPage *page;
+  byte *cur;
+  byte *end;
+
+  // set while the owning thread is allocating, or while the arena's page is being released from
+  // another thread.
+  volatile int32_t busy;
+};
+
+struct ChunkArenaList
+{
+  Threading::CriticalSection lock;
+  std::vector<ChunkArena *> arenas;
+};
+
+ChunkArenaList &GetChunkArenas()
+{
+  // deliberately leaked, as chunks can be released on any thread up until shutdown
+  static ChunkArenaList *list = new ChunkArenaList;
+  return *list;
+}
+
+ChunkPage *AllocChunkPage(size_t size)
+{
+  ChunkPage *page = (ChunkPage *)AllocAlignedBuffer(AlignUp(sizeof(ChunkPage), (size_t)64) + size, 64);
+  page->refs = 0;
+  return page;
+}
+
+void ReleaseChunkPage(ChunkPage *page)
+{
+  if(Atomic::Dec32(&page->refs) == 0)
+    FreeAlignedBuffer((byte *)page);
+}
+
+ChunkArena *GetChunkArena()
+{
+  // arenas are never freed, but they're registered so that the page of a thread that has exited
+  // can be released by ReleaseArenaPages().
+  static uint64_t arenaSlot = Threading::AllocateTLSSlot();
+
+  ChunkArena *arena = (ChunkArena *)Threading::GetTLSValue(arenaSlot);
+
+  if(arena == NULL)
+  {
+    arena = new ChunkArena();
+    arena->page = NULL;
+    arena->cur = arena->end = NULL;
+    arena->busy = 0;
+    Threading::SetTLSValue(arenaSlot, arena);
+
+    ChunkArenaList &list = GetChunkArenas();
+    SCOPED_LOCK(list.lock);
+    list.arenas.push_back(arena);
+  }
+
+  return arena;
+}
+
+ChunkAllocHeader *GetAllocHeader(const byte *ptr)
+{
+  return (ChunkAllocHeader *)(ptr - sizeof(ChunkAllocHeader));
+}
+};
+
+byte *ChunkAllocator::Allocate(size_t size, size_t alignment, bool packed)
+{
+  RDCASSERT(alignment <= 64 && alignment >= sizeof(void *));
+
+  ChunkPage *page = NULL;
+  byte *ret = NULL;
+
+  if(size > ChunkMaxPacked)
+    packed = false;
+
+  if(!packed)
+  {
+    page = AllocChunkPage(sizeof(ChunkAllocHeader) + alignment + size);
+
+    byte *base = (byte *)page + AlignUp(sizeof(ChunkPage), (size_t)64);
+    ret = AlignUpPtr(base + sizeof(ChunkAllocHeader), alignment);
+
+    Atomic::Inc32(&page->refs);
+  }
+  else
+  {
+    ChunkArena *arena = GetChunkArena();
+
+    // only contended if the page is being released at the same moment by ReleaseArenaPages()
+    while(Atomic::CmpExch32(&arena->busy, 0, 1) != 0)
+      Threading::Sleep(0);
+
+    ret = AlignUpPtr(arena->cur + sizeof(ChunkAllocHeader), alignment);
+
+    if(arena->page == NULL || ret + size > arena->end)
+    {
+      // move to a new page, and let the old one be freed once its allocations are released.
+      if(arena->page)
+        ReleaseChunkPage(arena->page);
+
+      arena->page = AllocChunkPage(ChunkPageSize);
+      arena->page->refs = 1;
+      arena->cur = (byte *)arena->page + AlignUp(sizeof(ChunkPage), (size_t)64);
+      arena->end = arena->cur + ChunkPageSize;
+
+      ret = AlignUpPtr(arena->cur + sizeof(ChunkAllocHeader), alignment);
+    }
+
+    arena->cur = ret + size;
+    page = arena->page;
+
+    // allocations can be released on any thread
+    Atomic::Inc32(&page->refs);
+
+    arena->busy = 0;
+  }
+
+  ChunkAllocHeader *header = GetAllocHeader(ret);
+  header->page = page;
+  header->refs = 1;
+  header->packed = packed ? 1 : 0;
+
+  return ret;
+}
+
+void ChunkAllocator::AddRef(byte *ptr)
+{
+  if(ptr)
+    Atomic::Inc32(&GetAllocHeader(ptr)->refs);
+}
+
+bool ChunkAllocator::Release(byte *ptr)
+{
+  if(ptr == NULL)
+    return false;
+
+  ChunkAllocHeader *header = GetAllocHeader(ptr);
+
+  if(Atomic::Dec32(&header->refs) > 0)
+    return false;
+
+  ReleaseChunkPage(header->page);
+
+  return true;
+}
+
+bool ChunkAllocator::IsShared(const byte *ptr)
+{
+  return ptr && GetAllocHeader(ptr)->refs > 1;
+}
+
+bool ChunkAllocator::IsPacked(const byte *ptr)
+{
+  return ptr && GetAllocHeader(ptr)->packed;
+}
+
+void ChunkAllocator::ReleaseArenaPages()
+{
+  ChunkArenaList &list = GetChunkArenas();
+  SCOPED_LOCK(list.lock);
+
+  for(ChunkArena *arena : list.arenas)
+  {
+    while(Atomic::CmpExch32(&arena->busy, 0, 1) != 0)
+      Threading::Sleep(0);
+
+    // the page is freed as soon as any allocations still in it are released. Live threads just
+    // start a new page on their next allocation.
+    if(arena->page)
+      ReleaseChunkPage(arena->page);
+
+    arena->page = NULL;
+    arena->cur = arena->end = NULL;
+
+    arena->busy = 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////
+// String interning
+
+namespace
+{
+// interned strings are bucketed by hash, and since nothing is ever removed we only need to take
+// the write lock the first time any given string is seen.
+struct InternedStrings
+{
+  Threading::RWLock lock;
+  std::map<uint32_t, std::vector<const char *>> buckets;
+};
+
+InternedStrings &GetInternedStrings()
+{
+  // deliberately leaked, as interned strings can be referenced up until shutdown
+  static InternedStrings *strings = new InternedStrings;
+  return *strings;
+}
+
+const char *FindInterned(const std::vector<const char *> &bucket, const char *str)
+{
+  for(const char *s : bucket)
+    if(!strcmp(s, str))
+      return s;
+
+  return NULL;
+}
+};
+
+rdcinflexiblestr InternString(const char *str)
+{
+  if(str == NULL || str[0] == 0)
+    return rdcinflexiblestr();
+
+  InternedStrings &strings = GetInternedStrings();
+
+  uint32_t hash = strhash(str);
+
+  {
+    SCOPED_READLOCK(strings.lock);
+
+    auto it = strings.buckets.find(hash);
+    if(it != strings.buckets.end())
+    {
+      const char *ret = FindInterned(it->second, str);
+      if(ret)
+        return rdcinflexiblestr::Literal(ret);
+    }
+  }
+
+  SCOPED_WRITELOCK(strings.lock);
+
+  std::vector<const char *> &bucket = strings.buckets[hash];
+
+  // another thread could have added the string while we weren't holding the lock
+  const char *ret = FindInterned(bucket, str);
+
+  if(ret == NULL)
+  {
+    size_t len = strlen(str);
+    char *copy = new char[len + 1];
+    memcpy(copy, str, len + 1);
+    bucket.push_back(copy);
+    ret = copy;
+  }
+
+  return rdcinflexiblestr::Literal(ret);
+}
+
 /////////////////////////////////////////////////////////////
 // Read Serialiser functions
 
@@ -106,13 +383,14 @@ uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint32_t)
     if(name.empty())
       name = "<Unknown Chunk>";
 
-    SDChunk *chunk = new SDChunk(name.c_str());
+    SDChunk *chunk = new SDChunk(InternString(name.c_str()));
     chunk->metadata = m_ChunkMetadata;
 
     m_StructuredFile->chunks.push_back(chunk);
     m_StructureStack.push_back(chunk);
 
     m_InternalElement = false;
+    m_LazyChunk = m_LazyStructured;
   }
 
   return chunkID;
@@ -129,7 +407,7 @@ void Serialiser<SerialiserMode::Reading>::SkipCurrentChunk()
     SDObject &current = *m_StructureStack.back();
 
     current.data.basic.numChildren++;
-    current.data.children.push_back(new SDObject("Opaque chunk", "Byte Buffer"));
+    current.data.children.push_back(MakeStructuredElement("Opaque chunk", "Byte Buffer"));
 
     SDObject &obj = *current.data.children.back();
     obj.type.basetype = SDBasic::Buffer;
@@ -182,6 +460,8 @@ void Serialiser<SerialiserMode::Reading>::SkipCurrentChunk()
 template <>
 void Serialiser<SerialiserMode::Reading>::EndChunk()
 {
+  m_LazyChunk = false;
+
   if(ExportStructure())
   {
     RDCASSERTMSG("Object Stack is imbalanced!", m_StructureStack.size() <= 1,
@@ -581,7 +861,7 @@ void DoSerialise(SerialiserType &ser, StructuredObjectList &el)
   {
     // we also assume that the caller serialising these objects will handle lifetime management.
     if(ser.IsReading())
-      el[c] = new SDObject("", "");
+      el[c] = new SDObject(rdcinflexiblestr(), rdcinflexiblestr());
 
     ser.Serialise("$el", *el[c]);
   }
@@ -776,6 +1056,12 @@ std::string DoStringise(const uint32_t &el)
   return StringFormat::Fmt("%u", el);
 }
 
+template <>
+std::string DoStringise(const rdcinflexiblestr &el)
+{
+  return el.c_str();
+}
+
 template <>
 std::string DoStringise(const char &el)
 {
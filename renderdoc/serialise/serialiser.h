@@ -53,6 +53,11 @@ void Deserialise(const T &el)
 
 typedef std::string (*ChunkLookup)(uint32_t chunkType);
 
+// returns a string with the same contents as str that is never freed. The same handful of member
+// and type names is repeated for every object in a structured export, so interning them means the
+// objects can all share one copy.
+rdcinflexiblestr InternString(const char *str);
+
 enum class SerialiserFlags
 {
   NoFlags = 0x0,
@@ -90,7 +95,8 @@ public:
   static constexpr bool IsWriting() { return sertype == SerialiserMode::Writing; }
   bool ExportStructure() const
   {
-    return sertype == SerialiserMode::Reading && m_ExportStructured && !m_InternalElement;
+    return sertype == SerialiserMode::Reading && m_ExportStructured && !m_InternalElement &&
+           !m_LazyChunk;
   }
 
   enum ChunkFlags
@@ -155,6 +161,11 @@ public:
     m_ExportStructured = (lookup != NULL);
   }
 
+  // in lazy mode each chunk is still exported with its name and metadata, but its contents are
+  // not. They can be filled in later by re-reading the chunk from its offset with lazy mode off.
+  void SetLazyStructuredExport(bool lazy) { m_LazyStructured = lazy; }
+  bool IsLazyStructuredExport() const { return m_LazyStructured; }
+
   uint32_t BeginChunk(uint32_t chunkID, uint32_t byteLength);
   void EndChunk();
 
@@ -201,7 +212,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       current.data.basic.numChildren++;
-      current.data.children.push_back(new SDObject(name, TypeName<T>()));
+      current.data.children.push_back(MakeStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(current.data.children.back());
 
       SDObject &obj = *m_StructureStack.back();
@@ -248,7 +259,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       current.data.basic.numChildren++;
-      current.data.children.push_back(new SDObject(name, "Byte Buffer"));
+      current.data.children.push_back(MakeStructuredObject(name, "Byte Buffer"));
       m_StructureStack.push_back(current.data.children.back());
 
       SDObject &obj = *m_StructureStack.back();
@@ -359,7 +370,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       current.data.basic.numChildren++;
-      current.data.children.push_back(new SDObject(name, "Byte Buffer"));
+      current.data.children.push_back(MakeStructuredObject(name, "Byte Buffer"));
       m_StructureStack.push_back(current.data.children.back());
 
       SDObject &obj = *m_StructureStack.back();
@@ -432,7 +443,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       current.data.basic.numChildren++;
-      current.data.children.push_back(new SDObject(name, "Byte Buffer"));
+      current.data.children.push_back(MakeStructuredObject(name, "Byte Buffer"));
       m_StructureStack.push_back(current.data.children.back());
 
       SDObject &obj = *m_StructureStack.back();
@@ -545,7 +556,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, TypeName<T>()));
+      parent.data.children.push_back(MakeStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -558,7 +569,7 @@ public:
 
       for(size_t i = 0; i < N; i++)
       {
-        arr.data.children[i] = new SDObject("$el", TypeName<T>());
+        arr.data.children[i] = MakeStructuredElement("$el", TypeName<T>());
         m_StructureStack.push_back(arr.data.children[i]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -666,7 +677,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, TypeName<T>()));
+      parent.data.children.push_back(MakeStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -691,7 +702,7 @@ public:
 
       for(uint64_t i = 0; el && i < arrayCount; i++)
       {
-        arr.data.children[(size_t)i] = new SDObject("$el", TypeName<T>());
+        arr.data.children[(size_t)i] = MakeStructuredElement("$el", TypeName<T>());
         m_StructureStack.push_back(arr.data.children[(size_t)i]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -759,7 +770,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, TypeName<U>()));
+      parent.data.children.push_back(MakeStructuredObject(name, TypeName<U>()));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -774,7 +785,7 @@ public:
 
       for(size_t i = 0; i < (size_t)size; i++)
       {
-        arr.data.children[i] = new SDObject("$el", TypeName<U>());
+        arr.data.children[i] = MakeStructuredElement("$el", TypeName<U>());
         m_StructureStack.push_back(arr.data.children[i]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -829,7 +840,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, TypeName<U>()));
+      parent.data.children.push_back(MakeStructuredObject(name, TypeName<U>()));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -846,7 +857,7 @@ public:
 
       for(size_t i = 0; i < (size_t)size; i++)
       {
-        arr.data.children[i] = new SDObject("$el", TypeName<U>());
+        arr.data.children[i] = MakeStructuredElement("$el", TypeName<U>());
         m_StructureStack.push_back(arr.data.children[i]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -889,7 +900,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, "pair"));
+      parent.data.children.push_back(MakeStructuredObject(name, "pair"));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -900,7 +911,7 @@ public:
       arr.data.children.resize(2);
 
       {
-        arr.data.children[0] = new SDObject("first", TypeName<U>());
+        arr.data.children[0] = MakeStructuredElement("first", TypeName<U>());
         m_StructureStack.push_back(arr.data.children[0]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -915,7 +926,7 @@ public:
       }
 
       {
-        arr.data.children[1] = new SDObject("second", TypeName<V>());
+        arr.data.children[1] = MakeStructuredElement("second", TypeName<V>());
         m_StructureStack.push_back(arr.data.children[1]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -967,7 +978,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, TypeName<U>()));
+      parent.data.children.push_back(MakeStructuredObject(name, TypeName<U>()));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -982,7 +993,7 @@ public:
 
       for(size_t i = 0; i < (size_t)size; i++)
       {
-        arr.data.children[i] = new SDObject("$el", TypeName<U>());
+        arr.data.children[i] = MakeStructuredElement("$el", TypeName<U>());
         m_StructureStack.push_back(arr.data.children[i]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -1024,7 +1035,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
       parent.data.basic.numChildren++;
-      parent.data.children.push_back(new SDObject(name, "pair"));
+      parent.data.children.push_back(MakeStructuredObject(name, "pair"));
       m_StructureStack.push_back(parent.data.children.back());
 
       SDObject &arr = *m_StructureStack.back();
@@ -1035,7 +1046,7 @@ public:
       arr.data.children.resize(2);
 
       {
-        arr.data.children[0] = new SDObject("first", TypeName<U>());
+        arr.data.children[0] = MakeStructuredElement("first", TypeName<U>());
         m_StructureStack.push_back(arr.data.children[0]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -1050,7 +1061,7 @@ public:
       }
 
       {
-        arr.data.children[1] = new SDObject("second", TypeName<V>());
+        arr.data.children[1] = MakeStructuredElement("second", TypeName<V>());
         m_StructureStack.push_back(arr.data.children[1]);
 
         SDObject &obj = *m_StructureStack.back();
@@ -1142,7 +1153,7 @@ public:
       {
         SDObject &parent = *m_StructureStack.back();
         parent.data.basic.numChildren++;
-        parent.data.children.push_back(new SDObject(name, TypeName<T>()));
+        parent.data.children.push_back(MakeStructuredObject(name, TypeName<T>()));
 
         SDObject &nullable = *parent.data.children.back();
         nullable.type.basetype = SDBasic::Null;
@@ -1230,7 +1241,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       current.data.basic.numChildren++;
-      current.data.children.push_back(new SDObject(name.c_str(), "Byte Buffer"));
+      current.data.children.push_back(MakeStructuredObject(name.c_str(), "Byte Buffer"));
       m_StructureStack.push_back(current.data.children.back());
 
       SDObject &obj = *m_StructureStack.back();
@@ -1322,7 +1333,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       if(!current.data.children.empty())
-        current.data.children.back()->type.name = name;
+        current.data.children.back()->type.name = InternString(name);
     }
 
     return *this;
@@ -1335,7 +1346,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       if(!current.data.children.empty())
-        current.data.children.back()->name = name;
+        current.data.children.back()->name = InternString(name);
     }
 
     return *this;
@@ -1443,6 +1454,37 @@ public:
     }
   }
 
+  // names in structured data are interned when read, as they are heavily repeated
+  void SerialiseValue(SDBasic type, size_t byteSize, rdcinflexiblestr &el)
+  {
+    uint32_t len = 0;
+
+    if(IsReading())
+    {
+      std::string str;
+      m_Read->Read(len);
+      str.resize(len);
+      if(len > 0)
+        m_Read->Read(&str[0], len);
+      el = InternString(str.c_str());
+    }
+    else
+    {
+      len = (uint32_t)el.size();
+      m_Write->Write(len);
+      m_Write->Write(el.c_str(), len);
+    }
+
+    if(ExportStructure())
+    {
+      SDObject &current = *m_StructureStack.back();
+
+      current.type.basetype = type;
+      current.type.byteSize = len;
+      current.data.str = el;
+    }
+  }
+
   void SerialiseValue(SDBasic type, size_t byteSize, rdcstr &el)
   {
     uint32_t len = 0;
@@ -1545,6 +1587,19 @@ private:
     }
   };
 
+  // type names are always literals, and member names are interned, so that the objects in a
+  // structured export don't each need their own copies of the strings.
+  SDObject *MakeStructuredObject(const char *name, const char *typeName)
+  {
+    return new SDObject(InternString(name), rdcinflexiblestr::Literal(typeName));
+  }
+
+  // for internal elements such as "$el" where the name is known to be a literal as well
+  SDObject *MakeStructuredElement(const char *name, const char *typeName)
+  {
+    return new SDObject(rdcinflexiblestr::Literal(name), rdcinflexiblestr::Literal(typeName));
+  }
+
   void VerifyArraySize(uint64_t &count)
   {
     uint64_t size = m_Read->GetSize();
@@ -1591,6 +1646,9 @@ private:
   bool m_ExportStructured = false;
   bool m_ExportBuffers = false;
   bool m_InternalElement = false;
+  bool m_LazyStructured = false;
+  // set between BeginChunk and EndChunk while lazily exporting, so the contents are skipped
+  bool m_LazyChunk = false;
   SDFile m_StructData;
   SDFile *m_StructuredFile = &m_StructData;
   std::vector<SDObject *> m_StructureStack;
@@ -1715,11 +1773,49 @@ void DoSerialise(SerialiserType &ser, rdcstr &el)
 {
   ser.SerialiseValue(SDBasic::String, 0, el);
 }
+template <>
+inline const char *TypeName<rdcinflexiblestr>()
+{
+  return "string";
+}
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, rdcinflexiblestr &el)
+{
+  ser.SerialiseValue(SDBasic::String, 0, el);
+}
 
 DECLARE_STRINGISE_TYPE(SDObject *);
 
 class ScopedChunk;
 
+// Chunks are recorded for nearly every API call during capture, so rather than a heap allocation
+// each they are bump-allocated from pages owned by the recording thread. A page is freed as a whole
+// once every allocation in it has been released. Allocations are reference counted so chunk data
+// can be shared between duplicated chunks.
+namespace ChunkAllocator
+{
+// allocates from the calling thread's current page if packed is true, otherwise (or if the
+// allocation is large) the allocation gets a page to itself.
+byte *Allocate(size_t size, size_t alignment, bool packed = true);
+
+// adds a reference to an allocation, to share it
+void AddRef(byte *ptr);
+
+// releases a reference to an allocation. Returns true if that was the last reference and it has
+// been freed.
+bool Release(byte *ptr);
+
+// returns true if more than one reference is held on an allocation
+bool IsShared(const byte *ptr);
+
+// returns true if an allocation is in a page shared with other allocations
+bool IsPacked(const byte *ptr);
+
+// stops every thread allocating from its current page, so that pages are freed as soon as their
+// allocations are, and pages belonging to threads that have exited aren't kept forever.
+void ReleaseArenaPages();
+};
+
 // holds the memory, length and type for a given chunk, so that it can be
 // passed around and moved between owners before being serialised out
 class Chunk
@@ -1727,11 +1823,12 @@ class Chunk
 public:
   ~Chunk()
   {
-    FreeAlignedBuffer(m_Data);
+    bool freed = ChunkAllocator::Release(m_Data);
 
 #if !defined(RELEASE)
     Atomic::Dec64(&m_LiveChunks);
-    Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
+    if(freed)
+      Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
 #endif
   }
 
@@ -1757,7 +1854,8 @@ public:
 
     m_ChunkType = chunkType;
 
-    m_Data = AllocAlignedBuffer(m_Length);
+    m_Data = ChunkAllocator::Allocate(m_Length, 64);
+    m_Writable = false;
 
     memcpy(m_Data, ser.GetWriter()->GetData(), (size_t)m_Length);
 
@@ -1769,20 +1867,77 @@ public:
 #endif
   }
 
-  byte *GetData() const { return m_Data; }
+  // returns the data for writing. Duplicated chunks share their data until it's written, so this
+  // gives the chunk its own copy if needed and stops it being shared from now on.
+  byte *GetData()
+  {
+    if(!m_Writable)
+    {
+      if(ChunkAllocator::IsShared(m_Data))
+      {
+        byte *data = ChunkAllocator::Allocate(m_Length, 64);
+        memcpy(data, m_Data, (size_t)m_Length);
+        ChunkAllocator::Release(m_Data);
+        m_Data = data;
+
+#if !defined(RELEASE)
+        Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
+#endif
+      }
+
+      m_Writable = true;
+    }
+
+    return m_Data;
+  }
+
+  // moves the data out of the shared pages, for chunks that will be kept indefinitely and would
+  // otherwise keep a page alive after everything else in it is freed. Data that's been returned
+  // from GetData() stays where it is, as the pointer may be held elsewhere.
+  void Unpack()
+  {
+    if(m_Writable || !ChunkAllocator::IsPacked(m_Data))
+      return;
+
+    byte *data = ChunkAllocator::Allocate(m_Length, 64, false);
+    memcpy(data, m_Data, (size_t)m_Length);
+
+#if !defined(RELEASE)
+    // if the data was shared it's now been copied, rather than moved
+    if(ChunkAllocator::IsShared(m_Data))
+      Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
+#endif
+
+    ChunkAllocator::Release(m_Data);
+    m_Data = data;
+  }
+
   Chunk *Duplicate()
   {
     Chunk *ret = new Chunk();
     ret->m_Length = m_Length;
     ret->m_ChunkType = m_ChunkType;
+    ret->m_Writable = false;
 
-    ret->m_Data = AllocAlignedBuffer(m_Length);
+    // once data has been handed out for writing it can change under us, so it can't be shared
+    if(m_Writable)
+    {
+      ret->m_Data = ChunkAllocator::Allocate(m_Length, 64);
+
+      memcpy(ret->m_Data, m_Data, (size_t)m_Length);
 
-    memcpy(ret->m_Data, m_Data, (size_t)m_Length);
+#if !defined(RELEASE)
+      Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
+#endif
+    }
+    else
+    {
+      ChunkAllocator::AddRef(m_Data);
+      ret->m_Data = m_Data;
+    }
 
 #if !defined(RELEASE)
     Atomic::Inc64(&m_LiveChunks);
-    Atomic::ExchAdd64(&m_TotalMem, int64_t(m_Length));
 #endif
 
     return ret;
@@ -1805,6 +1960,9 @@ private:
   uint32_t m_Length;
   byte *m_Data;
 
+  // true once the data has been returned from GetData(), and may be written through that pointer
+  bool m_Writable;
+
 #if !defined(RELEASE)
   static int64_t m_LiveChunks, m_TotalMem;
 #endif
@@ -562,6 +562,106 @@ TEST_CASE("Read/write chunk metadata", "[serialiser]")
   delete buf;
 };
 
+TEST_CASE("Read structured data lazily", "[serialiser][structured]")
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    for(uint32_t i = 0; i < 8; i++)
+    {
+      SCOPED_SERIALISE_CHUNK(1 + i);
+
+      uint32_t value = i * 10;
+      std::vector<float> floats(i, 1.5f);
+
+      SERIALISE_ELEMENT(value);
+      SERIALISE_ELEMENT(floats);
+    }
+
+    REQUIRE_FALSE(ser.IsErrored());
+  }
+
+  ChunkLookup testChunkLoop = [](uint32_t) -> std::string { return "TestChunk"; };
+
+  std::vector<uint64_t> offsets;
+
+  ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+  ser.ConfigureStructuredExport(testChunkLoop, false);
+  ser.SetLazyStructuredExport(true);
+
+  for(uint32_t i = 0; i < 8; i++)
+  {
+    offsets.push_back(ser.GetReader()->GetOffset());
+
+    CHECK(ser.ReadChunk<uint32_t>() == 1 + i);
+
+    // the values are still read as normal
+    uint32_t value = 0;
+    std::vector<float> floats;
+
+    SERIALISE_ELEMENT(value);
+    SERIALISE_ELEMENT(floats);
+
+    CHECK(value == i * 10);
+    CHECK(floats.size() == i);
+
+    ser.EndChunk();
+  }
+
+  REQUIRE_FALSE(ser.IsErrored());
+  CHECK(ser.GetReader()->AtEnd());
+
+  const SDFile &file = ser.GetStructuredFile();
+
+  REQUIRE(file.chunks.size() == 8);
+
+  for(uint32_t i = 0; i < 8; i++)
+  {
+    CHECK(file.chunks[i]->name == "TestChunk");
+    CHECK(file.chunks[i]->metadata.chunkID == 1 + i);
+    CHECK(file.chunks[i]->type.byteSize == file.chunks[i]->metadata.length);
+    CHECK(file.chunks[i]->data.children.empty());
+  }
+
+  // re-read one chunk from its offset, with full structured export
+  {
+    ReadSerialiser lazyser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+    lazyser.ConfigureStructuredExport(testChunkLoop, false);
+    lazyser.GetReader()->SetOffset(offsets[5]);
+
+    CHECK(lazyser.ReadChunk<uint32_t>() == 6);
+
+    uint32_t value = 0;
+    std::vector<float> floats;
+
+    lazyser.Serialise("value", value);
+    lazyser.Serialise("floats", floats);
+
+    lazyser.EndChunk();
+
+    REQUIRE_FALSE(lazyser.IsErrored());
+
+    const SDFile &lazyFile = lazyser.GetStructuredFile();
+
+    REQUIRE(lazyFile.chunks.size() == 1);
+
+    const SDChunk &chunk = *lazyFile.chunks[0];
+
+    CHECK(chunk.metadata.length == file.chunks[5]->metadata.length);
+    REQUIRE(chunk.data.children.size() == 2);
+    CHECK(chunk.data.children[0]->name == "value");
+    CHECK(chunk.data.children[0]->data.basic.u == 50);
+    CHECK(chunk.data.children[1]->name == "floats");
+    CHECK(chunk.data.children[1]->data.children.size() == 5);
+  }
+
+  delete buf;
+};
+
 TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -720,6 +820,168 @@ TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
   delete buf;
 };
 
+TEST_CASE("Verify chunks share data when duplicated", "[serialiser][chunks]")
+{
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  Chunk *chunk = NULL;
+  {
+    SCOPED_SERIALISE_CHUNK(5U);
+
+    uint64_t data[4] = {1, 2, 3, 4};
+    SERIALISE_ELEMENT(data);
+
+    chunk = scope.Get();
+  }
+
+  REQUIRE(chunk);
+
+  Chunk *dup = chunk->Duplicate();
+  Chunk *dup2 = dup->Duplicate();
+
+  // duplicates are identical when written out
+  StreamWriter a(64), b(64);
+  {
+    WriteSerialiser sera(&a, Ownership::Nothing), serb(&b, Ownership::Nothing);
+    chunk->Write(sera);
+    dup2->Write(serb);
+  }
+
+  REQUIRE(a.GetOffset() == b.GetOffset());
+  CHECK(memcmp(a.GetData(), b.GetData(), (size_t)a.GetOffset()) == 0);
+
+  // fetching the data for writing gives the chunk its own copy, leaving the others untouched
+  byte *data = dup->GetData();
+  data[0] ^= 0xff;
+
+  CHECK(dup->GetData() == data);
+
+  StreamWriter c(64);
+  {
+    WriteSerialiser serc(&c, Ownership::Nothing);
+    dup2->Write(serc);
+  }
+
+  CHECK(memcmp(a.GetData(), c.GetData(), (size_t)a.GetOffset()) == 0);
+
+  // once the data has been written, duplicates must copy it
+  Chunk *dup3 = dup->Duplicate();
+  CHECK(dup3->GetData() != data);
+  CHECK(dup3->GetData()[0] == data[0]);
+
+  delete chunk;
+  delete dup;
+  delete dup2;
+  delete dup3;
+};
+
+TEST_CASE("Verify unpacked chunks keep their data", "[serialiser][chunks]")
+{
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  uint64_t baseMem = Chunk::TotalMem();
+
+  Chunk *chunk = NULL;
+  {
+    SCOPED_SERIALISE_CHUNK(5U);
+
+    uint64_t data[4] = {1, 2, 3, 4};
+    SERIALISE_ELEMENT(data);
+
+    chunk = scope.Get();
+  }
+
+  REQUIRE(chunk);
+
+  Chunk *dup = chunk->Duplicate();
+
+  // unpacking a shared chunk copies the data, leaving the original alone
+  dup->Unpack();
+  dup->Unpack();
+
+  StreamWriter a(64), b(64);
+  {
+    WriteSerialiser sera(&a, Ownership::Nothing), serb(&b, Ownership::Nothing);
+    chunk->Write(sera);
+    dup->Write(serb);
+  }
+
+  REQUIRE(a.GetOffset() == b.GetOffset());
+  CHECK(memcmp(a.GetData(), b.GetData(), (size_t)a.GetOffset()) == 0);
+
+  // the page the chunk was packed into can be released from under it
+  ChunkAllocator::ReleaseArenaPages();
+
+  delete chunk;
+
+  StreamWriter c(64);
+  {
+    WriteSerialiser serc(&c, Ownership::Nothing);
+    dup->Write(serc);
+  }
+
+  CHECK(memcmp(a.GetData(), c.GetData(), (size_t)a.GetOffset()) == 0);
+
+  delete dup;
+
+  CHECK(Chunk::TotalMem() == baseMem);
+};
+
+TEST_CASE("Verify chunks can be freed on other threads", "[serialiser][chunks]")
+{
+  // record chunks on several threads, and free them on a different thread from the one that
+  // allocated them, including large chunks that don't fit in a page.
+  const size_t numThreads = 4;
+  const size_t numChunks = 2000;
+
+  std::vector<Chunk *> chunks[numThreads];
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(size_t t = 0; t < numThreads; t++)
+  {
+    threads.push_back(Threading::CreateThread([&chunks, t]() {
+      WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+      std::vector<byte> big(100 * 1024, byte(t));
+
+      for(size_t i = 0; i < numChunks; i++)
+      {
+        SCOPED_SERIALISE_CHUNK(uint32_t(i));
+
+        uint32_t thread = (uint32_t)t;
+        SERIALISE_ELEMENT(thread);
+        SERIALISE_ELEMENT(i);
+
+        if((i % 100) == 0)
+          SERIALISE_ELEMENT(big);
+
+        chunks[t].push_back(scope.Get());
+      }
+    }));
+  }
+
+  for(Threading::ThreadHandle th : threads)
+  {
+    Threading::JoinThread(th);
+    Threading::CloseThread(th);
+  }
+
+  // the threads have exited, so their last pages are only freed once released here
+  ChunkAllocator::ReleaseArenaPages();
+
+  for(size_t t = 0; t < numThreads; t++)
+  {
+    REQUIRE(chunks[t].size() == numChunks);
+
+    for(size_t i = 0; i < numChunks; i++)
+    {
+      Chunk *c = chunks[t][i];
+      CHECK(c->GetChunkType<uint32_t>() == uint32_t(i));
+      delete c;
+    }
+  }
+};
+
 TEST_CASE("Read/write container types", "[serialiser][structured]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -1317,4 +1579,109 @@ TEST_CASE("Read/write complex types", "[serialiser][structured]")
   delete buf;
 };
 
+TEST_CASE("Benchmark structured export", "[serialiser][structured][!benchmark]")
+{
+  // a synthetic capture with many chunks of small members, similar in shape to a long frame of API
+  // calls. This gives millions of structured objects.
+  const uint32_t numChunks = 200000;
+
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    std::vector<struct1> viewports(4, struct1(1.0f, 2.0f, 3.0f, 4.0f));
+
+    for(uint32_t i = 0; i < numChunks; i++)
+    {
+      SCOPED_SERIALISE_CHUNK(5 + (i % 4));
+
+      uint64_t id = i;
+      std::string label = "label";
+
+      SERIALISE_ELEMENT(id);
+      SERIALISE_ELEMENT(label);
+      SERIALISE_ELEMENT(viewports);
+    }
+  }
+
+  auto load = [&](ReadSerialiser &ser) {
+    ChunkLookup lookup = [](uint32_t) -> std::string { return "TestChunk"; };
+
+    ser.ConfigureStructuredExport(lookup, true);
+
+    for(uint32_t i = 0; i < numChunks; i++)
+    {
+      ser.ReadChunk<uint32_t>();
+
+      uint64_t id;
+      std::string label;
+      std::vector<struct1> viewports;
+
+      SERIALISE_ELEMENT(id);
+      SERIALISE_ELEMENT(label);
+      SERIALISE_ELEMENT(viewports);
+
+      ser.EndChunk();
+    }
+
+    CHECK_FALSE(ser.IsErrored());
+  };
+
+  BENCHMARK("Load structured export")
+  {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+    load(ser);
+  }
+
+  // estimate the memory used by the structured data, counting every separate heap allocation
+  {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+    load(ser);
+
+    uint64_t numObjects = 0, numAllocs = 0, bytes = 0;
+
+    std::function<void(const SDObject *)> count = [&](const SDObject *o) {
+      numObjects++;
+      numAllocs++;
+      bytes += sizeof(SDObject);
+
+      if(!o->name.isLiteral())
+      {
+        numAllocs++;
+        bytes += o->name.size() + 1;
+      }
+      if(!o->type.name.isLiteral())
+      {
+        numAllocs++;
+        bytes += o->type.name.size() + 1;
+      }
+      if(o->data.str.capacity() > 0)
+      {
+        numAllocs++;
+        bytes += o->data.str.capacity();
+      }
+      if(o->data.children.capacity() > 0)
+      {
+        numAllocs++;
+        bytes += o->data.children.capacity() * sizeof(SDObject *);
+      }
+
+      for(const SDObject *child : o->data.children)
+        count(child);
+    };
+
+    for(const SDChunk *chunk : ser.GetStructuredFile().chunks)
+      count(chunk);
+
+    // every object should share its names
+    CHECK(numAllocs < numObjects * 2);
+
+    WARN(StringFormat::Fmt("%llu structured objects in %llu allocations, ~%llu MB", numObjects,
+                           numAllocs, bytes / (1024 * 1024)));
+  }
+
+  delete buf;
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
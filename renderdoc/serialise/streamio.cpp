@@ -102,6 +102,7 @@ StreamReader::StreamReader(FILE *file, uint64_t fileSize, Ownership own)
 
   m_File = file;
   m_InputSize = fileSize;
+  m_FileBaseOffset = FileIO::ftell64(file);
 
   m_BufferSize = initialBufferSize;
   m_BufferHead = m_BufferBase = AllocAlignedBuffer(m_BufferSize);
@@ -180,9 +181,47 @@ StreamReader::~StreamReader()
 
 void StreamReader::SetOffset(uint64_t offs)
 {
+  if(m_Sock)
+  {
+    RDCERR("Socket stream readers do not support seeking");
+    return;
+  }
+
   if(m_File || m_Decompressor)
   {
-    RDCERR("File and decompress stream readers do not support seeking");
+    if(m_HasError)
+      return;
+
+    if(offs > m_InputSize)
+    {
+      RDCERR("Seeking off the end of the stream");
+      return;
+    }
+
+    // if the offset is within our current window, we can just move the head. File readers can
+    // skip past their window without reading it so we always seek those.
+    uint64_t windowSize = RDCMIN(m_BufferSize, m_InputSize - m_ReadOffset);
+    if(m_Decompressor && offs >= m_ReadOffset && offs < m_ReadOffset + windowSize)
+    {
+      m_BufferHead = m_BufferBase + (offs - m_ReadOffset);
+      return;
+    }
+
+    if(m_Decompressor && !m_Decompressor->Seek(offs))
+    {
+      RDCERR("Decompressor does not support seeking");
+      return;
+    }
+
+    if(m_File)
+      FileIO::fseek64(m_File, m_FileBaseOffset + offs, SEEK_SET);
+
+    // refill the window from the new offset
+    m_ReadOffset = offs;
+    m_BufferHead = m_BufferBase;
+
+    ReadFromExternal(0, RDCMIN(m_BufferSize, m_InputSize - offs));
+
     return;
   }
 
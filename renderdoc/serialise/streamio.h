@@ -61,6 +61,10 @@ public:
   virtual bool Recompress(Compressor *comp) = 0;
   virtual bool Read(void *data, uint64_t numBytes) = 0;
 
+  // seek to an offset in the uncompressed data. Only supported by decompressors that can access
+  // their data randomly, streaming decompressors return false.
+  virtual bool Seek(uint64_t offset) { return false; }
+
 protected:
   StreamReader *m_Read;
   Ownership m_Ownership;
@@ -226,6 +230,9 @@ private:
   // the offset in the file/decompressor that corresponds to the start of m_BufferBase
   uint64_t m_ReadOffset = 0;
 
+  // the position in the file where our data starts, for seeking
+  uint64_t m_FileBaseOffset = 0;
+
   // flag indicating if an error has been encountered and the stream is now invalid
   bool m_HasError = false;
 
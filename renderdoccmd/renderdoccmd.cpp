@@ -26,6 +26,7 @@
 #include "renderdoccmd.h"
 #include <app/renderdoc_app.h>
 #include <replay/version.h>
+#include <chrono>
 #include <string>
 
 // normally this is in the renderdoc core library, but it's needed for the 'unknown enum' path,
@@ -620,6 +621,123 @@ struct ReplayCommand : public Command
   }
 };
 
+static void AddEventIDs(const rdcarray<DrawcallDescription> &draws, std::vector<uint32_t> &eventIDs)
+{
+  for(const DrawcallDescription &d : draws)
+  {
+    if(!d.children.empty())
+      AddEventIDs(d.children, eventIDs);
+    else
+      eventIDs.push_back(d.eventId);
+  }
+}
+
+struct BenchmarkCommand : public Command
+{
+  BenchmarkCommand(const GlobalEnvironment &env) : Command(env) {}
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<capture.rdc>");
+    parser.add<uint32_t>("steps", 's', "Only step through this many drawcalls (0 for all).", false,
+                         0);
+  }
+  virtual const char *Description()
+  {
+    return "Time stepping through the drawcalls in a capture, forwards and backwards.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    std::vector<std::string> rest = parser.rest();
+    if(rest.empty())
+    {
+      std::cerr << "Error: benchmark command requires a filename to load." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = rest[0];
+
+    rest.erase(rest.begin());
+
+    RENDERDOC_InitGlobalEnv(m_Env, convertArgs(rest));
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile();
+
+    if(file->OpenFile(filename.c_str(), "rdc", NULL) != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    IReplayController *renderer = NULL;
+    ReplayStatus status = ReplayStatus::InternalError;
+    std::tie(status, renderer) = file->OpenCapture(NULL);
+
+    file->Shutdown();
+
+    if(status != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load and replay '" << filename << "': " << ToStr(status) << std::endl;
+      return 1;
+    }
+
+    std::vector<uint32_t> eventIDs;
+    AddEventIDs(renderer->GetDrawcalls(), eventIDs);
+
+    uint32_t steps = parser.get<uint32_t>("steps");
+    if(steps > 0 && steps < eventIDs.size())
+      eventIDs.resize(steps);
+
+    if(eventIDs.empty())
+    {
+      std::cerr << "No drawcalls in '" << filename << "'." << std::endl;
+      renderer->Shutdown();
+      return 1;
+    }
+
+    std::cout << "Stepping through " << eventIDs.size() << " drawcalls in '" << filename << "'"
+              << std::endl;
+
+    // start from a known position before the first step
+    renderer->SetFrameEvent(eventIDs[0], true);
+
+    // forward steps can continue from the previously replayed state, backward steps must replay
+    // from the start of the frame.
+    for(int pass = 0; pass < 2; pass++)
+    {
+      double total = 0.0, worst = 0.0;
+
+      for(size_t i = 1; i < eventIDs.size(); i++)
+      {
+        uint32_t eventId = pass == 0 ? eventIDs[i] : eventIDs[eventIDs.size() - 1 - i];
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        renderer->SetFrameEvent(eventId, false);
+
+        std::chrono::duration<double, std::milli> duration =
+            std::chrono::high_resolution_clock::now() - start;
+
+        total += duration.count();
+        worst = std::max(worst, duration.count());
+      }
+
+      size_t count = eventIDs.size() - 1;
+
+      std::cout << (pass == 0 ? "Forwards: " : "Backwards: ") << total << "ms total, "
+                << (count > 0 ? total / count : 0.0) << "ms per step, " << worst << "ms slowest"
+                << std::endl;
+    }
+
+    renderer->Shutdown();
+
+    return 0;
+  }
+};
+
 struct formats_reader
 {
   formats_reader()
@@ -1174,6 +1292,7 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
     add_command("inject", new InjectCommand(env));
     add_command("remoteserver", new RemoteServerCommand(env));
     add_command("replay", new ReplayCommand(env));
+    add_command("benchmark", new BenchmarkCommand(env));
     add_command("capaltbit", new CapAltBitCommand(env));
     add_command("test", new TestCommand(env));
     add_command("convert", new ConvertCommand(env));
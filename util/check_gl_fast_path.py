@@ -0,0 +1,90 @@
+#!/usr/bin/env python
+#
+# Checks that every function on the GL fast path (GLFastPathFunction in
+# renderdoc/driver/gl/gl_hooks_linux_shared.cpp) has a wrapper that does nothing outside of an
+# active frame capture except call the real function.
+#
+# The fast path skips the wrapper entirely while no frame is being captured, so any wrapper that
+# tracks state or records chunks in the background would silently lose that work. Wrappers must
+# look like:
+#
+#   void WrappedOpenGL::glFoo(...)
+#   {
+#     SERIALISE_TIME_CALL(m_Real.glFoo(...));
+#
+#     if(IsActiveCapturing(m_State))
+#     {
+#       ...
+#     }
+#   }
+
+from __future__ import print_function
+
+import glob
+import os
+import re
+import sys
+
+root = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'renderdoc', 'driver', 'gl')
+
+with open(os.path.join(root, 'gl_hooks_linux_shared.cpp')) as f:
+    functions = re.findall(r'^GLFastPathFunction\((\w+)\);', f.read(), re.M)
+
+sources = {}
+for path in glob.glob(os.path.join(root, 'wrappers', '*.cpp')):
+    with open(path) as f:
+        sources[path] = f.read()
+
+
+def find_body(text, start):
+    open_brace = text.index('{', start)
+    depth = 0
+    for i in range(open_brace, len(text)):
+        if text[i] == '{':
+            depth += 1
+        elif text[i] == '}':
+            depth -= 1
+            if depth == 0:
+                return text[open_brace + 1:i]
+    return None
+
+
+# everything in the body that isn't the real call or inside the active capture block
+def outside_active_capture(body):
+    body = re.sub(r'SERIALISE_TIME_CALL\(m_Real\.\w+\(.*?\)\);', '', body, count=1, flags=re.S)
+
+    match = re.search(r'if\(IsActiveCapturing\(m_State\)\)\s*\{', body)
+    if match:
+        inner = find_body(body, match.end() - 1)
+        body = body[:match.start()] + body[match.end() + len(inner) + 1:]
+
+    return body.strip()
+
+
+errors = []
+
+for func in functions:
+    pattern = re.compile(r'^\w[\w \*]* WrappedOpenGL::' + func + r'\(', re.M)
+
+    bodies = []
+    for path, text in sources.items():
+        for match in pattern.finditer(text):
+            bodies.append(find_body(text, match.end()))
+
+    if len(bodies) != 1:
+        errors.append('%s: expected one wrapper, found %d' % (func, len(bodies)))
+        continue
+
+    leftover = outside_active_capture(bodies[0])
+    if leftover:
+        errors.append('%s: wrapper does work outside of an active capture:\n    %s' %
+                      (func, leftover.replace('\n', '\n    ')))
+
+if errors:
+    print('GL fast path functions with unsafe wrappers:\n')
+    for e in errors:
+        print(e)
+    print('\nRemove them from the GLFastPathFunction list in gl_hooks_linux_shared.cpp')
+    sys.exit(1)
+
+print('Checked %d GL fast path functions' % len(functions))
@@ -29,6 +29,9 @@ if git log --oneline | tail -n +2 | cut -d ' ' -f2- | grep -q '.\{73\}'; then
   exit 1;
 fi
 
+# check that GL functions on the lock-free fast path don't skip any background capture work
+python util/check_gl_fast_path.py
+
 # check formatting matches clang-format-3.8. Since newer versions can have
 # changes in formatting even without any rule changes, we have to fix on a
 # single version.